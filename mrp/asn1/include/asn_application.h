@@ -16,6 +16,7 @@
 
 #include "asn_system.h"		/* for platform-dependent types */
 #include "asn_codecs.h"		/* for ASN.1 codecs specifics */
+#include "asn_arena.h"		/* for arena allocation */
 
 #ifdef __cplusplus
 extern "C" {
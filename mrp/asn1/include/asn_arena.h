@@ -0,0 +1,52 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+/*
+ * Arena allocation for the ASN.1 support code.
+ * While an arena is in use by the calling thread, CALLOC, MALLOC and REALLOC
+ * allocate from the arena and FREEMEM of an arena block is a no-op (except for
+ * the most recent block, which is given back). All blocks are released at once
+ * by asn_arena_reset(). Without an arena in use the calls go to the C library.
+ */
+#ifndef	ASN_ARENA_H
+#define	ASN_ARENA_H
+
+#include <stddef.h>	/* for size_t */
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+typedef struct asn_arena_s asn_arena_t;
+
+/*
+ * Create an arena with an initial chunk of (size) bytes, returns 0 on ENOMEM.
+ * The arena grows by chunks when needed, and asn_arena_reset() merges
+ * the chunks into one so that the steady state needs a single chunk.
+ */
+asn_arena_t *asn_arena_new(size_t size);
+void asn_arena_delete(asn_arena_t *arena);
+/* Release all blocks allocated from the arena. */
+void asn_arena_reset(asn_arena_t *arena);
+/* Route allocations of the calling thread to (arena), or to the C library
+ * when (arena) is 0. Returns the arena that was in use before. */
+asn_arena_t *asn_arena_use(asn_arena_t *arena);
+/* Arena in use by the calling thread, or 0. */
+asn_arena_t *asn_arena_get(void);
+/* Whether (ptr) is a block of (arena). */
+int asn_arena_owns(const asn_arena_t *arena, const void *ptr);
+
+/* Allocation functions behind CALLOC, MALLOC, REALLOC and FREEMEM. */
+void *asn_calloc(size_t nmemb, size_t size);
+void *asn_malloc(size_t size);
+void *asn_realloc(void *ptr, size_t size);
+void asn_free(void *ptr);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ASN_ARENA_H */
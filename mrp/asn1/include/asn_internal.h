@@ -29,10 +29,11 @@ extern "C" {
 #define	ASN1C_ENVIRONMENT_VERSION	924	/* Compile-time version */
 int get_asn1c_environment_version(void);	/* Run-time version */
 
-#define	CALLOC(nmemb, size)	calloc(nmemb, size)
-#define	MALLOC(size)		malloc(size)
-#define	REALLOC(oldptr, size)	realloc(oldptr, size)
-#define	FREEMEM(ptr)		free(ptr)
+/* Allocations go to the arena in use by the calling thread, if any (asn_arena.h) */
+#define	CALLOC(nmemb, size)	asn_calloc(nmemb, size)
+#define	MALLOC(size)		asn_malloc(size)
+#define	REALLOC(oldptr, size)	asn_realloc(oldptr, size)
+#define	FREEMEM(ptr)		asn_free(ptr)
 
 #define	asn_debug_indent	0
 #define ASN_DEBUG_INDENT_ADD(i) do{}while(0)
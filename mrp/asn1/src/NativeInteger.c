@@ -247,6 +247,7 @@ NativeInteger_decode_uper(asn_codec_ctx_t *opt_codec_ctx,
 	asn_INTEGER_specifics_t *specs=(asn_INTEGER_specifics_t *)td->specifics;
 	asn_dec_rval_t rval;
 	long long *native = (long long *)*sptr;
+	asn_per_constraint_t *ct;
 	INTEGER_t tmpint;
 	void *tmpintptr = &tmpint;
 
@@ -258,6 +259,36 @@ NativeInteger_decode_uper(asn_codec_ctx_t *opt_codec_ctx,
 		if(!native) ASN__DECODE_FAILED;
 	}
 
+	/*
+	 * Constrained whole number within the root: read it straight into
+	 * the native value instead of going through a temporary INTEGER_t.
+	 */
+	if(!constraints) constraints = td->per_constraints;
+	ct = constraints ? &constraints->value : 0;
+	if(ct && (ct->flags & APC_CONSTRAINED)
+	&& !(ct->flags & APC_SEMI_CONSTRAINED)
+	&& ct->range_bits >= 0
+	&& (size_t)ct->range_bits <= 8 * sizeof(unsigned long long)) {
+		unsigned long long value;
+		int inext = 0;
+		if(ct->flags & APC_EXTENSIBLE) {
+			inext = per_get_few_bits(pd, 1);
+			if(inext < 0) ASN__DECODE_STARVED;
+			if(inext) per_get_undo(pd, 1);
+		}
+		if(!inext) {
+			if(uper_get_constrained_whole_number(pd,
+				&value, ct->range_bits))
+				ASN__DECODE_STARVED;
+			*native = (long long)(value + ct->lower_bound);
+			ASN_DEBUG("NativeInteger %s got value %lld",
+				td->name, *native);
+			rval.code = RC_OK;
+			rval.consumed = 0;
+			return rval;
+		}
+	}
+
 	memset(&tmpint, 0, sizeof tmpint);
 	rval = INTEGER_decode_uper(opt_codec_ctx, td, constraints,
 				   &tmpintptr, pd);
@@ -316,6 +347,7 @@ NativeInteger_encode_uper(asn_TYPE_descriptor_t *td,
 	asn_per_constraints_t *constraints, void *sptr, asn_per_outp_t *po) {
 	asn_INTEGER_specifics_t *specs=(asn_INTEGER_specifics_t *)td->specifics;
 	asn_enc_rval_t er;
+	asn_per_constraint_t *ct;
 	long native;
 	INTEGER_t tmpint;
 
@@ -325,6 +357,35 @@ NativeInteger_encode_uper(asn_TYPE_descriptor_t *td,
 
 	ASN_DEBUG("Encoding NativeInteger %s %ld (UPER)", td->name, native);
 
+	/*
+	 * Constrained whole number within the root: write it straight from
+	 * the native value instead of going through a temporary INTEGER_t.
+	 */
+	if(!constraints) constraints = td->per_constraints;
+	ct = constraints ? &constraints->value : 0;
+	if(ct && !(ct->flags & APC_SEMI_CONSTRAINED) && ct->range_bits >= 0) {
+		int inext;
+		if(specs && specs->field_unsigned)
+			inext = (unsigned long)native
+					< (unsigned long long)ct->lower_bound
+				|| (unsigned long)native
+					> (unsigned long long)ct->upper_bound;
+		else
+			inext = native < ct->lower_bound
+				|| native > ct->upper_bound;
+		if(!inext) {
+			if((ct->flags & APC_EXTENSIBLE)
+			&& per_put_few_bits(po, 0, 1))
+				ASN__ENCODE_FAILED;
+			if(uper_put_constrained_whole_number_u(po,
+				(unsigned long long)native - ct->lower_bound,
+				ct->range_bits))
+				ASN__ENCODE_FAILED;
+			er.encoded = 0;
+			ASN__ENCODED_OK(er);
+		}
+	}
+
 	memset(&tmpint, 0, sizeof(tmpint));
 	if((specs&&specs->field_unsigned)
 		? asn_ulong2INTEGER(&tmpint, native)
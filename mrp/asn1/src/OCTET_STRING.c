@@ -1365,13 +1365,13 @@ OCTET_STRING_decode_uper(asn_codec_ctx_t *opt_codec_ctx,
 
 	switch(specs->subvariant) {
 	default:
-	case ASN_OSUBV_ANY:
 		ASN_DEBUG("Unrecognized subvariant %d", specs->subvariant);
 		RETURN(RC_FAIL);
 	case ASN_OSUBV_BIT:
 		canonical_unit_bits = unit_bits = 1;
 		bpc = OS__BPC_BIT;
 		break;
+	case ASN_OSUBV_ANY:	/* Open type, the octets of its encoding */
 	case ASN_OSUBV_STR:
 		canonical_unit_bits = unit_bits = 8;
 		if(cval->flags & APC_CONSTRAINED)
@@ -1729,7 +1729,6 @@ OCTET_STRING_encode_uper(asn_TYPE_descriptor_t *td,
 
 	switch(specs->subvariant) {
 	default:
-	case ASN_OSUBV_ANY:
 		ASN__ENCODE_FAILED;
 	case ASN_OSUBV_BIT:
 		canonical_unit_bits = unit_bits = 1;
@@ -1738,6 +1737,7 @@ OCTET_STRING_encode_uper(asn_TYPE_descriptor_t *td,
 		ASN_DEBUG("BIT STRING of %d bytes, %d bits unused",
 				sizeinunits, st->bits_unused);
 		break;
+	case ASN_OSUBV_ANY:	/* Open type, the octets of its encoding */
 	case ASN_OSUBV_STR:
 		canonical_unit_bits = unit_bits = 8;
 		if(cval->flags & APC_CONSTRAINED)
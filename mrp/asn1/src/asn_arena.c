@@ -0,0 +1,217 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#include <stdlib.h>
+#include <string.h>
+#include <asn_arena.h>
+
+/*
+ * Each block is preceded by its size, which REALLOC needs for copying.
+ */
+#define	ASN_ARENA_ALIGN	8
+#define	ASN_ARENA_HDR	(sizeof(size_t))
+#define	ASN_ARENA_ROUND(n)	(((n) + ASN_ARENA_ALIGN - 1) & ~(size_t)(ASN_ARENA_ALIGN - 1))
+
+typedef struct asn_arena_chunk_s {
+	struct asn_arena_chunk_s *next;	/* older chunks */
+	size_t size;			/* bytes of data */
+	size_t pad;			/* keep data 8-byte aligned */
+} asn_arena_chunk_t;
+
+struct asn_arena_s {
+	asn_arena_chunk_t *chunks;	/* current chunk first */
+	char *top;			/* first free byte of the current chunk */
+	char *end;			/* end of the current chunk */
+	char *last;			/* most recent block, 0 if none */
+	size_t capacity;		/* bytes of data in all chunks */
+};
+
+static __thread asn_arena_t *asn_arena_current;
+
+#define	CHUNK_DATA(chunk)	((char *)(chunk) + sizeof(asn_arena_chunk_t))
+#define	CHUNK_CDATA(chunk)	((const char *)(chunk) + sizeof(asn_arena_chunk_t))
+#define	BLOCK_SIZE(ptr)		(*(size_t *)((char *)(ptr) - ASN_ARENA_HDR))
+
+static int
+asn_arena_grow(asn_arena_t *arena, size_t size) {
+	asn_arena_chunk_t *chunk;
+
+	if(size < arena->capacity)
+		size = arena->capacity;	/* double the capacity */
+	chunk = (asn_arena_chunk_t *)malloc(sizeof(asn_arena_chunk_t) + size);
+	if(chunk == 0)
+		return -1;
+	chunk->next = arena->chunks;
+	chunk->size = size;
+	arena->chunks = chunk;
+	arena->top = CHUNK_DATA(chunk);
+	arena->end = arena->top + size;
+	arena->last = 0;
+	arena->capacity += size;
+	return 0;
+}
+
+static void *
+asn_arena_alloc(asn_arena_t *arena, size_t size) {
+	size_t need = ASN_ARENA_HDR + ASN_ARENA_ROUND(size);
+	char *ptr;
+
+	if((size_t)(arena->end - arena->top) < need
+	&& asn_arena_grow(arena, need))
+		return 0;
+	ptr = arena->top + ASN_ARENA_HDR;
+	*(size_t *)arena->top = size;
+	arena->top += need;
+	arena->last = ptr;
+	return ptr;
+}
+
+asn_arena_t *
+asn_arena_new(size_t size) {
+	asn_arena_t *arena = (asn_arena_t *)calloc(1, sizeof(asn_arena_t));
+
+	if(arena && asn_arena_grow(arena, ASN_ARENA_ROUND(size))) {
+		free(arena);
+		arena = 0;
+	}
+	return arena;
+}
+
+void
+asn_arena_delete(asn_arena_t *arena) {
+	asn_arena_chunk_t *chunk;
+
+	if(arena == 0)
+		return;
+	if(asn_arena_current == arena)
+		asn_arena_current = 0;
+	while((chunk = arena->chunks)) {
+		arena->chunks = chunk->next;
+		free(chunk);
+	}
+	free(arena);
+}
+
+void
+asn_arena_reset(asn_arena_t *arena) {
+	asn_arena_chunk_t *chunk;
+	asn_arena_chunk_t *merged;
+
+	if(arena == 0)
+		return;
+	chunk = arena->chunks;
+	if(chunk->next) {
+		/*
+		 * Replace the chunks by one chunk holding the whole capacity,
+		 * keep the current chunk if that fails.
+		 */
+		merged = (asn_arena_chunk_t *)malloc(sizeof(asn_arena_chunk_t) + arena->capacity);
+		if(merged) {
+			merged->size = arena->capacity;
+			merged->next = chunk;
+			chunk = merged;
+		}
+		while(chunk->next) {
+			asn_arena_chunk_t *next = chunk->next->next;
+			free(chunk->next);
+			chunk->next = next;
+		}
+		arena->chunks = chunk;
+		arena->capacity = chunk->size;
+	}
+	arena->top = CHUNK_DATA(chunk);
+	arena->end = arena->top + chunk->size;
+	arena->last = 0;
+}
+
+asn_arena_t *
+asn_arena_use(asn_arena_t *arena) {
+	asn_arena_t *prev = asn_arena_current;
+	asn_arena_current = arena;
+	return prev;
+}
+
+asn_arena_t *
+asn_arena_get(void) {
+	return asn_arena_current;
+}
+
+int
+asn_arena_owns(const asn_arena_t *arena, const void *ptr) {
+	const asn_arena_chunk_t *chunk;
+
+	if(arena == 0 || ptr == 0)
+		return 0;
+	for(chunk = arena->chunks; chunk; chunk = chunk->next) {
+		const char *data = CHUNK_CDATA(chunk);
+		if((const char *)ptr > data && (const char *)ptr < data + chunk->size)
+			return 1;
+	}
+	return 0;
+}
+
+void *
+asn_calloc(size_t nmemb, size_t size) {
+	asn_arena_t *arena = asn_arena_current;
+	void *ptr;
+
+	if(arena == 0)
+		return calloc(nmemb, size);
+	if(size && nmemb > (size_t)-1 / size)
+		return 0;
+	ptr = asn_arena_alloc(arena, nmemb * size);
+	if(ptr)
+		memset(ptr, 0, nmemb * size);
+	return ptr;
+}
+
+void *
+asn_malloc(size_t size) {
+	asn_arena_t *arena = asn_arena_current;
+
+	if(arena == 0)
+		return malloc(size);
+	return asn_arena_alloc(arena, size);
+}
+
+void *
+asn_realloc(void *ptr, size_t size) {
+	asn_arena_t *arena = asn_arena_current;
+	void *nptr;
+	size_t old;
+
+	if(arena == 0 || (ptr && !asn_arena_owns(arena, ptr)))
+		return realloc(ptr, size);
+	if(ptr == 0)
+		return asn_arena_alloc(arena, size);
+	old = BLOCK_SIZE(ptr);
+	if(ptr == arena->last
+	&& (size_t)(arena->end - (char *)ptr) >= ASN_ARENA_ROUND(size)) {
+		/* The most recent block grows or shrinks in place */
+		BLOCK_SIZE(ptr) = size;
+		arena->top = (char *)ptr + ASN_ARENA_ROUND(size);
+		return ptr;
+	}
+	nptr = asn_arena_alloc(arena, size);
+	if(nptr)
+		memcpy(nptr, ptr, old < size ? old : size);
+	return nptr;
+}
+
+void
+asn_free(void *ptr) {
+	asn_arena_t *arena = asn_arena_current;
+
+	if(arena == 0 || !asn_arena_owns(arena, ptr)) {
+		free(ptr);
+		return;
+	}
+	if(ptr == arena->last) {
+		/* Give back the most recent block */
+		arena->top = (char *)ptr - ASN_ARENA_HDR;
+		arena->last = 0;
+	}
+}
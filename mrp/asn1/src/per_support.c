@@ -13,6 +13,32 @@
 #include <asn_internal.h>
 #include <per_support.h>
 
+/*
+ * Load 8 octets starting at (buf) as a big-endian 64-bit word.
+ * The bit primitives below use it to move up to 31 bits (plus the 0..7 bits
+ * offset into the first octet) with a single shift and mask once at least
+ * 64 bits are known to be present in the buffer.
+ */
+static inline uint64_t
+per_load_word(const uint8_t *buf) {
+	return ((uint64_t)buf[0] << 56) | ((uint64_t)buf[1] << 48)
+		| ((uint64_t)buf[2] << 40) | ((uint64_t)buf[3] << 32)
+		| ((uint64_t)buf[4] << 24) | ((uint64_t)buf[5] << 16)
+		| ((uint64_t)buf[6] << 8) | (uint64_t)buf[7];
+}
+
+static inline void
+per_store_word(uint8_t *buf, uint64_t word) {
+	buf[0] = (uint8_t)(word >> 56);
+	buf[1] = (uint8_t)(word >> 48);
+	buf[2] = (uint8_t)(word >> 40);
+	buf[3] = (uint8_t)(word >> 32);
+	buf[4] = (uint8_t)(word >> 24);
+	buf[5] = (uint8_t)(word >> 16);
+	buf[6] = (uint8_t)(word >> 8);
+	buf[7] = (uint8_t)word;
+}
+
 char *
 per_data_string(asn_per_data_t *pd) {
 	static char buf[2][32];
@@ -87,10 +113,21 @@ per_get_few_bits(asn_per_data_t *pd, int nbits) {
 		pd->nbits  -= (pd->nboff & ~0x07);
 		pd->nboff  &= 0x07;
 	}
+	buf = pd->buffer;
+
+	/*
+	 * Whole word is available: extract with a single shift and mask.
+	 */
+	if(nbits && nbits <= 31 && pd->nbits >= 64) {
+		accum = (uint32_t)((per_load_word(buf) << pd->nboff) >> (64 - nbits));
+		pd->moved += nbits;
+		pd->nboff += nbits;
+		return accum;
+	}
+
 	pd->moved += nbits;
 	pd->nboff += nbits;
 	off = pd->nboff;
-	buf = pd->buffer;
 
 	/*
 	 * Extract specified number of bits.
@@ -149,6 +186,35 @@ per_get_many_bits(asn_per_data_t *pd, uint8_t *dst, int alright, int nbits) {
 		nbits &= ~7;
 	}
 
+	/*
+	 * Whole octets present in the buffer are copied directly,
+	 * shifting them into place if the stream is not octet-aligned.
+	 */
+	if(nbits >= 8 && (ssize_t)(pd->nbits - pd->nboff) >= nbits) {
+		const uint8_t *src;
+		size_t shift;
+		int bytes = nbits >> 3;
+		int i;
+
+		if(pd->nboff >= 8) {
+			pd->buffer += (pd->nboff >> 3);
+			pd->nbits  -= (pd->nboff & ~0x07);
+			pd->nboff  &= 0x07;
+		}
+		src = pd->buffer;
+		shift = pd->nboff;
+		if(shift == 0)
+			memcpy(dst, src, bytes);
+		else
+			for(i = 0; i < bytes; i++)
+				dst[i] = (uint8_t)((src[i] << shift)
+					| (src[i + 1] >> (8 - shift)));
+		dst += bytes;
+		pd->nboff += 8 * bytes;
+		pd->moved += 8 * bytes;
+		nbits &= 7;
+	}
+
 	while(nbits) {
 		if(nbits >= 24) {
 			value = per_get_few_bits(pd, 24);
@@ -467,6 +533,17 @@ per_put_few_bits(asn_per_outp_t *po, uint32_t bits, int obits) {
 	/* Clear data of debris before meaningful bits */
 	bits &= (((uint32_t)1 << obits) - 1);
 
+	/*
+	 * Whole word fits into (tmpspace): merge and store it at once.
+	 * Octets past the meaningful bits are scratch until written again.
+	 */
+	if(po->nbits >= 64) {
+		per_store_word(buf, ((uint64_t)(buf[0] & omsk) << 56)
+			| ((uint64_t)bits << (64 - off)));
+		po->nboff = off;
+		return 0;
+	}
+
 	ASN_DEBUG("[PER out %d %u/%x (t=%d,o=%d) %x&%x=%x]", obits,
 		(int)bits, (int)bits,
 		(int)po->nboff, (int)off,
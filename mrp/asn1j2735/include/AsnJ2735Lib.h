@@ -9,6 +9,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 
 #include "dsrcBSM.h"
 #include "dsrcSPAT.h"
@@ -31,6 +32,58 @@ namespace AsnJ2735Lib
 	size_t decode_srm_payload(const uint8_t* buf, size_t size, SRM_element_t& srmOut);
 	size_t decode_ssm_payload(const uint8_t* buf, size_t size, SSM_element_t& ssmOut);
 	size_t decode_bsm_payload(const uint8_t* buf, size_t size, BSM_element_t& bsmOut);
+
+	/// decode BSMcoreData only. Part II, regional and extension content that follow BSMcoreData are
+	/// neither decoded nor checked, they stay in buf for decode_bsm_payload when needed.
+	/// Returns the number of bytes holding BSMcoreData, 0 on error. When BSMcoreData does not decode
+	/// directly, the message is handed to asn1c::decode_bsm_payload and the number of bytes of the whole
+	/// message is returned instead
+	size_t decode_bsm_coredata(const uint8_t* buf, size_t size, BSM_element_t& bsmOut);
+
+	/// read msgCnt, TemporaryID, timeStampSec, latitude and longitude at their fixed bit positions
+	/// in a UPER encoded BSM, without decoding the message. Returns false when buf is too short
+	bool peek_bsm_header(const uint8_t* buf, size_t size, BSM_header_t& header);
+
+	/// UPER codecs through the asn1c generated structures. The functions above encode and decode
+	/// the element structures directly and fall back to these when a message carries content
+	/// they do not cover (e.g., extensions, regional data), or on any error
+	namespace asn1c
+	{
+		size_t encode_mapdata_payload(const MapData_element_t& mapDataIn, uint8_t* buf, size_t size);
+		size_t encode_spat_payload(const SPAT_element_t& spatIn, uint8_t* buf, size_t size);
+		size_t encode_srm_payload(const SRM_element_t& srmIn, uint8_t* buf, size_t size);
+		size_t encode_ssm_payload(const SSM_element_t& ssmIn, uint8_t* buf, size_t size);
+		size_t encode_bsm_payload(const BSM_element_t& bsmIn, uint8_t* buf, size_t size);
+
+		size_t decode_mapdata_payload(const uint8_t* buf, size_t size, MapData_element_t& mapDataOut);
+		size_t decode_spat_payload(const uint8_t* buf, size_t size, SPAT_element_t& spatOut);
+		size_t decode_srm_payload(const uint8_t* buf, size_t size, SRM_element_t& srmOut);
+		size_t decode_ssm_payload(const uint8_t* buf, size_t size, SSM_element_t& ssmOut);
+		size_t decode_bsm_payload(const uint8_t* buf, size_t size, BSM_element_t& bsmOut);
+	};
+
+	/// incremental SPaT encoding for one intersection (SPaT built from the controller status every 100 ms).
+	/// The last encoding is kept as a skeleton together with the bit position of each field. When the next
+	/// SPaT has the same layout (intersection ID, permitted phases and the same optional time marks present),
+	/// only the fields that changed are rewritten in the skeleton, otherwise the skeleton is rebuilt.
+	/// Output is identical to encode_spat_payload
+	class SPaTencoder
+	{
+		private:
+			SPAT_element_t spat;              // SPaT held by the skeleton
+			std::vector<uint8_t>  skeleton;   // empty when there is no skeleton
+			std::vector<uint16_t> fieldPos;   // bit position of each field in skeleton, 0 when absent
+			size_t fullNums;
+			size_t patchNums;
+			bool sameLayout(const SPAT_element_t& spatIn) const;
+
+		public:
+			SPaTencoder(void);
+			size_t encode(const SPAT_element_t& spatIn, uint8_t* buf, size_t size);
+			/// number of encodings that rebuilt the skeleton and that patched it
+			size_t fullEncodes(void) const {return(fullNums);};
+			size_t patchedEncodes(void) const {return(patchNums);};
+	};
 };
 
 #endif
@@ -66,4 +66,13 @@ struct BSM_element_t
 	};
 };
 
+struct BSM_header_t
+{ // leading fields of BSMcoreData, same units as BSM_element_t
+	uint8_t   msgCnt;
+	uint32_t  id;
+	uint16_t  timeStampSec;
+	int32_t   latitude;
+	int32_t   longitude;
+};
+
 #endif
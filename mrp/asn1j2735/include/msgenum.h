@@ -14,6 +14,7 @@ namespace MsgEnum
 	static const uint8_t patternFlashing = 0xFE;
 	static const uint8_t patternFree = 0xFF;
 	static const unsigned long long mapInterval = 1000;  /// in milliseconds
+	static const unsigned long long spatInterval = 100;  /// in milliseconds
 	static const unsigned long long ssmInterval = 1000;  /// in milliseconds
 	static const uint32_t invalid_timeStampMinute = 527040;
 	static const int32_t  unknown_elevation = -4096;
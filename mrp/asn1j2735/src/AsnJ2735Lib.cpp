@@ -22,6 +22,48 @@
 // asn1j2735
 #include "AsnJ2735Lib.h"
 
+/// initial size of the per-thread arena for ASN.1 structures, grows as needed
+static const size_t asnArenaSize = 16384;
+
+/// per-thread arena for ASN.1 structures
+struct asnArena_t
+{
+	asn_arena_t* arena;
+	asnArena_t(void) : arena(asn_arena_new(asnArenaSize)) {};
+	~asnArena_t(void) {asn_arena_delete(arena);};
+};
+static thread_local asnArena_t asnArena;
+
+/// routes asn1 allocations of the calling thread to its arena for the lifetime of the scope,
+/// all ASN.1 structures built or decoded within the scope are released at once when it ends.
+/// A nested scope keeps using the enclosing one
+class asnArenaScope
+{
+	private:
+		asn_arena_t* prev;
+		bool active;
+	public:
+		asnArenaScope(void)
+		{
+			prev = asn_arena_get();
+			active = ((asnArena.arena != NULL) && (prev != asnArena.arena));
+			if (active)
+				asn_arena_use(asnArena.arena);
+		};
+		~asnArenaScope(void)
+		{
+			if (active)
+				asn_arena_reset(asn_arena_use(prev));
+		};
+};
+
+/// free ASN.1 structure, skipped for a structure built in the arena in use (released with the arena)
+auto freeAsnStruct = [](asn_TYPE_descriptor_t& td, void* ptr)->void
+{
+	if (!asn_arena_owns(asn_arena_get(), ptr))
+		ASN_STRUCT_FREE(td, ptr);
+};
+
 /// convert number of bits to number of bytes
 auto numbits2numbytes = [](ssize_t bit_nums)->size_t
 	{return((bit_nums <= 0) ? (0) : ((bit_nums + 7) >> 3));};
@@ -56,7 +98,7 @@ auto bitString2ul = [](const uint8_t* pbuf, int size, int bits_unused)->unsigned
 auto ul2bitString = [](uint8_t** pbuf, int& num_bytes, int& bits_unused, int num_bits, unsigned long value)->bool
 {
 	int bytes = (num_bits / 8) + (((num_bits % 8) > 0) ? 1 : 0);
-	if ((*pbuf = (uint8_t *)calloc(bytes, sizeof(uint8_t))) == NULL)
+	if ((*pbuf = (uint8_t *)asn_calloc(bytes, sizeof(uint8_t))) == NULL)
 		return(false);
 	num_bytes = bytes;
 	bits_unused = bytes * 8 - num_bits;
@@ -67,17 +109,18 @@ auto ul2bitString = [](uint8_t** pbuf, int& num_bytes, int& bits_unused, int num
 /// convert uint32_t vehicle ID to Temporary ID
 auto vehId2temporaryId = [](uint8_t** pbuf, int& size, unsigned long value)->bool
 { // Temporary ID has 4 bytes
-	if ((*pbuf = (uint8_t *)calloc(4, sizeof(uint8_t))) == NULL)
+	if ((*pbuf = (uint8_t *)asn_calloc(4, sizeof(uint8_t))) == NULL)
 		return(false);
 	size = 4;
 	ul2octString(*pbuf, 4, value);
 	return(true);
 };
 
-size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, uint8_t* buf, size_t size)
+size_t AsnJ2735Lib::asn1c::encode_mapdata_payload(const MapData_element_t& mapDataIn, uint8_t* buf, size_t size)
 {
 	std::string allocate_level{"MapData"};
-	MapData_t* pMapData = (MapData_t *)calloc(1, sizeof(MapData_t));
+	asnArenaScope arenaScope;
+	MapData_t* pMapData = (MapData_t *)asn_calloc(1, sizeof(MapData_t));
 	if (pMapData == NULL)
 	{
 		std::cerr << "encode_mapdata_payload: failed allocate " << allocate_level << std::endl;
@@ -100,28 +143,28 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 	// msgIssueRevision
 	pMapData->msgIssueRevision	= mapDataIn.mapVersion;
 	// LayerType
-	if ((pMapData->layerType = (LayerType_t *)calloc(1, sizeof(LayerType_t))) == NULL)
+	if ((pMapData->layerType = (LayerType_t *)asn_calloc(1, sizeof(LayerType_t))) == NULL)
 	{
 		std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;
 		std::cerr << ", failed allocate " << allocate_level << ".LayerType" << std::endl;
-		free(pMapData);
+		asn_free(pMapData);
 		return(0);
 	}
 	*(pMapData->layerType) = LayerType_intersectionData;
 
 	// IntersectionGeometryList - one intersection per MapData
 	allocate_level += ".IntersectionGeometryList";
-	pMapData->intersections = (IntersectionGeometryList_t *)calloc(1, sizeof(IntersectionGeometryList_t));
+	pMapData->intersections = (IntersectionGeometryList_t *)asn_calloc(1, sizeof(IntersectionGeometryList_t));
 	if (pMapData->intersections != NULL) // one IntersectionGeometry per distinct speed limit
-		pMapData->intersections->list.array = (IntersectionGeometry_t **)calloc(mapDataIn.speeds.size(), sizeof(IntersectionGeometry_t *));
+		pMapData->intersections->list.array = (IntersectionGeometry_t **)asn_calloc(mapDataIn.speeds.size(), sizeof(IntersectionGeometry_t *));
 	if ((pMapData->intersections == NULL) || (pMapData->intersections->list.array == NULL))
 	{
 		std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;
 		std::cerr << ", failed allocate " << allocate_level << std::endl;
 		if (pMapData->intersections != NULL)
-			free(pMapData->intersections);
-		free(pMapData->layerType);
-		free(pMapData);
+			asn_free(pMapData->intersections);
+		asn_free(pMapData->layerType);
+		asn_free(pMapData);
 		return(0);
 	}
 	pMapData->intersections->list.size = static_cast<int>(mapDataIn.speeds.size());
@@ -145,7 +188,7 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 		// get the reference lane width for this speed group
 		uint16_t refLaneWidth = mapDataIn.mpApproaches[approachIndex[0]].mpLanes[0].width;
 		// allocate IntersectionGeometry - one per speed group
-		if ((pMapData->intersections->list.array[geoListCnt] = (IntersectionGeometry_t *)calloc(1, sizeof(IntersectionGeometry_t))) == NULL)
+		if ((pMapData->intersections->list.array[geoListCnt] = (IntersectionGeometry_t *)asn_calloc(1, sizeof(IntersectionGeometry_t))) == NULL)
 		{
 			std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;
 			std::cerr << ", failed allocate " << allocate_level << std::endl;
@@ -176,7 +219,7 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 		pIntersectionGeometry->refPoint.Long = mapDataIn.geoRef.longitude;
 		if (mapDataIn.attributes.test(0))
 		{ // include elevation data
-			if ((pIntersectionGeometry->refPoint.elevation = (Elevation_t *)calloc(1, sizeof(Elevation_t))) == NULL)
+			if ((pIntersectionGeometry->refPoint.elevation = (Elevation_t *)asn_calloc(1, sizeof(Elevation_t))) == NULL)
 			{
 				std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;
 				std::cerr << ", failed allocate " << allocate_level << ".Position3D.Elevation" << std::endl;
@@ -186,7 +229,7 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 			*(pIntersectionGeometry->refPoint.elevation) = mapDataIn.geoRef.elevation;
 		}
 		// LaneWidth
-		if ((pIntersectionGeometry->laneWidth = (LaneWidth_t *)calloc(1, sizeof(LaneWidth_t))) == NULL)
+		if ((pIntersectionGeometry->laneWidth = (LaneWidth_t *)asn_calloc(1, sizeof(LaneWidth_t))) == NULL)
 		{
 			std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;
 			std::cerr << ", failed allocate " << allocate_level << ".LaneWidth" << std::endl;
@@ -197,9 +240,9 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 		// SpeedLimitList
 		if ((speed_limit > 0) && (speed_limit < MsgEnum::unknown_speed))
 		{ // 0 = crosswalk, MsgEnum::unknown_speed = speed limit not available on vehicular lanes
-			pIntersectionGeometry->speedLimits = (SpeedLimitList_t *)calloc(1, sizeof(SpeedLimitList_t));
+			pIntersectionGeometry->speedLimits = (SpeedLimitList_t *)asn_calloc(1, sizeof(SpeedLimitList_t));
 			if (pIntersectionGeometry->speedLimits != NULL)
-				pIntersectionGeometry->speedLimits->list.array = (RegulatorySpeedLimit_t **)calloc(1, sizeof(RegulatorySpeedLimit_t *));
+				pIntersectionGeometry->speedLimits->list.array = (RegulatorySpeedLimit_t **)asn_calloc(1, sizeof(RegulatorySpeedLimit_t *));
 			if ((pIntersectionGeometry->speedLimits == NULL) || (pIntersectionGeometry->speedLimits->list.array == NULL))
 			{
 				std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;
@@ -208,7 +251,7 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 				break;
 			}
 			pIntersectionGeometry->speedLimits->list.size = 1;
-			if ((pIntersectionGeometry->speedLimits->list.array[0] = (RegulatorySpeedLimit_t *)calloc(1, sizeof(RegulatorySpeedLimit_t))) == NULL)
+			if ((pIntersectionGeometry->speedLimits->list.array[0] = (RegulatorySpeedLimit_t *)asn_calloc(1, sizeof(RegulatorySpeedLimit_t))) == NULL)
 			{
 				std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;
 				std::cerr << ", failed allocate " << allocate_level << ".SpeedLimitList.RegulatorySpeedLimit" << std::endl;
@@ -222,7 +265,7 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 
 		// LaneList
 		std::string branch_level{".LaneList"};
-		if ((pIntersectionGeometry->laneSet.list.array = (GenericLane_t **)calloc(num_lanes, sizeof(GenericLane_t *))) == NULL)
+		if ((pIntersectionGeometry->laneSet.list.array = (GenericLane_t **)asn_calloc(num_lanes, sizeof(GenericLane_t *))) == NULL)
 		{
 			std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;
 			std::cerr << ", failed allocate " << allocate_level << branch_level << std::endl;
@@ -238,7 +281,7 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 			const auto& approachStruct = mapDataIn.mpApproaches[i_approach];
 			for (const auto& laneStruct : approachStruct.mpLanes)
 			{
-				if ((pIntersectionGeometry->laneSet.list.array[laneListCnt] = (GenericLane_t *)calloc(1, sizeof(GenericLane_t))) == NULL)
+				if ((pIntersectionGeometry->laneSet.list.array[laneListCnt] = (GenericLane_t *)asn_calloc(1, sizeof(GenericLane_t))) == NULL)
 				{
 					std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;
 					std::cerr << ", failed allocate " << allocate_level;
@@ -324,14 +367,14 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 				switch(approachStruct.type)
 				{
 				case MsgEnum::approachType::outbound:
-					if ((pGenericLane->egressApproach = (ApproachID_t *)calloc(1, sizeof(ApproachID_t))) == NULL)
+					if ((pGenericLane->egressApproach = (ApproachID_t *)asn_calloc(1, sizeof(ApproachID_t))) == NULL)
 						has_error = true;
 					else
 						*(pGenericLane->egressApproach) = approachStruct.id;
 					break;
 				case MsgEnum::approachType::inbound:
 				case MsgEnum::approachType::crosswalk:
-					if ((pGenericLane->ingressApproach = (ApproachID_t *)calloc(1, sizeof(ApproachID_t))) == NULL)
+					if ((pGenericLane->ingressApproach = (ApproachID_t *)asn_calloc(1, sizeof(ApproachID_t))) == NULL)
 						has_error = true;
 					else
 						*(pGenericLane->ingressApproach) = approachStruct.id;
@@ -346,7 +389,7 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 				// AllowedManeuvers - 12 bits BIT STRING
 				if (approachStruct.type != MsgEnum::approachType::crosswalk)
 				{
-					if (((pGenericLane->maneuvers = (AllowedManeuvers_t *)calloc(1, sizeof(AllowedManeuvers_t))) == NULL)
+					if (((pGenericLane->maneuvers = (AllowedManeuvers_t *)asn_calloc(1, sizeof(AllowedManeuvers_t))) == NULL)
 						|| !(ul2bitString(&pGenericLane->maneuvers->buf, pGenericLane->maneuvers->size,
 							pGenericLane->maneuvers->bits_unused, 12, (laneStruct.attributes.to_ulong() >> 8))))
 					{
@@ -360,9 +403,9 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 				// ConnectsToList
 				if (!laneStruct.mpConnectTo.empty())
 				{
-					pGenericLane->connectsTo = (ConnectsToList_t *)calloc(1, sizeof(ConnectsToList_t));
+					pGenericLane->connectsTo = (ConnectsToList_t *)asn_calloc(1, sizeof(ConnectsToList_t));
 					if (pGenericLane->connectsTo != NULL)
-						pGenericLane->connectsTo->list.array = (Connection_t **)calloc(laneStruct.mpConnectTo.size(), sizeof(Connection_t *));
+						pGenericLane->connectsTo->list.array = (Connection_t **)asn_calloc(laneStruct.mpConnectTo.size(), sizeof(Connection_t *));
 					if ((pGenericLane->connectsTo == NULL) || (pGenericLane->connectsTo->list.array == NULL))
 					{
 						std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;
@@ -374,7 +417,7 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 					int& connListCnt = pGenericLane->connectsTo->list.count;
 					for (const auto& connStruct : laneStruct.mpConnectTo)
 					{
-						if ((pGenericLane->connectsTo->list.array[connListCnt] = (Connection_t *)calloc(1, sizeof(Connection_t))) == NULL)
+						if ((pGenericLane->connectsTo->list.array[connListCnt] = (Connection_t *)asn_calloc(1, sizeof(Connection_t))) == NULL)
 						{
 							std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;
 							std::cerr << ", failed allocate " << allocate_level << branch_level << ".ConnectsToList.Connection" << std::endl;
@@ -406,7 +449,7 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 							default:
 								break;
 							}
-							if (((connLane.maneuver = (AllowedManeuvers_t *)calloc(1, sizeof(AllowedManeuvers_t))) == NULL)
+							if (((connLane.maneuver = (AllowedManeuvers_t *)asn_calloc(1, sizeof(AllowedManeuvers_t))) == NULL)
 								|| !(ul2bitString(&connLane.maneuver->buf, connLane.maneuver->size,
 									connLane.maneuver->bits_unused, 12, connecting_maneuvers.to_ulong())))
 							{
@@ -420,7 +463,7 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 						// Connection::IntersectionReferenceID
 						if (connStruct.intersectionId != mapDataIn.id)
 						{
-							if ((pConnection->remoteIntersection = (IntersectionReferenceID_t *)calloc(1, sizeof(IntersectionReferenceID_t))) == NULL)
+							if ((pConnection->remoteIntersection = (IntersectionReferenceID_t *)asn_calloc(1, sizeof(IntersectionReferenceID_t))) == NULL)
 							{
 								std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;;
 								std::cerr << ", failed allocate " << allocate_level << branch_level;
@@ -433,7 +476,7 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 						// Connection::signalGroup
 						if (laneStruct.controlPhase != 0)
 						{
-							if ((pConnection->signalGroup = (SignalGroupID_t *)calloc(1, sizeof(SignalGroupID_t))) == NULL)
+							if ((pConnection->signalGroup = (SignalGroupID_t *)asn_calloc(1, sizeof(SignalGroupID_t))) == NULL)
 							{
 								std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;
 								std::cerr << ", failed allocate " << allocate_level << branch_level << ".ConnectsToList.Connection.signalGroup" << std::endl;
@@ -450,7 +493,7 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 				// NodeListXY
 				pGenericLane->nodeList.present = NodeListXY_PR_nodes; // NodeSetXY
 				auto& nodeSet = pGenericLane->nodeList.choice.nodes;
-				if ((nodeSet.list.array = (NodeXY_t **)calloc(laneStruct.mpNodes.size(), sizeof(NodeXY_t *))) == NULL)
+				if ((nodeSet.list.array = (NodeXY_t **)asn_calloc(laneStruct.mpNodes.size(), sizeof(NodeXY_t *))) == NULL)
 				{
 					std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;
 					std::cerr << ", failed allocate " << allocate_level << branch_level << ".NodeListXY" << std::endl;
@@ -465,7 +508,7 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 					const auto& offset_x = it->offset_x;
 					const auto& offset_y = it->offset_y;
 					uint32_t offset_dist = static_cast<uint32_t>(std::sqrt(offset_x * offset_x + offset_y * offset_y));
-					if ((nodeSet.list.array[nodeListCnt] = (NodeXY_t *)calloc(1, sizeof(NodeXY_t))) == NULL)
+					if ((nodeSet.list.array[nodeListCnt] = (NodeXY_t *)asn_calloc(1, sizeof(NodeXY_t))) == NULL)
 					{
 						std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;
 						std::cerr << ", failed allocate " << allocate_level << branch_level	<< ".NodeListXY.NodeXY" << std::endl;
@@ -513,9 +556,9 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 					// NodeXY::NodeAttributeSetXY - lane width adjustment w.r.t. refLaneWidth
 					if ((laneStruct.width != refLaneWidth) && (it == laneStruct.mpNodes.cbegin()))
 					{
-						pNode->attributes = (NodeAttributeSetXY_t *)calloc(1, sizeof(NodeAttributeSetXY_t));
+						pNode->attributes = (NodeAttributeSetXY_t *)asn_calloc(1, sizeof(NodeAttributeSetXY_t));
 						if (pNode->attributes != NULL)
-							pNode->attributes->dWidth = (Offset_B10_t *)calloc(1, sizeof(Offset_B10_t));
+							pNode->attributes->dWidth = (Offset_B10_t *)asn_calloc(1, sizeof(Offset_B10_t));
 						if ((pNode->attributes == NULL) || (pNode->attributes->dWidth == NULL))
 						{
 							std::cerr << "encode_mapdata_payload: intersectionId=" << mapDataIn.id;
@@ -537,29 +580,30 @@ size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, u
 	}
 	if (has_error)
 	{
-		ASN_STRUCT_FREE(asn_DEF_MapData, pMapData);
+		freeAsnStruct(asn_DEF_MapData, pMapData);
 		return(0);
 	}
 	// encode MapData
 	asn_enc_rval_t rval = uper_encode_to_buffer(&asn_DEF_MapData, pMapData, buf, size);
-	ASN_STRUCT_FREE(asn_DEF_MapData, pMapData);
+	freeAsnStruct(asn_DEF_MapData, pMapData);
 	return(numbits2numbytes(rval.encoded));
 }
 
-size_t AsnJ2735Lib::decode_mapdata_payload(const uint8_t* buf, size_t size, MapData_element_t& mapDataOut)
+size_t AsnJ2735Lib::asn1c::decode_mapdata_payload(const uint8_t* buf, size_t size, MapData_element_t& mapDataOut)
 {
+	asnArenaScope arenaScope;
 	MapData_t* pMapData = NULL;
 	asn_dec_rval_t rval = uper_decode(0, &asn_DEF_MapData,(void **)&pMapData, buf, size, 0, 0);
 	if (rval.code != RC_OK)
 	{
 		std::cerr << "decode_mapdata_payload: failed UPER decoding" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_MapData, pMapData);
+		freeAsnStruct(asn_DEF_MapData, pMapData);
 		return(0);
 	}
 	if ((pMapData == NULL) || (pMapData->intersections == NULL) || (pMapData->intersections->list.count == 0))
 	{
 		std::cerr << "decode_mapdata_payload: empty IntersectionGeometryList" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_MapData, pMapData);
+		freeAsnStruct(asn_DEF_MapData, pMapData);
 		return(0);
 	}
 	mapDataOut.reset();
@@ -685,7 +729,14 @@ size_t AsnJ2735Lib::decode_mapdata_payload(const uint8_t* buf, size_t size, MapD
 
 			uint8_t approachId = static_cast<uint8_t>((pGenericLane->ingressApproach != NULL) ?
 				(*(pGenericLane->ingressApproach)) : (*(pGenericLane->egressApproach)));
-			if ((approachId > 0) && (approachId <= 12) && (mapDataOut.mpApproaches[approachId-1].id != approachId))
+			if ((approachId == 0) || (approachId > 12))
+			{
+				std::cerr << "decode_mapdata_payload: intersectionId=" << mapDataOut.id;
+				std::cerr << ", laneId=" << pGenericLane->laneID << ", invalid ApproachID=" << static_cast<unsigned int>(approachId) << std::endl;
+				has_error = true;
+				break;
+			}
+			if (mapDataOut.mpApproaches[approachId-1].id != approachId)
 			{ // assign ApproachStruct variables
 				mapDataOut.mpApproaches[approachId-1].id = approachId;
 				mapDataOut.mpApproaches[approachId-1].speed_limit = speed_limit;
@@ -805,11 +856,11 @@ size_t AsnJ2735Lib::decode_mapdata_payload(const uint8_t* buf, size_t size, MapD
 		if (has_error)
 			break;
 	}
-	ASN_STRUCT_FREE(asn_DEF_MapData, pMapData);
+	freeAsnStruct(asn_DEF_MapData, pMapData);
 	return((has_error) ? (0) : (numbits2numbytes(rval.consumed)));
 }
 
-size_t AsnJ2735Lib::encode_spat_payload(const SPAT_element_t& spatIn, uint8_t* buf, size_t size)
+size_t AsnJ2735Lib::asn1c::encode_spat_payload(const SPAT_element_t& spatIn, uint8_t* buf, size_t size)
 { // get array of signalGroupID for permitted vehicular and pedestrian phases
 	std::vector<int> signalGroupArray;
 	for (uint8_t i = 0; i < 8; i++)
@@ -826,7 +877,8 @@ size_t AsnJ2735Lib::encode_spat_payload(const SPAT_element_t& spatIn, uint8_t* b
 		return(0);   // nothing to encode
 
 	std::string allocate_level{"SPAT"};
-	SPAT_t* pSPAT = (SPAT_t *)calloc(1, sizeof(SPAT_t));
+	asnArenaScope arenaScope;
+	SPAT_t* pSPAT = (SPAT_t *)asn_calloc(1, sizeof(SPAT_t));
 	if (pSPAT == NULL)
 	{
 		std::cerr << "encode_spat_payload: failed allocate " << allocate_level << std::endl;
@@ -843,19 +895,19 @@ size_t AsnJ2735Lib::encode_spat_payload(const SPAT_element_t& spatIn, uint8_t* b
 
 	// IntersectionStateList - one intersection per SPAT
 	allocate_level += ".IntersectionStateList";
-	if ((pSPAT->intersections.list.array = (IntersectionState_t **)calloc(1, sizeof(IntersectionState_t *))) == NULL)
+	if ((pSPAT->intersections.list.array = (IntersectionState_t **)asn_calloc(1, sizeof(IntersectionState_t *))) == NULL)
 	{
 		std::cerr << "encode_spat_payload: failed allocate " << allocate_level << std::endl;
-		free(pSPAT);
+		asn_free(pSPAT);
 		return(0);
 	}
 	pSPAT->intersections.list.size  = 1;
 	allocate_level += ".IntersectionState";
-	if ((pSPAT->intersections.list.array[0] = (IntersectionState_t *)calloc(1, sizeof(IntersectionState_t))) == NULL)
+	if ((pSPAT->intersections.list.array[0] = (IntersectionState_t *)asn_calloc(1, sizeof(IntersectionState_t))) == NULL)
 	{
 		std::cerr << "encode_spat_payload: failed allocate " << allocate_level << std::endl;
-		free(pSPAT->intersections.list.array);
-		free(pSPAT);
+		asn_free(pSPAT->intersections.list.array);
+		asn_free(pSPAT);
 		return(0);
 	}
 	pSPAT->intersections.list.count = 1;
@@ -885,28 +937,28 @@ size_t AsnJ2735Lib::encode_spat_payload(const SPAT_element_t& spatIn, uint8_t* b
 	{
 		std::cerr << "encode_spat_payload: failed allocate " << allocate_level;
 		std::cerr << ".IntersectionStatusObject" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SPAT, pSPAT);
+		freeAsnStruct(asn_DEF_SPAT, pSPAT);
 		return(0);
 	}
 	// TimeStamp
 	if (spatIn.timeStampMinute < MsgEnum::invalid_timeStampMinute)
 	{
-		if ((pIntsectionState->moy = (MinuteOfTheYear_t *)calloc(1, sizeof(MinuteOfTheYear_t))) == NULL)
+		if ((pIntsectionState->moy = (MinuteOfTheYear_t *)asn_calloc(1, sizeof(MinuteOfTheYear_t))) == NULL)
 		{
 			std::cerr << "encode_spat_payload: failed allocate " << allocate_level;
 			std::cerr	<< ".MinuteOfTheYear" << std::endl;
-			ASN_STRUCT_FREE(asn_DEF_SPAT, pSPAT);
+			freeAsnStruct(asn_DEF_SPAT, pSPAT);
 			return(0);
 		}
 		*(pIntsectionState->moy) = spatIn.timeStampMinute;
 	}
 	if (spatIn.timeStampSec < 0xFFFF)
 	{
-		if ((pIntsectionState->timeStamp = (DSecond_t *)calloc(1, sizeof(DSecond_t))) == NULL)
+		if ((pIntsectionState->timeStamp = (DSecond_t *)asn_calloc(1, sizeof(DSecond_t))) == NULL)
 		{
 			std::cerr << "encode_spat_payload: failed allocate " << allocate_level;
 			std::cerr	<< ".timeStamp" << std::endl;
-			ASN_STRUCT_FREE(asn_DEF_SPAT, pSPAT);
+			freeAsnStruct(asn_DEF_SPAT, pSPAT);
 			return(0);
 		}
 		*(pIntsectionState->timeStamp) = spatIn.timeStampSec;
@@ -915,10 +967,10 @@ size_t AsnJ2735Lib::encode_spat_payload(const SPAT_element_t& spatIn, uint8_t* b
 	// MovementList
 	allocate_level += ".MovementList"; // one MovementState per vehicular/pedestrian signal group
 	if ((pIntsectionState->states.list.array =
-		(MovementState_t **)calloc(signalGroupArray.size(), sizeof(MovementState_t *))) == NULL)
+		(MovementState_t **)asn_calloc(signalGroupArray.size(), sizeof(MovementState_t *))) == NULL)
 	{
 		std::cerr << "encode_spat_payload: failed allocate " << allocate_level << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SPAT, pSPAT);
+		freeAsnStruct(asn_DEF_SPAT, pSPAT);
 		return(0);
 	}
 	pIntsectionState->states.list.size  = static_cast<int>(signalGroupArray.size());
@@ -932,7 +984,7 @@ size_t AsnJ2735Lib::encode_spat_payload(const SPAT_element_t& spatIn, uint8_t* b
 		const PhaseState_element_t& phaseState = (signal_group < 8) ?
 			spatIn.phaseState[signal_group] : spatIn.pedPhaseState[signal_group - 8];
 		// allocate MovementState object
-		if ((pIntsectionState->states.list.array[stateListCnt] = (MovementState_t *)calloc(1, sizeof(MovementState_t))) == NULL)
+		if ((pIntsectionState->states.list.array[stateListCnt] = (MovementState_t *)asn_calloc(1, sizeof(MovementState_t))) == NULL)
 		{
 			std::cerr << "encode_spat_payload: failed allocate " << allocate_level << std::endl;
 			has_error = true;
@@ -954,7 +1006,7 @@ size_t AsnJ2735Lib::encode_spat_payload(const SPAT_element_t& spatIn, uint8_t* b
 		// MovementEventList - one MovementEvent per movement
 		std::string branch_level(".MovementEventList");
 		if ((pMovementState->state_time_speed.list.array =
-			(MovementEvent_t **)calloc(1, sizeof(MovementEvent_t *))) == NULL)
+			(MovementEvent_t **)asn_calloc(1, sizeof(MovementEvent_t *))) == NULL)
 		{
 			std::cerr << "encode_spat_payload: failed allocate " << allocate_level;
 			std::cerr	<< branch_level << std::endl;
@@ -964,7 +1016,7 @@ size_t AsnJ2735Lib::encode_spat_payload(const SPAT_element_t& spatIn, uint8_t* b
 		pMovementState->state_time_speed.list.size  = 1;
 		branch_level += ".MovementEvent";
 		if ((pMovementState->state_time_speed.list.array[0] =
-			(MovementEvent_t *)calloc(1, sizeof(MovementEvent_t))) == NULL)
+			(MovementEvent_t *)asn_calloc(1, sizeof(MovementEvent_t))) == NULL)
 		{
 			std::cerr << "encode_spat_payloadL: failed allocate " << allocate_level;
 			std::cerr << branch_level << std::endl;
@@ -997,7 +1049,7 @@ size_t AsnJ2735Lib::encode_spat_payload(const SPAT_element_t& spatIn, uint8_t* b
 		// -------------------------------------------------------- //
 		if (phaseState.minEndTime < MsgEnum::unknown_timeDetail)
 		{
-			if ((pMovementEvent->timing = (TimeChangeDetails *)calloc(1, sizeof(TimeChangeDetails))) == NULL)
+			if ((pMovementEvent->timing = (TimeChangeDetails *)asn_calloc(1, sizeof(TimeChangeDetails))) == NULL)
 			{
 				std::cerr << "encode_spat_payloadL: failed allocate " << allocate_level;
 				std::cerr	<< branch_level << std::endl;
@@ -1009,7 +1061,7 @@ size_t AsnJ2735Lib::encode_spat_payload(const SPAT_element_t& spatIn, uint8_t* b
 			// startTime
 			if (phaseState.startTime < MsgEnum::unknown_timeDetail)
 			{
-				if ((pMovementEvent->timing->startTime = (TimeMark_t *)calloc(1, sizeof(TimeMark_t))) == NULL)
+				if ((pMovementEvent->timing->startTime = (TimeMark_t *)asn_calloc(1, sizeof(TimeMark_t))) == NULL)
 				{
 					std::cerr << "encode_spat_payloadL: failed allocate " << allocate_level;
 					std::cerr	<< branch_level	<< ".startTime" << std::endl;
@@ -1021,7 +1073,7 @@ size_t AsnJ2735Lib::encode_spat_payload(const SPAT_element_t& spatIn, uint8_t* b
 			// maxEndTime
 			if (phaseState.maxEndTime < MsgEnum::unknown_timeDetail)
 			{
-				if ((pMovementEvent->timing->maxEndTime = (TimeMark_t *)calloc(1, sizeof(TimeMark_t))) == NULL)
+				if ((pMovementEvent->timing->maxEndTime = (TimeMark_t *)asn_calloc(1, sizeof(TimeMark_t))) == NULL)
 				{
 					std::cerr << "encode_spat_payloadL: failed allocate " << allocate_level;
 					std::cerr	<< branch_level	<< ".maxEndTime" << std::endl;
@@ -1034,29 +1086,30 @@ size_t AsnJ2735Lib::encode_spat_payload(const SPAT_element_t& spatIn, uint8_t* b
 	}
 	if (has_error)
 	{
-		ASN_STRUCT_FREE(asn_DEF_SPAT, pSPAT);
+		freeAsnStruct(asn_DEF_SPAT, pSPAT);
 		return(0);
 	}
 	// encode SPAT
 	asn_enc_rval_t rval = uper_encode_to_buffer(&asn_DEF_SPAT, pSPAT, buf, size);
-	ASN_STRUCT_FREE(asn_DEF_SPAT, pSPAT);
+	freeAsnStruct(asn_DEF_SPAT, pSPAT);
 	return(numbits2numbytes(rval.encoded));
 }
 
-size_t AsnJ2735Lib::decode_spat_payload(const uint8_t* buf, size_t size, SPAT_element_t& spatOut)
+size_t AsnJ2735Lib::asn1c::decode_spat_payload(const uint8_t* buf, size_t size, SPAT_element_t& spatOut)
 {
+	asnArenaScope arenaScope;
 	SPAT_t* pSPAT = NULL;
 	asn_dec_rval_t rval = uper_decode(0, &asn_DEF_SPAT,(void **)&pSPAT, buf, size, 0, 0);
 	if (rval.code != RC_OK)
 	{
 		std::cerr << "decode_spat_payload: failed UPER decoding" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SPAT, pSPAT);
+		freeAsnStruct(asn_DEF_SPAT, pSPAT);
 		return(0);
 	}
 	if ((pSPAT == NULL) || (pSPAT->intersections.list.count == 0))
 	{
 		std::cerr << "decode_spat_payload: empty IntersectionStateList" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SPAT, pSPAT);
+		freeAsnStruct(asn_DEF_SPAT, pSPAT);
 		return(0);
 	}
 	spatOut.reset();
@@ -1071,7 +1124,7 @@ size_t AsnJ2735Lib::decode_spat_payload(const uint8_t* buf, size_t size, SPAT_el
 	if (pIntsectionState->states.list.count == 0)
 	{
 		std::cerr << "decode_spat_payload: empty MovementList" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SPAT, pSPAT);
+		freeAsnStruct(asn_DEF_SPAT, pSPAT);
 		return(0);
 	}
 	auto& permittedPhases = spatOut.permittedPhases;
@@ -1106,11 +1159,11 @@ size_t AsnJ2735Lib::decode_spat_payload(const uint8_t* buf, size_t size, SPAT_el
 				phaseState.maxEndTime = static_cast<uint16_t>(*(pMovementEvent->timing->maxEndTime));
 		}
 	}
-	ASN_STRUCT_FREE(asn_DEF_SPAT, pSPAT);
+	freeAsnStruct(asn_DEF_SPAT, pSPAT);
 	return((has_error) ? (0) : (numbits2numbytes(rval.consumed)));
 }
 
-size_t AsnJ2735Lib::encode_srm_payload(const SRM_element_t& srmIn, uint8_t* buf, size_t size)
+size_t AsnJ2735Lib::asn1c::encode_srm_payload(const SRM_element_t& srmIn, uint8_t* buf, size_t size)
 {
 	if ((srmIn.inApprochId == 0) && (srmIn.inLaneId == 0))
 	{
@@ -1119,7 +1172,8 @@ size_t AsnJ2735Lib::encode_srm_payload(const SRM_element_t& srmIn, uint8_t* buf,
 	}
 
 	std::string allocate_level{"SRM"};
-	SignalRequestMessage_t* pSRM = (SignalRequestMessage_t *)calloc(1, sizeof(SignalRequestMessage_t));
+	asnArenaScope arenaScope;
+	SignalRequestMessage_t* pSRM = (SignalRequestMessage_t *)asn_calloc(1, sizeof(SignalRequestMessage_t));
 	if (pSRM == NULL)
 	{
 		std::cerr << "encode_srm_payload: failed allocate " << allocate_level << std::endl;
@@ -1141,11 +1195,11 @@ size_t AsnJ2735Lib::encode_srm_payload(const SRM_element_t& srmIn, uint8_t* buf,
 	// SRM::MinuteOfTheYear
 	if (srmIn.timeStampMinute < MsgEnum::invalid_timeStampMinute)
 	{
-		if ((pSRM->timeStamp = (MinuteOfTheYear_t *)calloc(1, sizeof(MinuteOfTheYear_t))) == NULL)
+		if ((pSRM->timeStamp = (MinuteOfTheYear_t *)asn_calloc(1, sizeof(MinuteOfTheYear_t))) == NULL)
 		{
 			std::cerr << "encode_srm_payload: failed allocate " << allocate_level;
 			std::cerr << ".MinuteOfTheYear" << std::endl;
-			free(pSRM);
+			asn_free(pSRM);
 			return(0);
 		}
 		*(pSRM->timeStamp) = srmIn.timeStampMinute;
@@ -1153,40 +1207,40 @@ size_t AsnJ2735Lib::encode_srm_payload(const SRM_element_t& srmIn, uint8_t* buf,
 	// MsgCount
 	if (srmIn.msgCnt < 0xFF)
 	{
-		if ((pSRM->sequenceNumber = (MsgCount_t *)calloc(1, sizeof(MsgCount_t))) == NULL)
+		if ((pSRM->sequenceNumber = (MsgCount_t *)asn_calloc(1, sizeof(MsgCount_t))) == NULL)
 		{
 			std::cerr << "encode_srm_payload: failed allocate " << allocate_level;
 			std::cerr	<< ".MsgCount" << std::endl;
 			if (pSRM->timeStamp != NULL)
-				free(pSRM->timeStamp);
-			free(pSRM);
+				asn_free(pSRM->timeStamp);
+			asn_free(pSRM);
 			return(0);
 		}
 		*(pSRM->sequenceNumber) = srmIn.msgCnt;
 	}
 	// SignalRequestList - request for one intersection
 	std::string branch_level(".SignalRequestList");
-	pSRM->requests = (SignalRequestList_t *)calloc(1, sizeof(SignalRequestList_t));
+	pSRM->requests = (SignalRequestList_t *)asn_calloc(1, sizeof(SignalRequestList_t));
 	if (pSRM->requests != NULL)
-		pSRM->requests->list.array = (SignalRequestPackage_t **)calloc(1, sizeof(SignalRequestPackage_t *));
+		pSRM->requests->list.array = (SignalRequestPackage_t **)asn_calloc(1, sizeof(SignalRequestPackage_t *));
 	if ((pSRM->requests == NULL) || (pSRM->requests->list.array == NULL))
 	{
 		std::cerr << "encode_srm_payload: failed allocate " << allocate_level << branch_level << std::endl;
 		if (pSRM->requests != NULL)
-			free(pSRM->requests);
+			asn_free(pSRM->requests);
 		if (pSRM->timeStamp != NULL)
-			free(pSRM->timeStamp);
+			asn_free(pSRM->timeStamp);
 		if (pSRM->sequenceNumber != NULL)
-			free(pSRM->sequenceNumber);
-		free(pSRM);
+			asn_free(pSRM->sequenceNumber);
+		asn_free(pSRM);
 		return(0);
 	}
 	pSRM->requests->list.size = 1;
 	branch_level += ".SignalRequestPackage";
-	if ((pSRM->requests->list.array[0] = (SignalRequestPackage_t *)calloc(1, sizeof(SignalRequestPackage_t))) == NULL)
+	if ((pSRM->requests->list.array[0] = (SignalRequestPackage_t *)asn_calloc(1, sizeof(SignalRequestPackage_t))) == NULL)
 	{
 		std::cerr << "encode_srm_payload: failed allocate " << allocate_level << branch_level << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+		freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 		return(0);
 	}
 	pSRM->requests->list.count = 1;
@@ -1204,22 +1258,22 @@ size_t AsnJ2735Lib::encode_srm_payload(const SRM_element_t& srmIn, uint8_t* buf,
 	// ETA
 	if (srmIn.ETAminute < MsgEnum::invalid_timeStampMinute)
 	{
-		if ((pSignalRequestPackage->minute = (MinuteOfTheYear_t *)calloc(1, sizeof(MinuteOfTheYear_t))) == NULL)
+		if ((pSignalRequestPackage->minute = (MinuteOfTheYear_t *)asn_calloc(1, sizeof(MinuteOfTheYear_t))) == NULL)
 		{
 			std::cerr << "encode_srm_payload: failed allocate " << allocate_level << branch_level;
 			std::cerr << ".ETAminute" << std::endl;
-			ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+			freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 			return(0);
 		}
 		*(pSignalRequestPackage->minute) = srmIn.ETAminute;
 	}
 	if (srmIn.ETAsec < 0xFFFF)
 	{
-		if ((pSignalRequestPackage->second = (DSecond_t *)calloc(1, sizeof(DSecond_t))) == NULL)
+		if ((pSignalRequestPackage->second = (DSecond_t *)asn_calloc(1, sizeof(DSecond_t))) == NULL)
 		{
 			std::cerr << "encode_srm_payload: failed allocate " << allocate_level << branch_level;
 			std::cerr	<< ".ETAsec" << std::endl;
-			ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+			freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 			return(0);
 		}
 		*(pSignalRequestPackage->second) = srmIn.ETAsec;
@@ -1227,11 +1281,11 @@ size_t AsnJ2735Lib::encode_srm_payload(const SRM_element_t& srmIn, uint8_t* buf,
 	// duration
 	if (srmIn.duration < 0xFFFF)
 	{
-		if ((pSignalRequestPackage->duration = (DSecond_t *)calloc(1, sizeof(DSecond_t))) == NULL)
+		if ((pSignalRequestPackage->duration = (DSecond_t *)asn_calloc(1, sizeof(DSecond_t))) == NULL)
 		{
 			std::cerr << "encode_srm_payload: failed allocate " << allocate_level << branch_level;
 			std::cerr	<< ".duration" << std::endl;
-			ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+			freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 			return(0);
 		}
 		*(pSignalRequestPackage->duration) = srmIn.duration;
@@ -1268,11 +1322,11 @@ size_t AsnJ2735Lib::encode_srm_payload(const SRM_element_t& srmIn, uint8_t* buf,
 	// outBoundLane
 	if (!((srmIn.outApproachId == 0) && (srmIn.outLaneId == 0)))
 	{
-		if ((signalRequest.outBoundLane = (IntersectionAccessPoint_t *)calloc(1, sizeof(IntersectionAccessPoint_t))) == NULL)
+		if ((signalRequest.outBoundLane = (IntersectionAccessPoint_t *)asn_calloc(1, sizeof(IntersectionAccessPoint_t))) == NULL)
 		{
 			std::cerr << "encode_srm_payload: failed allocate " << allocate_level << branch_level;
 			std::cerr << ".SignalRequest.outBoundLane" << std::endl;
-			ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+			freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 			return(0);
 		}
 		if (srmIn.outLaneId == 0)
@@ -1310,15 +1364,15 @@ size_t AsnJ2735Lib::encode_srm_payload(const SRM_element_t& srmIn, uint8_t* buf,
 	{
 		std::cerr << "encode_srm_payload: failed allocate " << allocate_level;
 		std::cerr << ".VehicleID" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+		freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 		return(0);
 	}
 	// RequestorType
-	if ((requestor.type = (RequestorType_t *)calloc(1, sizeof(RequestorType_t))) == NULL)
+	if ((requestor.type = (RequestorType_t *)asn_calloc(1, sizeof(RequestorType_t))) == NULL)
 	{
 		std::cerr << "encode_srm_payload: failed allocate " << allocate_level;
 		std::cerr	<< ".RequestorType" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+		freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 		return(0);
 	}
 	// RequestorType
@@ -1335,21 +1389,21 @@ size_t AsnJ2735Lib::encode_srm_payload(const SRM_element_t& srmIn, uint8_t* buf,
 	// BasicVehicleRole
 	requestor.type->role = static_cast<BasicVehicleRole_t>(srmIn.vehRole);
 	// VehicleType
-	if ((requestor.type->hpmsType = (VehicleType_t *)calloc(1, sizeof(VehicleType_t))) == NULL)
+	if ((requestor.type->hpmsType = (VehicleType_t *)asn_calloc(1, sizeof(VehicleType_t))) == NULL)
 	{
 		std::cerr << "encode_srm_payload: failed allocate " << allocate_level;
 		std::cerr	<< ".RequestorType.VehicleType" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+		freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 		return(0);
 	}
 	*(requestor.type->hpmsType) = static_cast<VehicleType_t>(srmIn.vehType);
 
 	// RequestorPositionVector
-	if ((requestor.position = (RequestorPositionVector_t *)calloc(1, sizeof(RequestorPositionVector_t))) == NULL)
+	if ((requestor.position = (RequestorPositionVector_t *)asn_calloc(1, sizeof(RequestorPositionVector_t))) == NULL)
 	{
 		std::cerr << "encode_srm_payload: failed allocate " << allocate_level;
 		std::cerr	<< ".RequestorPositionVector" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+		freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 		return(0);
 	}
 	// RequestorPositionVector
@@ -1365,54 +1419,55 @@ size_t AsnJ2735Lib::encode_srm_payload(const SRM_element_t& srmIn, uint8_t* buf,
 	requestor.position->position.Long = srmIn.longitude;
 	if (srmIn.elevation > MsgEnum::unknown_elevation)
 	{
-		if ((requestor.position->position.elevation = (Elevation_t *)calloc(1, sizeof(Elevation_t))) == NULL)
+		if ((requestor.position->position.elevation = (Elevation_t *)asn_calloc(1, sizeof(Elevation_t))) == NULL)
 		{
 			std::cerr << "encode_srm_payload: failed allocate " << allocate_level;
 			std::cerr	<< ".RequestorPositionVector.Position3D.elevation" << std::endl;
-			ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+			freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 			return(0);
 		}
 		*(requestor.position->position.elevation) = srmIn.elevation;
 	}
 	// heading
-	if ((requestor.position->heading = (Angle_t *)calloc(1, sizeof(Angle_t))) == NULL)
+	if ((requestor.position->heading = (Angle_t *)asn_calloc(1, sizeof(Angle_t))) == NULL)
 	{
 		std::cerr << "encode_srm_payload: failed allocate " << allocate_level;
 		std::cerr	<< ".RequestorPositionVector.heading" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+		freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 		return(0);
 	}
 	*(requestor.position->heading) = srmIn.heading;
 	// speed
-	if ((requestor.position->speed = (TransmissionAndSpeed_t *)calloc(1, sizeof(TransmissionAndSpeed_t))) == NULL)
+	if ((requestor.position->speed = (TransmissionAndSpeed_t *)asn_calloc(1, sizeof(TransmissionAndSpeed_t))) == NULL)
 	{
 		std::cerr << "encode_srm_payload: failed allocate " << allocate_level;
 		std::cerr << ".RequestorPositionVector.speed" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+		freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 		return(0);
 	}
 	requestor.position->speed->transmisson = static_cast<TransmissionState_t>(srmIn.transState);
 	requestor.position->speed->speed = srmIn.speed;
 	// encode SRM
 	asn_enc_rval_t rval = uper_encode_to_buffer(&asn_DEF_SignalRequestMessage, pSRM, buf, size);
-	ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+	freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 	return(numbits2numbytes(rval.encoded));
 }
 
-size_t AsnJ2735Lib::decode_srm_payload(const uint8_t* buf, size_t size, SRM_element_t& srmOut)
+size_t AsnJ2735Lib::asn1c::decode_srm_payload(const uint8_t* buf, size_t size, SRM_element_t& srmOut)
 {
+	asnArenaScope arenaScope;
 	SignalRequestMessage_t* pSRM = NULL;
 	asn_dec_rval_t rval = uper_decode(0, &asn_DEF_SignalRequestMessage, (void **)&pSRM, buf, size, 0, 0);
 	if (rval.code != RC_OK)
 	{
 		std::cerr << "decode_srm_payload: failed UPER decoding" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+		freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 		return(0);
 	}
 	if ((pSRM == NULL) || (pSRM->requests == NULL) || (pSRM->requests->list.count == 0))
 	{
 		std::cerr << "decode_srm_payload: missing SignalRequestList" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+		freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 		return(0);
 	}
 	srmOut.reset();
@@ -1447,28 +1502,28 @@ size_t AsnJ2735Lib::decode_srm_payload(const uint8_t* buf, size_t size, SRM_elem
 	if (requestor.id.present != VehicleID_PR_entityID)
 	{
 		std::cerr << "decode_srm_payload: missing Temporary ID" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+		freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 		return(0);
 	}
 	srmOut.vehId = static_cast<uint32_t>(octString2ul(requestor.id.choice.entityID.buf, requestor.id.choice.entityID.size));
 	if (requestor.type == NULL)
 	{
 		std::cerr << "decode_srm_payload: missing RequestorType" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+		freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 		return(0);
 	}
 	srmOut.vehRole = static_cast<MsgEnum::basicRole>(requestor.type->role);
 	if (requestor.type->hpmsType == NULL)
 	{
 		std::cerr << "decode_srm_payload: missing VehicleType" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+		freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 		return(0);
 	}
 	srmOut.vehType = static_cast<MsgEnum::vehicleType>(*(requestor.type->hpmsType));
 	if (requestor.position == NULL)
 	{
 		std::cerr << "decode_srm_payload: missing RequestorPositionVector" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+		freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 		return(0);
 	}
 	srmOut.latitude = static_cast<int32_t>(requestor.position->position.lat);
@@ -1478,29 +1533,30 @@ size_t AsnJ2735Lib::decode_srm_payload(const uint8_t* buf, size_t size, SRM_elem
 	if (requestor.position->heading == NULL)
 	{
 		std::cerr << "decode_srm_payload: missing heading" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+		freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 		return(0);
 	}
 	srmOut.heading = static_cast<uint16_t>(*(requestor.position->heading));
 	if (requestor.position->speed == NULL)
 	{
 		std::cerr << "decode_srm_payload: missing TransmissionAndSpeed" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+		freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 		return(0);
 	}
 	srmOut.transState = static_cast<MsgEnum::transGear>(requestor.position->speed->transmisson);
 	srmOut.speed = static_cast<uint16_t>(requestor.position->speed->speed);
-	ASN_STRUCT_FREE(asn_DEF_SignalRequestMessage, pSRM);
+	freeAsnStruct(asn_DEF_SignalRequestMessage, pSRM);
 	return(numbits2numbytes(rval.consumed));
 }
 
-size_t AsnJ2735Lib::encode_ssm_payload(const SSM_element_t& ssmIn, uint8_t* buf, size_t size)
+size_t AsnJ2735Lib::asn1c::encode_ssm_payload(const SSM_element_t& ssmIn, uint8_t* buf, size_t size)
 {
 	if (ssmIn.mpSignalRequetStatus.empty())
 		return(0);  // nothing to encode
 
 	std::string allocate_level{"SSM"};
-	SignalStatusMessage_t* pSSM = (SignalStatusMessage_t *)calloc(1, sizeof(SignalStatusMessage_t));
+	asnArenaScope arenaScope;
+	SignalStatusMessage_t* pSSM = (SignalStatusMessage_t *)asn_calloc(1, sizeof(SignalStatusMessage_t));
 	if (pSSM == NULL)
 	{
 		std::cerr << "encode_ssm_payload: failed allocate " << allocate_level << std::endl;
@@ -1521,11 +1577,11 @@ size_t AsnJ2735Lib::encode_ssm_payload(const SSM_element_t& ssmIn, uint8_t* buf,
 	// SSM::MinuteOfTheYear
 	if (ssmIn.timeStampMinute < MsgEnum::invalid_timeStampMinute)
 	{
-		if ((pSSM->timeStamp = (MinuteOfTheYear_t *)calloc(1, sizeof(MinuteOfTheYear_t))) == NULL)
+		if ((pSSM->timeStamp = (MinuteOfTheYear_t *)asn_calloc(1, sizeof(MinuteOfTheYear_t))) == NULL)
 		{
 			std::cerr << "encode_ssm_payload: failed allocate " << allocate_level;
 			std::cerr	<< ".MinuteOfTheYear" << std::endl;
-			free(pSSM);
+			asn_free(pSSM);
 			return(0);
 		}
 		*(pSSM->timeStamp) = ssmIn.timeStampMinute;
@@ -1533,40 +1589,40 @@ size_t AsnJ2735Lib::encode_ssm_payload(const SSM_element_t& ssmIn, uint8_t* buf,
 	// MsgCount
 	if (ssmIn.msgCnt < 0xFF)
 	{
-		if ((pSSM->sequenceNumber = (MsgCount_t *)calloc(1, sizeof(MsgCount_t))) == NULL)
+		if ((pSSM->sequenceNumber = (MsgCount_t *)asn_calloc(1, sizeof(MsgCount_t))) == NULL)
 		{
 			std::cerr << "encode_ssm_payload: failed allocate " << allocate_level;
 			std::cerr	<< ".MsgCount" << std::endl;
 			if (pSSM->timeStamp != NULL)
-				free(pSSM->timeStamp);
-			free(pSSM);
+				asn_free(pSSM->timeStamp);
+			asn_free(pSSM);
 			return(0);
 		}
 		*(pSSM->sequenceNumber) = ssmIn.msgCnt;
 	}
 	// SignalStatusList - one intersection per SSM
 	allocate_level += ".SignalStatusList";
-	if ((pSSM->status.list.array = (SignalStatus_t **)calloc(1, sizeof(SignalStatus_t *))) == NULL)
+	if ((pSSM->status.list.array = (SignalStatus_t **)asn_calloc(1, sizeof(SignalStatus_t *))) == NULL)
 	{
 		std::cerr << "encode_ssm_payload: failed allocate " << allocate_level << std::endl;
 		if (pSSM->sequenceNumber != NULL)
-			free(pSSM->sequenceNumber);
+			asn_free(pSSM->sequenceNumber);
 		if (pSSM->timeStamp != NULL)
-			free(pSSM->timeStamp);
-		free(pSSM);
+			asn_free(pSSM->timeStamp);
+		asn_free(pSSM);
 		return(0);
 	}
 	pSSM->status.list.size  = 1;
 	allocate_level += ".SignalStatus";
-	if ((pSSM->status.list.array[0] = (SignalStatus_t *)calloc(1, sizeof(SignalStatus_t))) == NULL)
+	if ((pSSM->status.list.array[0] = (SignalStatus_t *)asn_calloc(1, sizeof(SignalStatus_t))) == NULL)
 	{
 		std::cerr << "encode_ssm_payload: failed allocate " << allocate_level << std::endl;
-		free(pSSM->status.list.array);
+		asn_free(pSSM->status.list.array);
 		if (pSSM->sequenceNumber != NULL)
-			free(pSSM->sequenceNumber);
+			asn_free(pSSM->sequenceNumber);
 		if (pSSM->timeStamp != NULL)
-			free(pSSM->timeStamp);
-		free(pSSM);
+			asn_free(pSSM->timeStamp);
+		asn_free(pSSM);
 		return(0);
 	}
 	pSSM->status.list.count = 1;
@@ -1586,17 +1642,17 @@ size_t AsnJ2735Lib::encode_ssm_payload(const SSM_element_t& ssmIn, uint8_t* buf,
 	pSignalStatus->id.id = ssmIn.id;
 	// SignalStatusPackageList
 	allocate_level += ".SignalStatusPackageList";
-	if ((pSignalStatus->sigStatus.list.array = (SignalStatusPackage_t **)calloc(ssmIn.mpSignalRequetStatus.size(),
+	if ((pSignalStatus->sigStatus.list.array = (SignalStatusPackage_t **)asn_calloc(ssmIn.mpSignalRequetStatus.size(),
 		sizeof(SignalStatusPackage_t *))) == NULL)
 	{
 		std::cerr << "encode_ssm_payload: failed allocate " << allocate_level << std::endl;
-		free(pSSM->status.list.array[0]);
-		free(pSSM->status.list.array);
+		asn_free(pSSM->status.list.array[0]);
+		asn_free(pSSM->status.list.array);
 		if (pSSM->sequenceNumber != NULL)
-			free(pSSM->sequenceNumber);
+			asn_free(pSSM->sequenceNumber);
 		if (pSSM->timeStamp != NULL)
-			free(pSSM->timeStamp);
-		free(pSSM);
+			asn_free(pSSM->timeStamp);
+		asn_free(pSSM);
 		return(0);
 	}
 	pSignalStatus->sigStatus.list.size = static_cast<int>(ssmIn.mpSignalRequetStatus.size());
@@ -1608,7 +1664,7 @@ size_t AsnJ2735Lib::encode_ssm_payload(const SSM_element_t& ssmIn, uint8_t* buf,
 	for (const auto& signalRequetStatus : ssmIn.mpSignalRequetStatus)
 	{
 		if ((pSignalStatus->sigStatus.list.array[statusListCnt] =
-			(SignalStatusPackage_t *)calloc(1, sizeof(SignalStatusPackage_t))) = NULL)
+			(SignalStatusPackage_t *)asn_calloc(1, sizeof(SignalStatusPackage_t))) == NULL)
 		{
 			std::cerr << "encode_ssm_payload: failed allocate " << allocate_level << std::endl;
 			has_error = true;
@@ -1651,7 +1707,7 @@ size_t AsnJ2735Lib::encode_ssm_payload(const SSM_element_t& ssmIn, uint8_t* buf,
 		if (!((signalRequetStatus.outApproachId == 0) && (signalRequetStatus.outLaneId == 0)))
 		{
 			if ((pSignalStatusPackage->outboundOn =
-				(IntersectionAccessPoint_t *)calloc(1, sizeof(IntersectionAccessPoint_t))) == NULL)
+				(IntersectionAccessPoint_t *)asn_calloc(1, sizeof(IntersectionAccessPoint_t))) == NULL)
 			{
 				std::cerr << "encode_ssm_payload: failed allocate " << allocate_level;
 				std::cerr << ".outboundOn" << std::endl;
@@ -1672,7 +1728,7 @@ size_t AsnJ2735Lib::encode_ssm_payload(const SSM_element_t& ssmIn, uint8_t* buf,
 		// ETA
 		if (signalRequetStatus.ETAminute < MsgEnum::invalid_timeStampMinute)
 		{
-			if ((pSignalStatusPackage->minute =	(MinuteOfTheYear_t *)calloc(1, sizeof(MinuteOfTheYear_t))) == NULL)
+			if ((pSignalStatusPackage->minute =	(MinuteOfTheYear_t *)asn_calloc(1, sizeof(MinuteOfTheYear_t))) == NULL)
 			{
 				std::cerr << "encode_ssm_payload: failed allocate " << allocate_level;
 				std::cerr	<< ".ETAminute" << std::endl;
@@ -1683,7 +1739,7 @@ size_t AsnJ2735Lib::encode_ssm_payload(const SSM_element_t& ssmIn, uint8_t* buf,
 		}
 		if (signalRequetStatus.ETAsec < 0xFFFF)
 		{
-			if ((pSignalStatusPackage->second = (DSecond_t *)calloc(1, sizeof(DSecond_t))) == NULL)
+			if ((pSignalStatusPackage->second = (DSecond_t *)asn_calloc(1, sizeof(DSecond_t))) == NULL)
 			{
 				std::cerr << "encode_ssm_payload: failed allocate " << allocate_level;
 				std::cerr	<< ".ETAsec" << std::endl;
@@ -1695,7 +1751,7 @@ size_t AsnJ2735Lib::encode_ssm_payload(const SSM_element_t& ssmIn, uint8_t* buf,
 		// duration
 		if (signalRequetStatus.duration < 0xFFFF)
 		{
-			if ((pSignalStatusPackage->duration = (DSecond_t *)calloc(1, sizeof(DSecond_t))) == NULL)
+			if ((pSignalStatusPackage->duration = (DSecond_t *)asn_calloc(1, sizeof(DSecond_t))) == NULL)
 			{
 				std::cerr << "encode_ssm_payload: failed allocate " << allocate_level;
 				std::cerr	<< ".duration" << std::endl;
@@ -1705,7 +1761,7 @@ size_t AsnJ2735Lib::encode_ssm_payload(const SSM_element_t& ssmIn, uint8_t* buf,
 			*(pSignalStatusPackage->duration) = signalRequetStatus.duration;
 		}
 		// SignalRequesterInfo
-		if ((pSignalStatusPackage->requester = (SignalRequesterInfo_t *)calloc(1, sizeof(SignalRequesterInfo_t))) == NULL)
+		if ((pSignalStatusPackage->requester = (SignalRequesterInfo_t *)asn_calloc(1, sizeof(SignalRequesterInfo_t))) == NULL)
 		{
 			std::cerr << "encode_ssm_payload: failed allocate " << allocate_level;
 			std::cerr	<< ".SignalRequesterInfo" << std::endl;
@@ -1739,7 +1795,7 @@ size_t AsnJ2735Lib::encode_ssm_payload(const SSM_element_t& ssmIn, uint8_t* buf,
 		// BasicVehicleRole
 		if (signalRequetStatus.vehRole != MsgEnum::basicRole::unavailable)
 		{
-			if ((pSignalStatusPackage->requester->role = (BasicVehicleRole_t *)calloc(1, sizeof(BasicVehicleRole_t))) == NULL)
+			if ((pSignalStatusPackage->requester->role = (BasicVehicleRole_t *)asn_calloc(1, sizeof(BasicVehicleRole_t))) == NULL)
 			{
 				std::cerr << "encode_ssm_payload: failed allocate " << allocate_level;
 				std::cerr	<< ".SignalRequesterInfo.BasicVehicleRole" << std::endl;
@@ -1751,29 +1807,30 @@ size_t AsnJ2735Lib::encode_ssm_payload(const SSM_element_t& ssmIn, uint8_t* buf,
 	}
 	if (has_error)
 	{
-		ASN_STRUCT_FREE(asn_DEF_SignalStatusMessage, pSSM);
+		freeAsnStruct(asn_DEF_SignalStatusMessage, pSSM);
 		return(0);
 	}
 	// encode SSM
 	asn_enc_rval_t rval = uper_encode_to_buffer(&asn_DEF_SignalStatusMessage, pSSM, buf, size);
-	ASN_STRUCT_FREE(asn_DEF_SignalStatusMessage, pSSM);
+	freeAsnStruct(asn_DEF_SignalStatusMessage, pSSM);
 	return(numbits2numbytes(rval.encoded));
 }
 
-size_t AsnJ2735Lib::decode_ssm_payload(const uint8_t* buf, size_t size, SSM_element_t& ssmOut)
+size_t AsnJ2735Lib::asn1c::decode_ssm_payload(const uint8_t* buf, size_t size, SSM_element_t& ssmOut)
 {
+	asnArenaScope arenaScope;
 	SignalStatusMessage_t* pSSM	= NULL;
 	asn_dec_rval_t rval = uper_decode(0, &asn_DEF_SignalStatusMessage,(void **)&pSSM, buf, size, 0, 0);
 	if (rval.code != RC_OK)
 	{
 		std::cerr << "decode_ssm_payload: failed UPER decoding" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalStatusMessage, pSSM);
+		freeAsnStruct(asn_DEF_SignalStatusMessage, pSSM);
 		return(0);
 	}
 	if ((pSSM == NULL) || (pSSM->status.list.count == 0))
 	{
 		std::cerr << "decode_ssm_payload: empty SignalStatusList" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalStatusMessage, pSSM);
+		freeAsnStruct(asn_DEF_SignalStatusMessage, pSSM);
 		return(0);
 	}
 	ssmOut.reset();
@@ -1788,7 +1845,7 @@ size_t AsnJ2735Lib::decode_ssm_payload(const uint8_t* buf, size_t size, SSM_elem
 	if (pSignalStatus->sigStatus.list.count == 0)
 	{
 		std::cerr << "decode_ssm_payload: empty SignalStatusPackageList" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_SignalStatusMessage, pSSM);
+		freeAsnStruct(asn_DEF_SignalStatusMessage, pSSM);
 		return(0);
 	}
 	ssmOut.mpSignalRequetStatus.resize(pSignalStatus->sigStatus.list.count);
@@ -1840,14 +1897,15 @@ size_t AsnJ2735Lib::decode_ssm_payload(const uint8_t* buf, size_t size, SSM_elem
 		}
 		signalRequetStatus.vehRole = static_cast<MsgEnum::basicRole>(*(pSignalStatusPackage->requester->role));
 	}
-	ASN_STRUCT_FREE(asn_DEF_SignalStatusMessage, pSSM);
+	freeAsnStruct(asn_DEF_SignalStatusMessage, pSSM);
 	return((has_error) ? (0) : (numbits2numbytes(rval.consumed)));
 }
 
-size_t AsnJ2735Lib::encode_bsm_payload(const BSM_element_t& bsmIn, uint8_t* buf, size_t size)
+size_t AsnJ2735Lib::asn1c::encode_bsm_payload(const BSM_element_t& bsmIn, uint8_t* buf, size_t size)
 {
 	std::string allocate_level{"BSM"};
-	BasicSafetyMessage_t* pBSM = (BasicSafetyMessage_t *)calloc(1, sizeof(BasicSafetyMessage_t));
+	asnArenaScope arenaScope;
+	BasicSafetyMessage_t* pBSM = (BasicSafetyMessage_t *)asn_calloc(1, sizeof(BasicSafetyMessage_t));
 	if (pBSM == NULL)
 	{
 		std::cerr << "encode_bsm_payload: failed allocate " << allocate_level << std::endl;
@@ -1868,7 +1926,7 @@ size_t AsnJ2735Lib::encode_bsm_payload(const BSM_element_t& bsmIn, uint8_t* buf,
 	{
 		std::cerr << "encode_bsm_payload: failed allocate " << allocate_level;
 		std::cerr << ".TemporaryID" << std::endl;
-		free(pBSM);
+		asn_free(pBSM);
 		return(0);
 	}
 	coreData.secMark = bsmIn.timeStampSec;
@@ -1895,7 +1953,7 @@ size_t AsnJ2735Lib::encode_bsm_payload(const BSM_element_t& bsmIn, uint8_t* buf,
 	{
 		std::cerr << "encode_bsm_payload: failed allocate " << allocate_level;
 		std::cerr	<< ".BrakeAppliedStatus" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_BasicSafetyMessage, pBSM);
+		freeAsnStruct(asn_DEF_BasicSafetyMessage, pBSM);
 		return(0);
 	}
 	brakeSystemStatus.traction = static_cast<TractionControlStatus_t>(bsmIn.tractionControlStatus);
@@ -1905,18 +1963,19 @@ size_t AsnJ2735Lib::encode_bsm_payload(const BSM_element_t& bsmIn, uint8_t* buf,
 	brakeSystemStatus.auxBrakes = static_cast<AuxiliaryBrakeStatus_t>(bsmIn.auxiliaryBrakeStatus);
 	// encode BSM
 	asn_enc_rval_t rval = uper_encode_to_buffer(&asn_DEF_BasicSafetyMessage, pBSM, buf, size);
-	ASN_STRUCT_FREE(asn_DEF_BasicSafetyMessage, pBSM);
+	freeAsnStruct(asn_DEF_BasicSafetyMessage, pBSM);
 	return(numbits2numbytes(rval.encoded));
 }
 
-size_t AsnJ2735Lib::decode_bsm_payload(const uint8_t* buf, size_t size, BSM_element_t& bsmOut)
+size_t AsnJ2735Lib::asn1c::decode_bsm_payload(const uint8_t* buf, size_t size, BSM_element_t& bsmOut)
 {
+	asnArenaScope arenaScope;
 	BasicSafetyMessage_t* pBSM = NULL;
 	asn_dec_rval_t rval = uper_decode(0, &asn_DEF_BasicSafetyMessage,(void **)&pBSM, buf, size, 0, 0);
 	if (rval.code != RC_OK)
 	{
 		std::cerr << "decode_bsm_payload: failed UPER decoding" << std::endl;
-		ASN_STRUCT_FREE(asn_DEF_BasicSafetyMessage, pBSM);
+		freeAsnStruct(asn_DEF_BasicSafetyMessage, pBSM);
 		return(0);
 	}
 	const auto& coreData = pBSM->coreData;
@@ -1947,6 +2006,6 @@ size_t AsnJ2735Lib::decode_bsm_payload(const uint8_t* buf, size_t size, BSM_elem
 	bsmOut.stabilityControlStatus = static_cast<MsgEnum::engageStatus>(brakeSystemStatus.scs);
 	bsmOut.brakeBoostApplied = static_cast<MsgEnum::engageStatus>(brakeSystemStatus.brakeBoost);
 	bsmOut.auxiliaryBrakeStatus = static_cast<MsgEnum::engageStatus>(brakeSystemStatus.auxBrakes);
-	ASN_STRUCT_FREE(asn_DEF_BasicSafetyMessage, pBSM);
+	freeAsnStruct(asn_DEF_BasicSafetyMessage, pBSM);
 	return(numbits2numbytes(rval.consumed));
 }
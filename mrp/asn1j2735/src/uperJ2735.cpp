@@ -0,0 +1,1396 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+/// UPER codecs that encode and decode the element structures directly, without building the asn1c
+/// structures. Each codec covers the subset of J2735 that AsnJ2735Lib puts on the air and follows the
+/// PER-visible constraints of the asn1c generated types in directory 'asn1' (bit widths, lower bounds,
+/// extension markers and optional member bitmaps), so that the output is identical to uper_encode.
+/// A message outside that subset, or any value that uper_encode would reject, makes the direct codec
+/// return 0 and the call goes to the asn1c codec (AsnJ2735Lib::asn1c) which produces the final result.
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "AsnJ2735Lib.h"
+
+namespace
+{
+	/// UPER bit stream writer on the caller's buffer, most significant bit first.
+	/// The last byte is padded with zero bits
+	class uperWriter
+	{
+		private:
+			uint8_t* buf;
+			size_t   bitsMax;
+			size_t   bitPos;
+			bool     ok;
+		public:
+			uperWriter(uint8_t* buf_, size_t size) : buf(buf_), bitsMax(size * 8), bitPos(0), ok(true) {};
+
+			/// append the lowest 'bits' bits of value, bits <= 32
+			void put(uint32_t value, int bits)
+			{
+				if (!ok || (bitPos + (size_t)bits > bitsMax))
+				{
+					ok = false;
+					return;
+				}
+				while (bits > 0)
+				{
+					uint8_t& byte = buf[bitPos >> 3];
+					int room = 8 - (int)(bitPos & 0x07);
+					if (room == 8)
+						byte = 0;
+					int n = (bits < room) ? bits : room;
+					bits -= n;
+					byte = (uint8_t)(byte | (((value >> bits) & ((1U << n) - 1)) << (room - n)));
+					bitPos += (size_t)n;
+				}
+			};
+			void putBit(bool flag)
+				{put((flag ? 1 : 0), 1);};
+			/// constrained whole number (X.691 #11.5.6), fails when value is out of [lb, ub]
+			void putInt(long value, long lb, long ub, int bits)
+			{
+				if ((value < lb) || (value > ub))
+					ok = false;
+				else
+					put((uint32_t)(value - lb), bits);
+			};
+			void fail(void)
+				{ok = false;};
+			/// bit position of the next put
+			size_t position(void) const
+				{return(bitPos);};
+			/// number of bytes written, 0 on error
+			size_t bytes(void) const
+				{return((ok) ? ((bitPos + 7) >> 3) : 0);};
+	};
+
+	/// UPER bit stream reader, most significant bit first
+	class uperReader
+	{
+		private:
+			const uint8_t* buf;
+			size_t bitsMax;
+			size_t bitPos;
+			bool   ok;
+		public:
+			uperReader(const uint8_t* buf_, size_t size) : buf(buf_), bitsMax(size * 8), bitPos(0), ok(true) {};
+
+			/// read 'bits' bits, bits <= 32. Returns 0 when the stream is exhausted
+			uint32_t get(int bits)
+			{
+				if (!ok || (bitPos + (size_t)bits > bitsMax))
+				{
+					ok = false;
+					return(0);
+				}
+				uint32_t value = 0;
+				while (bits > 0)
+				{
+					int room = 8 - (int)(bitPos & 0x07);
+					int n = (bits < room) ? bits : room;
+					value = (value << n) | ((uint32_t)(buf[bitPos >> 3] >> (room - n)) & ((1U << n) - 1));
+					bits -= n;
+					bitPos += (size_t)n;
+				}
+				return(value);
+			};
+			bool getBit(void)
+				{return(get(1) != 0);};
+			/// constrained whole number, as uper_decode the value is not checked against the upper bound
+			long getInt(long lb, int bits)
+				{return(lb + (long)get(bits));};
+			bool good(void) const
+				{return(ok);};
+			/// number of bytes consumed
+			size_t bytes(void) const
+				{return((bitPos + 7) >> 3);};
+	};
+
+	// J2735 building blocks shared by the messages
+
+	/// IntersectionReferenceID without RoadRegulatorID
+	auto putIntersectionReferenceID = [](uperWriter& w, uint16_t id)->void
+	{
+		w.put(0, 1);     // region absent
+		w.put(id, 16);
+	};
+
+	auto getIntersectionReferenceID = [](uperReader& r)->uint16_t
+	{
+		if (r.getBit())  // RoadRegulatorID
+			r.get(16);
+		return((uint16_t)r.get(16));
+	};
+
+	/// IntersectionAccessPoint, by laneId when known, otherwise by approachId
+	auto putIntersectionAccessPoint = [](uperWriter& w, uint8_t approachId, uint8_t laneId)->void
+	{
+		w.put(0, 1);     // extension
+		if (laneId == 0)
+		{
+			w.put(1, 2);   // approach
+			w.putInt(approachId, 0, 15, 4);
+		}
+		else
+		{
+			w.put(0, 2);   // lane
+			w.put(laneId, 8);
+		}
+	};
+
+	auto getIntersectionAccessPoint = [](uperReader& r, uint8_t& approachId, uint8_t& laneId)->bool
+	{
+		if (r.getBit())
+			return(false);
+		switch(r.get(2))
+		{
+		case 0:
+			laneId = (uint8_t)r.get(8);
+			return(true);
+		case 1:
+			approachId = (uint8_t)r.get(4);
+			return(true);
+		default:  // LaneConnectionID
+			return(false);
+		}
+	};
+
+	/// VehicleID as TemporaryID
+	auto putTemporaryId = [](uperWriter& w, uint32_t vehId)->void
+	{
+		w.put(0, 1);     // entityID
+		w.put(vehId, 32);
+	};
+
+	auto getTemporaryId = [](uperReader& r, uint32_t& vehId)->bool
+	{
+		if (r.getBit()) // StationID
+			return(false);
+		vehId = r.get(32);
+		return(true);
+	};
+
+	/// Position3D
+	auto putPosition3D = [](uperWriter& w, int32_t lat, int32_t lon, bool withElevation, int32_t elevation)->void
+	{
+		w.put(0, 1);     // extension
+		w.putBit(withElevation);
+		w.put(0, 1);     // regional
+		w.putInt(lat, -900000000L, 900000001L, 31);
+		w.putInt(lon, -1799999999L, 1800000001L, 32);
+		if (withElevation)
+			w.putInt(elevation, -4096, 61439, 16);
+	};
+
+	auto getPosition3D = [](uperReader& r, int32_t& lat, int32_t& lon, bool& hasElevation, int32_t& elevation)->bool
+	{
+		if (r.getBit())
+			return(false);
+		hasElevation = r.getBit();
+		if (r.getBit())
+			return(false);
+		lat = static_cast<int32_t>(r.getInt(-900000000L, 31));
+		lon = static_cast<int32_t>(r.getInt(-1799999999L, 32));
+		if (hasElevation)
+			elevation = static_cast<int32_t>(r.getInt(-4096, 16));
+		return(true);
+	};
+
+	/// enumerated index of an ENUMERATED type with values 0..count-1
+	auto putEnum = [](uperWriter& w, unsigned int value, unsigned int count, int bits, bool extensible)->void
+	{
+		if (extensible)
+			w.put(0, 1);
+		if (value >= count)
+			w.fail();
+		else
+			w.put(value, bits);
+	};
+
+	auto getEnum = [](uperReader& r, unsigned int count, int bits, bool extensible, unsigned int& value)->bool
+	{
+		if (extensible && r.getBit())
+			return(false);
+		value = r.get(bits);
+		return(value < count);
+	};
+
+	// MapData
+
+	const int nodeXYbits[] = {10, 11, 12, 13, 14, 16};  // Node-XY-20b .. Node-XY-32b
+
+	bool encodeLane(uperWriter& w, const MapData_element_t& mapDataIn, const approach_element_t& approachStruct,
+		const lane_element_t& laneStruct, uint16_t refLaneWidth)
+	{
+		bool isCrosswalk = (approachStruct.type == MsgEnum::approachType::crosswalk);
+		bool isIngress = ((approachStruct.type == MsgEnum::approachType::inbound) || isCrosswalk);
+		bool isEgress = (approachStruct.type == MsgEnum::approachType::outbound);
+		// GenericLane
+		w.put(0, 1);                              // extension
+		w.put(0, 1);                              // name
+		w.putBit(isIngress);                      // ingressApproach
+		w.putBit(isEgress);                       // egressApproach
+		w.putBit(!isCrosswalk);                   // maneuvers
+		w.putBit(!laneStruct.mpConnectTo.empty());// connectsTo
+		w.put(0, 2);                              // overlays, regional
+		w.put(laneStruct.id, 8);
+		if (isIngress || isEgress)
+			w.putInt(approachStruct.id, 0, 15, 4);
+		// LaneAttributes
+		uint32_t directionalUse = 0;
+		switch(approachStruct.type)
+		{
+		case MsgEnum::approachType::inbound:
+			directionalUse = 0x01;
+			break;
+		case MsgEnum::approachType::outbound:
+			directionalUse = 0x02;
+			break;
+		case MsgEnum::approachType::crosswalk:
+			directionalUse = 0x03;
+			break;
+		}
+		w.put(0, 1);                              // regional
+		w.put(directionalUse, 2);
+		w.put(0, 10);                             // sharedWith
+		w.put(0, 1);                              // LaneTypeAttributes extension
+		if (isCrosswalk)
+		{
+			w.put(1, 3);
+			w.put((uint32_t)(laneStruct.attributes.to_ulong() & 0xFFFF), 16);
+		}
+		else
+		{
+			w.put(0, 3);
+			w.put(0, 1);                            // SIZE(8,...) extension
+			w.put((uint32_t)(laneStruct.attributes.to_ulong() & 0xFF), 8);
+		}
+		if (!isCrosswalk)
+			w.put((uint32_t)(laneStruct.attributes.to_ulong() >> 8), 12);
+		// NodeListXY::NodeSetXY
+		size_t nodeNums = laneStruct.mpNodes.size();
+		if ((nodeNums < 2) || (nodeNums > 63))
+			return(false);
+		w.put(0, 1);                              // NodeListXY extension
+		w.put(0, 1);                              // nodes
+		w.put((uint32_t)(nodeNums - 2), 6);
+		for (auto it = laneStruct.mpNodes.cbegin(); it != laneStruct.mpNodes.cend(); ++it)
+		{
+			const auto& offset_x = it->offset_x;
+			const auto& offset_y = it->offset_y;
+			uint32_t offset_dist = static_cast<uint32_t>(std::sqrt(offset_x * offset_x + offset_y * offset_y));
+			uint32_t choice = (offset_dist <= 511) ? 0 : (offset_dist <= 1023) ? 1 : (offset_dist <= 2047) ? 2
+				: (offset_dist <= 4096) ? 3 : (offset_dist <= 8191) ? 4 : 5;
+			bool withWidth = ((laneStruct.width != refLaneWidth) && (it == laneStruct.mpNodes.cbegin()));
+			int  bits = nodeXYbits[choice];
+			long lb = -(1L << (bits - 1));
+			// NodeXY
+			w.put(0, 1);                            // extension
+			w.putBit(withWidth);                    // attributes
+			w.put(choice, 3);
+			w.putInt(offset_x, lb, -lb - 1, bits);
+			w.putInt(offset_y, lb, -lb - 1, bits);
+			if (withWidth)
+			{ // NodeAttributeSetXY with dWidth only
+				w.put(0, 1);
+				w.put(0x04, 7);
+				w.putInt(laneStruct.width - refLaneWidth, -512, 511, 10);
+			}
+		}
+		// ConnectsToList
+		if (!laneStruct.mpConnectTo.empty())
+		{
+			if (laneStruct.mpConnectTo.size() > 16)
+				return(false);
+			w.put((uint32_t)(laneStruct.mpConnectTo.size() - 1), 4);
+			for (const auto& connStruct : laneStruct.mpConnectTo)
+			{
+				bool withManeuver = (connStruct.laneManeuver != MsgEnum::maneuverType::unavailable);
+				bool isRemote = (connStruct.intersectionId != mapDataIn.id);
+				// Connection
+				w.putBit(isRemote);                   // remoteIntersection
+				w.putBit(laneStruct.controlPhase != 0);  // signalGroup
+				w.put(0, 2);                          // userClass, connectionID
+				// ConnectingLane
+				w.putBit(withManeuver);
+				w.put(connStruct.laneId, 8);
+				if (withManeuver)
+				{
+					uint32_t connecting_maneuvers = 0;
+					switch(connStruct.laneManeuver)
+					{
+					case MsgEnum::maneuverType::uTurn:
+						connecting_maneuvers = 0x08;
+						break;
+					case MsgEnum::maneuverType::leftTurn:
+						connecting_maneuvers = 0x02;
+						break;
+					case MsgEnum::maneuverType::rightTurn:
+						connecting_maneuvers = 0x04;
+						break;
+					case MsgEnum::maneuverType::straightAhead:
+					case MsgEnum::maneuverType::straight:
+						connecting_maneuvers = 0x01;
+						break;
+					default:
+						break;
+					}
+					w.put(connecting_maneuvers, 12);
+				}
+				if (isRemote)
+					putIntersectionReferenceID(w, connStruct.intersectionId);
+				if (laneStruct.controlPhase != 0)
+					w.put(laneStruct.controlPhase, 8);
+			}
+		}
+		return(true);
+	}
+
+	size_t encodeMapData(const MapData_element_t& mapDataIn, uint8_t* buf, size_t size)
+	{
+		if (mapDataIn.speeds.empty() || (mapDataIn.speeds.size() > 32))
+			return(0);
+		uperWriter w(buf, size);
+		// MapData
+		w.put(0, 1);                              // extension
+		w.put(0x50, 8);                           // layerType, intersections
+		w.putInt(mapDataIn.mapVersion, 0, 127, 7);
+		w.put(0, 1);                              // LayerType extension
+		w.put(3, 3);                              // intersectionData
+		w.put((uint32_t)(mapDataIn.speeds.size() - 1), 5);
+		std::vector<uint8_t> approachIndex;
+		uint32_t revision = 0;
+		for (const auto& speed_limit : mapDataIn.speeds)
+		{
+			approachIndex.clear();
+			size_t num_lanes = 0;
+			for (auto it = mapDataIn.mpApproaches.begin(); it != mapDataIn.mpApproaches.end(); ++it)
+			{
+				if ((it->speed_limit == speed_limit) && (!it->mpLanes.empty()))
+				{
+					approachIndex.push_back((uint8_t)(it - mapDataIn.mpApproaches.begin()));
+					num_lanes += it->mpLanes.size();
+				}
+			}
+			if (approachIndex.empty() || (num_lanes > 255))
+				return(0);
+			uint16_t refLaneWidth = mapDataIn.mpApproaches[approachIndex[0]].mpLanes[0].width;
+			bool withSpeedLimit = ((speed_limit > 0) && (speed_limit < MsgEnum::unknown_speed));
+			// IntersectionGeometry
+			w.put(0, 1);                            // extension
+			w.put(0, 1);                            // name
+			w.put(1, 1);                            // laneWidth
+			w.putBit(withSpeedLimit);               // speedLimits
+			w.put(0, 2);                            // preemptPriorityData, regional
+			putIntersectionReferenceID(w, mapDataIn.id);
+			w.putInt(revision++, 0, 127, 7);
+			putPosition3D(w, mapDataIn.geoRef.latitude, mapDataIn.geoRef.longitude,
+				mapDataIn.attributes.test(0), mapDataIn.geoRef.elevation);
+			w.putInt(refLaneWidth, 0, 32767, 15);
+			if (withSpeedLimit)
+			{ // SpeedLimitList with one RegulatorySpeedLimit
+				w.put(0, 4);
+				w.put(0, 1);                          // SpeedLimitType extension
+				w.put(5, 4);                          // vehicleMaxSpeed
+				w.put(speed_limit, 13);
+			}
+			w.put((uint32_t)(num_lanes - 1), 8);
+			for (const auto& i_approach : approachIndex)
+			{
+				const auto& approachStruct = mapDataIn.mpApproaches[i_approach];
+				for (const auto& laneStruct : approachStruct.mpLanes)
+				{
+					if (!encodeLane(w, mapDataIn, approachStruct, laneStruct, refLaneWidth))
+						return(0);
+				}
+			}
+		}
+		return(w.bytes());
+	}
+
+	/// GenericLane as decoded, before the checks of decode_mapdata_payload
+	struct genericLane_t
+	{
+		uint8_t  laneId;
+		bool     hasIngress;
+		bool     hasEgress;
+		uint8_t  ingressApproach;
+		uint8_t  egressApproach;
+		uint8_t  directionalUse;
+		unsigned long laneTypeAttrib;
+		bool     hasManeuvers;
+		unsigned long maneuvers;
+		bool     hasWidth;
+		long     dWidth;
+		bool     hasSignalGroup;     // on the first Connection
+		uint8_t  signalGroup;
+		std::vector<conn_element_t> mpConnectTo;
+		std::vector<node_element_t> mpNodes;
+	};
+
+	bool decodeLane(uperReader& r, uint16_t intersectionId, genericLane_t& lane)
+	{
+		if (r.getBit())
+			return(false);
+		uint32_t opts = r.get(7);
+		if (opts & 0x43)  // name, overlays, regional
+			return(false);
+		lane.hasIngress = ((opts & 0x20) != 0);
+		lane.hasEgress = ((opts & 0x10) != 0);
+		lane.hasManeuvers = ((opts & 0x08) != 0);
+		bool hasConnectsTo = ((opts & 0x04) != 0);
+		lane.laneId = (uint8_t)r.get(8);
+		if (lane.hasIngress)
+			lane.ingressApproach = (uint8_t)r.get(4);
+		if (lane.hasEgress)
+			lane.egressApproach = (uint8_t)r.get(4);
+		// LaneAttributes
+		if (r.getBit())
+			return(false);
+		lane.directionalUse = (uint8_t)r.get(2);
+		r.get(10);                                // sharedWith
+		if (r.getBit())
+			return(false);
+		switch(r.get(3))
+		{
+		case 0:  // vehicle
+			if (r.getBit())
+				return(false);
+			lane.laneTypeAttrib = r.get(8);
+			break;
+		case 1:  // crosswalk
+			lane.laneTypeAttrib = r.get(16);
+			break;
+		default:
+			return(false);
+		}
+		lane.maneuvers = (lane.hasManeuvers) ? r.get(12) : 0;
+		// NodeListXY::NodeSetXY
+		if (r.getBit() || r.getBit())
+			return(false);
+		uint32_t nodeNums = r.get(6) + 2;
+		if (nodeNums > 63)
+			return(false);
+		lane.hasWidth = false;
+		lane.mpNodes.resize(nodeNums);
+		for (uint32_t i = 0; i < nodeNums; i++)
+		{
+			if (r.getBit())
+				return(false);
+			bool hasAttributes = r.getBit();
+			uint32_t choice = r.get(3);
+			if (choice > 5)   // node-LatLon, regional
+				return(false);
+			int  bits = nodeXYbits[choice];
+			long lb = -(1L << (bits - 1));
+			lane.mpNodes[i].offset_x = static_cast<int32_t>(r.getInt(lb, bits));
+			lane.mpNodes[i].offset_y = static_cast<int32_t>(r.getInt(lb, bits));
+			if (hasAttributes)
+			{ // NodeAttributeSetXY, only dWidth and dElevation
+				if (r.getBit())
+					return(false);
+				uint32_t attrOpts = r.get(7);
+				if (attrOpts & 0x79)  // only dWidth and dElevation
+					return(false);
+				if (attrOpts & 0x04)
+				{
+					long dWidth = r.getInt(-512, 10);
+					if (i == 0)
+					{
+						lane.hasWidth = true;
+						lane.dWidth = dWidth;
+					}
+				}
+				if (attrOpts & 0x02)
+					r.get(10);                          // dElevation
+			}
+		}
+		// ConnectsToList
+		lane.hasSignalGroup = false;
+		lane.mpConnectTo.clear();
+		if (hasConnectsTo)
+		{
+			uint32_t connNums = r.get(4) + 1;
+			lane.mpConnectTo.resize(connNums);
+			for (uint32_t i = 0; i < connNums; i++)
+			{
+				uint32_t connOpts = r.get(4);
+				bool hasManeuver = r.getBit();
+				conn_element_t& conn = lane.mpConnectTo[i];
+				conn.laneId = (uint8_t)r.get(8);
+				switch((hasManeuver) ? r.get(12) : 0)
+				{
+				case 0x00:
+					conn.laneManeuver = MsgEnum::maneuverType::unavailable;
+					break;
+				case 0x01:
+					conn.laneManeuver = (lane.directionalUse == 0x01) ?
+						(MsgEnum::maneuverType::straightAhead) : (MsgEnum::maneuverType::straight);
+					break;
+				case 0x02:
+					conn.laneManeuver = MsgEnum::maneuverType::leftTurn;
+					break;
+				case 0x04:
+					conn.laneManeuver = MsgEnum::maneuverType::rightTurn;
+					break;
+				case 0x08:
+					conn.laneManeuver = MsgEnum::maneuverType::uTurn;
+					break;
+				default:
+					conn.laneManeuver = MsgEnum::maneuverType::unavailable;
+					break;
+				}
+				conn.intersectionId = (connOpts & 0x08) ? getIntersectionReferenceID(r) : intersectionId;
+				if (connOpts & 0x04)
+				{
+					uint8_t signalGroup = (uint8_t)r.get(8);
+					if (i == 0)
+					{
+						lane.hasSignalGroup = true;
+						lane.signalGroup = signalGroup;
+					}
+				}
+				if (connOpts & 0x02)
+					r.get(8);                           // userClass
+				if (connOpts & 0x01)
+					r.get(8);                           // connectionID
+			}
+		}
+		return(r.good());
+	}
+
+	size_t decodeMapData(const uint8_t* buf, size_t size, MapData_element_t& mapDataOut)
+	{
+		uperReader r(buf, size);
+		// MapData
+		if (r.getBit())
+			return(0);
+		uint32_t opts = r.get(8);
+		if ((opts & 0x10) == 0)   // IntersectionGeometryList
+			return(0);
+		if (opts & 0x0F)          // roadSegments, dataParameters, restrictionList, regional
+			return(0);
+		if (opts & 0x80)
+			r.get(20);              // timeStamp
+		uint8_t mapVersion = (uint8_t)r.get(7);
+		if (opts & 0x40)
+		{ // LayerType
+			unsigned int layerType;
+			if (!getEnum(r, 8, 3, true, layerType))
+				return(0);
+		}
+		if (opts & 0x20)
+			r.get(7);               // LayerID
+		uint32_t geoNums = r.get(5) + 1;
+
+		mapDataOut.reset();
+		mapDataOut.mapVersion = mapVersion;
+		mapDataOut.mpApproaches.resize(12);
+		mapDataOut.attributes.set(1);
+		genericLane_t lane;
+		for (uint32_t i = 0; i < geoNums; i++)
+		{ // IntersectionGeometry
+			if (r.getBit())
+				return(0);
+			uint32_t geoOpts = r.get(5);
+			if ((geoOpts & 0x13) || ((geoOpts & 0x08) == 0))  // name, preemptPriorityData, regional, or no laneWidth
+				return(0);
+			uint16_t intersectionId = getIntersectionReferenceID(r);
+			r.get(7);               // revision
+			int32_t lat, lon, elevation = 0;
+			bool hasElevation;
+			if (!getPosition3D(r, lat, lon, hasElevation, elevation))
+				return(0);
+			if (i == 0)
+			{
+				mapDataOut.id = intersectionId;
+				mapDataOut.geoRef.latitude = lat;
+				mapDataOut.geoRef.longitude = lon;
+				if (hasElevation && (elevation != MsgEnum::unknown_elevation))
+				{
+					mapDataOut.attributes.set(0);
+					mapDataOut.geoRef.elevation = elevation;
+				}
+				else
+					mapDataOut.geoRef.elevation = 0;
+			}
+			else if (intersectionId != mapDataOut.id)
+				return(0);
+			uint16_t refLaneWidth = (uint16_t)r.get(15);
+			bool hasMaxSpeed = false;
+			uint16_t maxSpeed = 0;
+			if (geoOpts & 0x04)
+			{ // SpeedLimitList
+				uint32_t speedNums = r.get(4) + 1;
+				if (speedNums > 9)
+					return(0);
+				for (uint32_t j = 0; j < speedNums; j++)
+				{
+					unsigned int speedLimitType;
+					if (!getEnum(r, 13, 4, true, speedLimitType))
+						return(0);
+					uint16_t speed = (uint16_t)r.get(13);
+					if (!hasMaxSpeed && (speedLimitType == 5) && (speed != MsgEnum::unknown_speed))
+					{ // vehicleMaxSpeed
+						hasMaxSpeed = true;
+						maxSpeed = speed;
+					}
+				}
+			}
+			// LaneList
+			uint32_t laneNums = r.get(8) + 1;
+			uint16_t speed_limit = MsgEnum::unknown_speed;
+			for (uint32_t j = 0; j < laneNums; j++)
+			{
+				if (!decodeLane(r, mapDataOut.id, lane))
+					return(0);
+				const uint8_t& directionalUse = lane.directionalUse;
+				if ((directionalUse < 0x01) || (directionalUse > 0x03))
+					return(0);
+				if (j == 0)
+				{ // speed limit of the IntersectionGeometry follows the first lane
+					if (directionalUse == 0x03)
+						speed_limit = 0;
+					else if (hasMaxSpeed)
+					{
+						mapDataOut.attributes.set(2);
+						speed_limit = maxSpeed;
+					}
+				}
+				if ((!lane.hasIngress && !lane.hasEgress)
+					|| ((directionalUse != 0x02) && !lane.hasSignalGroup)
+					|| ((directionalUse != 0x03) && !lane.hasManeuvers))
+					return(0);
+				uint8_t approachId = (lane.hasIngress) ? lane.ingressApproach : lane.egressApproach;
+				if ((approachId == 0) || (approachId > 12))
+					return(0);
+				approach_element_t& approachStruct = mapDataOut.mpApproaches[approachId-1];
+				if (approachStruct.id != approachId)
+				{
+					approachStruct.id = approachId;
+					approachStruct.speed_limit = speed_limit;
+					if (std::find(mapDataOut.speeds.begin(), mapDataOut.speeds.end(), speed_limit) == mapDataOut.speeds.end())
+						mapDataOut.speeds.push_back(speed_limit);
+					approachStruct.type = (directionalUse == 0x01) ? MsgEnum::approachType::inbound
+						: (directionalUse == 0x02) ? MsgEnum::approachType::outbound : MsgEnum::approachType::crosswalk;
+				}
+				approachStruct.mpLanes.push_back(lane_element_t());
+				lane_element_t& laneStruct = approachStruct.mpLanes.back();
+				laneStruct.id = lane.laneId;
+				laneStruct.type = (directionalUse == 0x03) ? (MsgEnum::laneType::crosswalk) : (MsgEnum::laneType::traffic);
+				unsigned long allowedManeuvers = (directionalUse == 0x03) ? 0 : lane.maneuvers;
+				laneStruct.attributes = std::bitset<20>(allowedManeuvers << 8 | lane.laneTypeAttrib);
+				laneStruct.width = (lane.hasWidth) ? (uint16_t)(refLaneWidth + lane.dWidth) : refLaneWidth;
+				laneStruct.controlPhase = (lane.hasSignalGroup) ? lane.signalGroup : 0;
+				laneStruct.mpConnectTo.swap(lane.mpConnectTo);
+				laneStruct.mpNodes.swap(lane.mpNodes);
+			}
+		}
+		if (!r.good())
+			return(0);
+		mapDataOut.mapPayload.assign(buf, buf + size);
+		return(r.bytes());
+	}
+
+	// SPaT
+
+	/// overwrite 'bits' bits at bit position 'pos' with the lowest bits of value, bits <= 32
+	void patchBits(uint8_t* buf, size_t pos, uint32_t value, int bits)
+	{
+		while (bits > 0)
+		{
+			int room = 8 - (int)(pos & 0x07);
+			int n = (bits < room) ? bits : room;
+			bits -= n;
+			uint32_t mask = ((1U << n) - 1) << (room - n);
+			buf[pos >> 3] = (uint8_t)((buf[pos >> 3] & ~mask) | (((value >> bits) << (room - n)) & mask));
+			pos += (size_t)n;
+		}
+	}
+
+	/// SPaT fields rewritten by SPaTencoder, indexes to its fieldPos.
+	/// Each signal group (1..16) has spatFieldNums fields starting at spatMovements + spatFieldNums * (signal_group - 1)
+	enum spatField : size_t {spatMsgCnt, spatStatus, spatMinute, spatSecond, spatMovements};
+	enum movementField : size_t {movementState, movementStart, movementMinEnd, movementMaxEnd, spatFieldNums};
+	const size_t spatFieldPosNums = spatMovements + spatFieldNums * 16;
+
+	/// fieldPos, when not null, receives the bit position of the fields that are in the encoding
+	size_t encodeSPaT(const SPAT_element_t& spatIn, uint8_t* buf, size_t size, uint16_t* fieldPos = nullptr)
+	{
+		uint16_t scratchPos[spatFieldPosNums];
+		uint16_t* pos = (fieldPos != nullptr) ? fieldPos : scratchPos;
+		size_t movementNums = spatIn.permittedPhases.count() + spatIn.permittedPedPhases.count();
+		if (movementNums == 0)
+			return(0);
+		bool withMinute = (spatIn.timeStampMinute < MsgEnum::invalid_timeStampMinute);
+		bool withSecond = (spatIn.timeStampSec < 0xFFFF);
+		std::fill(pos, pos + spatFieldPosNums, (uint16_t)0);
+		uperWriter w(buf, size);
+		// SPAT
+		w.put(0, 1);                              // extension
+		w.put(0, 3);                              // timeStamp, name, regional
+		w.put(0, 5);                              // one IntersectionState
+		// IntersectionState
+		w.put(0, 1);                              // extension
+		w.put(0, 1);                              // name
+		w.putBit(withMinute);                     // moy
+		w.putBit(withSecond);                     // timeStamp
+		w.put(0, 3);                              // enabledLanes, maneuverAssistList, regional
+		putIntersectionReferenceID(w, spatIn.id);
+		pos[spatMsgCnt] = (uint16_t)w.position();
+		w.putInt(spatIn.msgCnt, 0, 127, 7);
+		pos[spatStatus] = (uint16_t)w.position();
+		w.put((uint32_t)spatIn.status.to_ulong(), 16);
+		if (withMinute)
+		{
+			pos[spatMinute] = (uint16_t)w.position();
+			w.put(spatIn.timeStampMinute, 20);
+		}
+		if (withSecond)
+		{
+			pos[spatSecond] = (uint16_t)w.position();
+			w.put(spatIn.timeStampSec, 16);
+		}
+		// MovementList
+		w.put((uint32_t)(movementNums - 1), 8);
+		for (int signal_group = 0; signal_group < 16; signal_group++)
+		{
+			if (((signal_group < 8) && !spatIn.permittedPhases.test(signal_group))
+				|| ((signal_group >= 8) && !spatIn.permittedPedPhases.test(signal_group - 8)))
+				continue;
+			const PhaseState_element_t& phaseState = (signal_group < 8) ?
+				spatIn.phaseState[signal_group] : spatIn.pedPhaseState[signal_group - 8];
+			bool withTiming = (phaseState.minEndTime < MsgEnum::unknown_timeDetail);
+			uint16_t* movementPos = &pos[spatMovements + spatFieldNums * (size_t)signal_group];
+			// MovementState
+			w.put(0, 1);                            // extension
+			w.put(0, 3);                            // movementName, maneuverAssistList, regional
+			w.put((uint32_t)(signal_group + 1), 8);
+			w.put(0, 4);                            // one MovementEvent
+			// MovementEvent
+			w.put(0, 1);                            // extension
+			w.putBit(withTiming);                   // timing
+			w.put(0, 2);                            // speeds, regional
+			movementPos[movementState] = (uint16_t)w.position();
+			putEnum(w, static_cast<unsigned int>(phaseState.currState), 10, 4, false);
+			if (withTiming)
+			{ // TimeChangeDetails
+				bool withStart = (phaseState.startTime < MsgEnum::unknown_timeDetail);
+				bool withMax = (phaseState.maxEndTime < MsgEnum::unknown_timeDetail);
+				w.putBit(withStart);
+				w.putBit(withMax);
+				w.put(0, 3);                          // likelyTime, confidence, nextTime
+				if (withStart)
+				{
+					movementPos[movementStart] = (uint16_t)w.position();
+					w.put(phaseState.startTime, 16);
+				}
+				movementPos[movementMinEnd] = (uint16_t)w.position();
+				w.put(phaseState.minEndTime, 16);
+				if (withMax)
+				{
+					movementPos[movementMaxEnd] = (uint16_t)w.position();
+					w.put(phaseState.maxEndTime, 16);
+				}
+			}
+		}
+		return(w.bytes());
+	}
+
+	size_t decodeSPaT(const uint8_t* buf, size_t size, SPAT_element_t& spatOut)
+	{
+		uperReader r(buf, size);
+		// SPAT
+		if (r.getBit() || (r.get(3) != 0) || (r.get(5) != 0))  // optional members, more than one IntersectionState
+			return(0);
+		// IntersectionState
+		if (r.getBit())
+			return(0);
+		uint32_t opts = r.get(6);
+		if (opts & 0x27)          // name, enabledLanes, maneuverAssistList, regional
+			return(0);
+		spatOut.reset();
+		spatOut.id = getIntersectionReferenceID(r);
+		spatOut.msgCnt = (uint8_t)r.get(7);
+		spatOut.status = std::bitset<16>(r.get(16));
+		if (opts & 0x10)
+			spatOut.timeStampMinute = r.get(20);
+		if (opts & 0x08)
+			spatOut.timeStampSec = (uint16_t)r.get(16);
+		uint32_t movementNums = r.get(8) + 1;
+		for (uint32_t i = 0; i < movementNums; i++)
+		{ // MovementState
+			if (r.getBit() || (r.get(3) != 0))
+				return(0);
+			uint32_t signalGroup = r.get(8);
+			if ((signalGroup < 1) || (signalGroup > 2 * 8))
+				return(0);
+			uint32_t eventNums = r.get(4) + 1;
+			int j = static_cast<int>((signalGroup - 1) % 8);
+			PhaseState_element_t& phaseState = (signalGroup > 8) ? spatOut.pedPhaseState[j] : spatOut.phaseState[j];
+			if (signalGroup > 8)
+				spatOut.permittedPedPhases.set(j);
+			else
+				spatOut.permittedPhases.set(j);
+			for (uint32_t k = 0; k < eventNums; k++)
+			{ // MovementEvent, state of the first one
+				if (r.getBit())
+					return(0);
+				uint32_t eventOpts = r.get(3);
+				if (eventOpts & 0x03)  // speeds, regional
+					return(0);
+				unsigned int eventState;
+				if (!getEnum(r, 10, 4, false, eventState))
+					return(0);
+				if (k == 0)
+					phaseState.currState = static_cast<MsgEnum::phaseState>(eventState);
+				if (eventOpts & 0x04)
+				{ // TimeChangeDetails
+					uint32_t timingOpts = r.get(5);
+					uint16_t startTime = (timingOpts & 0x10) ? (uint16_t)r.get(16) : MsgEnum::unknown_timeDetail;
+					uint16_t minEndTime = (uint16_t)r.get(16);
+					uint16_t maxEndTime = (timingOpts & 0x08) ? (uint16_t)r.get(16) : MsgEnum::unknown_timeDetail;
+					if (timingOpts & 0x04)
+						r.get(16);                        // likelyTime
+					if (timingOpts & 0x02)
+						r.get(4);                         // confidence
+					if (timingOpts & 0x01)
+						r.get(16);                        // nextTime
+					if (k == 0)
+					{
+						phaseState.minEndTime = minEndTime;
+						if (timingOpts & 0x10)
+							phaseState.startTime = startTime;
+						if (timingOpts & 0x08)
+							phaseState.maxEndTime = maxEndTime;
+					}
+				}
+			}
+		}
+		return((r.good()) ? r.bytes() : 0);
+	}
+
+	// SRM
+
+	size_t encodeSRM(const SRM_element_t& srmIn, uint8_t* buf, size_t size)
+	{
+		if ((srmIn.inApprochId == 0) && (srmIn.inLaneId == 0))
+			return(0);
+		bool withMinute = (srmIn.timeStampMinute < MsgEnum::invalid_timeStampMinute);
+		bool withMsgCnt = (srmIn.msgCnt < 0xFF);
+		bool withETAminute = (srmIn.ETAminute < MsgEnum::invalid_timeStampMinute);
+		bool withETAsec = (srmIn.ETAsec < 0xFFFF);
+		bool withDuration = (srmIn.duration < 0xFFFF);
+		bool withOutBound = !((srmIn.outApproachId == 0) && (srmIn.outLaneId == 0));
+		bool withElevation = (srmIn.elevation > MsgEnum::unknown_elevation);
+		uperWriter w(buf, size);
+		// SignalRequestMessage
+		w.put(0, 1);                              // extension
+		w.putBit(withMinute);                     // timeStamp
+		w.putBit(withMsgCnt);                     // sequenceNumber
+		w.put(1, 1);                              // requests
+		w.put(0, 1);                              // regional
+		if (withMinute)
+			w.put(srmIn.timeStampMinute, 20);
+		w.put(srmIn.timeStampSec, 16);
+		if (withMsgCnt)
+			w.putInt(srmIn.msgCnt, 0, 127, 7);
+		w.put(0, 5);                              // one SignalRequestPackage
+		// SignalRequestPackage
+		w.put(0, 1);                              // extension
+		w.putBit(withETAminute);                  // minute
+		w.putBit(withETAsec);                     // second
+		w.putBit(withDuration);                   // duration
+		w.put(0, 1);                              // regional
+		// SignalRequest
+		w.put(0, 1);                              // extension
+		w.putBit(withOutBound);                   // outBoundLane
+		w.put(0, 1);                              // regional
+		putIntersectionReferenceID(w, srmIn.intId);
+		w.put(srmIn.reqId, 8);
+		putEnum(w, static_cast<unsigned int>(srmIn.reqType), 4, 2, true);
+		putIntersectionAccessPoint(w, srmIn.inApprochId, srmIn.inLaneId);
+		if (withOutBound)
+			putIntersectionAccessPoint(w, srmIn.outApproachId, srmIn.outLaneId);
+		if (withETAminute)
+			w.put(srmIn.ETAminute, 20);
+		if (withETAsec)
+			w.put(srmIn.ETAsec, 16);
+		if (withDuration)
+			w.put(srmIn.duration, 16);
+		// RequestorDescription
+		w.put(0, 1);                              // extension
+		w.put(0xC0, 8);                           // type, position
+		putTemporaryId(w, srmIn.vehId);
+		// RequestorType
+		w.put(0, 1);                              // extension
+		w.put(0x02, 5);                           // hpmsType
+		putEnum(w, static_cast<unsigned int>(srmIn.vehRole), 23, 5, true);
+		putEnum(w, static_cast<unsigned int>(srmIn.vehType), 16, 4, true);
+		// RequestorPositionVector
+		w.put(0, 1);                              // extension
+		w.put(0x03, 2);                           // heading, speed
+		putPosition3D(w, srmIn.latitude, srmIn.longitude, withElevation, srmIn.elevation);
+		w.putInt(srmIn.heading, 0, 28800, 15);
+		putEnum(w, static_cast<unsigned int>(srmIn.transState), 8, 3, false);
+		w.putInt(srmIn.speed, 0, 8191, 13);
+		return(w.bytes());
+	}
+
+	size_t decodeSRM(const uint8_t* buf, size_t size, SRM_element_t& srmOut)
+	{
+		uperReader r(buf, size);
+		// SignalRequestMessage
+		if (r.getBit())
+			return(0);
+		uint32_t opts = r.get(4);
+		if ((opts & 0x03) != 0x02)  // requests without regional
+			return(0);
+		srmOut.reset();
+		if (opts & 0x08)
+			srmOut.timeStampMinute = r.get(20);
+		srmOut.timeStampSec = (uint16_t)r.get(16);
+		if (opts & 0x04)
+			srmOut.msgCnt = (uint8_t)r.get(7);
+		if (r.get(5) != 0)          // one SignalRequestPackage
+			return(0);
+		// SignalRequestPackage
+		if (r.getBit())
+			return(0);
+		uint32_t packageOpts = r.get(4);
+		if (packageOpts & 0x01)
+			return(0);
+		// SignalRequest
+		if (r.getBit())
+			return(0);
+		uint32_t requestOpts = r.get(2);
+		if (requestOpts & 0x01)
+			return(0);
+		srmOut.intId = getIntersectionReferenceID(r);
+		srmOut.reqId = (uint8_t)r.get(8);
+		unsigned int reqType;
+		if (!getEnum(r, 4, 2, true, reqType))
+			return(0);
+		srmOut.reqType = static_cast<MsgEnum::requestType>(reqType);
+		if (!getIntersectionAccessPoint(r, srmOut.inApprochId, srmOut.inLaneId))
+			return(0);
+		if ((requestOpts & 0x02) && !getIntersectionAccessPoint(r, srmOut.outApproachId, srmOut.outLaneId))
+			return(0);
+		if (packageOpts & 0x08)
+			srmOut.ETAminute = r.get(20);
+		if (packageOpts & 0x04)
+			srmOut.ETAsec = (uint16_t)r.get(16);
+		if (packageOpts & 0x02)
+			srmOut.duration = (uint16_t)r.get(16);
+		// RequestorDescription with type and position only
+		if (r.getBit() || (r.get(8) != 0xC0))
+			return(0);
+		if (!getTemporaryId(r, srmOut.vehId))
+			return(0);
+		// RequestorType with hpmsType only
+		if (r.getBit() || (r.get(5) != 0x02))
+			return(0);
+		unsigned int vehRole, vehType;
+		if (!getEnum(r, 23, 5, true, vehRole) || !getEnum(r, 16, 4, true, vehType))
+			return(0);
+		srmOut.vehRole = static_cast<MsgEnum::basicRole>(vehRole);
+		srmOut.vehType = static_cast<MsgEnum::vehicleType>(vehType);
+		// RequestorPositionVector with heading and speed
+		if (r.getBit() || (r.get(2) != 0x03))
+			return(0);
+		bool hasElevation;
+		if (!getPosition3D(r, srmOut.latitude, srmOut.longitude, hasElevation, srmOut.elevation))
+			return(0);
+		srmOut.heading = (uint16_t)r.get(15);
+		unsigned int transState;
+		if (!getEnum(r, 8, 3, false, transState))
+			return(0);
+		srmOut.transState = static_cast<MsgEnum::transGear>(transState);
+		srmOut.speed = (uint16_t)r.get(13);
+		return((r.good()) ? r.bytes() : 0);
+	}
+
+	// SSM
+
+	size_t encodeSSM(const SSM_element_t& ssmIn, uint8_t* buf, size_t size)
+	{
+		if (ssmIn.mpSignalRequetStatus.empty() || (ssmIn.mpSignalRequetStatus.size() > 32))
+			return(0);
+		bool withMinute = (ssmIn.timeStampMinute < MsgEnum::invalid_timeStampMinute);
+		bool withMsgCnt = (ssmIn.msgCnt < 0xFF);
+		uperWriter w(buf, size);
+		// SignalStatusMessage
+		w.put(0, 1);                              // extension
+		w.putBit(withMinute);                     // timeStamp
+		w.putBit(withMsgCnt);                     // sequenceNumber
+		w.put(0, 1);                              // regional
+		if (withMinute)
+			w.put(ssmIn.timeStampMinute, 20);
+		w.put(ssmIn.timeStampSec, 16);
+		if (withMsgCnt)
+			w.putInt(ssmIn.msgCnt, 0, 127, 7);
+		w.put(0, 5);                              // one SignalStatus
+		// SignalStatus
+		w.put(0, 1);                              // extension
+		w.put(0, 1);                              // regional
+		w.putInt(ssmIn.updateCnt, 0, 127, 7);
+		putIntersectionReferenceID(w, ssmIn.id);
+		w.put((uint32_t)(ssmIn.mpSignalRequetStatus.size() - 1), 5);
+		for (const auto& signalRequetStatus : ssmIn.mpSignalRequetStatus)
+		{
+			if ((signalRequetStatus.inApprochId == 0) && (signalRequetStatus.inLaneId == 0))
+				return(0);
+			bool withOutBound = !((signalRequetStatus.outApproachId == 0) && (signalRequetStatus.outLaneId == 0));
+			bool withETAminute = (signalRequetStatus.ETAminute < MsgEnum::invalid_timeStampMinute);
+			bool withETAsec = (signalRequetStatus.ETAsec < 0xFFFF);
+			bool withDuration = (signalRequetStatus.duration < 0xFFFF);
+			bool withRole = (signalRequetStatus.vehRole != MsgEnum::basicRole::unavailable);
+			// SignalStatusPackage
+			w.put(0, 1);                            // extension
+			w.put(1, 1);                            // requester
+			w.putBit(withOutBound);                 // outboundOn
+			w.putBit(withETAminute);                // minute
+			w.putBit(withETAsec);                   // second
+			w.putBit(withDuration);                 // duration
+			w.put(0, 1);                            // regional
+			// SignalRequesterInfo
+			w.put(0, 1);                            // extension
+			w.putBit(withRole);                     // role
+			w.put(0, 1);                            // typeData
+			putTemporaryId(w, signalRequetStatus.vehId);
+			w.put(signalRequetStatus.reqId, 8);
+			w.putInt(signalRequetStatus.sequenceNumber, 0, 127, 7);
+			if (withRole)
+				putEnum(w, static_cast<unsigned int>(signalRequetStatus.vehRole), 23, 5, true);
+			putIntersectionAccessPoint(w, signalRequetStatus.inApprochId, signalRequetStatus.inLaneId);
+			if (withOutBound)
+				putIntersectionAccessPoint(w, signalRequetStatus.outApproachId, signalRequetStatus.outLaneId);
+			if (withETAminute)
+				w.put(signalRequetStatus.ETAminute, 20);
+			if (withETAsec)
+				w.put(signalRequetStatus.ETAsec, 16);
+			if (withDuration)
+				w.put(signalRequetStatus.duration, 16);
+			putEnum(w, static_cast<unsigned int>(signalRequetStatus.status), 8, 3, true);
+		}
+		return(w.bytes());
+	}
+
+	size_t decodeSSM(const uint8_t* buf, size_t size, SSM_element_t& ssmOut)
+	{
+		uperReader r(buf, size);
+		// SignalStatusMessage
+		if (r.getBit())
+			return(0);
+		uint32_t opts = r.get(3);
+		if (opts & 0x01)
+			return(0);
+		ssmOut.reset();
+		if (opts & 0x04)
+			ssmOut.timeStampMinute = r.get(20);
+		ssmOut.timeStampSec = (uint16_t)r.get(16);
+		if (opts & 0x02)
+			ssmOut.msgCnt = (uint8_t)r.get(7);
+		if (r.get(5) != 0)          // one SignalStatus
+			return(0);
+		// SignalStatus
+		if (r.getBit() || r.getBit())
+			return(0);
+		ssmOut.updateCnt = (uint8_t)r.get(7);
+		ssmOut.id = getIntersectionReferenceID(r);
+		uint32_t packageNums = r.get(5) + 1;
+		ssmOut.mpSignalRequetStatus.resize(packageNums);
+		for (auto& signalRequetStatus : ssmOut.mpSignalRequetStatus)
+		{ // SignalStatusPackage
+			signalRequetStatus.reset();
+			if (r.getBit())
+				return(0);
+			uint32_t packageOpts = r.get(6);
+			if ((packageOpts & 0x21) != 0x20)   // requester without regional
+				return(0);
+			// SignalRequesterInfo with role only
+			if (r.getBit() || (r.get(2) != 0x02))
+				return(0);
+			if (!getTemporaryId(r, signalRequetStatus.vehId))
+				return(0);
+			signalRequetStatus.reqId = (uint8_t)r.get(8);
+			signalRequetStatus.sequenceNumber = (uint8_t)r.get(7);
+			unsigned int vehRole, status;
+			if (!getEnum(r, 23, 5, true, vehRole))
+				return(0);
+			signalRequetStatus.vehRole = static_cast<MsgEnum::basicRole>(vehRole);
+			if (!getIntersectionAccessPoint(r, signalRequetStatus.inApprochId, signalRequetStatus.inLaneId))
+				return(0);
+			if ((packageOpts & 0x10)
+					&& !getIntersectionAccessPoint(r, signalRequetStatus.outApproachId, signalRequetStatus.outLaneId))
+				return(0);
+			if (packageOpts & 0x08)
+				signalRequetStatus.ETAminute = r.get(20);
+			if (packageOpts & 0x04)
+				signalRequetStatus.ETAsec = (uint16_t)r.get(16);
+			if (packageOpts & 0x02)
+				signalRequetStatus.duration = (uint16_t)r.get(16);
+			if (!getEnum(r, 8, 3, true, status))
+				return(0);
+			signalRequetStatus.status = static_cast<MsgEnum::requestStatus>(status);
+		}
+		return((r.good()) ? r.bytes() : 0);
+	}
+
+	// BSM
+
+	size_t encodeBSM(const BSM_element_t& bsmIn, uint8_t* buf, size_t size)
+	{
+		uperWriter w(buf, size);
+		// BasicSafetyMessage
+		w.put(0, 1);                              // extension
+		w.put(0, 2);                              // partII, regional
+		// BSMcoreData
+		w.putInt(bsmIn.msgCnt, 0, 127, 7);
+		w.put(bsmIn.id, 32);
+		w.put(bsmIn.timeStampSec, 16);
+		w.putInt(bsmIn.latitude, -900000000L, 900000001L, 31);
+		w.putInt(bsmIn.longitude, -1799999999L, 1800000001L, 32);
+		w.putInt(bsmIn.elevation, -4096, 61439, 16);
+		w.put(bsmIn.semiMajor, 8);
+		w.put(bsmIn.semiMinor, 8);
+		w.put(bsmIn.orientation, 16);
+		putEnum(w, static_cast<unsigned int>(bsmIn.transState), 8, 3, false);
+		w.putInt(bsmIn.speed, 0, 8191, 13);
+		w.putInt(bsmIn.heading, 0, 28800, 15);
+		w.putInt(bsmIn.steeringAngle, -126, 127, 8);
+		w.putInt(bsmIn.accelLon, -2000, 2001, 12);
+		w.putInt(bsmIn.accelLat, -2000, 2001, 12);
+		w.putInt(bsmIn.accelVert, -127, 127, 8);
+		w.putInt(bsmIn.yawRate, -32767, 32767, 16);
+		w.put((uint32_t)bsmIn.brakeAppliedStatus.to_ulong(), 5);
+		putEnum(w, static_cast<unsigned int>(bsmIn.tractionControlStatus), 4, 2, false);
+		putEnum(w, static_cast<unsigned int>(bsmIn.absStatus), 4, 2, false);
+		putEnum(w, static_cast<unsigned int>(bsmIn.stabilityControlStatus), 4, 2, false);
+		putEnum(w, static_cast<unsigned int>(bsmIn.brakeBoostApplied), 3, 2, false);
+		putEnum(w, static_cast<unsigned int>(bsmIn.auxiliaryBrakeStatus), 4, 2, false);
+		w.putInt(bsmIn.vehWidth, 0, 1023, 10);
+		w.putInt(bsmIn.vehLen, 0, 4095, 12);
+		return(w.bytes());
+	}
+
+	/// with coreDataOnly, anything after BSMcoreData (partII, regional, extension additions) is left undecoded
+	/// and the returned size covers BSMcoreData only
+	size_t decodeBSM(const uint8_t* buf, size_t size, BSM_element_t& bsmOut, bool coreDataOnly = false)
+	{
+		uperReader r(buf, size);
+		// BasicSafetyMessage without partII and regional
+		if ((r.get(3) != 0) && !coreDataOnly)
+			return(0);
+		// BSMcoreData
+		bsmOut.msgCnt = (uint8_t)r.get(7);
+		bsmOut.id = r.get(32);
+		bsmOut.timeStampSec = (uint16_t)r.get(16);
+		bsmOut.latitude = static_cast<int32_t>(r.getInt(-900000000L, 31));
+		bsmOut.longitude = static_cast<int32_t>(r.getInt(-1799999999L, 32));
+		bsmOut.elevation = static_cast<int32_t>(r.getInt(-4096, 16));
+		bsmOut.semiMajor = (uint8_t)r.get(8);
+		bsmOut.semiMinor = (uint8_t)r.get(8);
+		bsmOut.orientation = (uint16_t)r.get(16);
+		unsigned int transState, traction, abs, scs, brakeBoost, auxBrakes;
+		if (!getEnum(r, 8, 3, false, transState))
+			return(0);
+		bsmOut.speed = (uint16_t)r.get(13);
+		bsmOut.heading = (uint16_t)r.get(15);
+		bsmOut.steeringAngle = static_cast<int8_t>(r.getInt(-126, 8));
+		bsmOut.accelLon = static_cast<int16_t>(r.getInt(-2000, 12));
+		bsmOut.accelLat = static_cast<int16_t>(r.getInt(-2000, 12));
+		bsmOut.accelVert = static_cast<int8_t>(r.getInt(-127, 8));
+		bsmOut.yawRate = static_cast<int16_t>(r.getInt(-32767, 16));
+		bsmOut.brakeAppliedStatus = std::bitset<5>(r.get(5));
+		if (!getEnum(r, 4, 2, false, traction) || !getEnum(r, 4, 2, false, abs) || !getEnum(r, 4, 2, false, scs)
+				|| !getEnum(r, 3, 2, false, brakeBoost) || !getEnum(r, 4, 2, false, auxBrakes))
+			return(0);
+		bsmOut.vehWidth = (uint16_t)r.get(10);
+		bsmOut.vehLen = (uint16_t)r.get(12);
+		if (!r.good())
+			return(0);
+		bsmOut.transState = static_cast<MsgEnum::transGear>(transState);
+		bsmOut.tractionControlStatus = static_cast<MsgEnum::engageStatus>(traction);
+		bsmOut.absStatus = static_cast<MsgEnum::engageStatus>(abs);
+		bsmOut.stabilityControlStatus = static_cast<MsgEnum::engageStatus>(scs);
+		bsmOut.brakeBoostApplied = static_cast<MsgEnum::engageStatus>(brakeBoost);
+		bsmOut.auxiliaryBrakeStatus = static_cast<MsgEnum::engageStatus>(auxBrakes);
+		return(r.bytes());
+	}
+}
+
+size_t AsnJ2735Lib::encode_mapdata_payload(const MapData_element_t& mapDataIn, uint8_t* buf, size_t size)
+{
+	size_t bytes = encodeMapData(mapDataIn, buf, size);
+	return((bytes > 0) ? bytes : asn1c::encode_mapdata_payload(mapDataIn, buf, size));
+}
+
+size_t AsnJ2735Lib::decode_mapdata_payload(const uint8_t* buf, size_t size, MapData_element_t& mapDataOut)
+{
+	size_t bytes = decodeMapData(buf, size, mapDataOut);
+	return((bytes > 0) ? bytes : asn1c::decode_mapdata_payload(buf, size, mapDataOut));
+}
+
+size_t AsnJ2735Lib::encode_spat_payload(const SPAT_element_t& spatIn, uint8_t* buf, size_t size)
+{
+	size_t bytes = encodeSPaT(spatIn, buf, size);
+	return((bytes > 0) ? bytes : asn1c::encode_spat_payload(spatIn, buf, size));
+}
+
+size_t AsnJ2735Lib::decode_spat_payload(const uint8_t* buf, size_t size, SPAT_element_t& spatOut)
+{
+	size_t bytes = decodeSPaT(buf, size, spatOut);
+	return((bytes > 0) ? bytes : asn1c::decode_spat_payload(buf, size, spatOut));
+}
+
+size_t AsnJ2735Lib::encode_srm_payload(const SRM_element_t& srmIn, uint8_t* buf, size_t size)
+{
+	size_t bytes = encodeSRM(srmIn, buf, size);
+	return((bytes > 0) ? bytes : asn1c::encode_srm_payload(srmIn, buf, size));
+}
+
+size_t AsnJ2735Lib::decode_srm_payload(const uint8_t* buf, size_t size, SRM_element_t& srmOut)
+{
+	size_t bytes = decodeSRM(buf, size, srmOut);
+	return((bytes > 0) ? bytes : asn1c::decode_srm_payload(buf, size, srmOut));
+}
+
+size_t AsnJ2735Lib::encode_ssm_payload(const SSM_element_t& ssmIn, uint8_t* buf, size_t size)
+{
+	size_t bytes = encodeSSM(ssmIn, buf, size);
+	return((bytes > 0) ? bytes : asn1c::encode_ssm_payload(ssmIn, buf, size));
+}
+
+size_t AsnJ2735Lib::decode_ssm_payload(const uint8_t* buf, size_t size, SSM_element_t& ssmOut)
+{
+	size_t bytes = decodeSSM(buf, size, ssmOut);
+	return((bytes > 0) ? bytes : asn1c::decode_ssm_payload(buf, size, ssmOut));
+}
+
+size_t AsnJ2735Lib::encode_bsm_payload(const BSM_element_t& bsmIn, uint8_t* buf, size_t size)
+{
+	size_t bytes = encodeBSM(bsmIn, buf, size);
+	return((bytes > 0) ? bytes : asn1c::encode_bsm_payload(bsmIn, buf, size));
+}
+
+size_t AsnJ2735Lib::decode_bsm_payload(const uint8_t* buf, size_t size, BSM_element_t& bsmOut)
+{
+	size_t bytes = decodeBSM(buf, size, bsmOut);
+	return((bytes > 0) ? bytes : asn1c::decode_bsm_payload(buf, size, bsmOut));
+}
+
+size_t AsnJ2735Lib::decode_bsm_coredata(const uint8_t* buf, size_t size, BSM_element_t& bsmOut)
+{
+	size_t bytes = decodeBSM(buf, size, bsmOut, true);
+	return((bytes > 0) ? bytes : asn1c::decode_bsm_payload(buf, size, bsmOut));
+}
+
+bool AsnJ2735Lib::peek_bsm_header(const uint8_t* buf, size_t size, BSM_header_t& header)
+{ /// BSMcoreData is the first root component of BasicSafetyMessage and has no optional member, so its leading
+	/// fields are at the same positions whether or not the message has the extension bit, partII or regional.
+	/// Positions are constant, each field is read from the bytes that cover it
+	if (size < 16)                            // 3 + 7 + 32 + 16 + 31 + 32 bits
+		return(false);
+	auto field = [buf](size_t pos, int bits)->uint32_t
+	{
+		size_t first = pos >> 3;
+		size_t last = (pos + (size_t)bits - 1) >> 3;
+		uint64_t word = 0;
+		for (size_t i = first; i <= last; i++)
+			word = (word << 8) | buf[i];
+		return((uint32_t)((word >> ((last + 1) * 8 - pos - (size_t)bits)) & ((1ULL << bits) - 1)));
+	};
+	header.msgCnt = (uint8_t)field(3, 7);
+	header.id = field(10, 32);
+	header.timeStampSec = (uint16_t)field(42, 16);
+	header.latitude = static_cast<int32_t>(-900000000L + (long)field(58, 31));
+	header.longitude = static_cast<int32_t>(-1799999999L + (long)field(89, 32));
+	return(true);
+}
+
+AsnJ2735Lib::SPaTencoder::SPaTencoder(void) : fieldPos(spatFieldPosNums, 0), fullNums(0), patchNums(0)
+{
+	spat.reset();
+}
+
+bool AsnJ2735Lib::SPaTencoder::sameLayout(const SPAT_element_t& spatIn) const
+{
+	if ((spatIn.id != spat.id) || (spatIn.permittedPhases != spat.permittedPhases)
+		|| (spatIn.permittedPedPhases != spat.permittedPedPhases)
+		|| ((spatIn.timeStampMinute < MsgEnum::invalid_timeStampMinute) != (fieldPos[spatMinute] > 0))
+		|| ((spatIn.timeStampSec < 0xFFFF) != (fieldPos[spatSecond] > 0)))
+		return(false);
+	for (int signal_group = 0; signal_group < 16; signal_group++)
+	{
+		if (((signal_group < 8) && !spatIn.permittedPhases.test(signal_group))
+			|| ((signal_group >= 8) && !spatIn.permittedPedPhases.test(signal_group - 8)))
+			continue;
+		const PhaseState_element_t& phaseState = (signal_group < 8) ?
+			spatIn.phaseState[signal_group] : spatIn.pedPhaseState[signal_group - 8];
+		const uint16_t* movementPos = &fieldPos[spatMovements + spatFieldNums * (size_t)signal_group];
+		bool withTiming = (phaseState.minEndTime < MsgEnum::unknown_timeDetail);
+		if ((static_cast<unsigned int>(phaseState.currState) >= 10)  // rejected by the encoder
+			|| (withTiming != (movementPos[movementMinEnd] > 0))
+			|| (withTiming && ((phaseState.startTime < MsgEnum::unknown_timeDetail) != (movementPos[movementStart] > 0)))
+			|| (withTiming && ((phaseState.maxEndTime < MsgEnum::unknown_timeDetail) != (movementPos[movementMaxEnd] > 0))))
+			return(false);
+	}
+	return(true);
+}
+
+size_t AsnJ2735Lib::SPaTencoder::encode(const SPAT_element_t& spatIn, uint8_t* buf, size_t size)
+{
+	if (skeleton.empty() || (spatIn.msgCnt > 127) || !sameLayout(spatIn))
+	{ /// rebuild the skeleton. Without one (e.g., direct encoding failed), encode_spat_payload does the work
+		fullNums++;
+		skeleton.clear();
+		size_t bytes = encodeSPaT(spatIn, buf, size, fieldPos.data());
+		if (bytes == 0)
+			return(asn1c::encode_spat_payload(spatIn, buf, size));
+		skeleton.assign(buf, buf + bytes);
+		spat = spatIn;
+		return(bytes);
+	}
+	if (size < skeleton.size())
+		return(0);
+	patchNums++;
+	uint8_t* bytes = skeleton.data();
+	if (spatIn.msgCnt != spat.msgCnt)
+		patchBits(bytes, fieldPos[spatMsgCnt], spatIn.msgCnt, 7);
+	if (spatIn.status != spat.status)
+		patchBits(bytes, fieldPos[spatStatus], (uint32_t)spatIn.status.to_ulong(), 16);
+	if ((fieldPos[spatMinute] > 0) && (spatIn.timeStampMinute != spat.timeStampMinute))
+		patchBits(bytes, fieldPos[spatMinute], spatIn.timeStampMinute, 20);
+	if ((fieldPos[spatSecond] > 0) && (spatIn.timeStampSec != spat.timeStampSec))
+		patchBits(bytes, fieldPos[spatSecond], spatIn.timeStampSec, 16);
+	for (int signal_group = 0; signal_group < 16; signal_group++)
+	{
+		const uint16_t* movementPos = &fieldPos[spatMovements + spatFieldNums * (size_t)signal_group];
+		if (movementPos[movementState] == 0)  // not permitted
+			continue;
+		const PhaseState_element_t& phaseState = (signal_group < 8) ?
+			spatIn.phaseState[signal_group] : spatIn.pedPhaseState[signal_group - 8];
+		const PhaseState_element_t& phaseStatePrev = (signal_group < 8) ?
+			spat.phaseState[signal_group] : spat.pedPhaseState[signal_group - 8];
+		if (phaseState.currState != phaseStatePrev.currState)
+			patchBits(bytes, movementPos[movementState], static_cast<uint32_t>(phaseState.currState), 4);
+		if ((movementPos[movementStart] > 0) && (phaseState.startTime != phaseStatePrev.startTime))
+			patchBits(bytes, movementPos[movementStart], phaseState.startTime, 16);
+		if ((movementPos[movementMinEnd] > 0) && (phaseState.minEndTime != phaseStatePrev.minEndTime))
+			patchBits(bytes, movementPos[movementMinEnd], phaseState.minEndTime, 16);
+		if ((movementPos[movementMaxEnd] > 0) && (phaseState.maxEndTime != phaseStatePrev.maxEndTime))
+			patchBits(bytes, movementPos[movementMaxEnd], phaseState.maxEndTime, 16);
+	}
+	spat = spatIn;
+	std::memcpy(buf, bytes, skeleton.size());
+	return(skeleton.size());
+}
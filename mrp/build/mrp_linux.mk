@@ -13,6 +13,12 @@ UTILS_DIR     := $(MRP_DIR)/utils
 TCI_DIR       := $(MRP_DIR)/tci
 DATAMGR_DIR   := $(MRP_DIR)/dataMgr
 MRPAWARE_DIR  := $(MRP_DIR)/mrpAware
+NMAPCOMP_DIR  := $(MRP_DIR)/nmapCompiler
+CODECBENCH_DIR := $(MRP_DIR)/codecBench
+LOCAWAREBENCH_DIR := $(MRP_DIR)/locAwareBench
+MRPAWAREBENCH_DIR := $(MRP_DIR)/mrpAwareBench
+UTILSBENCH_DIR := $(MRP_DIR)/utilsBench
+DATAMGRBENCH_DIR := $(MRP_DIR)/dataMgrBench
 SCRIPT_DIR    := $(MRP_DIR)/script
 
 MRP_EXEC_DIR  := $(MRP_DIR)/bin
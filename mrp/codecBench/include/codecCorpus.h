@@ -0,0 +1,22 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+/* codecCorpus.h
+ * reading the UPER payload corpus of codecBench and codecCheck: one file per message type,
+ * one hex encoded UPER payload per line, lines starting with '#' are comments.
+ */
+#ifndef _CODEC_CORPUS_H
+#define _CODEC_CORPUS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// append the payloads of corpus file fname to payloads, returns false (with error messages on std::cerr)
+/// when the file can not be read, has a malformed line, or holds no payload
+bool readCorpus(const std::string& fname, std::vector< std::vector<uint8_t> >& payloads);
+
+#endif
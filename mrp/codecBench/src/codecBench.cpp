@@ -0,0 +1,423 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+/* codecBench.cpp
+ * microbenchmark of the AsnJ2735Lib UPER encoding and decoding entry points. Every entry point runs over
+ * the payloads of a corpus directory (map.hex, spat.hex, srm.hex, ssm.hex and bsm.hex, one hex encoded
+ * UPER payload per line, lines starting with '#' are comments). Encoding functions encode the structures
+ * decoded from the corpus. For each entry point the benchmark reports
+ *   - messages per second;
+ *   - percentiles of nanoseconds per call (the cost of reading the clock is subtracted);
+ *   - heap allocations per call (malloc, calloc and realloc, the first pass over the corpus is not counted);
+ *   - peak resident set size of the process after the entry point has run.
+ * Results can be saved into a CSV file and a later run compared against it as a regression baseline.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+#include "AsnJ2735Lib.h"
+#include "codecCorpus.h"
+
+/// count heap allocations of the whole process (including libdsrc and libasn) by interposing on glibc malloc
+static unsigned long long allocCnt = 0;
+
+extern "C"
+{
+	void* __libc_malloc(size_t size);
+	void* __libc_calloc(size_t nmemb, size_t size);
+	void* __libc_realloc(void* ptr, size_t size);
+
+	void* malloc(size_t size) throw()
+	{
+		allocCnt++;
+		return(__libc_malloc(size));
+	}
+	void* calloc(size_t nmemb, size_t size) throw()
+	{
+		allocCnt++;
+		return(__libc_calloc(nmemb, size));
+	}
+	void* realloc(void* ptr, size_t size) throw()
+	{
+		allocCnt++;
+		return(__libc_realloc(ptr, size));
+	}
+}
+
+struct benchCase_t
+{
+	std::string name;
+	size_t msgNums;                      // number of corpus messages
+	std::function<size_t(size_t)> run;   // runs the entry point on the i-th message, returns 0 on failure
+};
+
+struct benchResult_t
+{
+	std::string name;
+	size_t ops;
+	size_t failures;
+	double msgPerSec;
+	double p50;
+	double p90;
+	double p99;
+	double max;
+	double allocPerOp;
+	long   peakRSS;    // in kilobytes
+};
+
+void do_usage(const char* progname)
+{
+	std::cerr << "Usage " << progname << " [options] <corpus directory>" << std::endl;
+	std::cerr << "\t-n number of calls per entry point (default 20000, at least one pass over the corpus)" << std::endl;
+	std::cerr << "\t-f run only entry points whose name contains this string" << std::endl;
+	std::cerr << "\t-o save results into this CSV file" << std::endl;
+	std::cerr << "\t-b compare median ns per call against this CSV file saved by -o" << std::endl;
+	std::cerr << "\t-t regression tolerance in percent for -b (default 10), exit with failure when exceeded" << std::endl;
+	std::cerr << "\t-? print this message" << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+/// decode all payloads with the library, so that encoding entry points have their input structures
+template<class T>
+static bool decodeCorpus(const std::vector< std::vector<uint8_t> >& payloads, std::vector<T>& elements,
+	std::function<size_t(const uint8_t*, size_t, T&)> decoder, const std::string& fname)
+{
+	elements.resize(payloads.size());
+	for (size_t i = 0; i < payloads.size(); i++)
+	{
+		if (decoder(payloads[i].data(), payloads[i].size(), elements[i]) == 0)
+		{
+			std::cerr << "Failed decoding payload " << i + 1 << " in " << fname << std::endl;
+			return(false);
+		}
+	}
+	return(true);
+}
+
+/// SPaTencoder has to produce the same payload as encode_spat_payload, encoding the corpus SPaTs in order
+/// (consecutive controller states of one intersection) patches the skeleton between layout changes
+static bool checkSPaTencoder(const std::vector<SPAT_element_t>& spatElements, const std::vector< std::vector<uint8_t> >& spatPayloads)
+{
+	AsnJ2735Lib::SPaTencoder spatEncoder;
+	std::vector<uint8_t> buf(2000);
+	std::vector<uint8_t> bufFull(2000);
+	size_t mismatches = 0;
+	for (size_t i = 0; i < spatElements.size(); i++)
+	{
+		size_t size = spatEncoder.encode(spatElements[i], buf.data(), buf.size());
+		size_t sizeFull = AsnJ2735Lib::encode_spat_payload(spatElements[i], bufFull.data(), bufFull.size());
+		if ((size == 0) || (size != sizeFull) || (std::memcmp(buf.data(), bufFull.data(), size) != 0)
+			|| (size != spatPayloads[i].size()) || (std::memcmp(buf.data(), spatPayloads[i].data(), size) != 0))
+		{
+			if (mismatches++ == 0)
+				std::cerr << "SPaTencoder output differs from encode_spat_payload on payload " << i + 1 << " in spat.hex" << std::endl;
+		}
+	}
+	std::cout << "SPaTencoder against encode_spat_payload on " << spatElements.size() << " SPaTs: " << spatEncoder.fullEncodes();
+	std::cout << " full, " << spatEncoder.patchedEncodes() << " patched, " << mismatches << " mismatches" << std::endl;
+	return(mismatches == 0);
+}
+
+static benchResult_t runCase(const benchCase_t& benchCase, size_t opsMin, double clockCost)
+{
+	typedef std::chrono::steady_clock clk;
+	benchResult_t result;
+	result.name = benchCase.name;
+	result.failures = 0;
+	/// first pass warms up caches and the asn1c arena, its failures are reported
+	for (size_t i = 0; i < benchCase.msgNums; i++)
+	{
+		if (benchCase.run(i) == 0)
+			result.failures++;
+	}
+	size_t rounds = std::max((size_t)1, (opsMin + benchCase.msgNums - 1) / benchCase.msgNums);
+	std::vector<double> nsPerOp;
+	nsPerOp.reserve(rounds * benchCase.msgNums);
+	unsigned long long allocStart = allocCnt;
+	for (size_t r = 0; r < rounds; r++)
+	{
+		for (size_t i = 0; i < benchCase.msgNums; i++)
+		{
+			auto t0 = clk::now();
+			benchCase.run(i);
+			auto t1 = clk::now();
+			double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() - clockCost;
+			nsPerOp.push_back((ns > 0) ? ns : 0);
+		}
+	}
+	unsigned long long allocs = allocCnt - allocStart;
+	result.ops = nsPerOp.size();
+	double total = 0;
+	for (const auto& ns : nsPerOp)
+		total += ns;
+	std::sort(nsPerOp.begin(), nsPerOp.end());
+	auto percentile = [&nsPerOp](double p)->double
+		{return(nsPerOp[std::min(nsPerOp.size() - 1, (size_t)(p * (double)nsPerOp.size()))]);};
+	result.msgPerSec = (total > 0) ? (double)result.ops * 1e9 / total : 0;
+	result.p50 = percentile(0.50);
+	result.p90 = percentile(0.90);
+	result.p99 = percentile(0.99);
+	result.max = nsPerOp.back();
+	result.allocPerOp = (double)allocs / (double)result.ops;
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	result.peakRSS = usage.ru_maxrss;
+	return(result);
+}
+
+/// cost of reading the steady clock twice, the shortest of a number of empty measurements
+static double measureClockCost(void)
+{
+	typedef std::chrono::steady_clock clk;
+	double cost = 1e9;
+	for (int i = 0; i < 10000; i++)
+	{
+		auto t0 = clk::now();
+		auto t1 = clk::now();
+		cost = std::min(cost, (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+	}
+	return(cost);
+}
+
+static bool readBaseline(const std::string& fname, std::map<std::string, double>& baseline)
+{
+	std::ifstream IS_F(fname);
+	if (!IS_F.is_open())
+	{
+		std::cerr << "Failed open " << fname << std::endl;
+		return(false);
+	}
+	std::string line;
+	std::getline(IS_F, line);  // header
+	while (std::getline(IS_F, line))
+	{
+		std::istringstream iss(line);
+		std::string name, field;
+		std::vector<std::string> fields;
+		std::getline(iss, name, ',');
+		while (std::getline(iss, field, ','))
+			fields.push_back(field);
+		if (fields.size() >= 4)
+			baseline[name] = strtod(fields[2].c_str(), NULL);  // p50
+	}
+	return(true);
+}
+
+int main(int argc, char** argv)
+{
+	int option;
+	size_t opsMin = 20000;
+	std::string filter;
+	std::string resultFile;
+	std::string baselineFile;
+	double tolerance = 10.0;
+
+	while ((option = getopt(argc, argv, "n:f:o:b:t:?")) != EOF)
+	{
+		switch(option)
+		{
+		case 'n':
+			opsMin = (size_t)strtoul(optarg, NULL, 10);
+			break;
+		case 'f':
+			filter = std::string(optarg);
+			break;
+		case 'o':
+			resultFile = std::string(optarg);
+			break;
+		case 'b':
+			baselineFile = std::string(optarg);
+			break;
+		case 't':
+			tolerance = strtod(optarg, NULL);
+			break;
+		case '?':
+		default:
+			do_usage(argv[0]);
+			break;
+		}
+	}
+	if (optind != argc - 1)
+		do_usage(argv[0]);
+	std::string corpusDir = std::string(argv[optind]);
+
+	/// read corpus
+	std::vector< std::vector<uint8_t> > mapPayloads, spatPayloads, srmPayloads, ssmPayloads, bsmPayloads;
+	if (!readCorpus(corpusDir + "/map.hex", mapPayloads) || !readCorpus(corpusDir + "/spat.hex", spatPayloads)
+		|| !readCorpus(corpusDir + "/srm.hex", srmPayloads) || !readCorpus(corpusDir + "/ssm.hex", ssmPayloads)
+		|| !readCorpus(corpusDir + "/bsm.hex", bsmPayloads))
+		exit(EXIT_FAILURE);
+	std::vector<MapData_element_t> mapElements;
+	std::vector<SPAT_element_t> spatElements;
+	std::vector<SRM_element_t> srmElements;
+	std::vector<SSM_element_t> ssmElements;
+	std::vector<BSM_element_t> bsmElements;
+	if (!decodeCorpus<MapData_element_t>(mapPayloads, mapElements, AsnJ2735Lib::decode_mapdata_payload, "map.hex")
+		|| !decodeCorpus<SPAT_element_t>(spatPayloads, spatElements, AsnJ2735Lib::decode_spat_payload, "spat.hex")
+		|| !decodeCorpus<SRM_element_t>(srmPayloads, srmElements, AsnJ2735Lib::decode_srm_payload, "srm.hex")
+		|| !decodeCorpus<SSM_element_t>(ssmPayloads, ssmElements, AsnJ2735Lib::decode_ssm_payload, "ssm.hex")
+		|| !decodeCorpus<BSM_element_t>(bsmPayloads, bsmElements, AsnJ2735Lib::decode_bsm_payload, "bsm.hex"))
+		exit(EXIT_FAILURE);
+	if (!checkSPaTencoder(spatElements, spatPayloads))
+		exit(EXIT_FAILURE);
+
+	/// entry points. Outputs go to structures and buffers that are reused across calls, as the components do
+	std::vector<uint8_t> buf(8000);
+	MapData_element_t mapOut;
+	SPAT_element_t spatOut;
+	SRM_element_t srmOut;
+	SSM_element_t ssmOut;
+	BSM_element_t bsmOut;
+	BSM_header_t bsmHeader;
+	AsnJ2735Lib::SPaTencoder spatEncoder;
+	std::vector<benchCase_t> benchCases;
+	auto addCase = [&benchCases, &filter](const std::string& name, size_t msgNums, std::function<size_t(size_t)> run)->void
+	{
+		if (filter.empty() || (name.find(filter) != std::string::npos))
+			benchCases.push_back(benchCase_t{name, msgNums, run});
+	};
+	addCase("encode_mapdata_payload", mapElements.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::encode_mapdata_payload(mapElements[i], buf.data(), buf.size()));});
+	addCase("decode_mapdata_payload", mapPayloads.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::decode_mapdata_payload(mapPayloads[i].data(), mapPayloads[i].size(), mapOut));});
+	addCase("asn1c::encode_mapdata_payload", mapElements.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::asn1c::encode_mapdata_payload(mapElements[i], buf.data(), buf.size()));});
+	addCase("asn1c::decode_mapdata_payload", mapPayloads.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::asn1c::decode_mapdata_payload(mapPayloads[i].data(), mapPayloads[i].size(), mapOut));});
+	addCase("encode_spat_payload", spatElements.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::encode_spat_payload(spatElements[i], buf.data(), buf.size()));});
+	addCase("SPaTencoder::encode", spatElements.size(), [&](size_t i)->size_t
+		{return(spatEncoder.encode(spatElements[i], buf.data(), buf.size()));});
+	addCase("decode_spat_payload", spatPayloads.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::decode_spat_payload(spatPayloads[i].data(), spatPayloads[i].size(), spatOut));});
+	addCase("asn1c::encode_spat_payload", spatElements.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::asn1c::encode_spat_payload(spatElements[i], buf.data(), buf.size()));});
+	addCase("asn1c::decode_spat_payload", spatPayloads.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::asn1c::decode_spat_payload(spatPayloads[i].data(), spatPayloads[i].size(), spatOut));});
+	addCase("encode_srm_payload", srmElements.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::encode_srm_payload(srmElements[i], buf.data(), buf.size()));});
+	addCase("decode_srm_payload", srmPayloads.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::decode_srm_payload(srmPayloads[i].data(), srmPayloads[i].size(), srmOut));});
+	addCase("asn1c::encode_srm_payload", srmElements.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::asn1c::encode_srm_payload(srmElements[i], buf.data(), buf.size()));});
+	addCase("asn1c::decode_srm_payload", srmPayloads.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::asn1c::decode_srm_payload(srmPayloads[i].data(), srmPayloads[i].size(), srmOut));});
+	addCase("encode_ssm_payload", ssmElements.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::encode_ssm_payload(ssmElements[i], buf.data(), buf.size()));});
+	addCase("decode_ssm_payload", ssmPayloads.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::decode_ssm_payload(ssmPayloads[i].data(), ssmPayloads[i].size(), ssmOut));});
+	addCase("asn1c::encode_ssm_payload", ssmElements.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::asn1c::encode_ssm_payload(ssmElements[i], buf.data(), buf.size()));});
+	addCase("asn1c::decode_ssm_payload", ssmPayloads.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::asn1c::decode_ssm_payload(ssmPayloads[i].data(), ssmPayloads[i].size(), ssmOut));});
+	addCase("encode_bsm_payload", bsmElements.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::encode_bsm_payload(bsmElements[i], buf.data(), buf.size()));});
+	addCase("decode_bsm_payload", bsmPayloads.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::decode_bsm_payload(bsmPayloads[i].data(), bsmPayloads[i].size(), bsmOut));});
+	addCase("decode_bsm_coredata", bsmPayloads.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::decode_bsm_coredata(bsmPayloads[i].data(), bsmPayloads[i].size(), bsmOut));});
+	addCase("peek_bsm_header", bsmPayloads.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::peek_bsm_header(bsmPayloads[i].data(), bsmPayloads[i].size(), bsmHeader) ? 1 : 0);});
+	addCase("asn1c::encode_bsm_payload", bsmElements.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::asn1c::encode_bsm_payload(bsmElements[i], buf.data(), buf.size()));});
+	addCase("asn1c::decode_bsm_payload", bsmPayloads.size(), [&](size_t i)->size_t
+		{return(AsnJ2735Lib::asn1c::decode_bsm_payload(bsmPayloads[i].data(), bsmPayloads[i].size(), bsmOut));});
+	/// BSM decoders again on the BSMs that carry Part II, the bytes after BSMcoreData
+	std::vector<size_t> partII;
+	for (size_t i = 0; i < bsmPayloads.size(); i++)
+	{
+		size_t coreBytes = AsnJ2735Lib::decode_bsm_coredata(bsmPayloads[i].data(), bsmPayloads[i].size(), bsmOut);
+		if ((coreBytes > 0) && (coreBytes < bsmPayloads[i].size()))
+			partII.push_back(i);
+	}
+	if (!partII.empty())
+	{
+		addCase("decode_bsm_payload/partII", partII.size(), [&](size_t i)->size_t
+			{return(AsnJ2735Lib::decode_bsm_payload(bsmPayloads[partII[i]].data(), bsmPayloads[partII[i]].size(), bsmOut));});
+		addCase("decode_bsm_coredata/partII", partII.size(), [&](size_t i)->size_t
+			{return(AsnJ2735Lib::decode_bsm_coredata(bsmPayloads[partII[i]].data(), bsmPayloads[partII[i]].size(), bsmOut));});
+		addCase("asn1c::decode_bsm_payload/partII", partII.size(), [&](size_t i)->size_t
+			{return(AsnJ2735Lib::asn1c::decode_bsm_payload(bsmPayloads[partII[i]].data(), bsmPayloads[partII[i]].size(), bsmOut));});
+	}
+
+	std::map<std::string, double> baseline;
+	if (!baselineFile.empty() && !readBaseline(baselineFile, baseline))
+		exit(EXIT_FAILURE);
+
+	/// run
+	double clockCost = measureClockCost();
+	std::cout << "corpus " << corpusDir << ": " << mapPayloads.size() << " MAP, " << spatPayloads.size() << " SPaT, ";
+	std::cout << srmPayloads.size() << " SRM, " << ssmPayloads.size() << " SSM, " << bsmPayloads.size() << " BSM";
+	std::cout << ", clock cost " << clockCost << " ns" << std::endl;
+	std::cout << std::left << std::setw(36) << "entry point" << std::right << std::setw(9) << "ops" << std::setw(12) << "msg/s";
+	std::cout << std::setw(10) << "p50 ns" << std::setw(10) << "p90 ns" << std::setw(10) << "p99 ns" << std::setw(11) << "max ns";
+	std::cout << std::setw(11) << "alloc/op" << std::setw(10) << "RSS KB";
+	if (!baseline.empty())
+		std::cout << std::setw(12) << "p50 vs base";
+	std::cout << std::endl;
+	std::vector<benchResult_t> results;
+	bool regressed = false;
+	bool failed = false;
+	for (const auto& benchCase : benchCases)
+	{
+		benchResult_t result = runCase(benchCase, opsMin, clockCost);
+		results.push_back(result);
+		std::cout << std::fixed << std::setprecision(0);
+		std::cout << std::left << std::setw(36) << result.name << std::right << std::setw(9) << result.ops;
+		std::cout << std::setw(12) << result.msgPerSec << std::setw(10) << result.p50 << std::setw(10) << result.p90;
+		std::cout << std::setw(10) << result.p99 << std::setw(11) << result.max;
+		std::cout << std::setprecision(2) << std::setw(11) << result.allocPerOp << std::setw(10) << result.peakRSS;
+		auto it = baseline.find(result.name);
+		if (it != baseline.end() && (it->second > 0))
+		{
+			double change = (result.p50 / it->second - 1.0) * 100.0;
+			std::cout << std::setprecision(1) << std::setw(11) << std::showpos << change << "%" << std::noshowpos;
+			if (change > tolerance)
+				regressed = true;
+		}
+		if (result.failures > 0)
+		{
+			std::cout << "  (" << result.failures << " failures)";
+			failed = true;
+		}
+		std::cout << std::endl;
+	}
+
+	/// save results
+	if (!resultFile.empty())
+	{
+		std::ofstream OS_F(resultFile);
+		if (!OS_F.is_open())
+		{
+			std::cerr << "Failed open " << resultFile << std::endl;
+			exit(EXIT_FAILURE);
+		}
+		OS_F << "entry,ops,msgPerSec,p50,p90,p99,max,allocPerOp,peakRSS" << std::endl;
+		OS_F << std::fixed;
+		for (const auto& result : results)
+		{
+			OS_F << result.name << "," << result.ops << "," << std::setprecision(0) << result.msgPerSec;
+			OS_F << "," << result.p50 << "," << result.p90 << "," << result.p99 << "," << result.max;
+			OS_F << "," << std::setprecision(2) << result.allocPerOp << "," << result.peakRSS << std::endl;
+		}
+		OS_F.close();
+	}
+	if (regressed)
+		std::cout << "median ns per call regressed more than " << tolerance << "% against " << baselineFile << std::endl;
+	exit((regressed || failed) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,578 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+/* codecCheck.cpp
+ * differential check of the direct UPER codecs in AsnJ2735Lib against the asn1c codecs (namespace
+ * AsnJ2735Lib::asn1c) over the payloads of a corpus directory (map.hex, spat.hex, srm.hex, ssm.hex and
+ * bsm.hex), and over mutants of each payload: bit flips, and truncations at every length. For every input
+ *   - the direct and the asn1c decoder have to return the same number of bytes (0 on failure), and when
+ *     decoded, the same structure;
+ *   - the structure decoded by asn1c is encoded by the direct and the asn1c encoder, which have to return
+ *     the same number of bytes (0 on failure) and the same payload.
+ * With -l, every input is also decoded and encoded with the asn1c runtime of a previous libasn build (loaded
+ * with dlopen), which has to return the same result code, the same number of bits and the same payload as the
+ * asn1c runtime of this build, and the PER bit reader and writer of both builds run the same random sequences
+ * of calls, which have to return the same values and leave the same bit positions.
+ * The exit status is a failure on any mismatch.
+ */
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include <asn_application.h>
+#include <per_decoder.h>
+#include <per_encoder.h>
+#include "BasicSafetyMessage.h"
+#include "MapData.h"
+#include "SPAT.h"
+#include "SignalRequestMessage.h"
+#include "SignalStatusMessage.h"
+
+#include "AsnJ2735Lib.h"
+#include "codecCorpus.h"
+
+void do_usage(const char* progname)
+{
+	std::cerr << "Usage " << progname << " [options] <corpus directory>" << std::endl;
+	std::cerr << "\t-n number of bit-flip mutants per payload (default 200)" << std::endl;
+	std::cerr << "\t-s seed of the mutants (default 1)" << std::endl;
+	std::cerr << "\t-l previous libasn.so to compare the asn1c runtime against" << std::endl;
+	std::cerr << "\t-? print this message" << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+/// the codecs report failures on std::cerr, which is silenced while they run on mutants
+class nullBuffer : public std::streambuf
+{
+	protected:
+		int overflow(int c)
+			{return(c);};
+};
+
+/// field by field comparison of decoded structures
+static bool isSame(const BSM_element_t& s1, const BSM_element_t& s2)
+{
+	return((s1.msgCnt == s2.msgCnt) && (s1.id == s2.id) && (s1.timeStampSec == s2.timeStampSec)
+		&& (s1.latitude == s2.latitude) && (s1.longitude == s2.longitude) && (s1.elevation == s2.elevation)
+		&& (s1.semiMajor == s2.semiMajor) && (s1.semiMinor == s2.semiMinor) && (s1.orientation == s2.orientation)
+		&& (s1.vehLen == s2.vehLen) && (s1.vehWidth == s2.vehWidth) && (s1.speed == s2.speed) && (s1.heading == s2.heading)
+		&& (s1.accelLon == s2.accelLon) && (s1.accelLat == s2.accelLat) && (s1.accelVert == s2.accelVert)
+		&& (s1.steeringAngle == s2.steeringAngle) && (s1.yawRate == s2.yawRate) && (s1.brakeAppliedStatus == s2.brakeAppliedStatus)
+		&& (s1.transState == s2.transState) && (s1.tractionControlStatus == s2.tractionControlStatus)
+		&& (s1.absStatus == s2.absStatus) && (s1.stabilityControlStatus == s2.stabilityControlStatus)
+		&& (s1.brakeBoostApplied == s2.brakeBoostApplied) && (s1.auxiliaryBrakeStatus == s2.auxiliaryBrakeStatus));
+}
+
+static bool isSame(const PhaseState_element_t& s1, const PhaseState_element_t& s2)
+{
+	return((s1.currState == s2.currState) && (s1.startTime == s2.startTime)
+		&& (s1.minEndTime == s2.minEndTime) && (s1.maxEndTime == s2.maxEndTime));
+}
+
+static bool isSame(const SPAT_element_t& s1, const SPAT_element_t& s2)
+{
+	if ((s1.id != s2.id) || (s1.msgCnt != s2.msgCnt) || (s1.timeStampMinute != s2.timeStampMinute)
+			|| (s1.timeStampSec != s2.timeStampSec) || (s1.permittedPhases != s2.permittedPhases)
+			|| (s1.permittedPedPhases != s2.permittedPedPhases) || (s1.status != s2.status))
+		return(false);
+	for (int i = 0; i < 8; i++)
+	{
+		if (!isSame(s1.phaseState[i], s2.phaseState[i]) || !isSame(s1.pedPhaseState[i], s2.pedPhaseState[i]))
+			return(false);
+	}
+	return(true);
+}
+
+static bool isSame(const SRM_element_t& s1, const SRM_element_t& s2)
+{
+	return((s1.timeStampMinute == s2.timeStampMinute) && (s1.timeStampSec == s2.timeStampSec) && (s1.msgCnt == s2.msgCnt)
+		&& (s1.intId == s2.intId) && (s1.reqId == s2.reqId) && (s1.inApprochId == s2.inApprochId) && (s1.inLaneId == s2.inLaneId)
+		&& (s1.outApproachId == s2.outApproachId) && (s1.outLaneId == s2.outLaneId) && (s1.ETAminute == s2.ETAminute)
+		&& (s1.ETAsec == s2.ETAsec) && (s1.duration == s2.duration) && (s1.vehId == s2.vehId) && (s1.latitude == s2.latitude)
+		&& (s1.longitude == s2.longitude) && (s1.elevation == s2.elevation) && (s1.heading == s2.heading) && (s1.speed == s2.speed)
+		&& (s1.reqType == s2.reqType) && (s1.vehRole == s2.vehRole) && (s1.vehType == s2.vehType) && (s1.transState == s2.transState));
+}
+
+static bool isSame(const SignalRequetStatus_t& s1, const SignalRequetStatus_t& s2)
+{
+	return((s1.vehId == s2.vehId) && (s1.reqId == s2.reqId) && (s1.sequenceNumber == s2.sequenceNumber)
+		&& (s1.inApprochId == s2.inApprochId) && (s1.inLaneId == s2.inLaneId) && (s1.outApproachId == s2.outApproachId)
+		&& (s1.outLaneId == s2.outLaneId) && (s1.ETAminute == s2.ETAminute) && (s1.ETAsec == s2.ETAsec)
+		&& (s1.duration == s2.duration) && (s1.vehRole == s2.vehRole) && (s1.status == s2.status));
+}
+
+static bool isSame(const SSM_element_t& s1, const SSM_element_t& s2)
+{
+	if ((s1.timeStampMinute != s2.timeStampMinute) || (s1.timeStampSec != s2.timeStampSec) || (s1.msgCnt != s2.msgCnt)
+			|| (s1.updateCnt != s2.updateCnt) || (s1.id != s2.id) || (s1.mpSignalRequetStatus.size() != s2.mpSignalRequetStatus.size()))
+		return(false);
+	for (size_t i = 0; i < s1.mpSignalRequetStatus.size(); i++)
+	{
+		if (!isSame(s1.mpSignalRequetStatus[i], s2.mpSignalRequetStatus[i]))
+			return(false);
+	}
+	return(true);
+}
+
+static bool isSame(const lane_element_t& s1, const lane_element_t& s2)
+{
+	if ((s1.id != s2.id) || (s1.type != s2.type) || (s1.attributes != s2.attributes) || (s1.width != s2.width)
+			|| (s1.controlPhase != s2.controlPhase) || (s1.mpConnectTo.size() != s2.mpConnectTo.size())
+			|| (s1.mpNodes.size() != s2.mpNodes.size()))
+		return(false);
+	for (size_t i = 0; i < s1.mpConnectTo.size(); i++)
+	{
+		if ((s1.mpConnectTo[i].intersectionId != s2.mpConnectTo[i].intersectionId)
+				|| (s1.mpConnectTo[i].laneId != s2.mpConnectTo[i].laneId)
+				|| (s1.mpConnectTo[i].laneManeuver != s2.mpConnectTo[i].laneManeuver))
+			return(false);
+	}
+	for (size_t i = 0; i < s1.mpNodes.size(); i++)
+	{
+		if ((s1.mpNodes[i].offset_x != s2.mpNodes[i].offset_x) || (s1.mpNodes[i].offset_y != s2.mpNodes[i].offset_y))
+			return(false);
+	}
+	return(true);
+}
+
+static bool isSame(const MapData_element_t& s1, const MapData_element_t& s2)
+{
+	if ((s1.id != s2.id) || (s1.mapVersion != s2.mapVersion) || (s1.attributes != s2.attributes)
+			|| (s1.geoRef.latitude != s2.geoRef.latitude) || (s1.geoRef.longitude != s2.geoRef.longitude)
+			|| (s1.geoRef.elevation != s2.geoRef.elevation) || (s1.speeds != s2.speeds) || (s1.mapPayload != s2.mapPayload)
+			|| (s1.mpApproaches.size() != s2.mpApproaches.size()))
+		return(false);
+	for (size_t i = 0; i < s1.mpApproaches.size(); i++)
+	{
+		const auto& app1 = s1.mpApproaches[i];
+		const auto& app2 = s2.mpApproaches[i];
+		if ((app1.id != app2.id) || (app1.speed_limit != app2.speed_limit) || (app1.type != app2.type)
+				|| (app1.mpLanes.size() != app2.mpLanes.size()))
+			return(false);
+		for (size_t j = 0; j < app1.mpLanes.size(); j++)
+		{
+			if (!isSame(app1.mpLanes[j], app2.mpLanes[j]))
+				return(false);
+		}
+	}
+	return(true);
+}
+
+/// the asn1c UPER runtime of a previous libasn build
+class asnBaseline
+{
+	private:
+		void* handle;
+	public:
+		asn_dec_rval_t (*decode)(asn_codec_ctx_t*, asn_TYPE_descriptor_t*, void**, const void*, size_t, int, int);
+		asn_enc_rval_t (*encode)(asn_TYPE_descriptor_t*, void*, void*, size_t);
+		int32_t (*getFewBits)(asn_per_data_t*, int);
+		int (*getManyBits)(asn_per_data_t*, uint8_t*, int, int);
+		int (*putFewBits)(asn_per_outp_t*, uint32_t, int);
+		int (*putManyBits)(asn_per_outp_t*, const uint8_t*, int);
+		asnBaseline(void) : handle(NULL), decode(NULL), encode(NULL),
+			getFewBits(NULL), getManyBits(NULL), putFewBits(NULL), putManyBits(NULL) {};
+		~asnBaseline(void)
+		{
+			if (handle != NULL)
+				dlclose(handle);
+		};
+		/// RTLD_DEEPBIND keeps the calls inside the previous build from binding to the libasn this check links
+		bool load(const std::string& fname)
+		{
+			handle = dlopen(fname.c_str(), RTLD_NOW | RTLD_LOCAL | RTLD_DEEPBIND);
+			if (handle == NULL)
+			{
+				std::cerr << "Failed to load " << fname << ": " << dlerror() << std::endl;
+				return(false);
+			}
+			decode = (decltype(decode))dlsym(handle, "uper_decode");
+			encode = (decltype(encode))dlsym(handle, "uper_encode_to_buffer");
+			getFewBits = (decltype(getFewBits))dlsym(handle, "per_get_few_bits");
+			getManyBits = (decltype(getManyBits))dlsym(handle, "per_get_many_bits");
+			putFewBits = (decltype(putFewBits))dlsym(handle, "per_put_few_bits");
+			putManyBits = (decltype(putManyBits))dlsym(handle, "per_put_many_bits");
+			if ((decode == NULL) || (encode == NULL) || (getFewBits == NULL) || (getManyBits == NULL)
+				|| (putFewBits == NULL) || (putManyBits == NULL))
+			{
+				std::cerr << fname << " does not export the asn1c UPER runtime" << std::endl;
+				return(false);
+			}
+			return(true);
+		};
+		asn_TYPE_descriptor_t* getDef(const std::string& asnType) const
+			{return((asn_TYPE_descriptor_t*)dlsym(handle, ("asn_DEF_" + asnType).c_str()));};
+};
+
+/// encoding and decoding functions of one message type, direct and asn1c
+template<class T>
+struct codecPair_t
+{
+	std::string name;
+	std::string fname;
+	asn_TYPE_descriptor_t* asnDef;
+	std::function<size_t(const uint8_t*, size_t, T&)> decode;
+	std::function<size_t(const uint8_t*, size_t, T&)> decodeAsn1c;
+	std::function<size_t(const T&, uint8_t*, size_t)> encode;
+	std::function<size_t(const T&, uint8_t*, size_t)> encodeAsn1c;
+};
+
+struct checkStats_t
+{
+	size_t payloads;
+	size_t mutants;
+	size_t decodes;    // inputs decoded by both
+	size_t checks;
+	size_t mismatches;
+};
+
+template<class T>
+class codecChecker
+{
+	private:
+		const codecPair_t<T>& codec;
+		const asnBaseline* baseline;
+		asn_TYPE_descriptor_t* baseDef;
+		checkStats_t stats;
+		std::vector<uint8_t> buf;
+		std::vector<uint8_t> bufAsn1c;
+		nullBuffer silent;
+		void report(const std::string& what, const std::string& input, size_t ret, size_t retAsn1c)
+		{
+			if (++stats.mismatches <= 10)
+			{
+				std::cerr << codec.name << " " << what << " mismatch on " << input << ": direct returned " << ret;
+				std::cerr << ", asn1c returned " << retAsn1c << std::endl;
+			}
+		};
+		void reportBaseline(const std::string& what, const std::string& input, int code, size_t bits, int codeBase, size_t bitsBase)
+		{
+			if (++stats.mismatches <= 10)
+			{
+				std::cerr << codec.name << " baseline " << what << " mismatch on " << input << ": returned " << code << "/" << bits;
+				std::cerr << " bits, baseline returned " << codeBase << "/" << bitsBase << " bits" << std::endl;
+			}
+		};
+		/// decode input with the asn1c runtime of this build and of the baseline, and encode each result with its own runtime
+		void checkBaseline(const uint8_t* input, size_t size, const std::string& what)
+		{
+			void* ptr = NULL;
+			void* ptrBase = NULL;
+			asn_dec_rval_t rval = uper_decode(0, codec.asnDef, &ptr, input, size, 0, 0);
+			asn_dec_rval_t rvalBase = baseline->decode(0, baseDef, &ptrBase, input, size, 0, 0);
+			stats.checks++;
+			if ((rval.code != rvalBase.code) || (rval.consumed != rvalBase.consumed))
+				reportBaseline("decode", what, rval.code, rval.consumed, rvalBase.code, rvalBase.consumed);
+			else if (rval.code == RC_OK)
+			{
+				asn_enc_rval_t eval = uper_encode_to_buffer(codec.asnDef, ptr, buf.data(), buf.size());
+				asn_enc_rval_t evalBase = baseline->encode(baseDef, ptrBase, bufAsn1c.data(), bufAsn1c.size());
+				stats.checks++;
+				if ((eval.encoded != evalBase.encoded)
+					|| ((eval.encoded > 0) && (std::memcmp(buf.data(), bufAsn1c.data(), (eval.encoded + 7) / 8) != 0)))
+					reportBaseline("encode", what, 0, eval.encoded, 0, evalBase.encoded);
+			}
+			ASN_STRUCT_FREE(*codec.asnDef, ptr);
+			baseDef->free_struct(baseDef, ptrBase, 0);
+		};
+
+	public:
+		codecChecker(const codecPair_t<T>& codecIn, const asnBaseline* baselineIn, asn_TYPE_descriptor_t* baseDefIn) :
+			codec(codecIn), baseline(baselineIn), baseDef(baseDefIn), stats{0, 0, 0, 0, 0}, buf(8000), bufAsn1c(8000) {};
+		/// decode input with both decoders, and encode the asn1c result with both encoders
+		void check(const uint8_t* input, size_t size, const std::string& what)
+		{
+			if (baseline != NULL)
+				checkBaseline(input, size, what);
+			T element = T();
+			T elementAsn1c = T();
+			std::streambuf* cerrBuf = std::cerr.rdbuf(&silent);
+			size_t ret = codec.decode(input, size, element);
+			size_t retAsn1c = codec.decodeAsn1c(input, size, elementAsn1c);
+			std::cerr.rdbuf(cerrBuf);
+			stats.checks++;
+			if ((ret != retAsn1c) || ((ret > 0) && !isSame(element, elementAsn1c)))
+			{
+				report("decode", what, ret, retAsn1c);
+				return;
+			}
+			if (ret == 0)
+				return;
+			stats.decodes++;
+			cerrBuf = std::cerr.rdbuf(&silent);
+			ret = codec.encode(elementAsn1c, buf.data(), buf.size());
+			retAsn1c = codec.encodeAsn1c(elementAsn1c, bufAsn1c.data(), bufAsn1c.size());
+			std::cerr.rdbuf(cerrBuf);
+			stats.checks++;
+			if ((ret != retAsn1c) || (std::memcmp(buf.data(), bufAsn1c.data(), ret) != 0))
+				report("encode", what, ret, retAsn1c);
+		};
+		/// the payloads, and for each payload mutantNums bit-flip mutants (1 to 3 bits) and all its truncations
+		void run(const std::vector< std::vector<uint8_t> >& payloads, size_t mutantNums, std::mt19937& rng)
+		{
+			for (size_t i = 0; i < payloads.size(); i++)
+			{
+				const auto& payload = payloads[i];
+				std::string where = codec.fname + " payload " + std::to_string(i + 1);
+				stats.payloads++;
+				check(payload.data(), payload.size(), where);
+				if (payload.empty())
+					continue;
+				std::uniform_int_distribution<size_t> bitDist(0, payload.size() * 8 - 1);
+				for (size_t k = 0; k < mutantNums; k++)
+				{
+					std::vector<uint8_t> mutant = payload;
+					size_t flips = 1 + k % 3;
+					std::string bits;
+					for (size_t j = 0; j < flips; j++)
+					{
+						size_t bit = bitDist(rng);
+						mutant[bit / 8] ^= (uint8_t)(0x80 >> (bit % 8));
+						bits += " " + std::to_string(bit);
+					}
+					stats.mutants++;
+					check(mutant.data(), mutant.size(), where + " with flipped bits" + bits);
+				}
+				for (size_t len = 0; len < payload.size(); len++)
+				{
+					stats.mutants++;
+					check(payload.data(), len, where + " truncated to " + std::to_string(len) + " bytes");
+				}
+			}
+		};
+		const checkStats_t& getStats(void) const
+			{return(stats);};
+};
+
+template<class T>
+static bool runCheck(const codecPair_t<T>& codec, const std::string& corpusDir, size_t mutantNums, std::mt19937& rng,
+	const asnBaseline* baseline, size_t& totalChecks)
+{
+	std::vector< std::vector<uint8_t> > payloads;
+	if (!readCorpus(corpusDir + "/" + codec.fname, payloads))
+		return(false);
+	asn_TYPE_descriptor_t* baseDef = NULL;
+	if ((baseline != NULL) && ((baseDef = baseline->getDef(codec.asnDef->name)) == NULL))
+	{
+		std::cerr << "baseline libasn does not export asn_DEF_" << codec.asnDef->name << std::endl;
+		return(false);
+	}
+	codecChecker<T> checker(codec, baseline, baseDef);
+	checker.run(payloads, mutantNums, rng);
+	const auto& stats = checker.getStats();
+	std::cout << std::left << std::setw(8) << codec.name << std::right << std::setw(10) << stats.payloads;
+	std::cout << std::setw(10) << stats.mutants << std::setw(10) << stats.decodes << std::setw(10) << stats.checks;
+	std::cout << std::setw(12) << stats.mismatches << std::endl;
+	totalChecks += stats.checks;
+	return(stats.mismatches == 0);
+}
+
+/// the bit reader and writer may leave (buffer, nboff) unnormalized (nboff of 8 or more),
+/// so positions are compared as bit offsets from the start of the input or of tmpspace
+template<class T>
+static size_t bitPos(const T& per, const uint8_t* start)
+	{return((size_t)(per.buffer - start) * 8 + per.nboff);}
+
+template<class T>
+static size_t bitEnd(const T& per, const uint8_t* start)
+	{return((size_t)(per.buffer - start) * 8 + per.nbits);}
+
+/// the bits written into tmpspace and not flushed yet
+static bool isSameBits(const asn_per_outp_t& po1, const asn_per_outp_t& po2)
+{
+	size_t bits = bitPos(po1, po1.tmpspace);
+	if (std::memcmp(po1.tmpspace, po2.tmpspace, bits / 8) != 0)
+		return(false);
+	uint8_t mask = (uint8_t)(0xFF00 >> (bits % 8));
+	return((bits % 8 == 0) || ((po1.tmpspace[bits / 8] & mask) == (po2.tmpspace[bits / 8] & mask)));
+}
+
+/// PER output callback, appends the flushed octets to a vector
+static int outperAppend(const void* data, size_t size, void* op_key)
+{
+	const uint8_t* ptr = (const uint8_t*)data;
+	((std::vector<uint8_t>*)op_key)->insert(((std::vector<uint8_t>*)op_key)->end(), ptr, ptr + size);
+	return(0);
+}
+
+/// random sequences of per_get_few_bits and per_get_many_bits on random input, and of per_put_few_bits
+/// and per_put_many_bits on random bits, with the runtime of this build and of the baseline
+static bool runBitCheck(const asnBaseline& baseline, size_t sequenceNums, std::mt19937& rng, size_t& totalChecks)
+{
+	std::uniform_int_distribution<int> byteDist(0, 255);
+	std::uniform_int_distribution<int> fewDist(0, 31);
+	std::uniform_int_distribution<int> manyDist(0, 300);
+	size_t checks = 0;
+	size_t mismatches = 0;
+	auto report = [&mismatches](const std::string& what, size_t sequence, size_t step)
+	{
+		if (++mismatches <= 10)
+			std::cerr << "PER " << what << " mismatch in sequence " << sequence << " at call " << step << std::endl;
+	};
+	for (size_t i = 0; i < sequenceNums; i++)
+	{
+		std::vector<uint8_t> input(1 + i % 97);
+		for (auto& c : input)
+			c = (uint8_t)byteDist(rng);
+		asn_per_data_t pd;
+		std::memset(&pd, 0, sizeof(pd));
+		pd.buffer = input.data();
+		pd.nboff = i % 8;
+		pd.nbits = input.size() * 8;
+		asn_per_data_t pdBase = pd;
+		std::vector<uint8_t> dst(40);
+		std::vector<uint8_t> dstBase(40);
+		for (size_t step = 0; pd.nboff < pd.nbits; step++)
+		{
+			bool few = ((byteDist(rng) & 1) == 0);
+			int nbits = few ? fewDist(rng) : manyDist(rng);
+			int rightAlign = byteDist(rng) & 1;
+			int32_t ret, retBase;
+			if (few)
+			{
+				ret = per_get_few_bits(&pd, nbits);
+				retBase = baseline.getFewBits(&pdBase, nbits);
+			}
+			else
+			{
+				std::fill(dst.begin(), dst.end(), 0);
+				std::fill(dstBase.begin(), dstBase.end(), 0);
+				ret = per_get_many_bits(&pd, dst.data(), rightAlign, nbits);
+				retBase = baseline.getManyBits(&pdBase, dstBase.data(), rightAlign, nbits);
+			}
+			checks++;
+			if ((ret != retBase) || (dst != dstBase) || (bitPos(pd, input.data()) != bitPos(pdBase, input.data()))
+				|| (bitEnd(pd, input.data()) != bitEnd(pdBase, input.data())) || (pd.moved != pdBase.moved))
+			{
+				report(few ? "per_get_few_bits" : "per_get_many_bits", i, step);
+				break;
+			}
+			if (ret < 0)
+				break;
+		}
+		std::vector<uint8_t> out, outBase;
+		asn_per_outp_t po;
+		std::memset(&po, 0, sizeof(po));
+		po.buffer = po.tmpspace;
+		po.nbits = 8 * sizeof(po.tmpspace);
+		po.outper = outperAppend;
+		asn_per_outp_t poBase = po;
+		poBase.buffer = poBase.tmpspace;
+		po.op_key = &out;
+		poBase.op_key = &outBase;
+		size_t steps = 1 + i % 61;
+		for (size_t step = 0; step < steps; step++)
+		{
+			bool few = ((byteDist(rng) & 1) == 0);
+			int nbits = few ? fewDist(rng) : manyDist(rng);
+			for (auto& c : dst)
+				c = (uint8_t)byteDist(rng);
+			int ret, retBase;
+			if (few)
+			{
+				uint32_t bits = ((uint32_t)dst[0] << 24) | ((uint32_t)dst[1] << 16) | ((uint32_t)dst[2] << 8) | dst[3];
+				ret = per_put_few_bits(&po, bits, nbits);
+				retBase = baseline.putFewBits(&poBase, bits, nbits);
+			}
+			else
+			{
+				ret = per_put_many_bits(&po, dst.data(), nbits);
+				retBase = baseline.putManyBits(&poBase, dst.data(), nbits);
+			}
+			checks++;
+			if ((ret != retBase) || (out != outBase) || (po.flushed_bytes != poBase.flushed_bytes)
+				|| (bitPos(po, po.tmpspace) != bitPos(poBase, poBase.tmpspace))
+				|| (bitEnd(po, po.tmpspace) != bitEnd(poBase, poBase.tmpspace)) || !isSameBits(po, poBase))
+			{
+				report(few ? "per_put_few_bits" : "per_put_many_bits", i, step);
+				break;
+			}
+		}
+	}
+	std::cout << std::left << std::setw(8) << "PER bits" << std::right << std::setw(10) << 0 << std::setw(10) << sequenceNums;
+	std::cout << std::setw(10) << 0 << std::setw(10) << checks << std::setw(12) << mismatches << std::endl;
+	totalChecks += checks;
+	return(mismatches == 0);
+}
+
+int main(int argc, char** argv)
+{
+	int option;
+	size_t mutantNums = 200;
+	unsigned long seed = 1;
+	std::string baselineLib;
+
+	while ((option = getopt(argc, argv, "n:s:l:?")) != EOF)
+	{
+		switch(option)
+		{
+		case 'n':
+			mutantNums = (size_t)strtoul(optarg, NULL, 10);
+			break;
+		case 's':
+			seed = strtoul(optarg, NULL, 10);
+			break;
+		case 'l':
+			baselineLib = std::string(optarg);
+			break;
+		case '?':
+		default:
+			do_usage(argv[0]);
+			break;
+		}
+	}
+	if (optind != argc - 1)
+		do_usage(argv[0]);
+	std::string corpusDir = std::string(argv[optind]);
+
+	codecPair_t<MapData_element_t> mapCodec{"MAP", "map.hex",
+		&asn_DEF_MapData,
+		AsnJ2735Lib::decode_mapdata_payload, AsnJ2735Lib::asn1c::decode_mapdata_payload,
+		AsnJ2735Lib::encode_mapdata_payload, AsnJ2735Lib::asn1c::encode_mapdata_payload};
+	codecPair_t<SPAT_element_t> spatCodec{"SPaT", "spat.hex",
+		&asn_DEF_SPAT,
+		AsnJ2735Lib::decode_spat_payload, AsnJ2735Lib::asn1c::decode_spat_payload,
+		AsnJ2735Lib::encode_spat_payload, AsnJ2735Lib::asn1c::encode_spat_payload};
+	codecPair_t<SRM_element_t> srmCodec{"SRM", "srm.hex",
+		&asn_DEF_SignalRequestMessage,
+		AsnJ2735Lib::decode_srm_payload, AsnJ2735Lib::asn1c::decode_srm_payload,
+		AsnJ2735Lib::encode_srm_payload, AsnJ2735Lib::asn1c::encode_srm_payload};
+	codecPair_t<SSM_element_t> ssmCodec{"SSM", "ssm.hex",
+		&asn_DEF_SignalStatusMessage,
+		AsnJ2735Lib::decode_ssm_payload, AsnJ2735Lib::asn1c::decode_ssm_payload,
+		AsnJ2735Lib::encode_ssm_payload, AsnJ2735Lib::asn1c::encode_ssm_payload};
+	codecPair_t<BSM_element_t> bsmCodec{"BSM", "bsm.hex",
+		&asn_DEF_BasicSafetyMessage,
+		AsnJ2735Lib::decode_bsm_payload, AsnJ2735Lib::asn1c::decode_bsm_payload,
+		AsnJ2735Lib::encode_bsm_payload, AsnJ2735Lib::asn1c::encode_bsm_payload};
+
+	asnBaseline baseline;
+	if (!baselineLib.empty() && !baseline.load(baselineLib))
+		exit(EXIT_FAILURE);
+	const asnBaseline* pBaseline = baselineLib.empty() ? NULL : &baseline;
+
+	std::mt19937 rng((std::mt19937::result_type)seed);
+	size_t totalChecks = 0;
+	std::cout << std::left << std::setw(8) << "message" << std::right << std::setw(10) << "payloads" << std::setw(10) << "mutants";
+	std::cout << std::setw(10) << "decoded" << std::setw(10) << "checks" << std::setw(12) << "mismatches" << std::endl;
+	bool ret = runCheck(mapCodec, corpusDir, mutantNums, rng, pBaseline, totalChecks);
+	ret = runCheck(spatCodec, corpusDir, mutantNums, rng, pBaseline, totalChecks) && ret;
+	ret = runCheck(srmCodec, corpusDir, mutantNums, rng, pBaseline, totalChecks) && ret;
+	ret = runCheck(ssmCodec, corpusDir, mutantNums, rng, pBaseline, totalChecks) && ret;
+	ret = runCheck(bsmCodec, corpusDir, mutantNums, rng, pBaseline, totalChecks) && ret;
+	if (pBaseline != NULL)
+		ret = runBitCheck(baseline, mutantNums * 10, rng, totalChecks) && ret;
+	std::cout << totalChecks << " checks, " << (ret ? "no mismatch" : "codecs differ") << std::endl;
+	exit(ret ? EXIT_SUCCESS : EXIT_FAILURE);
+}
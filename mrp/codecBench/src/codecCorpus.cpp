@@ -0,0 +1,54 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "codecCorpus.h"
+
+bool readCorpus(const std::string& fname, std::vector< std::vector<uint8_t> >& payloads)
+{
+	std::ifstream IS_F(fname);
+	if (!IS_F.is_open())
+	{
+		std::cerr << "Failed open " << fname << std::endl;
+		return(false);
+	}
+	std::string line;
+	while (std::getline(IS_F, line))
+	{
+		line.erase(std::remove_if(line.begin(), line.end(), [](char c){return(isspace((unsigned char)c) != 0);}), line.end());
+		if (line.empty() || (line[0] == '#'))
+			continue;
+		if ((line.size() % 2) != 0)
+		{
+			std::cerr << "Odd number of hex digits in " << fname << std::endl;
+			return(false);
+		}
+		std::vector<uint8_t> payload(line.size() / 2);
+		for (size_t i = 0; i < payload.size(); i++)
+		{
+			char* end;
+			std::string byteStr = line.substr(2 * i, 2);
+			payload[i] = (uint8_t)strtoul(byteStr.c_str(), &end, 16);
+			if (*end != '\0')
+			{
+				std::cerr << "Invalid hex digits in " << fname << std::endl;
+				return(false);
+			}
+		}
+		payloads.push_back(payload);
+	}
+	if (payloads.empty())
+	{
+		std::cerr << "No payload in " << fname << std::endl;
+		return(false);
+	}
+	return(true);
+}
@@ -9,12 +9,158 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <string>
 #include <vector>
 
 #include "msgDefs.h"
+#include "socketUtils.h"
+#include "statsUtils.h"
 
-size_t packMapMsg(std::vector<uint8_t>& buf, const std::vector<uint8_t>& payload, uint8_t msgid);
-size_t packMapMsg(std::vector<uint8_t>& buf, const std::vector<uint8_t>& payload, uint16_t intersectionID, uint8_t msgtype);
-bool   getApchPerm(msgDefs::apchPerm_t& apchPerm, std::vector<msgDefs::vehTraj_t>& vehTraj, uint8_t speedLimit, bool permitted);
+/// percentiles (p50, p85, p95) of approach performance measures
+struct apchPercentile_t
+{
+	uint16_t travelSpeed[3];  // in mph
+	uint16_t travelTime[3];   // in deciseconds
+	uint16_t delay[3];        // in deciseconds
+};
+
+/// streaming performance measures of an approach (by control phase) from vehicle trajectories (msgid_traj).
+/// Trajectories are accumulated as they arrive into one-minute buckets of the last 15 minutes (count, mean,
+/// variance and histogram of travel speed, travel time and delay), so memory does not depend on traffic,
+/// and measures over the last 1 to 15 completed minutes (e.g., 1, 5 and 15 minutes) are available at any moment.
+class ApchStats
+{
+	public:
+		static const size_t bucketNums = 16;  // 15 completed buckets and the current one
+		static const unsigned long long bucketLen = 60 * 1000LL;  // in milliseconds
+
+	private:
+		struct bucket_t
+		{
+			uint32_t stoppedNums;                // trajectories stopped for 5 seconds or more
+			statsUtils::moments_t speed;         // in m/s
+			statsUtils::moments_t travelTime;    // in deciseconds
+			statsUtils::moments_t delay;         // in deciseconds
+			statsUtils::Histogram speedHist;     // in 0.1 mph
+			statsUtils::Histogram travelTimeHist;
+			statsUtils::Histogram delayHist;
+			void reset(void);
+		};
+		double freeflow_v;                     // in m/s, 0 when the speed limit is unknown
+		statsUtils::WindowRing<bucket_t> ring;
+
+	public:
+		ApchStats(uint8_t speedLimit, unsigned long long now);
+		/// account for a trajectory received at 'now' (monotonic clock in milliseconds)
+		void add(const msgDefs::vehTraj_t& traj, unsigned long long now);
+		/// measures over the whole minutes of the last 'window' milliseconds before the minute of 'now',
+		/// false when there is no valid sample
+		bool getApchPerm(msgDefs::apchPerm_t& apchPerm, apchPercentile_t& percentile,
+			unsigned long long now, unsigned long long window);
+};
+
+/// detector volume and occupancy aggregated over a time range
+struct detAggr_t
+{
+	uint32_t volume;   // vehicle count
+	uint32_t occSum;   // sum of occupancy samples, in 0.5%
+	uint32_t samples;  // number of occupancy samples
+	uint32_t faults;   // number of occupancy samples reporting a detector fault (not in occSum)
+	void reset(void)
+	{
+		volume = 0;
+		occSum = 0;
+		samples = 0;
+		faults = 0;
+	};
+	/// mean occupancy in percent
+	double occupancy(void) const {return((samples > 0) ? (double)occSum / (double)samples / 2.0 : 0.0);};
+};
+
+/// in-memory time series of detector volume and occupancy (msgid_detCnt), in three tiers of fixed-interval
+/// slots: 1 second for the last hour, 1 minute for the last 24 hours and 15 minutes for the last 7 days.
+/// A sample goes into the current slot of every tier, so data is downsampled as it arrives and memory is
+/// fixed whatever the message rate (see memory()). Each tier keeps its columns (volume, occupancy sum,
+/// samples and faults) by detector, a range is aggregated from the finest tier that covers it.
+class DetSeries
+{
+	public:
+		static const size_t tierNums = 3;
+
+	private:
+		struct tier_t
+		{
+			unsigned long long slotLen;  // in milliseconds
+			size_t slotNums;
+			unsigned long long curIdx;   // index of the current slot since the epoch
+			/// columns, slotNums slots of detector 0 followed by those of detector 1 and so on
+			std::vector<uint16_t> volume;
+			std::vector<uint16_t> samples;
+			std::vector<uint16_t> faults;
+			std::vector<uint32_t> occSum;
+			tier_t(unsigned long long slotLen_, size_t slotNums_, size_t detNums, unsigned long long now);
+			/// move the current slot to now, resetting the slots skipped
+			void advance(unsigned long long now, size_t detNums);
+		};
+		size_t detNums;
+		std::vector<tier_t> tiers;
+		int lastSeq;  // seq_num of the last msgid_detCnt message, -1 before the first one
+
+	public:
+		DetSeries(size_t detNums_, unsigned long long now);
+		size_t detectors(void) const {return(detNums);};
+		/// bytes held by the columns
+		size_t memory(void) const;
+		/// account for a sample of detector 'det' received at 'now' (monotonic clock in milliseconds),
+		/// occupancy in 0.5% (0-200), or a detector fault code (above 200)
+		void add(size_t det, uint8_t volume, uint8_t occupancy, unsigned long long now);
+		/// account for the detectors in a msgid_detCnt message, false when it repeats the last seq_num
+		bool add(const msgDefs::count_data_t& cnt, unsigned long long now);
+		/// aggregate of detector 'det' over the last 'window' milliseconds until 'now', from the current slot
+		/// and the window / slotLen whole slots before it of the finest tier that holds the window
+		detAggr_t aggregate(size_t det, unsigned long long now, unsigned long long window);
+		/// aggregates of all detectors
+		void aggregate(std::vector<detAggr_t>& aggr, unsigned long long now, unsigned long long window);
+		/// pack the aggregates of all detectors over each of 'windows' (in milliseconds) until 'now' as an MMITSS
+		/// message: number of windows and of detectors (1 byte each), then for each window its length in seconds
+		/// (4 bytes) followed by volume, occSum, samples and faults (4 bytes each) of each detector.
+		/// Returns the message size, 0 when it does not fit in 'buf'
+		size_t packMsg(std::vector<uint8_t>& buf, uint8_t msgid, uint32_t msOfDay, unsigned long long now,
+			const std::vector<unsigned long long>& windows);
+};
+
+/// responses to poll requests (msgid_pollReq), kept as MMITSS messages ready to send for each requested_msgid.
+/// A response is re-serialized when its data changes, answering a poll only sends the stored datagrams.
+/// A response may span several datagrams (e.g., the timing card).
+class PollSnapshots
+{
+	private:
+		struct snapshot_t
+		{
+			uint8_t msgid;
+			std::vector<uint8_t> data;  // datagrams back to back
+			std::vector<size_t> sizes;  // size of each datagram
+		};
+		std::vector<snapshot_t> snapshots;
+		std::vector<uint8_t> emptyMsg;  // MMITSS header without body, for requested data not available yet
+
+		snapshot_t* find(uint8_t msgid);
+
+	public:
+		/// serve requests for 'msgids'
+		PollSnapshots(const std::vector<uint8_t>& msgids);
+		/// replace the response to msgid with datagram buf
+		void store(uint8_t msgid, const uint8_t* buf, size_t len);
+		/// add datagram buf to the response to msgid
+		void append(uint8_t msgid, const uint8_t* buf, size_t len);
+		/// replace the response to msgid with 'text' split into datagrams of at most bufSize bytes:
+		/// MMITSS header + chunk index (1 byte) + number of chunks (1 byte) + text.
+		/// returns false, leaving the response empty, when text needs more than 255 datagrams
+		bool storeText(uint8_t msgid, const std::string& text, uint32_t msOfDay, size_t bufSize);
+		void clear(uint8_t msgid);
+		/// send the response to msgid to conn (an empty message when there is no data yet),
+		/// returns the number of datagrams sent, 0 when msgid is not served
+		size_t respond(uint8_t msgid, socketUtils::Conn_t conn, uint32_t msOfDay);
+};
 
 #endif
@@ -12,14 +12,16 @@
  * 4. receive UDP messages from MRP_TCI
  *    msgid_cntrlstatus   - encode SPaT, send SPaT to RSE_MessageTX and the pedestrian cloud server
  *                        - forward msgid_cntrlstatus message to MRP_Aware
- *    msgid_detCnt        - log to file, and save in memory for responding to poll request
+ *    msgid_detCnt        - log to file, save in memory for responding to poll request, and add to the
+ *                          detector volume and occupancy time series (DetSeries)
  *    msgid_detPres       - log to file, and save in memory for responding to poll request
  * 5. receive UDP messages from MRP_Aware
  *    msgid_ssm           - forward to RSE_MessageTX (SSM is encoded by MRP_Aware)
  *    msgid_softcall      - forward to MRP_TCI
- *    msgid_traj          - log to file, and save in memory for calculating performance measures
+ *    msgid_traj          - log to file, and accumulate into streaming performance measures (ApchStats)
  * 6. calculate performance measures, and send msgid_perm message to MRP_Aware
- * 7. receive poll request (msgid_pollReq) and send poll response back.
+ * 7. receive poll request (msgid_pollReq) and send poll response back. Responses are kept ready to send
+ *    (PollSnapshots), refreshed when the requested data is received or calculated, so a poll costs one send.
  *    Other MMITSS components can poll data regarding the traffic controller's timing card parameters,
  *    current control mode, performance measures, etc. The type of requested data is identified by
  *    requested_msgid byte inside the poll request message.
@@ -37,6 +39,11 @@
  *    - detector presence (msgid_detPres)
  *    - traffic controller and signal status (msgid_cntrlstatus)
  * MAP data is static therefor it is not logged.
+ * outbound pacing:
+ *    MAP and SPaT payloads are cached in paceUtils::TxSlot. MAP is encoded once and re-broadcast every
+ *    mapInterval, riding along with a SPaT when one goes out within spatInterval. SPaT is encoded from
+ *    the latest controller status only when the pacing (spatInterval, spatBurst) allows sending it.
+ *    Messages to the same destination in one wake-up go out with one sendmmsg call.
  *
  */
 
@@ -47,7 +54,7 @@
 #include <cstddef>
 #include <fstream>
 #include <iostream>
-#include <numeric>
+#include <iterator>
 #include <poll.h>
 #include <string>
 #include <sys/stat.h>
@@ -60,8 +67,10 @@
 #include "AsnJ2735Lib.h"
 #include "locAware.h"
 #include "cnfUtils.h"
+#include "eventUtils.h"
 #include "logUtils.h"
 #include "msgUtils.h"
+#include "paceUtils.h"
 #include "socketUtils.h"
 #include "timeUtils.h"
 #include "timeCard.h"
@@ -125,15 +134,19 @@ int main(int argc, char** argv)
 	}
 	unsigned long long logInterval = pmycnf->getIntegerParaValue(std::string("logInterval")) * 60 * 1000;   // in milliseconds
 	unsigned long long permInterval = pmycnf->getIntegerParaValue(std::string("permInterval")) * 60 * 1000; // in milliseconds
+	if ((permInterval < ApchStats::bucketLen) || (permInterval > ApchStats::bucketLen * (ApchStats::bucketNums - 1)))
+		permInterval = 5 * ApchStats::bucketLen;
 	int logType = pmycnf->getIntegerParaValue(std::string("logType"));
+	bool logCompress = (pmycnf->getIntegerParaValue(std::string("logCompress")) > 0);
+	int mapInterval = pmycnf->getIntegerParaValue(std::string("mapInterval"));    // in milliseconds
+	int spatInterval = pmycnf->getIntegerParaValue(std::string("spatInterval"));  // in milliseconds
+	int spatBurst = pmycnf->getIntegerParaValue(std::string("spatBurst"));
 	logUtils::logType log_type = ((logInterval == 0) || ((logType != 1) && (logType != 2)))
 		? logUtils::logType::none : static_cast<logUtils::logType>(logType);
 	std::string fnmap = pmycnf->getStringParaValue(std::string("nmapFile"));
 	std::string logPath = pmycnf->getStringParaValue(std::string("logPath"));
 	std::string cardName  = pmycnf->getStringParaValue(std::string("timeCardPath"))
 		+ std::string("/") + intersectionName + std::string(".timecard");
-	unsigned long long perm_msec = 0;
-	unsigned long long logfile_msec = 0;
 
 	/// open error log
 	std::ofstream OS_ERR(logPath + std::string("/mgr.err"), std::ofstream::app);
@@ -145,31 +158,22 @@ int main(int argc, char** argv)
 		return(-1);
 	}
 
-	/// open log files
-	std::vector<logUtils::Logfile_t> logFiles;
-	if (log_type != logUtils::logType::none)
+	/// open log files, written by a background thread
+	logUtils::Logger logger(logPath + std::string("/") + intersectionName, logCompress);
+	const size_t sigLog = logger.addChannel(std::string("sig"));          // log controller status message received from MRP_TCI
+	const size_t cntLog = logger.addChannel(std::string("cnt"));          // log count/volume message received from MRP_TCI
+	const size_t presLog = logger.addChannel(std::string("pres"));        // log detector presence message received from MRP_TCI
+	const size_t reqLog = logger.addChannel(std::string("req"));          // log soft-call request message received from MRP_Aware
+	const size_t trajLog = logger.addChannel(std::string("traj"));        // log vehicle trajectory message received from MRP_Aware
+	const size_t permLog = logger.addChannel(std::string("perm"));        // log performance measures
+	const size_t payloadLog = logger.addChannel(std::string("payload"));  // log WSM payload received from
+	if ((log_type != logUtils::logType::none) && !logger.open(fullTimeStamp.localDateTimeStamp.to_fileName()))
 	{
-		std::vector<std::string> logtypes;
-		logtypes.push_back(std::string("sig"));      // log controller status message received from MRP_TCI
-		logtypes.push_back(std::string("cnt"));      // log count/volume message received from MRP_TCI
-		logtypes.push_back(std::string("pres"));     // log detector presence message received from MRP_TCI
-		logtypes.push_back(std::string("req"));      // log soft-call request message received from MRP_Aware
-		logtypes.push_back(std::string("traj"));     // log vehicle trajectory message received from MRP_Aware
-		logtypes.push_back(std::string("perm"));     // log performance measures
-		logtypes.push_back(std::string("payload"));  // log WSM payload received from
-		std::string prefix = logPath + std::string("/") + intersectionName;
-		for (auto& type : logtypes)
-			{logFiles.push_back(logUtils::Logfile_t(prefix, type));}
-		if (!openLogFiles(logFiles, fullTimeStamp.localDateTimeStamp.to_fileName()))
-		{
-			OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-			OS_ERR << ", failed openLogFiles" << std::endl;
-			OS_ERR.close();
-			logUtils::closeLogFiles(logFiles);
-			delete pmycnf;
-			return(-1);
-		}
-		logfile_msec = fullTimeStamp.msec;
+		OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+		OS_ERR << ", failed openLogFiles" << std::endl;
+		OS_ERR.close();
+		delete pmycnf;
+		return(-1);
 	}
 
 	/// instance class LocAware
@@ -180,8 +184,7 @@ int main(int argc, char** argv)
 		OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
 		OS_ERR << ", failed initiating locAwareLib " << fnmap << "(" << intersectionName << ")" << std::endl;
 		OS_ERR.close();
-		if (log_type != logUtils::logType::none)
-			logUtils::closeLogFiles(logFiles);
+		logger.close();
 		delete pmycnf;
 		delete plocAwareLib;
 		return(-1);
@@ -192,17 +195,18 @@ int main(int argc, char** argv)
 	plocAwareLib->getSpeedLimits(speedLimits, intersectionId);
 	delete plocAwareLib;
 
-	/// form message buffer for sending MAP to RSE_MessageTX and Savari pedestrian cloud server
+	/// outbound MAP and SPaT slots: cached payload (after 9 bytes room for the MMITSS or Savari header) and pacing.
+	/// The MAP slot and the outbound batches are sized from the MAP payload, which can exceed bufSize
 	const size_t bufSize = 2000;
-	std::vector<uint8_t> map2RSE(bufSize, 0);
-	std::vector<uint8_t> map2cloud(bufSize, 0);
-	size_t map2RSE_size = packMapMsg(map2RSE, mapPayload, msgUtils::msgid_map);
-	size_t map2cloud_size = packMapMsg(map2cloud, mapPayload, intersectionId, msgUtils::savari_cloud_map);
-	map2RSE.resize(map2RSE_size);
-	map2RSE.shrink_to_fit();
-	map2cloud.resize(map2cloud_size);
-	map2cloud.shrink_to_fit();
-	unsigned long long sentMap_msec = 0;
+	const size_t headerSize = 9;
+	const size_t outSize = std::max(bufSize, mapPayload.size() + headerSize);
+	unsigned long long mapRefresh = (mapInterval > 0) ? (unsigned long long)mapInterval : MsgEnum::mapInterval;
+	unsigned long long spatPace = (spatInterval >= 0) ? (unsigned long long)spatInterval : MsgEnum::spatInterval;
+	paceUtils::TxSlot mapSlot(mapPayload.size() + headerSize, headerSize, mapRefresh, mapRefresh, 1);
+	paceUtils::TxSlot spatSlot(bufSize, headerSize, 0, spatPace, (spatBurst > 0) ? (unsigned long long)spatBurst : 2);
+	/// MAP data is static, version 0 is the only content version
+	std::memcpy(mapSlot.payload(), mapPayload.data(), mapPayload.size());
+	mapSlot.store(mapPayload.size(), 0);
 
 	/// wait until time-card been populated by MRP_TCI
 	if(verbose)
@@ -229,8 +233,7 @@ int main(int argc, char** argv)
 		OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
 		OS_ERR << ", timing card not exist" << std::endl;
 		OS_ERR.close();
-		if (log_type != logUtils::logType::none)
-			logUtils::closeLogFiles(logFiles);
+		logger.close();
 		delete pmycnf;
 		return(-1);
 	}
@@ -248,8 +251,7 @@ int main(int argc, char** argv)
 		OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
 		OS_ERR << ", failed reading timing card: " << cardName << std::endl;
 		OS_ERR.close();
-		if (log_type != logUtils::logType::none)
-			logUtils::closeLogFiles(logFiles);
+		logger.close();
 		delete pmycnf;
 		return(-1);
 	}
@@ -260,8 +262,7 @@ int main(int argc, char** argv)
 		OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
 		OS_ERR << ", failed initiating sockets" << std::endl;
 		OS_ERR.close();
-		if (log_type != logUtils::logType::none)
-			logUtils::closeLogFiles(logFiles);
+		logger.close();
 		delete pmycnf;
 		delete pcard;
 		return(-1);
@@ -283,32 +284,104 @@ int main(int argc, char** argv)
 
 	/* ----------- local variables -------------------------------------*/
 	/// receive & send UDP socket buffer
-	std::vector<uint8_t> recvbuf(bufSize, 0);
+	const size_t batchSize = 64;
+	socketUtils::DgramBatch rxBatch(batchSize, bufSize);     // drains a socket with one recvmmsg call per batch
+	socketUtils::DgramBatch awareRelay(batchSize, bufSize);  // messages forwarded to MRP_Aware, sent with sendmmsg
+	socketUtils::DgramBatch wmeOut(8, outSize);              // MAP, SPaT and SSM to RSE_MessageTX, sent with sendmmsg
+	socketUtils::DgramBatch cloudOut(8, outSize);            // MAP and SPaT to pedestrian cloud server, sent with sendmmsg
 	std::vector<uint8_t> sendbuf(bufSize, 0);
+	/// queue and send outbound messages, failures (datagram larger than the batch buffers, failed send) go to OS_ERR
+	auto queueOut = [&](socketUtils::DgramBatch& batch, socketUtils::Conn_t conn, const uint8_t* buf, size_t len, const char* what)
+	{
+		if (!batch.add(conn, buf, len))
+		{
+			OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+			OS_ERR << ", failed queueing " << what << " of " << len << " bytes" << std::endl;
+		}
+	};
+	auto flushOut = [&](socketUtils::DgramBatch& batch, socketUtils::Conn_t conn, const char* to)
+	{
+		if (!batch.flush(conn))
+		{
+			OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+			OS_ERR << ", failed sending to " << to << std::endl;
+		}
+	};
 
 	/// structures to hold the latest received messages
 	msgDefs::count_data_t det_cnt;
 	msgDefs::pres_data_t  det_pres;
+	/// history of detector volume and occupancy, and its aggregates at the performance measure interval
+	DetSeries detSeries(16, eventUtils::Reactor::now());
+	std::vector<detAggr_t> detAggr;
+	/// windows of the detector aggregates kept for polls (msgid_detAggr): permInterval, 15 minutes, 1 hour, 1 day and 1 week
+	const std::vector<unsigned long long> detAggrWindows = {permInterval, 15ULL * 60 * 1000, 60ULL * 60 * 1000,
+		24ULL * 60 * 60 * 1000, 7ULL * 24 * 60 * 60 * 1000};
 	msgDefs::vehTraj_t veh_traj;
-  /// buffer to hold vehicle trajectory data used for calculating performance measures
-	std::vector< std::vector<msgDefs::vehTraj_t> > a_vehTraj;
-	a_vehTraj.resize(8);  /// by control phase that the trajectory is associated with
+	/// streaming performance measures from vehicle trajectory data, by control phase that the trajectory is associated with
+	std::vector<ApchStats> apchStats;
+	for (int i = 0; i < 8; i++)
+		apchStats.push_back(ApchStats(speedLimits[i], eventUtils::Reactor::now()));
+	apchPercentile_t apchPercentile[8];
 	msgDefs::intPerm_t intPerm;
 
 	/// structure for encoding SPaT
 	msgDefs::controller_state_t cntrl_state;
 	cntrl_state.spatRaw.id = intersectionId;
 	cntrl_state.signalStatus.mode = MsgEnum::controlMode::unavailable;
+	AsnJ2735Lib::SPaTencoder spatEncoder;  // re-encodes only the SPaT fields that changed since the last one
+	unsigned long long spatVersion = 0;    // number of controller status messages received
 
-	/// set up sockets poll structure
-	nfds_t nfds = 3;
-	struct pollfd ufds[3];
-	ufds[0].fd = fd_wmeListen;
-	ufds[1].fd = fd_cloudListen;
-	ufds[2].fd = fd_localhostListen;
-	for (nfds_t i = 0; i < nfds; i++)
-		ufds[i].events = POLLIN;
-	int pollTimeout = 10;   // in milliseconds
+	/// responses to poll requests, the timing card is sent as text split into datagrams.
+	/// MRP_TCI re-writes the timing card when it re-polls the controller, the card text is re-read
+	/// when the modification time or size of the file changed
+	PollSnapshots pollSnapshots({msgUtils::msgid_timeCard, msgUtils::msgid_detCnt, msgUtils::msgid_detPres,
+		msgUtils::msgid_cntrlstatus, msgUtils::msgid_perm, msgUtils::msgid_detAggr});
+	struct stat cardStat;
+	std::memset(&cardStat, 0, sizeof(cardStat));
+	auto loadCard = [&]()
+	{
+		struct stat st;
+		if ((stat(cardName.c_str(), &st) != 0) || (st.st_size == 0))
+			return;
+		if ((st.st_mtim.tv_sec == cardStat.st_mtim.tv_sec) && (st.st_mtim.tv_nsec == cardStat.st_mtim.tv_nsec)
+			&& (st.st_size == cardStat.st_size))
+			return;
+		cardStat = st;
+		std::ifstream IS_TEXT(cardName);
+		std::string cardText((std::istreambuf_iterator<char>(IS_TEXT)), std::istreambuf_iterator<char>());
+		IS_TEXT.close();
+		timeUtils::getFullTimeStamp(fullTimeStamp);
+		if (!pollSnapshots.storeText(msgUtils::msgid_timeCard, cardText, fullTimeStamp.localDateTimeStamp.msOfDay, bufSize))
+		{
+			OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+			OS_ERR << ", timing card " << cardName << " of " << cardText.size();
+			OS_ERR << " bytes needs more than 255 poll response datagrams, not served" << std::endl;
+		}
+		else if (verbose)
+		{
+			std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+			std::cout << ", timing card poll response loaded, " << cardText.size() << " bytes" << std::endl;
+		}
+	};
+	loadCard();
+	unsigned long long pollCnt = 0;
+
+	/// set up reactor to wait on sockets and periodic tasks
+	const size_t nfds = 3;
+	const int listenFds[nfds] = {fd_wmeListen, fd_cloudListen, fd_localhostListen};
+	eventUtils::Reactor reactor;
+	for (size_t i = 0; i < nfds; i++)
+		reactor.addFd(listenFds[i]);
+	size_t mapTimer  = reactor.addTimer(0, 0);  // one-shot, sends MAP when no SPaT carries it along
+	size_t spatTimer = reactor.addTimer(0, 0);  // one-shot, armed while a SPaT waits for pacing
+	reactor.disarmTimer(spatTimer);
+	/// one-shot, armed for the next multiple of permInterval so that reports cover back to back whole minutes
+	size_t permTimer = reactor.addTimer(0, permInterval - eventUtils::Reactor::now() % permInterval);
+	size_t logTimer  = reactor.addTimer(logInterval, logInterval);
+	size_t cardTimer = reactor.addTimer(10000, 10000);  // checks whether the timing card changed
+	if (log_type == logUtils::logType::none)
+		reactor.disarmTimer(logTimer);
 
 	if (verbose)
 	{
@@ -318,190 +391,241 @@ int main(int argc, char** argv)
 
 	while(terminate == 0)
 	{ /// wait for events
-		int retval = poll(ufds, nfds, pollTimeout);
+		int retval = reactor.wait();
 		timeUtils::getFullTimeStamp(fullTimeStamp);
 		if (retval > 0)
 		{
-			for (nfds_t i = 0; i < nfds; i++)
+			for (size_t i = 0; i < nfds; i++)
 			{
-				if ((ufds[i].revents & POLLIN) != POLLIN)
-					continue;
-				ssize_t bytesReceived = recv(ufds[i].fd, (void*)&recvbuf[0], bufSize, 0);
-				if (bytesReceived <= 0)
+				if (!reactor.readable(listenFds[i]))
 					continue;
-				if ((ufds[i].fd == fd_wmeListen) || (ufds[i].fd == fd_localhostListen))
-				{ /// MMITSS header + message body
-					if (bytesReceived >= 9)
-					{
-						size_t offset = 0;
-						msgUtils::mmitss_udp_header_t udpHeader;
-						msgUtils::unpackHeader(recvbuf, offset, udpHeader);
-						if (udpHeader.msgheader == msgUtils::msg_header)
-						{ /// actions based on message ID
-							if ((udpHeader.msgid == msgUtils::msgid_bsm) || (udpHeader.msgid == msgUtils::msgid_srm))
-							{ /// received encoded BSM or SRM from RSE_MessageRX, forward the message to MRP_Aware
-								socketUtils::sendall(awareSend, &recvbuf[0], (size_t)bytesReceived);
-								if (log_type != logUtils::logType::none)
-									logUtils::logMsg(logFiles, std::string("payload"), recvbuf, (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
-								if (verbose)
-								{
-									std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-									std::cout << ", forward " << (udpHeader.msgid == msgUtils::msgid_bsm) ? std::string("BSM") : std::string("SRM");
-									std::cout << " to MRP_Aware"	<< std::endl;
+				while (rxBatch.next(listenFds[i]))
+				{ /// drain all pending datagrams on this socket
+					std::vector<uint8_t>& recvbuf = rxBatch.buf();
+					ssize_t bytesReceived = (ssize_t)rxBatch.len();
+					if (bytesReceived <= 0)
+						continue;
+					if ((listenFds[i] == fd_wmeListen) || (listenFds[i] == fd_localhostListen))
+					{ /// MMITSS header + message body
+						if (bytesReceived >= 9)
+						{
+							size_t offset = 0;
+							msgUtils::mmitss_udp_header_t udpHeader;
+							msgUtils::unpackHeader(recvbuf, offset, udpHeader);
+							if (udpHeader.msgheader == msgUtils::msg_header)
+							{ /// actions based on message ID
+								if ((udpHeader.msgid == msgUtils::msgid_bsm) || (udpHeader.msgid == msgUtils::msgid_srm))
+								{ /// received encoded BSM or SRM from RSE_MessageRX, forward the message to MRP_Aware
+									awareRelay.add(awareSend, &recvbuf[0], (size_t)bytesReceived);
+									if (log_type != logUtils::logType::none)
+										logger.log(payloadLog, &recvbuf[0], (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
+									if (verbose)
+									{
+										std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+										std::cout << ", forward " << (udpHeader.msgid == msgUtils::msgid_bsm) ? std::string("BSM") : std::string("SRM");
+										std::cout << " to MRP_Aware"	<< std::endl;
+									}
 								}
-							}
-							else if (udpHeader.msgid == msgUtils::msgid_detCnt)
-							{ /// received detector volume and occupancy message from MRP_TCI, save in memory
-								det_cnt.ms_since_midnight = udpHeader.ms_since_midnight;
-								msgDefs::unpackMsg(recvbuf, offset, det_cnt);
-								if (log_type == logUtils::logType::detailLog)
-									logUtils::logMsg(logFiles, std::string("cnt"), recvbuf, (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
-							}
-							else if (udpHeader.msgid == msgUtils::msgid_detPres)
-							{ /// received detector presence message from MRP_TCI, save in memory
-								det_pres.ms_since_midnight = udpHeader.ms_since_midnight;
-								msgDefs::unpackMsg(recvbuf, offset, det_pres);
-								if (log_type == logUtils::logType::detailLog)
-									logUtils::logMsg(logFiles, std::string("pres"), recvbuf, (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
-							}
-							else if (udpHeader.msgid == msgUtils::msgid_cntrlstatus)
-							{ /// encode SPaT
-								cntrl_state.ms_since_midnight = udpHeader.ms_since_midnight;
-								msgDefs::unpackMsg(recvbuf, offset, cntrl_state);
-								ssize_t payload_size = AsnJ2735Lib::encode_spat_payload(cntrl_state.spatRaw, &sendbuf[9], bufSize);
-								if (payload_size > 0)
-								{	/// add MMITSS header and send to RSE_MessageTX
-									size_t header_offset = 0;
-									msgUtils::packHeader(sendbuf, header_offset, msgUtils::msgid_spat, fullTimeStamp.localDateTimeStamp.msOfDay, (uint16_t)payload_size);
-									size_t msg_size = (size_t)payload_size + header_offset;
-									socketUtils::sendall(wmeSend, &sendbuf[0], msg_size);
+								else if (udpHeader.msgid == msgUtils::msgid_detCnt)
+								{ /// received detector volume and occupancy message from MRP_TCI, save in memory
+									det_cnt.ms_since_midnight = udpHeader.ms_since_midnight;
+									msgDefs::unpackMsg(recvbuf, offset, det_cnt);
+									detSeries.add(det_cnt, eventUtils::Reactor::now());
+									pollSnapshots.store(udpHeader.msgid, &recvbuf[0], (size_t)bytesReceived);
 									if (log_type == logUtils::logType::detailLog)
-										logUtils::logMsg(logFiles, std::string("payload"), sendbuf, msg_size);
-									/// add Savari header and send to pedestrian cloud server
-									header_offset = 0;
-									msgUtils::packHeader(sendbuf, header_offset, msgUtils::savari_cloud_spat, intersectionId,
-										fullTimeStamp.localDateTimeStamp.msOfDay, (uint16_t)payload_size);
-									msg_size = (size_t)payload_size + header_offset;
-									socketUtils::sendall(cloudSend, &sendbuf[0], msg_size);
-
+										logger.log(cntLog, &recvbuf[0], (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
+								}
+								else if (udpHeader.msgid == msgUtils::msgid_detPres)
+								{ /// received detector presence message from MRP_TCI, save in memory
+									det_pres.ms_since_midnight = udpHeader.ms_since_midnight;
+									msgDefs::unpackMsg(recvbuf, offset, det_pres);
+									pollSnapshots.store(udpHeader.msgid, &recvbuf[0], (size_t)bytesReceived);
+									if (log_type == logUtils::logType::detailLog)
+										logger.log(presLog, &recvbuf[0], (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
+								}
+								else if (udpHeader.msgid == msgUtils::msgid_cntrlstatus)
+								{ /// save in memory, SPaT is encoded from the latest controller status when it is sent
+									cntrl_state.ms_since_midnight = udpHeader.ms_since_midnight;
+									msgDefs::unpackMsg(recvbuf, offset, cntrl_state);
+									spatVersion++;
+									pollSnapshots.store(udpHeader.msgid, &recvbuf[0], (size_t)bytesReceived);
+									/// forward msgid_cntrlstatus message to MRP_Aware
+									awareRelay.add(awareSend, &recvbuf[0], (size_t)bytesReceived);
+									if (log_type == logUtils::logType::detailLog)
+										logger.log(sigLog, &recvbuf[0], (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
+								}
+								else if (udpHeader.msgid == msgUtils::msgid_ssm)
+								{ /// received encoded SSM from MRP_Aware, forward to RSE_MessageTX
+									queueOut(wmeOut, wmeSend, &recvbuf[0], (size_t)bytesReceived, "SSM");
+									if (log_type == logUtils::logType::detailLog)
+										logger.log(payloadLog, &recvbuf[0], (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
 									if (verbose)
 									{
 										std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-										std::cout << ", sent SPaT" << std::endl;
+										std::cout << ", forward SSM to RSE_MessageTX" << std::endl;
 									}
 								}
-								else
-								{
+								else if (udpHeader.msgid == msgUtils::msgid_softcall)
+								{ /// received soft-call request from MRP_Aware, forward to MRP_TCI
+									socketUtils::sendall(tciSend, &recvbuf[0], (size_t)bytesReceived);
+									if (log_type == logUtils::logType::detailLog)
+										logger.log(reqLog, &recvbuf[0], (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
+									if (verbose)
+									{
+										std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+										std::cout << ", forward soft-call request to MRP_TCI" << std::endl;
+									}
+								}
+								else if (udpHeader.msgid == msgUtils::msgid_traj)
+								{ /// received vehicle trajectory message from MRP_Aware, save in memory
+									veh_traj.ms_since_midnight = udpHeader.ms_since_midnight;
+									msgDefs::unpackMsg(recvbuf, offset, veh_traj);
+									if ((veh_traj.entryControlPhase > 0) && (veh_traj.entryControlPhase <= 8))
+										apchStats[veh_traj.entryControlPhase - 1].add(veh_traj, eventUtils::Reactor::now());
+									if (log_type != logUtils::logType::none)
+										logger.log(trajLog, &recvbuf[0], (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
+								}
+								else if ((udpHeader.msgid == msgUtils::msgid_pollReq) && (listenFds[i] != fd_localhostListen))
+								{ /// polls are answered to MRP components on the localhost socket only, not to the radio
 									OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-									OS_ERR << ", failed encode_spat_payload" << std::endl;
+									OS_ERR << ", dropped poll request received from RSU msgTransceiver" << std::endl;
 								}
-								/// forward msgid_cntrlstatus message to MRP_Aware
-								socketUtils::sendall(awareSend, &recvbuf[0], (size_t)bytesReceived);
-								if (log_type == logUtils::logType::detailLog)
-									logUtils::logMsg(logFiles, std::string("sig"), recvbuf, (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
-							}
-							else if (udpHeader.msgid == msgUtils::msgid_ssm)
-							{ /// received encoded SSM from MRP_Aware, forward to RSE_MessageTX
-								socketUtils::sendall(wmeSend, &recvbuf[0], (size_t)bytesReceived);
-								if (log_type == logUtils::logType::detailLog)
-									logUtils::logMsg(logFiles, std::string("payload"), recvbuf, (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
-								if (verbose)
+								else if (udpHeader.msgid == msgUtils::msgid_pollReq)
+								{ /// poll request: MMITSS header + requested message ID (1 byte), respond with the stored snapshot
+									socketUtils::Conn_t pollConn;
+									if ((udpHeader.length >= 1) && ((size_t)bytesReceived > offset) && rxBatch.source(listenFds[i], pollConn)
+										&& (pollSnapshots.respond(recvbuf[offset], pollConn, fullTimeStamp.localDateTimeStamp.msOfDay) > 0))
+										pollCnt++;
+									else
+									{
+										OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+										OS_ERR << ", failed responding to poll request" << std::endl;
+									}
+								}
+								else
 								{
-									std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-									std::cout << ", forward SSM to RSE_MessageTX" << std::endl;
+									OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+									OS_ERR << ", received unexpected MMITSS message ID " << static_cast<unsigned int>(udpHeader.msgid) << std::endl;
 								}
 							}
-							else if (udpHeader.msgid == msgUtils::msgid_softcall)
-							{ /// received soft-call request from MRP_Aware, forward to MRP_TCI
-								socketUtils::sendall(tciSend, &recvbuf[0], (size_t)bytesReceived);
-								if (log_type == logUtils::logType::detailLog)
-									logUtils::logMsg(logFiles, std::string("req"), recvbuf, (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
+						}
+					}
+					else if (listenFds[i] == fd_cloudListen)
+					{	/// received message from pedestrian cloud server: Savari header + PSRM payload
+						/// action: replace Savari header with MMITSS header and forward the message to MRP_Aware
+						if (bytesReceived >= 9)
+						{
+							size_t offset = 0;
+							msgUtils::savari_udp_header_t udpHeader;
+							msgUtils::unpackHeader(recvbuf, offset, udpHeader);
+							if ((udpHeader.type == msgUtils::savari_cloud_srm) && (udpHeader.intersectionID == intersectionId))
+							{ /// received pedestrian SRM from Savari clod server,
+								/// replace Savari header with MMITSS header, and send to MRP_Aware
+								offset = 0;
+								msgUtils::packHeader(recvbuf, offset, msgUtils::msgid_psrm, udpHeader.ms_since_midnight, udpHeader.length);
+								awareRelay.add(awareSend, &recvbuf[0], (size_t)bytesReceived);
+								if (log_type != logUtils::logType::none)
+									logger.log(payloadLog, &recvbuf[0], (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
 								if (verbose)
 								{
 									std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-									std::cout << ", forward soft-call request to MRP_TCI" << std::endl;
+									std::cout << ", forward PSRM to MRP_Aware" << std::endl;
 								}
 							}
-							else if (udpHeader.msgid == msgUtils::msgid_traj)
-							{ /// received vehicle trajectory message from MRP_Aware, save in memory
-								veh_traj.ms_since_midnight = udpHeader.ms_since_midnight;
-								msgDefs::unpackMsg(recvbuf, offset, veh_traj);
-								if ((veh_traj.entryControlPhase > 0) && (veh_traj.entryControlPhase <= 8))
-									a_vehTraj[veh_traj.entryControlPhase - 1].push_back(veh_traj);
-								if (log_type != logUtils::logType::none)
-									logUtils::logMsg(logFiles, std::string("traj"), recvbuf, (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
-							}
 							else
 							{
 								OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-								OS_ERR << ", received unexpected MMITSS message ID " << static_cast<unsigned int>(udpHeader.msgid) << std::endl;
-							}
-						}
-					}
-				}
-				else if (ufds[i].fd == fd_cloudListen)
-				{	/// received message from pedestrian cloud server: Savari header + PSRM payload
-					/// action: replace Savari header with MMITSS header and forward the message to MRP_Aware
-					if (bytesReceived >= 9)
-					{
-						size_t offset = 0;
-						msgUtils::savari_udp_header_t udpHeader;
-						msgUtils::unpackHeader(recvbuf, offset, udpHeader);
-						if ((udpHeader.type == msgUtils::savari_cloud_srm) && (udpHeader.intersectionID == intersectionId))
-						{ /// received pedestrian SRM from Savari clod server,
-							/// replace Savari header with MMITSS header, and send to MRP_Aware
-							offset = 0;
-							msgUtils::packHeader(recvbuf, offset, msgUtils::msgid_psrm, udpHeader.ms_since_midnight, udpHeader.length);
-							socketUtils::sendall(awareSend, &recvbuf[0], (size_t)bytesReceived);
-							if (log_type != logUtils::logType::none)
-								logUtils::logMsg(logFiles, std::string("payload"), recvbuf, (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
-							if (verbose)
-							{
-								std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-								std::cout << ", forward PSRM to MRP_Aware" << std::endl;
+								OS_ERR << ", received cloud message type " << static_cast<unsigned int>(udpHeader.type);
+								OS_ERR << " request to intersection " << udpHeader.intersectionID;
+								OS_ERR << " (this intersection " << intersectionId << " )" << std::endl;
 							}
 						}
 						else
 						{
 							OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-							OS_ERR << ", received cloud message type " << static_cast<unsigned int>(udpHeader.type);
-							OS_ERR << " request to intersection " << udpHeader.intersectionID;
-							OS_ERR << " (this intersection " << intersectionId << " )" << std::endl;
+							OS_ERR << ", received unexpected message from cloud server, size=" << bytesReceived;
+							OS_ERR << ", type=" << static_cast<unsigned int>(recvbuf[0]) << std::endl;
 						}
 					}
-					else
-					{
-						OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-						OS_ERR << ", received unexpected message from cloud server, size=" << bytesReceived;
-						OS_ERR << ", type=" << static_cast<unsigned int>(recvbuf[0]) << std::endl;
-					}
 				}
+				/// relay BSM/SRM/PSRM and signal status received in this wake-up to MRP_Aware
+				awareRelay.flush(awareSend);
+			}
+		}
+
+		/// check sending SPaT
+		unsigned long long now_msec = eventUtils::Reactor::now();
+		bool spatSent = false;
+		reactor.expired(spatTimer);
+		if ((spatVersion > 0) && spatSlot.due(now_msec, spatVersion))
+		{
+			ssize_t payload_size = spatEncoder.encode(cntrl_state.spatRaw, spatSlot.payload(), spatSlot.capacity());
+			if (payload_size > 0)
+			{
+				spatSlot.store((size_t)payload_size, spatVersion);
+				/// add MMITSS header and send to RSE_MessageTX
+				std::vector<uint8_t>& spatbuf = spatSlot.buf();
+				size_t header_offset = 0;
+				msgUtils::packHeader(spatbuf, header_offset, msgUtils::msgid_spat, fullTimeStamp.localDateTimeStamp.msOfDay, (uint16_t)payload_size);
+				size_t msg_size = (size_t)payload_size + header_offset;
+				queueOut(wmeOut, wmeSend, &spatbuf[0], msg_size, "SPaT");
+				if (log_type == logUtils::logType::detailLog)
+					logger.log(payloadLog, &spatbuf[0], msg_size);
+				/// add Savari header and send to pedestrian cloud server
+				header_offset = 0;
+				msgUtils::packHeader(spatbuf, header_offset, msgUtils::savari_cloud_spat, intersectionId,
+					fullTimeStamp.localDateTimeStamp.msOfDay, (uint16_t)payload_size);
+				queueOut(cloudOut, cloudSend, &spatbuf[0], msg_size, "cloud SPaT");
+				spatSlot.sent(now_msec);
+				spatSent = true;
+
+				if (verbose)
+				{
+					std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+					std::cout << ", sent SPaT" << std::endl;
+				}
+			}
+			else
+			{ /// do not retry this controller status
+				spatSlot.drop(spatVersion);
+				OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+				OS_ERR << ", failed encode_spat_payload" << std::endl;
 			}
 		}
+		else if ((spatVersion > 0) && spatSlot.stale(spatVersion))
+			reactor.armTimer(spatTimer, spatSlot.wait(now_msec, spatVersion));
 
-		/// check sending MAP
-		if (fullTimeStamp.msec > sentMap_msec + MsgEnum::mapInterval)
+		/// check sending MAP, along with SPaT or on its own when no SPaT went out within spatInterval
+		if ((reactor.expired(mapTimer) || spatSent) && mapSlot.due(now_msec, 0))
 		{	/// send MAP to RSE_MessageTX
-			size_t offset = 3;
-			msgUtils::pack4bytes(map2RSE, offset, fullTimeStamp.localDateTimeStamp.msOfDay);
-			socketUtils::sendall(wmeSend, &map2RSE[0], map2RSE_size);
+			std::vector<uint8_t>& mapbuf = mapSlot.buf();
+			size_t header_offset = 0;
+			msgUtils::packHeader(mapbuf, header_offset, msgUtils::msgid_map, fullTimeStamp.localDateTimeStamp.msOfDay, (uint16_t)mapSlot.size());
+			queueOut(wmeOut, wmeSend, &mapbuf[0], mapSlot.size() + header_offset, "MAP");
 			/// send MAP to pedestrian cloud server
-			offset = 3;
-			msgUtils::pack4bytes(map2cloud, offset, fullTimeStamp.localDateTimeStamp.msOfDay);
-			socketUtils::sendall(cloudSend, &map2cloud[0], map2cloud_size);
+			header_offset = 0;
+			msgUtils::packHeader(mapbuf, header_offset, msgUtils::savari_cloud_map, intersectionId,
+				fullTimeStamp.localDateTimeStamp.msOfDay, (uint16_t)mapSlot.size());
+			queueOut(cloudOut, cloudSend, &mapbuf[0], mapSlot.size() + header_offset, "cloud MAP");
+			mapSlot.sent(now_msec);
+			reactor.armTimer(mapTimer, mapSlot.wait(now_msec, 0) + spatPace);
 
-			/// reset sentMap_msec
-			sentMap_msec = fullTimeStamp.msec;
 			if (verbose)
 			{
 				std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
 				std::cout << ", sent MAP" << std::endl;
 			}
 		}
+		else if (!reactor.isArmed(mapTimer))
+			reactor.armTimer(mapTimer, mapSlot.wait(now_msec, 0) + spatPace);
+		flushOut(wmeOut, wmeSend, "RSE_MessageTX");
+		flushOut(cloudOut, cloudSend, "pedestrian cloud server");
 
 		/// check calculate performance measures
-		if (fullTimeStamp.msec > perm_msec + permInterval)
+		if (reactor.expired(permTimer))
 		{
+			unsigned long long permTick = eventUtils::Reactor::now();
+			reactor.armTimer(permTimer, permInterval - permTick % permInterval);
 			if (cntrl_state.signalStatus.mode != MsgEnum::controlMode::unavailable)
 			{
 				intPerm.ms_since_midnight = fullTimeStamp.localDateTimeStamp.msOfDay;
@@ -511,110 +635,80 @@ int main(int argc, char** argv)
 				intPerm.observedPhases.reset();
 				for (int i = 0; i < 8; i++)
 				{
-					if (getApchPerm(intPerm.apchPerm[i], a_vehTraj[i], speedLimits[i], intPerm.permittedPhases.test(i)))
+					if (intPerm.permittedPhases.test(i)
+						&& apchStats[i].getApchPerm(intPerm.apchPerm[i], apchPercentile[i], permTick, permInterval))
 						intPerm.observedPhases.set(i);
 				}
 				if (intPerm.observedPhases.any())
 				{ /// send performance measures to MRP_Aware
 					size_t msgSize = msgDefs::packMsg(sendbuf, intPerm, msgUtils::msgid_perm);
 					socketUtils::sendall(awareSend, &sendbuf[0], msgSize);
+					pollSnapshots.store(msgUtils::msgid_perm, &sendbuf[0], msgSize);
 					if (log_type != logUtils::logType::none)
-						logUtils::logMsg(logFiles, std::string("perm"), sendbuf, msgSize);
+						logger.log(permLog, &sendbuf[0], msgSize);
+					if (verbose)
+					{
+						std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+						std::cout << ", performance measures (p50/p85/p95)" << std::endl;
+						for (int i = 0; i < 8; i++)
+						{
+							if (!intPerm.observedPhases.test(i))
+								continue;
+							const auto& pct = apchPercentile[i];
+							std::cout << "\tphase " << i + 1 << ": samples " << intPerm.apchPerm[i].sampleNums;
+							std::cout << ", speed " << pct.travelSpeed[0] << "/" << pct.travelSpeed[1] << "/" << pct.travelSpeed[2] << " mph";
+							std::cout << ", travel time " << pct.travelTime[0] << "/" << pct.travelTime[1] << "/" << pct.travelTime[2] << " ds";
+							std::cout << ", delay " << pct.delay[0] << "/" << pct.delay[1] << "/" << pct.delay[2] << " ds" << std::endl;
+						}
+					}
+				}
+			}
+			{ /// detector aggregates for polls
+				size_t msgSize = detSeries.packMsg(sendbuf, msgUtils::msgid_detAggr, fullTimeStamp.localDateTimeStamp.msOfDay,
+					permTick, detAggrWindows);
+				if (msgSize > 0)
+					pollSnapshots.store(msgUtils::msgid_detAggr, &sendbuf[0], msgSize);
+				else
+				{
+					OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+					OS_ERR << ", detector aggregates do not fit in " << sendbuf.size() << " bytes" << std::endl;
+				}
+			}
+			if (verbose)
+			{
+				detSeries.aggregate(detAggr, permTick, permInterval);
+				std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+				std::cout << ", detector volume/occupancy" << std::endl;
+				for (size_t det = 0; det < detAggr.size(); det++)
+				{
+					if ((detAggr[det].samples == 0) && (detAggr[det].faults == 0))
+						continue;
+					std::cout << "\tdetector " << det + 1 << ": volume " << detAggr[det].volume;
+					std::cout << ", occupancy " << detAggr[det].occupancy() << "%";
+					if (detAggr[det].faults > 0)
+						std::cout << ", faults " << detAggr[det].faults;
+					std::cout << std::endl;
 				}
 			}
-			perm_msec = fullTimeStamp.msec;
 		}
 
 		/// check reopen log files
-		if ((log_type != logUtils::logType::none) && (fullTimeStamp.msec > logfile_msec + logInterval))
-		{
-			logUtils::reOpenLogFiles(logFiles, fullTimeStamp.localDateTimeStamp.to_fileName());
-			logfile_msec = fullTimeStamp.msec;
-		}
-
-		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		if (reactor.expired(logTimer))
+			logger.reopen(fullTimeStamp.localDateTimeStamp.to_fileName());
+		if (reactor.expired(cardTimer))
+			loadCard();
 	}
 	/// exit
 	timeUtils::getFullTimeStamp(fullTimeStamp);
 	OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-	OS_ERR << ", received user termination signal " << terminate << ", exit!" << std::endl;
+	OS_ERR << ", received user termination signal " << terminate << ", exit!";
+	OS_ERR << " responded to " << pollCnt << " poll requests" << std::endl;
+	if (logger.dropped() > 0)
+		OS_ERR << "\tdropped " << logger.dropped() << " log records on a full log ring" << std::endl;
 	OS_ERR.close();
-	if (log_type != logUtils::logType::none)
-		logUtils::closeLogFiles(logFiles);
+	logger.close();
 	pmycnf->disconnectAll();
 	delete pmycnf;
 	delete pcard;
 	return(0);
 }
-
-size_t packMapMsg(std::vector<uint8_t>& buf, const std::vector<uint8_t>& payload, uint8_t msgid)
-{ /// to RSE_MessageTX: MMITSS UDP header + encoded MAP payload
-	size_t offset = 0;
-	msgUtils::packHeader(buf, offset, msgid, 0, (uint16_t)payload.size());
-	buf.insert(buf.begin() + offset, payload.begin(), payload.end());
-	return(offset + payload.size());
-}
-
-size_t packMapMsg(std::vector<uint8_t>& buf, const std::vector<uint8_t>& payload, uint16_t intersectionID, uint8_t msgtype)
-{ /// to pedestrian cloud server: Savari UDP header + encoded MAP payload
-	size_t offset = 0;
-	msgUtils::packHeader(buf, offset, msgtype, intersectionID, 0, (uint16_t)payload.size());
-	buf.insert(buf.begin() + offset, payload.begin(), payload.end());
-	return(offset + payload.size());
-}
-
-bool getApchPerm(msgDefs::apchPerm_t& apchPerm, std::vector<msgDefs::vehTraj_t>& vehTraj, uint8_t speedLimit, bool permitted)
-{
-	if (!permitted || vehTraj.empty() || (speedLimit == 0))
-	{
-		vehTraj.clear();
-		return(false);
-	}
-	double freeflow_v = (double)speedLimit * DsrcConstants::mph2mps;
-	std::vector<double> sample_v;
-	std::vector<double> sample_tt;
-	std::vector<double> sample_delay;
-	size_t stopnums = std::count_if(vehTraj.begin(), vehTraj.end(),
-		[](const msgDefs::vehTraj_t& item){return(item.stoppedTime >= 50);});
-	for (auto& item : vehTraj)
-	{
-		double freeflow_tt = (double)item.inboundLaneLen / freeflow_v;       /// in deciseconds
-		if ((item.distTraveled != 0) && (item.timeTraveled != 0))
-		{
-			double speed = (double)item.distTraveled / item.timeTraveled;  /// in mps
-			double tt = (double)item.inboundLaneLen / speed;                   /// in deciseconds
-			double delay = (tt > freeflow_tt) ? (tt - freeflow_tt) : 0.0;  /// in deciseconds
-			sample_v.push_back(speed);
-			sample_tt.push_back(tt);
-			sample_delay.push_back(delay);
-		}
-	}
-	if (sample_v.empty())
-	{
-		vehTraj.clear();
-		return(false);
-	}
-	size_t sample_size = sample_v.size();
-	double mean_v = std::accumulate(sample_v.begin(), sample_v.end(), 0.0) / (double)sample_size;
-	double mean_tt = std::accumulate(sample_tt.begin(), sample_tt.end(), 0.0) / (double)sample_size;
-	double mean_delay = std::accumulate(sample_delay.begin(), sample_delay.end(), 0.0) / (double)sample_size;
-	std::vector<double> diff_v(sample_size);
-	std::vector<double> diff_tt(sample_size);
-	std::vector<double> diff_delay(sample_size);
-	std::transform(sample_v.begin(), sample_v.end(), diff_v.begin(), [mean_v](double x){return(x - mean_v);});
-	std::transform(sample_tt.begin(), sample_tt.end(), diff_tt.begin(), [mean_tt](double x){return(x - mean_tt);});
-	std::transform(sample_delay.begin(), sample_delay.end(), diff_delay.begin(), [mean_delay](double x){return(x - mean_delay);});
-	double std_v = std::sqrt(std::inner_product(diff_v.begin(), diff_v.end(), diff_v.begin(), 0.0) / (double)sample_size);
-	double std_tt = std::sqrt(std::inner_product(diff_tt.begin(), diff_tt.end(), diff_tt.begin(), 0.0) / (double)sample_size);
-	double std_delay = std::sqrt(std::inner_product(diff_delay.begin(), diff_delay.end(), diff_delay.begin(), 0.0) / (double)sample_size);
-	apchPerm.sampleNums = static_cast<uint16_t>(sample_size);
-	apchPerm.travelSpeed_mean = static_cast<uint16_t>(mean_v / DsrcConstants::mph2mps);
-	apchPerm.travelSpeed_std = static_cast<uint16_t>(std_v / DsrcConstants::mph2mps);
-	apchPerm.travelTime_mean = static_cast<uint16_t>(mean_tt);
-	apchPerm.travelTime_std = static_cast<uint16_t>(std_tt);
-	apchPerm.delay_mean = static_cast<uint16_t>(mean_delay);
-	apchPerm.delay_std = static_cast<uint16_t>(std_delay);
-	apchPerm.stoppedNums = static_cast<uint16_t>(stopnums);
-	vehTraj.clear();
-	return(true);
-}
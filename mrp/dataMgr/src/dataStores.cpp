@@ -0,0 +1,327 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+/* dataStores.cpp
+ * in-memory data kept by MRP_DataMgr (declared in dataMgr.h):
+ *   ApchStats     - streaming approach performance measures from vehicle trajectories
+ *   DetSeries     - detector volume and occupancy time series
+ *   PollSnapshots - responses to poll requests, ready to send
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include "dsrcConsts.h"
+#include "msgUtils.h"
+#include "dataMgr.h"
+
+const size_t ApchStats::bucketNums;
+const unsigned long long ApchStats::bucketLen;
+
+void ApchStats::bucket_t::reset(void)
+{
+	stoppedNums = 0;
+	speed.reset();
+	travelTime.reset();
+	delay.reset();
+	speedHist.reset();
+	travelTimeHist.reset();
+	delayHist.reset();
+}
+
+ApchStats::ApchStats(uint8_t speedLimit, unsigned long long now) : ring(bucketNums, bucketLen, now)
+	{freeflow_v = (double)speedLimit * DsrcConstants::mph2mps;}
+
+void ApchStats::add(const msgDefs::vehTraj_t& traj, unsigned long long now)
+{
+	bucket_t& bucket = ring.at(now);
+	if (traj.stoppedTime >= 50)
+		bucket.stoppedNums++;
+	if ((freeflow_v <= 0.0) || (traj.distTraveled == 0) || (traj.timeTraveled == 0))
+		return;
+	double freeflow_tt = (double)traj.inboundLaneLen / freeflow_v;   /// in deciseconds
+	double speed = (double)traj.distTraveled / traj.timeTraveled;    /// in mps
+	double tt = (double)traj.inboundLaneLen / speed;                 /// in deciseconds
+	double delay = (tt > freeflow_tt) ? (tt - freeflow_tt) : 0.0;    /// in deciseconds
+	bucket.speed.add(speed);
+	bucket.travelTime.add(tt);
+	bucket.delay.add(delay);
+	bucket.speedHist.add((uint32_t)std::lround(speed * 10.0 / DsrcConstants::mph2mps));
+	bucket.travelTimeHist.add((uint32_t)std::lround(tt));
+	bucket.delayHist.add((uint32_t)std::lround(delay));
+}
+
+bool ApchStats::getApchPerm(msgDefs::apchPerm_t& apchPerm, apchPercentile_t& percentile,
+	unsigned long long now, unsigned long long window)
+{
+	uint32_t stopnums = 0;
+	statsUtils::moments_t speed, travelTime, delay;
+	speed.reset();
+	travelTime.reset();
+	delay.reset();
+	statsUtils::Histogram speedHist, travelTimeHist, delayHist;
+	ring.window(now, window, [&](const bucket_t& bucket)
+	{
+		stopnums += bucket.stoppedNums;
+		speed.merge(bucket.speed);
+		travelTime.merge(bucket.travelTime);
+		delay.merge(bucket.delay);
+		speedHist.merge(bucket.speedHist);
+		travelTimeHist.merge(bucket.travelTimeHist);
+		delayHist.merge(bucket.delayHist);
+	});
+	if (speed.count == 0)
+		return(false);
+	apchPerm.sampleNums = static_cast<uint16_t>(speed.count);
+	apchPerm.travelSpeed_mean = static_cast<uint16_t>(speed.mean / DsrcConstants::mph2mps);
+	apchPerm.travelSpeed_std = static_cast<uint16_t>(speed.stddev() / DsrcConstants::mph2mps);
+	apchPerm.travelTime_mean = static_cast<uint16_t>(travelTime.mean);
+	apchPerm.travelTime_std = static_cast<uint16_t>(travelTime.stddev());
+	apchPerm.delay_mean = static_cast<uint16_t>(delay.mean);
+	apchPerm.delay_std = static_cast<uint16_t>(delay.stddev());
+	apchPerm.stoppedNums = static_cast<uint16_t>(stopnums);
+	const double quantiles[3] = {0.50, 0.85, 0.95};
+	for (int i = 0; i < 3; i++)
+	{
+		percentile.travelSpeed[i] = static_cast<uint16_t>((speedHist.quantile(quantiles[i]) + 5) / 10);
+		percentile.travelTime[i] = static_cast<uint16_t>(travelTimeHist.quantile(quantiles[i]));
+		percentile.delay[i] = static_cast<uint16_t>(delayHist.quantile(quantiles[i]));
+	}
+	return(true);
+}
+
+const size_t DetSeries::tierNums;
+
+DetSeries::tier_t::tier_t(unsigned long long slotLen_, size_t slotNums_, size_t detNums, unsigned long long now)
+	: slotLen(slotLen_), slotNums(slotNums_), curIdx(now / slotLen_)
+{
+	volume.assign(slotNums * detNums, 0);
+	samples.assign(slotNums * detNums, 0);
+	faults.assign(slotNums * detNums, 0);
+	occSum.assign(slotNums * detNums, 0);
+}
+
+void DetSeries::tier_t::advance(unsigned long long now, size_t detNums)
+{
+	unsigned long long idx = now / slotLen;
+	if (idx <= curIdx)
+		return;
+	unsigned long long steps = (idx - curIdx > slotNums) ? slotNums : idx - curIdx;
+	for (unsigned long long i = idx - steps + 1; i <= idx; i++)
+	{
+		size_t slot = (size_t)(i % slotNums);
+		for (size_t det = 0; det < detNums; det++)
+		{
+			size_t pos = det * slotNums + slot;
+			volume[pos] = 0;
+			samples[pos] = 0;
+			faults[pos] = 0;
+			occSum[pos] = 0;
+		}
+	}
+	curIdx = idx;
+}
+
+DetSeries::DetSeries(size_t detNums_, unsigned long long now) : detNums(detNums_), lastSeq(-1)
+{
+	tiers.push_back(tier_t(1000LL, 3600, detNums, now));          // 1 second for an hour
+	tiers.push_back(tier_t(60 * 1000LL, 1440, detNums, now));     // 1 minute for 24 hours
+	tiers.push_back(tier_t(15 * 60 * 1000LL, 672, detNums, now)); // 15 minutes for 7 days
+}
+
+size_t DetSeries::memory(void) const
+{
+	size_t bytes = 0;
+	for (const auto& tier : tiers)
+	{
+		bytes += tier.volume.size() * sizeof(uint16_t) + tier.samples.size() * sizeof(uint16_t)
+			+ tier.faults.size() * sizeof(uint16_t) + tier.occSum.size() * sizeof(uint32_t);
+	}
+	return(bytes);
+}
+
+void DetSeries::add(size_t det, uint8_t volume, uint8_t occupancy, unsigned long long now)
+{
+	if (det >= detNums)
+		return;
+	for (auto& tier : tiers)
+	{
+		tier.advance(now, detNums);
+		size_t pos = det * tier.slotNums + (size_t)(tier.curIdx % tier.slotNums);
+		/// counters saturate rather than wrap around
+		tier.volume[pos] = (uint16_t)std::min(tier.volume[pos] + volume, UINT16_MAX);
+		if (occupancy > 200)
+			tier.faults[pos] = (uint16_t)std::min(tier.faults[pos] + 1, UINT16_MAX);
+		else if (tier.samples[pos] < UINT16_MAX)
+		{
+			tier.samples[pos]++;
+			tier.occSum[pos] += occupancy;
+		}
+	}
+}
+
+bool DetSeries::add(const msgDefs::count_data_t& cnt, unsigned long long now)
+{
+	if (cnt.seq_num == lastSeq)
+		return(false);
+	lastSeq = cnt.seq_num;
+	for (size_t det = 0; (det < detNums) && (det < 16); det++)
+		add(det, cnt.vol[det], cnt.occ[det], now);
+	return(true);
+}
+
+detAggr_t DetSeries::aggregate(size_t det, unsigned long long now, unsigned long long window)
+{
+	detAggr_t aggr;
+	aggr.reset();
+	if ((det >= detNums) || tiers.empty())
+		return(aggr);
+	size_t t = 0;
+	while ((t + 1 < tiers.size()) && (tiers[t].slotLen * tiers[t].slotNums < window))
+		t++;
+	tier_t& tier = tiers[t];
+	tier.advance(now, detNums);
+	unsigned long long nums = window / tier.slotLen + 1;
+	if (nums > tier.slotNums)
+		nums = tier.slotNums;
+	/// the slots are at most two contiguous runs of the detector's columns
+	size_t first = (size_t)((tier.curIdx + 1 - nums) % tier.slotNums);
+	size_t base = det * tier.slotNums;
+	size_t runs[2][2] = {{first, std::min(first + (size_t)nums, tier.slotNums)}, {0, 0}};
+	if (first + nums > tier.slotNums)
+		runs[1][1] = first + (size_t)nums - tier.slotNums;
+	for (const auto& run : runs)
+	{
+		for (size_t pos = base + run[0]; pos < base + run[1]; pos++)
+		{
+			aggr.volume += tier.volume[pos];
+			aggr.samples += tier.samples[pos];
+			aggr.faults += tier.faults[pos];
+			aggr.occSum += tier.occSum[pos];
+		}
+	}
+	return(aggr);
+}
+
+void DetSeries::aggregate(std::vector<detAggr_t>& aggr, unsigned long long now, unsigned long long window)
+{
+	aggr.resize(detNums);
+	for (size_t det = 0; det < detNums; det++)
+		aggr[det] = aggregate(det, now, window);
+}
+
+size_t DetSeries::packMsg(std::vector<uint8_t>& buf, uint8_t msgid, uint32_t msOfDay, unsigned long long now,
+	const std::vector<unsigned long long>& windows)
+{
+	size_t msgSize = 9 + 2 + windows.size() * (4 + detNums * 16);
+	if ((windows.size() > 0xFF) || (detNums > 0xFF) || (msgSize > buf.size()))
+		return(0);
+	size_t offset = 0;
+	msgUtils::packHeader(buf, offset, msgid, msOfDay, (uint16_t)(msgSize - 9));
+	buf[offset++] = (uint8_t)windows.size();
+	buf[offset++] = (uint8_t)detNums;
+	for (auto window : windows)
+	{
+		msgUtils::pack4bytes(buf, offset, (uint32_t)(window / 1000));
+		for (size_t det = 0; det < detNums; det++)
+		{
+			detAggr_t aggr = aggregate(det, now, window);
+			msgUtils::pack4bytes(buf, offset, aggr.volume);
+			msgUtils::pack4bytes(buf, offset, aggr.occSum);
+			msgUtils::pack4bytes(buf, offset, aggr.samples);
+			msgUtils::pack4bytes(buf, offset, aggr.faults);
+		}
+	}
+	return(offset);
+}
+
+PollSnapshots::PollSnapshots(const std::vector<uint8_t>& msgids)
+{
+	for (auto msgid : msgids)
+	{
+		snapshots.push_back(snapshot_t());
+		snapshots.back().msgid = msgid;
+	}
+	emptyMsg.resize(9, 0);
+}
+
+PollSnapshots::snapshot_t* PollSnapshots::find(uint8_t msgid)
+{
+	for (auto& snapshot : snapshots)
+	{
+		if (snapshot.msgid == msgid)
+			return(&snapshot);
+	}
+	return(nullptr);
+}
+
+void PollSnapshots::store(uint8_t msgid, const uint8_t* buf, size_t len)
+{
+	clear(msgid);
+	append(msgid, buf, len);
+}
+
+void PollSnapshots::append(uint8_t msgid, const uint8_t* buf, size_t len)
+{
+	snapshot_t* snapshot = find(msgid);
+	if ((snapshot == nullptr) || (len == 0))
+		return;
+	snapshot->data.insert(snapshot->data.end(), buf, buf + len);
+	snapshot->sizes.push_back(len);
+}
+
+bool PollSnapshots::storeText(uint8_t msgid, const std::string& text, uint32_t msOfDay, size_t bufSize)
+{
+	clear(msgid);
+	const size_t headerSize = 9;
+	const size_t chunkSize = bufSize - headerSize - 2;
+	size_t chunkNums = (text.size() + chunkSize - 1) / chunkSize;
+	if (chunkNums > UINT8_MAX)
+		return(false);
+	std::vector<uint8_t> buf(bufSize, 0);
+	for (size_t chunk = 0; chunk < chunkNums; chunk++)
+	{
+		size_t len = std::min(chunkSize, text.size() - chunk * chunkSize);
+		size_t offset = 0;
+		msgUtils::packHeader(buf, offset, msgid, msOfDay, (uint16_t)(len + 2));
+		buf[offset++] = static_cast<uint8_t>(chunk);
+		buf[offset++] = static_cast<uint8_t>(chunkNums);
+		std::memcpy(&buf[offset], &text[chunk * chunkSize], len);
+		append(msgid, &buf[0], offset + len);
+	}
+	return(true);
+}
+
+void PollSnapshots::clear(uint8_t msgid)
+{
+	snapshot_t* snapshot = find(msgid);
+	if (snapshot == nullptr)
+		return;
+	snapshot->data.clear();
+	snapshot->sizes.clear();
+}
+
+size_t PollSnapshots::respond(uint8_t msgid, socketUtils::Conn_t conn, uint32_t msOfDay)
+{
+	snapshot_t* snapshot = find(msgid);
+	if (snapshot == nullptr)
+		return(0);
+	if (snapshot->sizes.empty())
+	{
+		size_t offset = 0;
+		msgUtils::packHeader(emptyMsg, offset, msgid, msOfDay, 0);
+		socketUtils::sendall(conn, &emptyMsg[0], emptyMsg.size());
+		return(1);
+	}
+	size_t offset = 0;
+	for (auto size : snapshot->sizes)
+	{
+		socketUtils::sendall(conn, &snapshot->data[offset], size);
+		offset += size;
+	}
+	return(snapshot->sizes.size());
+}
@@ -0,0 +1,537 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+/* dataMgrBench.cpp
+ * benchmarks of the MRP_DataMgr data paths:
+ *   poll - latency of poll requests (msgid_pollReq) answered by a running dataMgr on its localhost socket,
+ *          from the request to the last response datagram, while controller status drives SPaT at 10 Hz.
+ *          Requests cycle over controller status, detector count and presence, performance measures
+ *          and the timing card.
+ *   load - datagrams received over loopback at a sustained rate from a forked sender, and the kernel drops
+ *          (RcvbufErrors in /proc/net/snmp), with the earlier receive loop (one datagram per pass and a 5 ms
+ *          sleep) against the batched one (socketUtils::DgramBatch, drained before waiting in poll()).
+ *   detseries - insert cost, memory and range query cost of the detector time series (DetSeries) with
+ *          64 detectors sampled every second for 8 days, against summing the raw samples. The aggregates
+ *          have to be identical.
+ */
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <random>
+#include <string>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "msgEnum.h"
+#include "msgUtils.h"
+#include "dataMgr.h"
+#include "socketUtils.h"
+
+void do_usage(const char* progname)
+{
+	std::cerr << "Usage " << progname << " [options] <benchmark>" << std::endl;
+	std::cerr << "\t-n number of iterations (default 10000, 50000 datagrams for load)" << std::endl;
+	std::cerr << "\t-r poll requests or datagrams per second (default 1000, 5000 for load)" << std::endl;
+	std::cerr << "\t-p dataMgr localhost port (default 25021)" << std::endl;
+	std::cerr << "\t-? print this message" << std::endl;
+	std::cerr << "benchmarks:" << std::endl;
+	std::cerr << "\tpoll      -n poll requests to a running dataMgr, with controller status at 10 Hz" << std::endl;
+	std::cerr << "\tload      -n datagrams over loopback at -r per second, one-per-pass receive against DgramBatch" << std::endl;
+	std::cerr << "\tdetseries DetSeries insert, memory and queries against raw samples, 64 detectors for 8 days" << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+static unsigned long long nowUs(void)
+{
+	return(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/// msgid_cntrlstatus with all 8 vehicle phases permitted, in the layout of msgDefs::unpackMsg(controller_state_t)
+static size_t packCntrlStatus(std::vector<uint8_t>& buf, uint8_t msgCnt, uint32_t msOfDay)
+{
+	size_t offset = 9;
+	buf[offset++] = msgCnt;
+	msgUtils::pack4bytes(buf, offset, msOfDay / 60000);
+	msgUtils::pack2bytes(buf, offset, (uint16_t)(msOfDay % 60000));
+	buf[offset++] = 0xFF;  // permitted phases
+	buf[offset++] = 0x00;  // permitted pedestrian phases
+	msgUtils::pack2bytes(buf, offset, 0);
+	for (int i = 0; i < 8; i++)
+	{
+		buf[offset++] = static_cast<uint8_t>(((i == 1) || (i == 5)) ? MsgEnum::phaseState::protectedGreen : MsgEnum::phaseState::redLight);
+		msgUtils::pack2bytes(buf, offset, 0);
+		msgUtils::pack2bytes(buf, offset, (uint16_t)(100 + msgCnt % 100));
+		msgUtils::pack2bytes(buf, offset, (uint16_t)(300 + msgCnt % 100));
+	}
+	buf[offset++] = static_cast<uint8_t>(MsgEnum::controlMode::runningFree);
+	buf[offset++] = 0;     // patternNum
+	buf[offset++] = 0;     // synch_phase
+	msgUtils::pack2bytes(buf, offset, 0);
+	msgUtils::pack2bytes(buf, offset, 0);
+	for (int i = 0; i < 4; i++)
+		buf[offset++] = 0;   // coordinated_phases, preempt, ped_call and veh_call
+	for (int i = 0; i < 16; i++)
+		buf[offset++] = 0;   // call_status and recall_status
+	size_t len = offset;
+	offset = 0;
+	msgUtils::packHeader(buf, offset, msgUtils::msgid_cntrlstatus, msOfDay, (uint16_t)(len - 9));
+	return(len);
+}
+
+static bool benchPoll(size_t requestNums, size_t rate, uint16_t port)
+{
+	const size_t headerSize = 9;
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0)
+	{
+		std::cerr << "Failed creating socket" << std::endl;
+		return(false);
+	}
+	struct sockaddr_in dst;
+	std::memset(&dst, 0, sizeof(dst));
+	dst.sin_family = AF_INET;
+	dst.sin_port = htons(port);
+	dst.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	const uint8_t msgids[] = {msgUtils::msgid_cntrlstatus, msgUtils::msgid_detCnt, msgUtils::msgid_detPres,
+		msgUtils::msgid_perm, msgUtils::msgid_detAggr, msgUtils::msgid_timeCard};
+	const char* names[] = {"cntrlstatus", "detCnt", "detPres", "perm", "detAggr", "timeCard"};
+	const size_t msgidNums = sizeof(msgids) / sizeof(msgids[0]);
+	std::vector< std::vector<double> > latency(msgidNums);
+	std::vector<unsigned long long> dgrams(msgidNums, 0);
+	std::vector<unsigned long long> bytes(msgidNums, 0);
+	std::vector<unsigned long long> empty(msgidNums, 0);
+	unsigned long long unanswered = 0;
+	unsigned long long badChunks = 0;
+	std::vector<uint8_t> status(200, 0);
+	std::vector<uint8_t> request(headerSize + 1, 0);
+	std::vector<uint8_t> recvbuf(2000, 0);
+	uint8_t msgCnt = 0;
+	unsigned long long t0 = nowUs();
+	unsigned long long nextStatus = t0;
+	unsigned long long nextRequest = t0;
+	for (size_t n = 0; n < requestNums; )
+	{
+		unsigned long long t = nowUs();
+		if (t >= nextStatus)
+		{ /// controller status at 10 Hz, as MRP_TCI sends it
+			size_t len = packCntrlStatus(status, msgCnt++, (uint32_t)(((t - t0) / 1000) % 86400000));
+			sendto(fd, &status[0], len, 0, (struct sockaddr*)&dst, sizeof(dst));
+			nextStatus += 100000;
+		}
+		if (t < nextRequest)
+		{
+			usleep((useconds_t)std::min(nextRequest - t, 200ULL));
+			continue;
+		}
+		nextRequest += 1000000 / rate;
+		size_t k = n++ % msgidNums;
+		size_t offset = 0;
+		msgUtils::packHeader(request, offset, msgUtils::msgid_pollReq, 0, 1);
+		request[offset] = msgids[k];
+		unsigned long long sent = nowUs();
+		sendto(fd, &request[0], request.size(), 0, (struct sockaddr*)&dst, sizeof(dst));
+		/// a response is one datagram, or for the timing card, chunks 0 to the number of chunks - 1 in order
+		bool done = false;
+		int chunk = 0;
+		while (!done)
+		{
+			struct pollfd pfd = {fd, POLLIN, 0};
+			if (poll(&pfd, 1, 100) <= 0)
+			{
+				unanswered++;
+				break;
+			}
+			ssize_t bytesReceived = recv(fd, &recvbuf[0], recvbuf.size(), 0);
+			if ((bytesReceived < (ssize_t)headerSize) || (recvbuf[2] != msgids[k]))
+				continue;
+			dgrams[k]++;
+			bytes[k] += bytesReceived;
+			offset = 0;
+			msgUtils::mmitss_udp_header_t header;
+			msgUtils::unpackHeader(recvbuf, offset, header);
+			if (header.length == 0)
+			{
+				empty[k]++;
+				done = true;
+			}
+			else if (msgids[k] != msgUtils::msgid_timeCard)
+				done = true;
+			else
+			{
+				if (recvbuf[offset] != chunk)
+					badChunks++;
+				chunk = recvbuf[offset] + 1;
+				done = (chunk >= recvbuf[offset + 1]);
+			}
+		}
+		if (done)
+			latency[k].push_back((double)(nowUs() - sent));
+	}
+	double secs = (double)(nowUs() - t0) / 1e6;
+	close(fd);
+
+	std::cout << requestNums << " poll requests to port " << port << " in " << std::fixed << std::setprecision(1);
+	std::cout << secs << " s, controller status at 10 Hz" << std::endl;
+	std::cout << std::setw(12) << "msgid" << std::setw(8) << "polls" << std::setw(8) << "empty";
+	std::cout << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << std::setw(10) << "max us";
+	std::cout << std::setw(10) << "dgrams" << std::setw(10) << "bytes" << std::endl;
+	for (size_t k = 0; k < msgidNums; k++)
+	{
+		std::vector<double>& v = latency[k];
+		if (v.empty())
+			continue;
+		std::sort(v.begin(), v.end());
+		std::cout << std::setw(12) << names[k] << std::setw(8) << v.size() << std::setw(8) << empty[k] << std::setprecision(0);
+		std::cout << std::setw(10) << v[v.size() / 2] << std::setw(10) << v[v.size() * 99 / 100] << std::setw(10) << v.back();
+		std::cout << std::setprecision(1) << std::setw(10) << (double)dgrams[k] / (double)v.size();
+		std::cout << std::setprecision(0) << std::setw(10) << (double)bytes[k] / (double)v.size() << std::endl;
+	}
+	std::cout << "unanswered " << unanswered << ", timing card chunks out of order " << badChunks << std::endl;
+	if ((unanswered > 0) || (badChunks > 0))
+	{
+		std::cerr << "Poll requests not answered in full within 100 ms" << std::endl;
+		return(false);
+	}
+	return(true);
+}
+
+/// RcvbufErrors of the Udp line of /proc/net/snmp (datagrams dropped for a full receive buffer), -1 when not available
+static long long udpRcvbufErrors(void)
+{
+	std::ifstream ifs("/proc/net/snmp");
+	std::string names;
+	std::string values;
+	std::string line;
+	while (std::getline(ifs, line))
+	{
+		if (line.compare(0, 4, "Udp:") != 0)
+			continue;
+		if (names.empty())
+			names = line;
+		else
+		{
+			values = line;
+			break;
+		}
+	}
+	std::istringstream issNames(names);
+	std::istringstream issValues(values);
+	std::string name;
+	std::string value;
+	while ((issNames >> name) && (issValues >> value))
+	{
+		if (name == "RcvbufErrors")
+			return(std::atoll(value.c_str()));
+	}
+	return(-1);
+}
+
+struct loadResult_t
+{
+	size_t received;
+	size_t outOfOrder;
+	long long rcvbufErrors;
+	unsigned long long wakeups;
+};
+
+/// send 'dgramNums' datagrams of 80 bytes to port on loopback at 'rate' per second from a forked process, and
+/// receive them with the earlier loop (batched is false) or with DgramBatch, spending 'workUs' on each datagram
+static bool runLoad(size_t dgramNums, size_t rate, bool batched, unsigned long long workUs, loadResult_t& result)
+{
+	const size_t headerSize = 9;
+	const size_t dgramSize = 80;
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	struct sockaddr_in addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = 0;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t addrLen = sizeof(addr);
+	if ((fd < 0) || (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+		|| (getsockname(fd, (struct sockaddr*)&addr, &addrLen) < 0) || (fcntl(fd, F_SETFL, O_NONBLOCK) == -1))
+	{
+		std::cerr << "Failed creating loopback socket" << std::endl;
+		if (fd >= 0)
+			close(fd);
+		return(false);
+	}
+	long long rcvbufErrors = udpRcvbufErrors();
+	unsigned long long interval = 1000000000ULL / rate;  // in nanoseconds
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		std::cerr << "Failed fork" << std::endl;
+		close(fd);
+		return(false);
+	}
+	if (pid == 0)
+	{ /// sender: datagram n is due at n * interval after start, carrying n after the MMITSS header
+		close(fd);
+		int sendFd = socket(AF_INET, SOCK_DGRAM, 0);
+		std::vector<uint8_t> dgram(dgramSize, 0);
+		auto t0 = std::chrono::steady_clock::now();
+		for (size_t n = 0; n < dgramNums; n++)
+		{
+			auto due = t0 + std::chrono::nanoseconds(n * interval);
+			auto now = std::chrono::steady_clock::now();
+			if (due > now + std::chrono::microseconds(100))
+				usleep((useconds_t)std::chrono::duration_cast<std::chrono::microseconds>(due - now).count() - 50);
+			while (std::chrono::steady_clock::now() < due);
+			size_t offset = 0;
+			msgUtils::packHeader(dgram, offset, msgUtils::msgid_bsm, 0, (uint16_t)(dgramSize - headerSize));
+			msgUtils::pack4bytes(dgram, offset, (uint32_t)n);
+			sendto(sendFd, &dgram[0], dgram.size(), 0, (struct sockaddr*)&addr, sizeof(addr));
+		}
+		close(sendFd);
+		_exit(EXIT_SUCCESS);
+	}
+	/// receiver: until every datagram arrived, or 1 second after the last one was due
+	auto work = [workUs](void)
+	{
+		auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(workUs);
+		while (std::chrono::steady_clock::now() < until);
+	};
+	result = loadResult_t{0, 0, 0, 0};
+	uint32_t expected = 0;
+	auto take = [&](const std::vector<uint8_t>& buf, size_t len)
+	{
+		if (len < headerSize + 4)
+			return;
+		size_t offset = headerSize;
+		uint32_t n = msgUtils::unpack4bytes(buf, offset);
+		if (n < expected)
+			result.outOfOrder++;
+		expected = n + 1;
+		result.received++;
+		work();
+	};
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(dgramNums * interval) + std::chrono::seconds(1);
+	socketUtils::DgramBatch rxBatch(256, 2000);
+	std::vector<uint8_t> recvbuf(2000, 0);
+	while ((result.received < dgramNums) && (std::chrono::steady_clock::now() < deadline))
+	{
+		result.wakeups++;
+		if (batched)
+		{ /// drain the socket, then wait in poll() for up to 5 ms
+			while (rxBatch.next(fd))
+				take(rxBatch.buf(), rxBatch.len());
+			struct pollfd pfd = {fd, POLLIN, 0};
+			poll(&pfd, 1, 5);
+		}
+		else
+		{ /// one datagram per pass, then sleep 5 ms
+			ssize_t bytesReceived = recv(fd, &recvbuf[0], recvbuf.size(), 0);
+			if (bytesReceived > 0)
+				take(recvbuf, (size_t)bytesReceived);
+			usleep(5000);
+		}
+	}
+	waitpid(pid, NULL, 0);
+	close(fd);
+	long long rcvbufErrorsAfter = udpRcvbufErrors();
+	result.rcvbufErrors = ((rcvbufErrors >= 0) && (rcvbufErrorsAfter >= 0)) ? rcvbufErrorsAfter - rcvbufErrors : -1;
+	return(true);
+}
+
+static bool benchLoad(size_t dgramNums, size_t rate)
+{
+	const unsigned long long workUs = 20;
+	std::cout << dgramNums << " datagrams of 80 bytes over loopback, " << workUs << " us per datagram" << std::endl;
+	std::cout << std::setw(14) << "receive loop" << std::setw(10) << "msg/s" << std::setw(10) << "sent";
+	std::cout << std::setw(10) << "received" << std::setw(14) << "RcvbufErrors" << std::setw(10) << "wake-ups";
+	std::cout << std::setw(14) << "out of order" << std::endl;
+	struct loadCase_t
+	{
+		const char* name;
+		bool batched;
+		size_t rate;
+	};
+	const loadCase_t cases[] = {{"recv+sleep", false, rate}, {"DgramBatch", true, rate}, {"DgramBatch", true, 2 * rate}};
+	bool ret = true;
+	for (const auto& c : cases)
+	{
+		loadResult_t result;
+		if (!runLoad(dgramNums, c.rate, c.batched, workUs, result))
+			return(false);
+		std::cout << std::setw(14) << c.name << std::setw(10) << c.rate << std::setw(10) << dgramNums;
+		std::cout << std::setw(10) << result.received << std::setw(14);
+		if (result.rcvbufErrors >= 0)
+			std::cout << result.rcvbufErrors;
+		else
+			std::cout << "n/a";
+		std::cout << std::setw(10) << result.wakeups << std::setw(14) << result.outOfOrder << std::endl;
+		/// the batched loop keeps up: every datagram arrives, in order, and none is dropped by the kernel
+		if (c.batched && ((result.received < dgramNums) || (result.outOfOrder > 0) || (result.rcvbufErrors > 0)))
+		{
+			std::cerr << "DgramBatch received " << result.received << " of " << dgramNums << " datagrams at ";
+			std::cerr << c.rate << " per second" << std::endl;
+			ret = false;
+		}
+	}
+	return(ret);
+}
+
+static unsigned long long nowNs(void)
+{
+	return(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static bool benchDetSeries(void)
+{
+	struct rawSample_t
+	{
+		unsigned long long msec;
+		uint8_t volume;
+		uint8_t occupancy;
+	};
+	const size_t detNums = 64;
+	const unsigned long long dayLen = 86400ULL * 1000ULL;
+	const unsigned long long start = 1000000ULL;  // monotonic clock in milliseconds
+	const unsigned long long end = start + 8 * dayLen;
+	DetSeries detSeries(detNums, start);
+	std::mt19937 rng(1);
+	/// reference: the raw samples of the last 25 hours, by detector
+	std::vector< std::vector<rawSample_t> > raw(detNums);
+	std::vector<uint8_t> volume(detNums);
+	std::vector<uint8_t> occupancy(detNums);
+	unsigned long long insertNs = 0;
+	unsigned long long sampleNums = 0;
+	for (unsigned long long msec = start; msec < end; msec += 1000)
+	{
+		for (size_t det = 0; det < detNums; det++)
+		{ /// occupancy codes above 200 are detector faults
+			volume[det] = (uint8_t)(rng() % 4);
+			occupancy[det] = (uint8_t)((rng() % 500 == 0) ? 210 : rng() % 201);
+		}
+		unsigned long long t0 = nowNs();
+		for (size_t det = 0; det < detNums; det++)
+			detSeries.add(det, volume[det], occupancy[det], msec);
+		insertNs += nowNs() - t0;
+		sampleNums += detNums;
+		if (msec + dayLen + 3600000ULL >= end)
+		{
+			for (size_t det = 0; det < detNums; det++)
+				raw[det].push_back(rawSample_t{msec, volume[det], occupancy[det]});
+		}
+	}
+	unsigned long long now = end - 1;
+	std::cout << detNums << " detectors sampled every second for 8 days" << std::fixed << std::setprecision(1) << std::endl;
+	std::cout << "insert " << (double)insertNs / (double)sampleNums << " ns per detector sample (all tiers), ";
+	std::cout << sampleNums << " samples" << std::endl;
+	std::cout << "memory " << (double)detSeries.memory() / 1024.0 << " KB, " << (double)detSeries.memory() / 1024.0 / detNums;
+	std::cout << " KB per detector for 7 days retained, raw samples " << 86400.0 * sizeof(rawSample_t) / 1024.0;
+	std::cout << " KB per detector-day" << std::endl;
+	std::cout << std::setw(10) << "window" << std::setw(14) << "DetSeries us" << std::setw(14) << "raw scan us";
+	std::cout << std::setw(12) << "mismatches" << std::endl;
+	const unsigned long long windows[] = {60000ULL, 900000ULL, 3600000ULL, dayLen};
+	const char* names[] = {"1 min", "15 min", "1 h", "24 h"};
+	const int reps = 200;
+	std::vector<detAggr_t> aggr;
+	bool ret = true;
+	for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++)
+	{
+		unsigned long long t0 = nowNs();
+		for (int i = 0; i < reps; i++)
+			detSeries.aggregate(aggr, now, windows[w]);
+		double queryUs = (double)(nowNs() - t0) / reps / 1000.0;
+		/// the range DetSeries covers: the current slot and the window / slotLen slots before it, of the 1-second
+		/// tier up to an hour and of the 1-minute tier up to a day
+		unsigned long long slotLen = (windows[w] <= 3600000ULL) ? 1000ULL : 60000ULL;
+		unsigned long long slotNums = (windows[w] <= 3600000ULL) ? 3600ULL : 1440ULL;
+		unsigned long long from = (now / slotLen + 1 - std::min(windows[w] / slotLen + 1, slotNums)) * slotLen;
+		size_t mismatches = 0;
+		t0 = nowNs();
+		for (size_t det = 0; det < detNums; det++)
+		{
+			detAggr_t ref;
+			ref.reset();
+			auto it = std::lower_bound(raw[det].begin(), raw[det].end(), from,
+				[](const rawSample_t& sample, unsigned long long msec) {return(sample.msec < msec);});
+			for (; (it != raw[det].end()) && (it->msec <= now); ++it)
+			{
+				ref.volume += it->volume;
+				if (it->occupancy > 200)
+					ref.faults++;
+				else
+				{
+					ref.occSum += it->occupancy;
+					ref.samples++;
+				}
+			}
+			if ((ref.volume != aggr[det].volume) || (ref.occSum != aggr[det].occSum)
+					|| (ref.samples != aggr[det].samples) || (ref.faults != aggr[det].faults))
+				mismatches++;
+		}
+		double scanUs = (double)(nowNs() - t0) / 1000.0;
+		std::cout << std::setw(10) << names[w] << std::setw(14) << queryUs << std::setw(14) << scanUs;
+		std::cout << std::setw(12) << mismatches << std::endl;
+		if (mismatches > 0)
+		{
+			std::cerr << "DetSeries aggregates differ from raw samples over " << names[w] << std::endl;
+			ret = false;
+		}
+	}
+	return(ret);
+}
+
+int main(int argc, char** argv)
+{
+	int option;
+	size_t iterations = 0;
+	size_t rate = 0;
+	uint16_t port = 25021;
+
+	while ((option = getopt(argc, argv, "n:r:p:?")) != EOF)
+	{
+		switch(option)
+		{
+		case 'n':
+			if ((iterations = (size_t)strtoul(optarg, NULL, 10)) == 0)
+				do_usage(argv[0]);
+			break;
+		case 'r':
+			if ((rate = (size_t)strtoul(optarg, NULL, 10)) == 0)
+				do_usage(argv[0]);
+			break;
+		case 'p':
+			port = (uint16_t)strtoul(optarg, NULL, 10);
+			break;
+		case '?':
+		default:
+			do_usage(argv[0]);
+			break;
+		}
+	}
+	if ((optind != argc - 1) || (rate > 1000000) || (port == 0))
+		do_usage(argv[0]);
+	std::string benchmark = std::string(argv[optind]);
+	if (iterations == 0)
+		iterations = (benchmark == "load") ? 50000 : 10000;
+	if (rate == 0)
+		rate = (benchmark == "load") ? 5000 : 1000;
+
+	bool ret = false;
+	if (benchmark == "poll")
+		ret = benchPoll(iterations, rate, port);
+	else if (benchmark == "load")
+		ret = benchLoad(iterations, rate);
+	else if (benchmark == "detseries")
+		ret = benchDetSeries();
+	else
+		do_usage(argv[0]);
+	exit(ret ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,827 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+/* locAwareBench.cpp
+ * benchmarks and checks of the locationAware library, run offline on an intersection nmap file:
+ *   locate - locateVehicleInMap on BSM trajectories that drive every inbound lane towards the stop-bar and
+ *            every outbound lane away from it (1 m steps, 0.3 m GPS noise), first without tracking state
+ *            (initial locate) and then with the tracking state carried between BSMs as mrpAware does
+ *            (tracked locate). Reports the cost and heap allocations per call, and how many BSMs are located
+ *            on the lane they drive. The check fails when no BSM is located on its lane, or when more than 1%
+ *            of the BSMs located on a lane of the intersection they drive are on another lane of it (where lane
+ *            geometries overlap or a lane bends away from the heading, a BSM can be closer to the next lane).
+ *   grid - cost of finding the intersections whose radius holds a point, a linear scan over all
+ *          intersections against the spatial index (nearedIntersections), on lattices of copies of the
+ *          nmap intersections (up to 252 intersections). The results of the two have to be identical.
+ *   enu  - error of GeoUtils::lla2enuLocal against the exact lla2enu over every lane node of the nmap file,
+ *          and over random points within 1 km of each reference point (-n per reference point). The error
+ *          has to stay within GeoUtils::localMaxError. Also the cost of both conversions.
+ *   replay - cost of locateVehicleInMap on BSM trajectories that drive every lane of the nmap file in both
+ *            directions (1 m steps, 0.5 m GPS noise), with the tracking state carried between BSMs as mrpAware
+ *            does, resuming from the last located lane against projecting onto every lane of the approach.
+ *            The located states of the two have to be identical.
+ *   startup - time to construct LocAware from the text nmap file against the binary nmap image saved from it
+ *            (saveNmapImage), for the nmap file and lattices of its copies (up to 252 intersections). The MAP
+ *            payloads of the two have to be identical.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "locAware.h"
+
+/// count heap allocations of the whole process (including liblocAware) by interposing on glibc malloc
+static unsigned long long allocCnt = 0;
+
+extern "C"
+{
+	void* __libc_malloc(size_t size);
+	void* __libc_calloc(size_t nmemb, size_t size);
+	void* __libc_realloc(void* ptr, size_t size);
+
+	void* malloc(size_t size) throw()
+	{
+		allocCnt++;
+		return(__libc_malloc(size));
+	}
+	void* calloc(size_t nmemb, size_t size) throw()
+	{
+		allocCnt++;
+		return(__libc_calloc(nmemb, size));
+	}
+	void* realloc(void* ptr, size_t size) throw()
+	{
+		allocCnt++;
+		return(__libc_realloc(ptr, size));
+	}
+}
+
+void do_usage(const char* progname)
+{
+	std::cerr << "Usage " << progname << " [options] <benchmark> <nmap file>" << std::endl;
+	std::cerr << "\t-n number of queries (default 20000)" << std::endl;
+	std::cerr << "\t-? print this message" << std::endl;
+	std::cerr << "benchmarks:" << std::endl;
+	std::cerr << "\tlocate  locating BSM trajectories on the lanes they drive, initial and tracked" << std::endl;
+	std::cerr << "\tgrid    intersection lookup, linear scan against the spatial index" << std::endl;
+	std::cerr << "\tenu     lla2enuLocal error bound against lla2enu, and conversion cost" << std::endl;
+	std::cerr << "\treplay  locating BSM trajectories, resuming from the last lane against all lanes" << std::endl;
+	std::cerr << "\tstartup LocAware construction, text nmap file against binary nmap image" << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+static double nsSince(const std::chrono::steady_clock::time_point& t0)
+	{return((double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());}
+
+/// LocAware reports loading on std::cout, keep it out of the benchmark output
+static LocAware* loadLocAware(const std::string& fname)
+{
+	std::ostringstream oss;
+	std::streambuf* coutBuf = std::cout.rdbuf(oss.rdbuf());
+	LocAware* plocAware = new LocAware(fname);
+	std::cout.rdbuf(coutBuf);
+	if (!plocAware->isInitiated())
+	{
+		std::cerr << "Failed initiating LocAware with " << fname << std::endl;
+		delete plocAware;
+		return(nullptr);
+	}
+	return(plocAware);
+}
+
+/// write into fout an nmap file holding 'copies' copies of the intersections in nmap file fname. Copy k is
+/// shifted by whole degrees on a square lattice, and its intersection ids (k * 2000 added), names and
+/// lane connections are renumbered, so that copies neither overlap nor share ids.
+static bool writeLatticeNmap(const std::string& fname, size_t copies, const std::string& fout)
+{
+	std::ifstream IS_NMAP(fname);
+	if (!IS_NMAP.is_open())
+	{
+		std::cerr << "Failed open " << fname << std::endl;
+		return(false);
+	}
+	std::vector<std::string> lines;
+	std::string line;
+	while (std::getline(IS_NMAP, line))
+	{
+		if (!lines.empty() || (line.find("MAP_Name") == 0))
+			lines.push_back(line);
+	}
+	IS_NMAP.close();
+	std::ofstream OS_NMAP(fout);
+	if (!OS_NMAP.is_open())
+	{
+		std::cerr << "Failed open " << fout << std::endl;
+		return(false);
+	}
+	size_t side = (size_t)ceil(sqrt((double)copies));
+	size_t intersectionNums = 0;
+	std::ostringstream body;
+	body << std::fixed << std::setprecision(9);
+	for (size_t k = 0; k < copies; k++)
+	{
+		double dLat = (double)(k / side);
+		double dLon = (double)(k % side);
+		for (const auto& l : lines)
+		{
+			std::istringstream iss(l);
+			std::vector<std::string> tokens;
+			std::string token;
+			while (iss >> token)
+				tokens.push_back(token);
+			if (tokens.empty())
+				body << l << std::endl;
+			else if ((tokens[0] == "MAP_Name") || (tokens[0] == "RSU_ID"))
+			{
+				body << tokens[0] << " " << tokens[1] << "-" << k << std::endl;
+				if (tokens[0] == "MAP_Name")
+					intersectionNums++;
+			}
+			else if (tokens[0] == "IntersectionID")
+				body << tokens[0] << " " << strtoul(tokens[1].c_str(), NULL, 10) + k * 2000 << std::endl;
+			else if (tokens[0] == "Reference_point")
+			{
+				body << tokens[0] << " " << strtod(tokens[1].c_str(), NULL) + dLat << " " << strtod(tokens[2].c_str(), NULL) + dLon;
+				for (size_t i = 3; i < tokens.size(); i++)
+					body << " " << tokens[i];
+				body << std::endl;
+			}
+			else if ((std::count(tokens[0].begin(), tokens[0].end(), '.') == 2) && (tokens.size() == 3))
+			{ // lane node
+				body << tokens[0] << " " << strtod(tokens[1].c_str(), NULL) + dLat;
+				body << " " << strtod(tokens[2].c_str(), NULL) + dLon << std::endl;
+			}
+			else if ((std::count(tokens[0].begin(), tokens[0].end(), '.') == 2) && (tokens.size() == 2))
+			{ // lane connection, intersectionId.approachId.laneId
+				size_t pos = tokens[0].find('.');
+				body << strtoul(tokens[0].substr(0, pos).c_str(), NULL, 10) + k * 2000 << tokens[0].substr(pos);
+				body << " " << tokens[1] << std::endl;
+			}
+			else
+				body << l << std::endl;
+		}
+	}
+	OS_NMAP << intersectionNums << " Intersections" << std::endl;
+	OS_NMAP << "--------------------------------------------------------------------------------" << std::endl;
+	OS_NMAP << body.str();
+	OS_NMAP.close();
+	return(true);
+}
+
+/// the private intersection lookups of LocAware (LocAwareBench is a friend of LocAware)
+struct LocAwareBench
+{
+	static bool isPointNearIntersection(const LocAware& locAware, uint8_t intersectionIndex, const GeoUtils::geoPoint_t& geoPoint)
+		{return(locAware.isPointNearIntersection(intersectionIndex, geoPoint));};
+	static std::vector<uint8_t> nearedIntersections(const LocAware& locAware, const GeoUtils::geoPoint_t& geoPoint)
+		{return(locAware.nearedIntersections(geoPoint));};
+};
+
+static bool benchGrid(const std::string& fnmap, size_t queryNums)
+{
+	std::string fname = std::string("/tmp/locAwareBench.") + std::to_string(getpid()) + ".nmap";
+	std::cout << std::setw(14) << "intersections" << std::setw(14) << "linear scan" << std::setw(14) << "grid";
+	std::cout << std::setw(10) << "hits" << std::setw(12) << "mismatches" << "  (ns per lookup)" << std::endl;
+	bool ret = true;
+	for (size_t copies : {1, 4, 10, 21})
+	{
+		if (!writeLatticeNmap(fnmap, copies, fname))
+			return(false);
+		LocAware* plocAware = loadLocAware(fname);
+		std::remove(fname.c_str());
+		if (plocAware == nullptr)
+			return(false);
+		/// half of the queries within about 300 m of an intersection, the other half anywhere on the lattice
+		size_t intersectionNums = plocAware->getIntersectionIds().size();
+		std::vector<GeoUtils::geoPoint_t> refs(intersectionNums);
+		for (size_t i = 0; i < intersectionNums; i++)
+			GeoUtils::geoRefPoint2geoPoint(plocAware->getIntersectionRefPoint((uint8_t)i), refs[i]);
+		double minLat = 90, maxLat = -90, minLon = 180, maxLon = -180;
+		for (const auto& ref : refs)
+		{
+			minLat = std::min(minLat, ref.latitude);
+			maxLat = std::max(maxLat, ref.latitude);
+			minLon = std::min(minLon, ref.longitude);
+			maxLon = std::max(maxLon, ref.longitude);
+		}
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<double> near(-0.003, 0.003);
+		std::uniform_real_distribution<double> lat(minLat - 0.01, maxLat + 0.01);
+		std::uniform_real_distribution<double> lon(minLon - 0.01, maxLon + 0.01);
+		std::vector<GeoUtils::geoPoint_t> queries(queryNums);
+		for (size_t j = 0; j < queryNums; j++)
+		{
+			if ((j % 2) == 0)
+			{
+				queries[j] = refs[rng() % refs.size()];
+				queries[j].latitude += near(rng);
+				queries[j].longitude += near(rng);
+			}
+			else
+			{
+				queries[j].latitude = lat(rng);
+				queries[j].longitude = lon(rng);
+				queries[j].elevation = 0;
+			}
+		}
+		std::vector< std::vector<uint8_t> > linearResults(queryNums);
+		auto t0 = std::chrono::steady_clock::now();
+		for (size_t j = 0; j < queryNums; j++)
+		{
+			for (size_t i = 0; i < intersectionNums; i++)
+			{
+				if (LocAwareBench::isPointNearIntersection(*plocAware, (uint8_t)i, queries[j]))
+					linearResults[j].push_back((uint8_t)i);
+			}
+		}
+		double linearNs = nsSince(t0);
+		std::vector< std::vector<uint8_t> > gridResults(queryNums);
+		t0 = std::chrono::steady_clock::now();
+		for (size_t j = 0; j < queryNums; j++)
+			gridResults[j] = LocAwareBench::nearedIntersections(*plocAware, queries[j]);
+		double gridNs = nsSince(t0);
+		size_t hits = 0;
+		size_t mismatches = 0;
+		for (size_t j = 0; j < queryNums; j++)
+		{
+			hits += gridResults[j].size();
+			if (gridResults[j] != linearResults[j])
+				mismatches++;
+		}
+		if (mismatches > 0)
+			ret = false;
+		std::cout << std::fixed << std::setprecision(0);
+		std::cout << std::setw(14) << intersectionNums << std::setw(14) << linearNs / (double)queryNums;
+		std::cout << std::setw(14) << gridNs / (double)queryNums << std::setw(10) << hits << std::setw(12) << mismatches << std::endl;
+		delete plocAware;
+	}
+	return(ret);
+}
+
+static bool benchEnu(const std::string& fnmap, size_t queryNums)
+{
+	std::ifstream IS_NMAP(fnmap);
+	if (!IS_NMAP.is_open())
+	{
+		std::cerr << "Failed open " << fnmap << std::endl;
+		return(false);
+	}
+	/// reference points, and lane nodes with the reference point they belong to
+	std::vector<GeoUtils::geoPoint_t> refs;
+	std::vector< std::pair<size_t, GeoUtils::geoPoint_t> > points;
+	std::string line;
+	while (std::getline(IS_NMAP, line))
+	{
+		std::istringstream iss(line);
+		std::vector<std::string> tokens;
+		std::string token;
+		while (iss >> token)
+			tokens.push_back(token);
+		if ((tokens.size() >= 3) && (tokens[0] == "Reference_point"))
+		{
+			GeoUtils::geoPoint_t geoPoint;
+			geoPoint.latitude = strtod(tokens[1].c_str(), NULL);
+			geoPoint.longitude = strtod(tokens[2].c_str(), NULL);
+			geoPoint.elevation = (tokens.size() > 3) ? strtod(tokens[3].c_str(), NULL) / DsrcConstants::deca : 0.0;
+			refs.push_back(geoPoint);
+		}
+		else if (!refs.empty() && (tokens.size() == 3) && (std::count(tokens[0].begin(), tokens[0].end(), '.') == 2))
+		{
+			GeoUtils::geoPoint_t geoPoint = refs.back();
+			geoPoint.latitude = strtod(tokens[1].c_str(), NULL);
+			geoPoint.longitude = strtod(tokens[2].c_str(), NULL);
+			points.push_back(std::make_pair(refs.size() - 1, geoPoint));
+		}
+	}
+	IS_NMAP.close();
+	size_t nodeNums = points.size();
+	if (nodeNums == 0)
+	{
+		std::cerr << "No lane node in " << fnmap << std::endl;
+		return(false);
+	}
+	std::vector<GeoUtils::enuCoord_t> enuCoords(refs.size());
+	for (size_t i = 0; i < refs.size(); i++)
+		GeoUtils::setEnuCoord(refs[i], enuCoords[i]);
+	/// random points within 1 km and 50 m in elevation of each reference point
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<double> unit(-1.0, 1.0);
+	for (size_t i = 0; i < refs.size(); i++)
+	{
+		for (size_t j = 0; j < queryNums; j++)
+		{
+			GeoUtils::geoPoint_t geoPoint = refs[i];
+			geoPoint.latitude += unit(rng) * 1000.0 / 111000.0;
+			geoPoint.longitude += unit(rng) * 1000.0 / (111000.0 * cos(DsrcConstants::deg2rad(refs[i].latitude)));
+			geoPoint.elevation += unit(rng) * 50.0;
+			points.push_back(std::make_pair(i, geoPoint));
+		}
+	}
+	double nodeErr = 0;
+	double maxErr = 0;
+	double maxErrZ = 0;
+	for (size_t k = 0; k < points.size(); k++)
+	{
+		GeoUtils::point3D_t exact, local;
+		GeoUtils::lla2enu(enuCoords[points[k].first], points[k].second, exact);
+		GeoUtils::lla2enuLocal(enuCoords[points[k].first], points[k].second, local);
+		double err = std::sqrt((exact.x - local.x) * (exact.x - local.x) + (exact.y - local.y) * (exact.y - local.y));
+		if (k < nodeNums)
+			nodeErr = std::max(nodeErr, err);
+		maxErr = std::max(maxErr, err);
+		maxErrZ = std::max(maxErrZ, std::abs(exact.z - local.z));
+	}
+	double exactSum = 0;
+	double localSum = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	for (const auto& pt : points)
+	{
+		GeoUtils::point3D_t ptENU;
+		GeoUtils::lla2enu(enuCoords[pt.first], pt.second, ptENU);
+		exactSum += ptENU.x;
+	}
+	double exactNs = nsSince(t0);
+	t0 = std::chrono::steady_clock::now();
+	for (const auto& pt : points)
+	{
+		GeoUtils::point3D_t ptENU;
+		GeoUtils::lla2enuLocal(enuCoords[pt.first], pt.second, ptENU);
+		localSum += ptENU.x;
+	}
+	double localNs = nsSince(t0);
+	bool ret = (nodeErr <= GeoUtils::localMaxError) && (maxErr <= GeoUtils::localMaxError) && (maxErrZ <= GeoUtils::localMaxError)
+		&& (std::abs(exactSum - localSum) <= GeoUtils::localMaxError * (double)points.size());
+	std::cout << refs.size() << " reference points, " << nodeNums << " lane nodes, ";
+	std::cout << points.size() - nodeNums << " random points within 1 km" << std::endl;
+	std::cout << std::scientific << std::setprecision(2);
+	std::cout << "lla2enuLocal against lla2enu: max horizontal error " << nodeErr << " m on lane nodes, " << maxErr;
+	std::cout << " m on all points, max vertical error " << maxErrZ << " m (bound " << GeoUtils::localMaxError << " m)" << std::endl;
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "lla2enu " << exactNs / (double)points.size() << " ns, lla2enuLocal " << localNs / (double)points.size();
+	std::cout << " ns per conversion" << std::endl;
+	if (!ret)
+		std::cerr << "lla2enuLocal error exceeds " << GeoUtils::localMaxError << " m" << std::endl;
+	return(ret);
+}
+
+static bool isSameTracking(const GeoUtils::vehicleTracking_t& s1, const GeoUtils::vehicleTracking_t& s2)
+{
+	return((s1.intsectionTrackingState.vehicleIntersectionStatus == s2.intsectionTrackingState.vehicleIntersectionStatus)
+		&& (s1.intsectionTrackingState.intersectionIndex == s2.intsectionTrackingState.intersectionIndex)
+		&& (s1.intsectionTrackingState.approachIndex == s2.intsectionTrackingState.approachIndex)
+		&& (s1.intsectionTrackingState.laneIndex == s2.intsectionTrackingState.laneIndex)
+		&& (s1.laneProj.nodeIndex == s2.laneProj.nodeIndex)
+		&& (s1.laneProj.proj2segment.t == s2.laneProj.proj2segment.t)
+		&& (s1.laneProj.proj2segment.d == s2.laneProj.proj2segment.d)
+		&& (s1.laneProj.proj2segment.length == s2.laneProj.proj2segment.length));
+}
+
+static bool benchReplay(const std::string& fnmap, size_t queryNums)
+{
+	LocAware* plocAware = loadLocAware(fnmap);
+	if (plocAware == nullptr)
+		return(false);
+	std::ifstream IS_NMAP(fnmap);
+	if (!IS_NMAP.is_open())
+	{
+		std::cerr << "Failed open " << fnmap << std::endl;
+		delete plocAware;
+		return(false);
+	}
+	/// lane nodes, a lane starts at node 1
+	std::vector< std::vector<GeoUtils::geoPoint_t> > lanes;
+	std::string line;
+	while (std::getline(IS_NMAP, line))
+	{
+		std::istringstream iss(line);
+		std::vector<std::string> tokens;
+		std::string token;
+		while (iss >> token)
+			tokens.push_back(token);
+		if ((tokens.size() != 3) || (std::count(tokens[0].begin(), tokens[0].end(), '.') != 2))
+			continue;
+		if ((lanes.empty()) || (tokens[0].substr(tokens[0].rfind('.') + 1) == "1"))
+			lanes.push_back(std::vector<GeoUtils::geoPoint_t>());
+		GeoUtils::geoPoint_t geoPoint;
+		geoPoint.latitude = strtod(tokens[1].c_str(), NULL);
+		geoPoint.longitude = strtod(tokens[2].c_str(), NULL);
+		geoPoint.elevation = 0.0;
+		lanes.back().push_back(geoPoint);
+	}
+	IS_NMAP.close();
+	/// BSM trajectories: every lane in both directions at 10 m/s and 10 Hz, with 0.5 m GPS noise,
+	/// repeated with different noise until there are at least queryNums BSMs
+	const double mPerDegree = 111320.0;
+	std::mt19937 rng(11);
+	std::normal_distribution<double> noise(0.0, 0.5);
+	std::vector<GeoUtils::connectedVehicle_t> bsms;
+	std::vector<bool> isFirst;
+	while (bsms.size() < queryNums)
+	{
+		size_t bsmNums = bsms.size();
+		for (auto nodes : lanes)
+		{
+			if (nodes.size() < 2)
+				continue;
+			for (int dir = 0; dir < 2; dir++)
+			{
+				if (dir == 1)
+					std::reverse(nodes.begin(), nodes.end());
+				bool first = true;
+				for (size_t i = 0; i + 1 < nodes.size(); i++)
+				{
+					double cosLat = cos(DsrcConstants::deg2rad(nodes[i].latitude));
+					double dy = (nodes[i+1].latitude - nodes[i].latitude) * mPerDegree;
+					double dx = (nodes[i+1].longitude - nodes[i].longitude) * mPerDegree * cosLat;
+					double length = std::sqrt(dx * dx + dy * dy);
+					double heading = atan2(dx, dy) * DsrcConstants::rad2degree;
+					if (heading < 0.0)
+						heading += 360.0;
+					for (double s = 0.0; s < length; s += 1.0)
+					{
+						GeoUtils::connectedVehicle_t cv;
+						cv.reset();
+						cv.msec = 0;
+						cv.id = 0;
+						cv.geoPoint.latitude = nodes[i].latitude + s / length * (nodes[i+1].latitude - nodes[i].latitude) + noise(rng) / mPerDegree;
+						cv.geoPoint.longitude = nodes[i].longitude + s / length * (nodes[i+1].longitude - nodes[i].longitude)
+							+ noise(rng) / (mPerDegree * cosLat);
+						cv.geoPoint.elevation = 0.0;
+						cv.motionState.speed = 10.0;
+						cv.motionState.heading = heading;
+						bsms.push_back(cv);
+						isFirst.push_back(first);
+						first = false;
+					}
+				}
+			}
+		}
+		if (bsms.size() == bsmNums)
+		{
+			std::cerr << "No lane in " << fnmap << std::endl;
+			delete plocAware;
+			return(false);
+		}
+	}
+	/// replay the trajectories with and without resuming from the last lane, the best of 3 runs
+	std::vector<GeoUtils::vehicleTracking_t> hintStates(bsms.size());
+	std::vector<bool> hintInMap(bsms.size());
+	double bestNs[2] = {0.0, 0.0};
+	size_t trackedNums = 0;
+	size_t sameLaneNums = 0;
+	size_t mismatches = 0;
+	for (int run = 0; run < 6; run++)
+	{
+		bool hint = (run % 2 == 0);
+		plocAware->setLaneHint(hint);
+		GeoUtils::vehicleTracking_t trackingState;
+		trackingState.reset();
+		bool isInMap = false;
+		trackedNums = 0;
+		sameLaneNums = 0;
+		auto t0 = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < bsms.size(); i++)
+		{
+			auto& cv = bsms[i];
+			if (isFirst[i])
+				isInMap = false;
+			cv.isVehicleInMap = isInMap;
+			if (isInMap)
+			{
+				cv.vehicleTrackingState = trackingState;
+				trackedNums++;
+			}
+			isInMap = plocAware->locateVehicleInMap(cv, trackingState);
+			if (cv.isVehicleInMap && isInMap
+				&& (trackingState.intsectionTrackingState.intersectionIndex == cv.vehicleTrackingState.intsectionTrackingState.intersectionIndex)
+				&& (trackingState.intsectionTrackingState.approachIndex == cv.vehicleTrackingState.intsectionTrackingState.approachIndex)
+				&& (trackingState.intsectionTrackingState.laneIndex == cv.vehicleTrackingState.intsectionTrackingState.laneIndex))
+				sameLaneNums++;
+			if (run == 0)
+			{
+				hintStates[i] = trackingState;
+				hintInMap[i] = isInMap;
+			}
+			else if (run == 1)
+			{
+				if ((isInMap != hintInMap[i]) || (isInMap && !isSameTracking(trackingState, hintStates[i])))
+					mismatches++;
+			}
+		}
+		double ns = nsSince(t0) / (double)bsms.size();
+		if ((run < 2) || (ns < bestNs[run % 2]))
+			bestNs[run % 2] = ns;
+	}
+	delete plocAware;
+	std::cout << bsms.size() << " BSMs on " << lanes.size() << " lanes, " << trackedNums << " tracked, ";
+	std::cout << sameLaneNums << " located on the previous lane (" << std::fixed << std::setprecision(1);
+	std::cout << 100.0 * (double)sameLaneNums / (double)trackedNums << "% of tracked)" << std::endl;
+	std::cout << std::setw(24) << "all lanes" << std::setw(14) << "last lane" << "  (ns per BSM)" << std::endl;
+	std::cout << std::setw(24) << bestNs[1] << std::setw(14) << bestNs[0] << std::endl;
+	if (mismatches > 0)
+		std::cerr << mismatches << " BSMs located differently when resuming from the last lane" << std::endl;
+	return(mismatches == 0);
+}
+
+/// a lane of the nmap file with its nodes in the order a vehicle drives them
+struct nmapLane_t
+{
+	uint16_t intersectionId;
+	uint8_t  laneId;
+	std::vector<GeoUtils::geoPoint_t> nodes;
+};
+
+static bool benchLocate(const std::string& fnmap, size_t queryNums)
+{
+	LocAware* plocAware = loadLocAware(fnmap);
+	if (plocAware == nullptr)
+		return(false);
+	std::ifstream IS_NMAP(fnmap);
+	if (!IS_NMAP.is_open())
+	{
+		std::cerr << "Failed open " << fnmap << std::endl;
+		delete plocAware;
+		return(false);
+	}
+	/// inbound lanes are driven from the last node to node 1 (the stop-bar), outbound lanes from node 1 on
+	std::vector<nmapLane_t> lanes;
+	uint16_t intersectionId = 0;
+	int approachType = 0;
+	std::string line;
+	while (std::getline(IS_NMAP, line))
+	{
+		std::istringstream iss(line);
+		std::vector<std::string> tokens;
+		std::string token;
+		while (iss >> token)
+			tokens.push_back(token);
+		if (tokens.size() < 2)
+		{
+			if ((tokens.size() == 1) && (tokens[0] == "end_lane") && !lanes.empty() && (approachType == 1))
+				std::reverse(lanes.back().nodes.begin(), lanes.back().nodes.end());
+			continue;
+		}
+		if (tokens[0] == "IntersectionID")
+			intersectionId = (uint16_t)strtoul(tokens[1].c_str(), NULL, 10);
+		else if (tokens[0] == "Approach_type")
+			approachType = (int)strtol(tokens[1].c_str(), NULL, 10);
+		else if ((tokens[0] == "Lane_ID") && ((approachType == 1) || (approachType == 2)))
+			lanes.push_back(nmapLane_t{intersectionId, (uint8_t)strtoul(tokens[1].c_str(), NULL, 10), {}});
+		else if ((tokens.size() == 3) && (std::count(tokens[0].begin(), tokens[0].end(), '.') == 2)
+			&& !lanes.empty() && ((approachType == 1) || (approachType == 2)))
+		{
+			GeoUtils::geoPoint_t geoPoint;
+			geoPoint.latitude = strtod(tokens[1].c_str(), NULL);
+			geoPoint.longitude = strtod(tokens[2].c_str(), NULL);
+			geoPoint.elevation = 0.0;
+			lanes.back().nodes.push_back(geoPoint);
+		}
+	}
+	IS_NMAP.close();
+	/// BSM trajectories at 10 m/s and 10 Hz, repeated with different noise until there are at least queryNums BSMs
+	const double mPerDegree = 111320.0;
+	std::mt19937 rng(13);
+	std::normal_distribution<double> noise(0.0, 0.3);
+	std::vector<GeoUtils::connectedVehicle_t> bsms;
+	std::vector<size_t> laneOf;
+	std::vector<bool> isFirst;
+	while (bsms.size() < queryNums)
+	{
+		size_t bsmNums = bsms.size();
+		for (size_t k = 0; k < lanes.size(); k++)
+		{
+			const auto& nodes = lanes[k].nodes;
+			bool first = true;
+			for (size_t i = 0; i + 1 < nodes.size(); i++)
+			{
+				double cosLat = cos(DsrcConstants::deg2rad(nodes[i].latitude));
+				double dy = (nodes[i+1].latitude - nodes[i].latitude) * mPerDegree;
+				double dx = (nodes[i+1].longitude - nodes[i].longitude) * mPerDegree * cosLat;
+				double length = std::sqrt(dx * dx + dy * dy);
+				double heading = atan2(dx, dy) * DsrcConstants::rad2degree;
+				if (heading < 0.0)
+					heading += 360.0;
+				for (double s = 0.0; s < length; s += 1.0)
+				{
+					GeoUtils::connectedVehicle_t cv;
+					cv.reset();
+					cv.msec = 0;
+					cv.id = 0;
+					cv.geoPoint.latitude = nodes[i].latitude + s / length * (nodes[i+1].latitude - nodes[i].latitude) + noise(rng) / mPerDegree;
+					cv.geoPoint.longitude = nodes[i].longitude + s / length * (nodes[i+1].longitude - nodes[i].longitude)
+						+ noise(rng) / (mPerDegree * cosLat);
+					cv.geoPoint.elevation = 0.0;
+					cv.motionState.speed = 10.0;
+					cv.motionState.heading = heading;
+					bsms.push_back(cv);
+					laneOf.push_back(k);
+					isFirst.push_back(first);
+					first = false;
+				}
+			}
+		}
+		if (bsms.size() == bsmNums)
+		{
+			std::cerr << "No lane in " << fnmap << std::endl;
+			delete plocAware;
+			return(false);
+		}
+	}
+	std::vector<uint16_t> intersectionIds = plocAware->getIntersectionIds();
+	/// whether the tracking state puts the vehicle on the lane it drives (1), on another lane of the same
+	/// intersection (-1), or elsewhere (0)
+	auto onLane = [&](const GeoUtils::vehicleTracking_t& state, const nmapLane_t& lane)->int
+	{
+		const auto& intState = state.intsectionTrackingState;
+		if (((intState.vehicleIntersectionStatus != MsgEnum::mapLocType::onInbound)
+				&& (intState.vehicleIntersectionStatus != MsgEnum::mapLocType::onOutbound))
+				|| (intersectionIds[intState.intersectionIndex] != lane.intersectionId))
+			return(0);
+		return((plocAware->getLaneIdByIndexes(intState.intersectionIndex, intState.approachIndex, intState.laneIndex) == lane.laneId) ? 1 : -1);
+	};
+	/// initial locate, then tracked locate, the best of 3 runs
+	double bestNs[2] = {0.0, 0.0};
+	double allocs[2] = {0.0, 0.0};
+	size_t locatedNums[2] = {0, 0};
+	size_t laneNums[2] = {0, 0};
+	size_t wrongNums[2] = {0, 0};
+	for (int run = 0; run < 6; run++)
+	{
+		int tracked = run % 2;
+		GeoUtils::vehicleTracking_t trackingState;
+		trackingState.reset();
+		bool isInMap = false;
+		locatedNums[tracked] = 0;
+		laneNums[tracked] = 0;
+		wrongNums[tracked] = 0;
+		unsigned long long allocStart = allocCnt;
+		auto t0 = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < bsms.size(); i++)
+		{
+			auto& cv = bsms[i];
+			if ((tracked == 0) || isFirst[i])
+				isInMap = false;
+			cv.isVehicleInMap = isInMap;
+			if (isInMap)
+				cv.vehicleTrackingState = trackingState;
+			isInMap = plocAware->locateVehicleInMap(cv, trackingState);
+			if (isInMap)
+			{
+				locatedNums[tracked]++;
+				int result = onLane(trackingState, lanes[laneOf[i]]);
+				if (result > 0)
+					laneNums[tracked]++;
+				else if (result < 0)
+					wrongNums[tracked]++;
+			}
+		}
+		double ns = nsSince(t0) / (double)bsms.size();
+		allocs[tracked] = (double)(allocCnt - allocStart) / (double)bsms.size();
+		if ((run < 2) || (ns < bestNs[tracked]))
+			bestNs[tracked] = ns;
+	}
+	delete plocAware;
+	std::cout << bsms.size() << " BSMs on " << lanes.size() << " lanes" << std::endl;
+	std::cout << std::setw(16) << "" << std::setw(10) << "ns/call" << std::setw(14) << "allocs/call" << std::setw(10) << "located";
+	std::cout << std::setw(10) << "on lane" << std::setw(12) << "wrong lane" << std::endl;
+	for (int tracked = 0; tracked < 2; tracked++)
+	{
+		std::cout << std::setw(16) << ((tracked == 0) ? "initial locate" : "tracked locate") << std::fixed << std::setprecision(0);
+		std::cout << std::setw(10) << bestNs[tracked] << std::setprecision(2) << std::setw(14) << allocs[tracked];
+		std::cout << std::setw(10) << locatedNums[tracked] << std::setw(10) << laneNums[tracked] << std::setw(12) << wrongNums[tracked] << std::endl;
+	}
+	bool ret = true;
+	for (int tracked = 0; tracked < 2; tracked++)
+	{
+		if ((laneNums[tracked] == 0) || (wrongNums[tracked] * 100 > laneNums[tracked] + wrongNums[tracked]))
+			ret = false;
+	}
+	if (!ret)
+		std::cerr << "BSMs are not located on the lanes they drive" << std::endl;
+	return(ret);
+}
+
+static bool benchStartup(const std::string& fnmap)
+{
+	const int runs = 5;
+	std::string fname = std::string("/tmp/locAwareBench.") + std::to_string(getpid()) + ".nmap";
+	std::string fimage = fname + ".img";
+	std::cout << "LocAware construction, best of " << runs << " runs, files in the page cache" << std::endl;
+	std::cout << std::setw(14) << "intersections" << std::setw(14) << "text ms" << std::setw(14) << "image ms";
+	std::cout << std::setw(14) << "text bytes" << std::setw(14) << "image bytes" << std::setw(12) << "mismatches" << std::endl;
+	bool ret = true;
+	for (size_t copies : {0, 4, 10, 21})
+	{ /// copies 0 is the nmap file itself
+		std::string ftext = (copies == 0) ? fnmap : fname;
+		if ((copies > 0) && !writeLatticeNmap(fnmap, copies, fname))
+			return(false);
+		LocAware* ptext = loadLocAware(ftext);
+		if ((ptext == nullptr) || !ptext->saveNmapImage(fimage))
+		{
+			std::cerr << "Failed saving nmap image " << fimage << std::endl;
+			delete ptext;
+			std::remove(fname.c_str());
+			return(false);
+		}
+		double textMs = 0.0;
+		double imageMs = 0.0;
+		size_t mismatches = 0;
+		for (int r = 0; r < runs; r++)
+		{
+			auto t0 = std::chrono::steady_clock::now();
+			LocAware* p = loadLocAware(ftext);
+			double ms = nsSince(t0) / 1e6;
+			textMs = (r == 0) ? ms : std::min(textMs, ms);
+			delete p;
+			t0 = std::chrono::steady_clock::now();
+			p = loadLocAware(fimage);
+			ms = nsSince(t0) / 1e6;
+			imageMs = (r == 0) ? ms : std::min(imageMs, ms);
+			if (p == nullptr)
+			{
+				mismatches++;
+				continue;
+			}
+			/// the image gives the same intersections and MAP payloads as the text file
+			if (p->getIntersectionIds() != ptext->getIntersectionIds())
+				mismatches++;
+			else
+			{
+				for (const auto& intersectionId : p->getIntersectionIds())
+				{
+					if (p->getMapdataPayload(intersectionId) != ptext->getMapdataPayload(intersectionId))
+						mismatches++;
+				}
+			}
+			delete p;
+		}
+		size_t intersectionNums = ptext->getIntersectionIds().size();
+		delete ptext;
+		struct stat textStat;
+		struct stat imageStat;
+		bool sized = (stat(ftext.c_str(), &textStat) == 0) && (stat(fimage.c_str(), &imageStat) == 0);
+		std::remove(fimage.c_str());
+		if (copies > 0)
+			std::remove(fname.c_str());
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << std::setw(14) << intersectionNums << std::setw(14) << textMs << std::setw(14) << imageMs;
+		std::cout << std::setw(14) << ((sized) ? (long long)textStat.st_size : -1);
+		std::cout << std::setw(14) << ((sized) ? (long long)imageStat.st_size : -1) << std::setw(12) << mismatches << std::endl;
+		if (mismatches > 0)
+			ret = false;
+	}
+	return(ret);
+}
+
+int main(int argc, char** argv)
+{
+	int option;
+	size_t queryNums = 20000;
+
+	while ((option = getopt(argc, argv, "n:?")) != EOF)
+	{
+		switch(option)
+		{
+		case 'n':
+			queryNums = (size_t)strtoul(optarg, NULL, 10);
+			break;
+		case '?':
+		default:
+			do_usage(argv[0]);
+			break;
+		}
+	}
+	if ((optind != argc - 2) || (queryNums == 0))
+		do_usage(argv[0]);
+	std::string benchmark = std::string(argv[optind]);
+	std::string fnmap = std::string(argv[optind + 1]);
+
+	bool ret = false;
+	if (benchmark == "locate")
+		ret = benchLocate(fnmap, queryNums);
+	else if (benchmark == "grid")
+		ret = benchGrid(fnmap, queryNums);
+	else if (benchmark == "enu")
+		ret = benchEnu(fnmap, queryNums);
+	else if (benchmark == "replay")
+		ret = benchReplay(fnmap, queryNums);
+	else if (benchmark == "startup")
+		ret = benchStartup(fnmap);
+	else
+		do_usage(argv[0]);
+	exit(ret ? EXIT_SUCCESS : EXIT_FAILURE);
+}
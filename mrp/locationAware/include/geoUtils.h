@@ -53,6 +53,10 @@ namespace GeoUtils
 	{
 		GeoUtils::point3D_t     pointECEF;        // ENU origin reference in ECEF
 		GeoUtils::transMatrix_t transMatrix;
+		// coefficients for lla2enuLocal
+		double latitude_r;                        // ENU origin reference latitude, in radians
+		double longitude_r;                       // ENU origin reference longitude, in radians
+		double meridianDist;                      // distance of ENU origin reference from the polar axis, in meters
 	};
 
 	struct point2D_t
@@ -244,6 +248,11 @@ namespace GeoUtils
 		};
 	};
 
+	// lla2enuLocal agrees with lla2enu within localMaxError (in meters) on each ENU coordinate for points
+	// within about 60 km of the ENU origin. The series truncation error is below 1e-10 meters, the rest is
+	// floating-point rounding of the two conversions.
+	const double localMaxError = 1e-8;
+
 	// methods
 	void geoPoint2geoRefPoint(const GeoUtils::geoPoint_t& geoPoint, GeoUtils::geoRefPoint_t& geoRef);
 	void geoRefPoint2geoPoint(const GeoUtils::geoRefPoint_t& geoRef, GeoUtils::geoPoint_t& geoPoint);
@@ -254,6 +263,8 @@ namespace GeoUtils
 	void lla2enu(const GeoUtils::enuCoord_t& enuCoord, const GeoUtils::geoPoint_t& geoPoint, GeoUtils::point3D_t& ptENU);
 	void lla2enu(const GeoUtils::enuCoord_t& enuCoord, const GeoUtils::geoPoint_t& geoPoint, GeoUtils::point2D_t& ptENU);
 	void lla2enu(const GeoUtils::enuCoord_t& enuCoord, const GeoUtils::geoRefPoint_t& geoRef, GeoUtils::point2D_t& ptENU);
+	void lla2enuLocal(const GeoUtils::enuCoord_t& enuCoord, const GeoUtils::geoPoint_t& geoPoint, GeoUtils::point3D_t& ptENU);
+	void lla2enuLocal(const GeoUtils::enuCoord_t& enuCoord, const GeoUtils::geoPoint_t& geoPoint, GeoUtils::point2D_t& ptENU);
 	void enu2ecef(const GeoUtils::enuCoord_t& enuCoord, const GeoUtils::point3D_t& ptENU, GeoUtils::point3D_t& ptECEF);
 	void enu2ecef(const GeoUtils::enuCoord_t& enuCoord, const GeoUtils::point2D_t& ptENU, GeoUtils::point3D_t& ptECEF);
 	void ecef2lla(const GeoUtils::point3D_t& ptECEF, GeoUtils::geoPoint_t& geoPoint);
@@ -264,6 +275,8 @@ namespace GeoUtils
 	long dotProduct(const GeoUtils::vector2D_t& v1, const GeoUtils::vector2D_t& v2);
 	long crossProduct(const GeoUtils::vector2D_t& v1, const GeoUtils::vector2D_t& v2);
 	long cross(const GeoUtils::point2D_t& O, const GeoUtils::point2D_t& A, const GeoUtils::point2D_t& B);
+	void projectPt2Lines(const GeoUtils::point2D_t& pt, const double* x0, const double* y0, const double* ux, const double* uy,
+		const double* length, size_t size, double* t, double* d);
 	void projectPt2Line(const GeoUtils::point2D_t& startPoint, const GeoUtils::point2D_t& endPoint,
 		const GeoUtils::point2D_t& pt, GeoUtils::projection_t& proj2line);
 	MsgEnum::polygonType convexcave(const std::vector<GeoUtils::point2D_t>& p);
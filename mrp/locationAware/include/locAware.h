@@ -8,14 +8,20 @@
 #define _MRPLOCAWARE_H
 
 #include <map>
+#include <unordered_map>
 #include "AsnJ2735Lib.h"
 #include "mapDataStruct.h"
 
 class LocAware
 {
+	// locAwareBench compares the spatial index against the linear scan through LocAwareBench
+	friend struct LocAwareBench;
+
 	private:
 		bool initiated;
 		bool mapUpdated;
+		bool nmapImage;  // nmap file is a binary image
+		bool laneHint;   // resume locating a tracked vehicle from the lane it was located on
 		// store intersection MAP data
 		std::vector<NmapData::IntersectionStruct> mpIntersection;
 		// map between (intersectionId, laneId) and (intersection, approach, lane)
@@ -23,15 +29,27 @@ class LocAware
 		// key:   (intersectionId << 8) | laneId
 		// value: (intIndx << 16) | (appIndx << 8) | laneIndx
 		std::map<uint32_t, uint32_t> IndexMap;
+		// spatial index over intersection reference points and radii: a uniform latitude/longitude grid.
+		// key:   (latitude cell << 32) | longitude cell
+		// value: indexes in mpIntersection of intersections whose radius overlaps the cell (ascending)
+		double gridCellSize;  // in degrees
+		std::unordered_map<uint64_t, std::vector<uint8_t>> spatialIndex;
 		// for saving updated MapData into file
 		std::string nmapFileName;
 
 		// processing intersection nmap file
 		bool readNmap(const std::string& fname);
 		void saveNmap(const std::string& fname) const;
+		// processing binary nmap image (nmapImage.cpp)
+		static bool isNmapImage(const std::string& fname);
+		bool readNmapImage(const std::string& fname);
 		void setLocalOffsetAndHeading(void);
 		void buildPolygons(void);
 		void buildPolygons(NmapData::IntersectionStruct& intObj);
+		void buildSegments(void);
+		void buildSegments(NmapData::IntersectionStruct& intObj);
+		void buildSpatialIndex(void);
+		uint64_t getGridCellKey(double latitude, double longitude) const;
 
 		// UPER encoding MapData
 		size_t encode_mapdata_payload(void);
@@ -46,14 +64,17 @@ class LocAware
 		std::vector<uint16_t> getIdsByIndexes(uint8_t intersectionIndx, uint8_t approachIndx, uint8_t laneIndx) const;
 		// locating vehicle BSM on intersection Map
 		bool isPointNearIntersection(uint8_t intersectionIndex, const GeoUtils::geoPoint_t& geoPoint) const;
+		// indexes of intersections whose radius holds geoPoint (ascending), looked up in the spatial index
+		std::vector<uint8_t> nearedIntersections(const GeoUtils::geoPoint_t& geoPoint) const;
 		bool isPointInsideIntersectionBox(uint8_t intersectionIndex, const GeoUtils::point2D_t& ptENU) const;
 		bool isPointOnApproach(uint8_t intersectionIndex, uint8_t approachIndex, const GeoUtils::point2D_t& ptENU) const;
-		std::vector<uint8_t> nearedIntersections(const GeoUtils::geoPoint_t& geoPoint) const;
 		std::vector<uint8_t> onApproaches(uint8_t intersectionIndex, const GeoUtils::point2D_t& ptENU) const;
 		GeoUtils::laneTracking_t projectPt2Lane(uint8_t intersectionIndex, uint8_t approachIndex, uint8_t laneIndex,
 			const GeoUtils::point2D_t& ptENU, const GeoUtils::motion_t& motionState) const;
 		bool locateVehicleOnApproach(uint8_t intersectionIndex, uint8_t approachIndex, const GeoUtils::point2D_t& ptENU,
 			const GeoUtils::motion_t& motionState, GeoUtils::vehicleTracking_t& vehicleTrackingState) const;
+		bool locateVehicleOnApproach(uint8_t intersectionIndex, uint8_t approachIndex, uint8_t hintLaneIndex, const GeoUtils::point2D_t& ptENU,
+			const GeoUtils::motion_t& motionState, GeoUtils::vehicleTracking_t& vehicleTrackingState) const;
 		bool isEgressConnect2Ingress(uint8_t intersectionIndex, uint8_t approachIndex, uint8_t laneIndex, const GeoUtils::geoPoint_t& geoPoint,
 			const GeoUtils::motion_t& motionState, GeoUtils::vehicleTracking_t& vehicleTrackingState) const;
 		double getPtDist2egress(uint8_t intersectionIndex, uint8_t approachIndex, const GeoUtils::point2D_t& ptENU) const;
@@ -63,6 +84,10 @@ class LocAware
 		LocAware(const std::string& fname);
 		~LocAware(void);
 
+		// save intersections with derived geometry and encoded MAP payloads into binary image,
+		// which the constructor loads without parsing, geometry building and UPER encoding
+		bool saveNmapImage(const std::string& fname) const;
+
 		// check MAP update based on encoded MAP payload
 		void checkNmapUpdate(const MapData_element_t& mapData);
 
@@ -81,7 +106,10 @@ class LocAware
 		std::vector<uint8_t> getMapdataPayload(uint16_t intersectionId) const;
 		bool getSpeedLimits(std::vector<uint8_t>& speedLimits, uint16_t intersectionId) const;
 		// locating vehicle BSM on intersection Map
+		bool isPointNearAnyIntersection(const GeoUtils::geoPoint_t& geoPoint) const;
 		bool locateVehicleInMap(const GeoUtils::connectedVehicle_t& cv, GeoUtils::vehicleTracking_t& cvTrackingState) const;
+		// turn on/off resuming from the last located lane (on by default), results are the same either way
+		void setLaneHint(bool on);
 		void updateLocationAware(const GeoUtils::vehicleTracking_t& vehicleTrackingState, GeoUtils::locationAware_t& vehicleLocationAware) const;
 		void getPtDist2D(const GeoUtils::vehicleTracking_t& vehicleTrackingState, GeoUtils::point2D_t& pt) const;
 };
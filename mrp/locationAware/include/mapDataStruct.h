@@ -85,6 +85,37 @@ namespace NmapData
 		std::vector<NmapData::NodeStruct> mpNodes;
 	};
 
+	struct SegmentsStruct
+	{ // lane segments of an approach in structure-of-arrays layout, built at map load for projecting a point
+		// onto all lanes of the approach in one batch. Segments of lane i are [laneStart[i], laneStart[i+1]),
+		// in the order projectPt2Lane checks them: from upstream towards the stop-bar on inbound lanes,
+		// and from the intersection box towards downstream on outbound lanes.
+		std::vector<uint16_t> laneStart;
+		std::vector<double>   x0;         // segment start point, in centimeter
+		std::vector<double>   y0;
+		std::vector<double>   ux;         // unit vector from start point to end point
+		std::vector<double>   uy;
+		std::vector<double>   length;     // in centimeter
+		std::vector<uint16_t> heading;    // heading of the start node, in decidegree
+		std::vector<uint8_t>  nodeIndex;  // index of the start node in mpNodes
+		// per lane, bounding box of points that projectPt2Lane can locate inside the lane (for any heading),
+		// in centimeter along (a) and across (c) the approach axis. Lanes whose box does not contain the point
+		// can not be the located lane and are skipped by locateVehicleOnApproach
+		double axisX;                     // unit vector of the approach axis
+		double axisY;
+		std::vector<double>   laneMinA;
+		std::vector<double>   laneMaxA;
+		std::vector<double>   laneMinC;
+		std::vector<double>   laneMaxC;
+		// per lane, bounding box of the feet of the projections that locate a point inside the lane,
+		// in centimeter along and across the approach axis. The distance from the point to this box is a
+		// lower bound of |projection_t.d| on the lane, used to skip lanes when resuming from the last lane
+		std::vector<double>   footMinA;
+		std::vector<double>   footMaxA;
+		std::vector<double>   footMinC;
+		std::vector<double>   footMaxC;
+	};
+
 	struct ApproachStruct
 	{ // an regular intersection has 12 approach objects: 8 for motor vehicles and 4 crosswalks.
 		// an approach with 0 number of lanes does not physically exist, and is not sent.
@@ -96,6 +127,7 @@ namespace NmapData
 		std::vector<GeoUtils::point2D_t> mpPolygon;
 		MsgEnum::polygonType mpPolygonType;
 		uint32_t mindist2intsectionCentralLine; // in centimeter
+		NmapData::SegmentsStruct mpSegments;
 	};
 
 	struct IntersectionStruct
@@ -33,6 +33,10 @@ void GeoUtils::setEnuCoord(const GeoUtils::geoPoint_t& geoPoint, GeoUtils::enuCo
 	enuCoord.transMatrix.dCosLong = std::cos(longitude_r);
 	// ENU origin reference at ECEF
 	GeoUtils::lla2ecef(geoPoint,enuCoord.pointECEF);
+	// coefficients for lla2enuLocal
+	enuCoord.latitude_r = latitude_r;
+	enuCoord.longitude_r = longitude_r;
+	enuCoord.meridianDist = enuCoord.transMatrix.dCosLong * enuCoord.pointECEF.x + enuCoord.transMatrix.dSinLong * enuCoord.pointECEF.y;
 }
 
 void GeoUtils::setEnuCoord(const GeoUtils::geoRefPoint_t& geoRef, GeoUtils::enuCoord_t& enuCoord)
@@ -63,7 +67,7 @@ void GeoUtils::ecef2enu(const GeoUtils::enuCoord_t& enuCoord, const GeoUtils::po
 		+ (enuCoord.transMatrix.dCosLat) * (ptECEF.z - enuCoord.pointECEF.z);
 	ptENU.z = (enuCoord.transMatrix.dCosLat * enuCoord.transMatrix.dCosLong) * (ptECEF.x - enuCoord.pointECEF.x)
 		+ (enuCoord.transMatrix.dCosLat * enuCoord.transMatrix.dSinLong) * (ptECEF.y - enuCoord.pointECEF.y)
-		+ (enuCoord.transMatrix.dSinLong) * (ptECEF.z - enuCoord.pointECEF.z);
+		+ (enuCoord.transMatrix.dSinLat) * (ptECEF.z - enuCoord.pointECEF.z);
 }
 
 void GeoUtils::lla2enu(const GeoUtils::enuCoord_t& enuCoord, const GeoUtils::geoPoint_t& geoPoint, GeoUtils::point3D_t& ptENU)
@@ -88,6 +92,45 @@ void GeoUtils::lla2enu(const GeoUtils::enuCoord_t& enuCoord, const GeoUtils::geo
 	GeoUtils::lla2enu(enuCoord,geoPoint,ptENU);
 }
 
+void GeoUtils::lla2enuLocal(const GeoUtils::enuCoord_t& enuCoord, const GeoUtils::geoPoint_t& geoPoint, GeoUtils::point3D_t& ptENU)
+{ // same transform as lla2enu, with ECEF taken in the frame rotated to the origin meridian. Sine and cosine of
+	// the latitude and longitude offsets from the origin come from truncated series. For offsets within
+	// localMaxAngle (about 60 km) the truncation error is below 1e-17, i.e., below 1e-10 meters on the ENU point.
+	// Beyond that the full conversion is used.
+	const double localMaxAngle = 0.01;  // in radians
+	double dLat = DsrcConstants::deg2rad(geoPoint.latitude) - enuCoord.latitude_r;
+	double dLong = DsrcConstants::deg2rad(geoPoint.longitude) - enuCoord.longitude_r;
+	if ((std::abs(dLat) > localMaxAngle) || (std::abs(dLong) > localMaxAngle))
+	{
+		GeoUtils::lla2enu(enuCoord, geoPoint, ptENU);
+		return;
+	}
+	auto sinSmall = [](double x)->double
+		{double x2 = x * x; return(x * (1.0 - x2 / 6.0 * (1.0 - x2 / 20.0)));};
+	auto cosSmall = [](double x)->double
+		{double x2 = x * x; return(1.0 - x2 / 2.0 * (1.0 - x2 / 12.0 * (1.0 - x2 / 30.0)));};
+	double dSinLat = sinSmall(dLat);
+	double dCosLat = cosSmall(dLat);
+	double sinLat = enuCoord.transMatrix.dSinLat * dCosLat + enuCoord.transMatrix.dCosLat * dSinLat;
+	double cosLat = enuCoord.transMatrix.dCosLat * dCosLat - enuCoord.transMatrix.dSinLat * dSinLat;
+	// Radius of Curvature
+	double N = DsrcConstants::ellipsoid_a / std::sqrt(1.0 - DsrcConstants::ellipsoid_e * DsrcConstants::ellipsoid_e * sinLat * sinLat);
+	double r = (N + geoPoint.elevation) * cosLat;
+	double dx = r * cosSmall(dLong) - enuCoord.meridianDist;
+	double dz = (N * (1.0 - DsrcConstants::ellipsoid_e * DsrcConstants::ellipsoid_e) + geoPoint.elevation) * sinLat - enuCoord.pointECEF.z;
+	ptENU.x = r * sinSmall(dLong);
+	ptENU.y = (-enuCoord.transMatrix.dSinLat) * dx + (enuCoord.transMatrix.dCosLat) * dz;
+	ptENU.z = (enuCoord.transMatrix.dCosLat) * dx + (enuCoord.transMatrix.dSinLat) * dz;
+}
+
+void GeoUtils::lla2enuLocal(const GeoUtils::enuCoord_t& enuCoord, const GeoUtils::geoPoint_t& geoPoint, GeoUtils::point2D_t& ptENU)
+{
+	GeoUtils::point3D_t pt3DENU;
+	GeoUtils::lla2enuLocal(enuCoord,geoPoint,pt3DENU);
+	ptENU.x = DsrcConstants::unit2hecto<int32_t>(pt3DENU.x);
+	ptENU.y = DsrcConstants::unit2hecto<int32_t>(pt3DENU.y);
+}
+
 void GeoUtils::enu2ecef(const GeoUtils::enuCoord_t& enuCoord, const GeoUtils::point3D_t& ptENU, GeoUtils::point3D_t& ptECEF)
 {
 	ptECEF.x = enuCoord.pointECEF.x + (-enuCoord.transMatrix.dSinLong) * ptENU.x
@@ -189,6 +232,21 @@ void GeoUtils::projectPt2Line(const GeoUtils::point2D_t& startPoint, const GeoUt
 	proj2line.length = std::sqrt(d);
 }
 
+void GeoUtils::projectPt2Lines(const GeoUtils::point2D_t& pt, const double* x0, const double* y0, const double* ux, const double* uy,
+	const double* length, size_t size, double* t, double* d)
+{ // projectPt2Line on line segments given by start point, unit direction and length,
+	// the loop has no branches so that the compiler can vectorize it
+	double px = pt.x;
+	double py = pt.y;
+	for (size_t i = 0; i < size; i++)
+	{
+		double vx = px - x0[i];
+		double vy = py - y0[i];
+		t[i] = (vx * ux[i] + vy * uy[i]) / length[i];
+		d[i] = vx * uy[i] - vy * ux[i];
+	}
+}
+
 MsgEnum::polygonType GeoUtils::convexcave(const std::vector<point2D_t>& p)
 { // for a convex polygon all the cross products of adjacent edges must
 	// have the same sign, while concave polygon will change sign
@@ -294,7 +352,7 @@ bool GeoUtils::isPointInsidePolygon(const std::vector<GeoUtils::point2D_t>& poly
 
 	for (int i = 0; i < size; i++)
 	{
-		int j = (i+1) % size;
+		int j = (i + 1 < size) ? (i + 1) : 0;
 		v1.set(waypoint,polygon[i]);
 		v2.set(polygon[i],polygon[j]);
 		long d = crossProduct(v1,v2);
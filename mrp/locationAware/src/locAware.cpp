@@ -21,9 +21,26 @@ LocAware::LocAware(const std::string& fname)
 {
 	initiated = false;
 	mapUpdated = false;
+	laneHint = true;
+	gridCellSize = 1.0;
 	// read nmap file
 	nmapFileName = fname;
-	if (!LocAware::readNmap(fname))
+	nmapImage = LocAware::isNmapImage(fname);
+	if (nmapImage)
+	{ // compiled image holds derived geometry and encoded MAP payloads
+		if (!LocAware::readNmapImage(fname))
+		{
+			mpIntersection.clear();
+			std::cerr << "Failed reading nmap image " << fname << std::endl;
+		}
+		else
+		{
+			std::cout << "Loaded " << mpIntersection.size() << " intersections from image" << std::endl;
+			LocAware::buildSpatialIndex();
+			initiated = true;
+		}
+	}
+	else if (!LocAware::readNmap(fname))
 	{
 		mpIntersection.clear();
 		std::cerr << "Failed reading nmap file " << fname << std::endl;
@@ -34,6 +51,8 @@ LocAware::LocAware(const std::string& fname)
 		LocAware::setLocalOffsetAndHeading();
 		// build approach boxes
 		LocAware::buildPolygons();
+		// build lane segment tables
+		LocAware::buildSegments();
 		// encode MAP payload
 		std::cout << "Read " << mpIntersection.size() << " intersections" << std::endl;
 		size_t encoded_interections = LocAware::encode_mapdata_payload();
@@ -45,6 +64,8 @@ LocAware::LocAware(const std::string& fname)
 		else
 		{
 			std::cout << "Encoded all intersections" << std::endl;
+			// build spatial index for locating BSM on MAP
+			LocAware::buildSpatialIndex();
 			initiated = true;
 		}
 	}
@@ -57,7 +78,10 @@ LocAware::~LocAware(void)
 		std::string backupFileName = nmapFileName + std::string(".old");
 		std::rename(nmapFileName.c_str(), backupFileName.c_str());
 		// save new MapData into file
-		LocAware::saveNmap(nmapFileName);
+		if (nmapImage)
+			LocAware::saveNmapImage(nmapFileName);
+		else
+			LocAware::saveNmap(nmapFileName);
 	}
 	mpIntersection.clear();
 }
@@ -566,7 +590,7 @@ void LocAware::buildPolygons(NmapData::IntersectionStruct& intObj)
 	const GeoUtils::point2D_t origin{0,0};
 	std::vector< std::pair<GeoUtils::point2D_t, GeoUtils::point2D_t> > nearestWayPointPair(4, std::make_pair(origin,origin));
 	// build ApproachPolygon
-	for (auto appObj : intObj.mpApproaches)
+	for (auto& appObj : intObj.mpApproaches)
 	{
 		std::vector<GeoUtils::point2D_t> farthestWaypoints;
 		if ((appObj.type == MsgEnum::approachType::crosswalk) || (appObj.mpLanes.empty()))
@@ -626,6 +650,201 @@ void LocAware::buildPolygons(NmapData::IntersectionStruct& intObj)
 		intObj.mpPolygon = GeoUtils::convexHullAndrew(intObj.mpPolygon);
 	intObj.mpPolygonType = GeoUtils::convexcave(intObj.mpPolygon);
 }
+
+auto addLaneSegment = [](NmapData::SegmentsStruct& segObj, const NmapData::NodeStruct& startNode,
+	const NmapData::NodeStruct& endNode, uint8_t nodeIndex)->void
+{
+	double dx = endNode.ptNode.x - startNode.ptNode.x;
+	double dy = endNode.ptNode.y - startNode.ptNode.y;
+	double length = std::sqrt(dx * dx + dy * dy);
+	segObj.x0.push_back(startNode.ptNode.x);
+	segObj.y0.push_back(startNode.ptNode.y);
+	segObj.ux.push_back(dx / length);
+	segObj.uy.push_back(dy / length);
+	segObj.length.push_back(length);
+	segObj.heading.push_back(startNode.heading);
+	segObj.nodeIndex.push_back(nodeIndex);
+};
+
+auto clipPolygon = [](std::vector< std::pair<double, double> >& polygon, double a, double b, double c)->void
+{ // keep the part of a convex polygon where a * x + b * y <= c
+	std::vector< std::pair<double, double> > clipped;
+	for (size_t i = 0, j = polygon.size(); i < j; i++)
+	{
+		const auto& p1 = polygon[i];
+		const auto& p2 = polygon[(i + 1) % j];
+		double v1 = a * p1.first + b * p1.second - c;
+		double v2 = a * p2.first + b * p2.second - c;
+		if (v1 <= 0.0)
+			clipped.push_back(p1);
+		if ((v1 < 0.0 && v2 > 0.0) || (v1 > 0.0 && v2 < 0.0))
+		{
+			double r = v1 / (v1 - v2);
+			clipped.push_back(std::make_pair(p1.first + r * (p2.first - p1.first), p1.second + r * (p2.second - p1.second)));
+		}
+	}
+	polygon.swap(clipped);
+};
+
+auto getLaneBox = [](const NmapData::SegmentsStruct& segObj, size_t first, size_t last, double dwidth, double box[4], double footBox[4])->void
+{ // projectPt2Lane locates a point inside a lane either on a segment (t in [0,1] and |d| < dwidth),
+	// or between two segments: after the end of the first one and before the start of the second one
+	// with |d| < dwidth on both (the segments in between are skipped by the heading check).
+	// box is the bounding box of the union of these areas along and across the approach axis,
+	// footBox is the bounding box of the feet of the projections that locate a point in these areas,
+	// both expanded by a margin for rounding, and unbounded when any of the areas is.
+	const double margin = 1.0;     // in centimeter
+	const double farAway = 1.0e8;  // in centimeter
+	double w = dwidth + margin;
+	box[0] = box[2] = footBox[0] = footBox[2] = farAway;
+	box[1] = box[3] = footBox[1] = footBox[3] = -farAway;
+	auto addPoint = [&segObj, margin, farAway](double bbox[4], double x, double y)
+	{
+		if ((std::abs(x) >= farAway) || (std::abs(y) >= farAway))
+		{ // unbounded area
+			bbox[0] = bbox[2] = -farAway;
+			bbox[1] = bbox[3] = farAway;
+			return(false);
+		}
+		double a = segObj.axisX * x + segObj.axisY * y;
+		double c = segObj.axisY * x - segObj.axisX * y;
+		bbox[0] = std::min(bbox[0], a - margin);
+		bbox[1] = std::max(bbox[1], a + margin);
+		bbox[2] = std::min(bbox[2], c - margin);
+		bbox[3] = std::max(bbox[3], c + margin);
+		return(true);
+	};
+	auto addPolygon = [&box, &addPoint](const std::vector< std::pair<double, double> >& polygon)
+	{
+		for (const auto& p : polygon)
+		{
+			if (!addPoint(box, p.first, p.second))
+				return;
+		}
+	};
+	auto addFeet = [&footBox, &segObj, &addPoint](const std::vector< std::pair<double, double> >& polygon, size_t k)
+	{ // feet of the projections onto segment k, extreme ones are the feet of the polygon vertices
+		for (const auto& p : polygon)
+		{
+			double s = (p.first - segObj.x0[k]) * segObj.ux[k] + (p.second - segObj.y0[k]) * segObj.uy[k];
+			if (!addPoint(footBox, segObj.x0[k] + s * segObj.ux[k], segObj.y0[k] + s * segObj.uy[k]))
+				return;
+		}
+	};
+	auto clipStrip = [&segObj, w](std::vector< std::pair<double, double> >& polygon, size_t k)
+	{ // |d| <= w
+		double c = segObj.uy[k] * segObj.x0[k] - segObj.ux[k] * segObj.y0[k];
+		clipPolygon(polygon, segObj.uy[k], -segObj.ux[k], c + w);
+		clipPolygon(polygon, -segObj.uy[k], segObj.ux[k], w - c);
+	};
+	auto clipAfterStart = [&segObj, margin](std::vector< std::pair<double, double> >& polygon, size_t k)
+	{ // t >= 0
+		double c = segObj.ux[k] * segObj.x0[k] + segObj.uy[k] * segObj.y0[k];
+		clipPolygon(polygon, -segObj.ux[k], -segObj.uy[k], margin - c);
+	};
+	auto clipBeforeStart = [&segObj, margin](std::vector< std::pair<double, double> >& polygon, size_t k)
+	{ // t <= 0
+		double c = segObj.ux[k] * segObj.x0[k] + segObj.uy[k] * segObj.y0[k];
+		clipPolygon(polygon, segObj.ux[k], segObj.uy[k], c + margin);
+	};
+	auto clipBeforeEnd = [&segObj, margin](std::vector< std::pair<double, double> >& polygon, size_t k)
+	{ // t <= 1
+		double c = segObj.ux[k] * segObj.x0[k] + segObj.uy[k] * segObj.y0[k] + segObj.length[k];
+		clipPolygon(polygon, segObj.ux[k], segObj.uy[k], c + margin);
+	};
+	auto clipAfterEnd = [&segObj, margin](std::vector< std::pair<double, double> >& polygon, size_t k)
+	{ // t >= 1
+		double c = segObj.ux[k] * segObj.x0[k] + segObj.uy[k] * segObj.y0[k] + segObj.length[k];
+		clipPolygon(polygon, -segObj.ux[k], -segObj.uy[k], margin - c);
+	};
+	const std::vector< std::pair<double, double> > square{{-farAway, -farAway}, {farAway, -farAway}, {farAway, farAway}, {-farAway, farAway}};
+	for (size_t k1 = first; k1 < last; k1++)
+	{
+		if (!(segObj.length[k1] > 0.0))
+			continue;  // t is not a number on zero-length segments
+		auto polygon = square;
+		clipStrip(polygon, k1);
+		clipAfterStart(polygon, k1);
+		clipBeforeEnd(polygon, k1);
+		addPolygon(polygon);
+		addFeet(polygon, k1);
+		for (size_t k2 = k1 + 1; k2 < last; k2++)
+		{
+			if (!(segObj.length[k2] > 0.0))
+				continue;
+			polygon = square;
+			clipStrip(polygon, k1);
+			clipAfterEnd(polygon, k1);
+			clipStrip(polygon, k2);
+			clipBeforeStart(polygon, k2);
+			addPolygon(polygon);
+			addFeet(polygon, k1);
+			addFeet(polygon, k2);
+		}
+	}
+};
+
+void LocAware::buildSegments(void)
+{
+	for (auto& intObj :  mpIntersection)
+		LocAware::buildSegments(intObj);
+}
+
+void LocAware::buildSegments(NmapData::IntersectionStruct& intObj)
+{
+	for (auto& appObj : intObj.mpApproaches)
+	{
+		auto& segObj = appObj.mpSegments;
+		segObj = NmapData::SegmentsStruct();
+		// approach axis along the first lane
+		segObj.axisX = 1.0;
+		segObj.axisY = 0.0;
+		if (!appObj.mpLanes.empty() && (appObj.mpLanes[0].mpNodes.size() > 1))
+		{
+			const auto& nodes = appObj.mpLanes[0].mpNodes;
+			double dx = nodes.back().ptNode.x - nodes.front().ptNode.x;
+			double dy = nodes.back().ptNode.y - nodes.front().ptNode.y;
+			double length = std::sqrt(dx * dx + dy * dy);
+			if (length > 0.0)
+			{
+				segObj.axisX = dx / length;
+				segObj.axisY = dy / length;
+			}
+		}
+		for (const auto& laneObj : appObj.mpLanes)
+		{
+			const auto& nodes = laneObj.mpNodes;
+			segObj.laneStart.push_back(static_cast<uint16_t>(segObj.x0.size()));
+			if (nodes.size() < 2)
+				continue;
+			if (appObj.type == MsgEnum::approachType::inbound)
+			{
+				for (size_t i = nodes.size() - 1; i > 0; i--)
+					addLaneSegment(segObj, nodes[i], nodes[i-1], static_cast<uint8_t>(i));
+			}
+			else
+			{
+				for (size_t i = 0, j = nodes.size() - 1; i < j; i++)
+					addLaneSegment(segObj, nodes[i], nodes[i+1], static_cast<uint8_t>(i));
+			}
+		}
+		segObj.laneStart.push_back(static_cast<uint16_t>(segObj.x0.size()));
+		for (size_t i = 0, j = appObj.mpLanes.size(); i < j; i++)
+		{
+			double box[4];
+			double footBox[4];
+			getLaneBox(segObj, segObj.laneStart[i], segObj.laneStart[i+1], appObj.mpLanes[i].width * NmapData::laneWidthRatio, box, footBox);
+			segObj.laneMinA.push_back(box[0]);
+			segObj.laneMaxA.push_back(box[1]);
+			segObj.laneMinC.push_back(box[2]);
+			segObj.laneMaxC.push_back(box[3]);
+			segObj.footMinA.push_back(footBox[0]);
+			segObj.footMaxA.push_back(footBox[1]);
+			segObj.footMinC.push_back(footBox[2]);
+			segObj.footMaxC.push_back(footBox[3]);
+		}
+	}
+}
 /// --- end of functions to process the intersection nmap file --- ///
 
 
@@ -837,6 +1056,7 @@ void LocAware::checkNmapUpdate(const MapData_element_t& mapData)
 		}
 	}
 	LocAware::buildPolygons(*pIntObj);
+	LocAware::buildSegments(*pIntObj);
 	LocAware::addIntersection(*pIntObj);
 	delete pIntObj;
 }
@@ -870,6 +1090,7 @@ void LocAware::addIntersection(const NmapData::IntersectionStruct& intObj)
 		}
 		appIndx++;
 	}
+	LocAware::buildSpatialIndex();
 }
 /// --- end of functions to encode MAP and update decoded MAP --- ///
 
@@ -1017,11 +1238,50 @@ bool LocAware::getSpeedLimits(std::vector<uint8_t>& speedLimits, uint16_t inters
 
 
 /// --- start of functions to locate BSM on MAP --- ///
+uint64_t LocAware::getGridCellKey(double latitude, double longitude) const
+{
+	uint32_t latCell = (uint32_t)(int32_t)std::floor(latitude / gridCellSize);
+	uint32_t lonCell = (uint32_t)(int32_t)std::floor(longitude / gridCellSize);
+	return(((uint64_t)latCell << 32) | lonCell);
+}
+
+void LocAware::buildSpatialIndex(void)
+{ // an intersection is added to every grid cell overlapped by the bounding box of its radius,
+	// so candidates for a point are the intersections listed in the cell that contains the point
+	const double metersPerDegree = 111320.0;  // length of one degree of latitude
+	const double minCellSize = 200.0;         // in meters
+	spatialIndex.clear();
+	double maxRadius = 0.0;
+	for (const auto& intObj : mpIntersection)
+		maxRadius = std::max(maxRadius, DsrcConstants::hecto2unit<uint32_t>(intObj.radius));
+	gridCellSize = std::max(2.0 * maxRadius, minCellSize) / metersPerDegree;
+	for (uint8_t i = 0, j = (uint8_t)(mpIntersection.size()); i < j; i++)
+	{
+		const auto& intObj = mpIntersection[i];
+		GeoUtils::geoPoint_t geoPoint;
+		GeoUtils::geoRefPoint2geoPoint(intObj.geoRef, geoPoint);
+		// pad radius to cover the difference between the local tangent plane and the latitude/longitude grid
+		double radius = DsrcConstants::hecto2unit<uint32_t>(intObj.radius) * 1.1 + 1.0;
+		double cosLat = std::max(std::cos(DsrcConstants::deg2rad(geoPoint.latitude)), 0.01);
+		double dLat = radius / metersPerDegree;
+		double dLon = radius / (metersPerDegree * cosLat);
+		int32_t latCell_L = (int32_t)std::floor((geoPoint.latitude - dLat) / gridCellSize);
+		int32_t latCell_U = (int32_t)std::floor((geoPoint.latitude + dLat) / gridCellSize);
+		int32_t lonCell_L = (int32_t)std::floor((geoPoint.longitude - dLon) / gridCellSize);
+		int32_t lonCell_U = (int32_t)std::floor((geoPoint.longitude + dLon) / gridCellSize);
+		for (int32_t latCell = latCell_L; latCell <= latCell_U; latCell++)
+		{
+			for (int32_t lonCell = lonCell_L; lonCell <= lonCell_U; lonCell++)
+				spatialIndex[((uint64_t)(uint32_t)latCell << 32) | (uint32_t)lonCell].push_back(i);
+		}
+	}
+}
+
 bool LocAware::isPointNearIntersection(uint8_t intersectionIndex, const GeoUtils::geoPoint_t& geoPoint) const
 { // check whether geoPt is inside radius of an intersection
 	GeoUtils::point3D_t ptENU;
 	const auto& intObj = mpIntersection[intersectionIndex];
-	GeoUtils::lla2enu(intObj.enuCoord, geoPoint, ptENU);
+	GeoUtils::lla2enuLocal(intObj.enuCoord, geoPoint, ptENU);
 	return(sqrt(ptENU.x * ptENU.x + ptENU.y * ptENU.y) <= DsrcConstants::hecto2unit<int32_t>(intObj.radius));
 }
 
@@ -1040,7 +1300,10 @@ bool LocAware::isPointOnApproach(uint8_t intersectionIndex, uint8_t approachInde
 std::vector<uint8_t> LocAware::nearedIntersections(const GeoUtils::geoPoint_t& geoPoint) const
 {
 	std::vector<uint8_t> ret;
-	for (uint8_t i = 0, j = (uint8_t)(mpIntersection.size()); i < j; i++)
+	auto it = spatialIndex.find(LocAware::getGridCellKey(geoPoint.latitude, geoPoint.longitude));
+	if (it == spatialIndex.end())
+		return(ret);
+	for (const auto& i : it->second)
 	{
 		if (LocAware::isPointNearIntersection(i, geoPoint))
 			ret.push_back(i);
@@ -1048,6 +1311,19 @@ std::vector<uint8_t> LocAware::nearedIntersections(const GeoUtils::geoPoint_t& g
 	return(ret);
 }
 
+bool LocAware::isPointNearAnyIntersection(const GeoUtils::geoPoint_t& geoPoint) const
+{ // same test as nearedIntersections, stops at the first intersection and does not allocate
+	auto it = spatialIndex.find(LocAware::getGridCellKey(geoPoint.latitude, geoPoint.longitude));
+	if (it == spatialIndex.end())
+		return(false);
+	for (const auto& i : it->second)
+	{
+		if (LocAware::isPointNearIntersection(i, geoPoint))
+			return(true);
+	}
+	return(false);
+}
+
 std::vector<uint8_t> LocAware::onApproaches(uint8_t intersectionIndex, const GeoUtils::point2D_t& ptENU) const
 { // also do this when geoPoint is near the intersection (check first with isPointNearIntersection)
 	std::vector<uint8_t> ret;
@@ -1107,163 +1383,178 @@ auto getIdx4minLatApproch = [](const std::vector<GeoUtils::vehicleTracking_t>& a
 	return((std::abs(it->laneProj.proj2segment.d) < dmax) ? (int)(it - aApproachTrackingState.begin()) : -1);
 };
 
-auto getIdx4minLatLane = [](const std::vector<GeoUtils::laneTracking_t>& aLaneTrackingState)->int
-{
-	double dmax = 1000.0; // in centimetres
-	if (aLaneTrackingState.empty())
-		return(-1);
-	std::vector<double> vd;
-	for (const auto& item : aLaneTrackingState)
-	{
-		double d = std::abs(item.laneProj.proj2segment.d);
-		if ((item.vehicleLaneStatus == MsgEnum::laneLocType::inside) && (d < dmax))
-			vd.push_back(d);
-	}
-	if (vd.empty())
-		return(-1);
-	auto it = std::min_element(vd.begin(), vd.end());
-	return((it != vd.end()) ? (int)(it - vd.begin()) : -1);
-};
-
-auto getIdx4minLatNode = [](const std::vector<GeoUtils::laneProjection_t>& aProj2Lane, uint16_t laneWidth)->int
-{
-	double dwidth	= laneWidth * NmapData::laneWidthRatio;
-	if (aProj2Lane.empty())
-		return(-1);
-	std::vector<double> vd;
-	for (const auto& item : aProj2Lane)
-	{
-		double d = std::abs(item.proj2segment.d);
-		if ((item.proj2segment.t >= 0.0) && (item.proj2segment.t <= 1.0) && (d < dwidth))
-			vd.push_back(d);
-	}
-	if (vd.empty())
-		return(-1);
-	auto it = std::min_element(vd.begin(), vd.end());
-	return((it != vd.end()) ? (int)(it - vd.begin()) : -1);
-};
-
-auto getIdx4specicalCase = [](const std::vector<GeoUtils::laneProjection_t>& aProj2Lane, uint16_t laneWidth)->int
-{
-	double dwidth = laneWidth * NmapData::laneWidthRatio;
-	if (aProj2Lane.empty())
-		return(-1);
-	std::vector< std::pair<size_t, double> > candidates;
-	for (size_t i = 0, j = aProj2Lane.size(); i + 1 < j; i++)
-	{
-		double d1 = std::abs(aProj2Lane[i].proj2segment.d);
-		double d2 = std::abs(aProj2Lane[i+1].proj2segment.d);
-		if ((aProj2Lane[i].proj2segment.t > 1.0) && (d1 < dwidth)
-			&& (aProj2Lane[i+1].proj2segment.t < 0.0) && (d2 < dwidth))
-		{
-			if (d1 < d2)
-				candidates.push_back(std::make_pair(i, d1));
-			else
-				candidates.push_back(std::make_pair(i+1, d2));
-		}
-	}
-	if (candidates.empty())
-		return(-1);
-	auto it = std::min_element(candidates.begin(), candidates.end(),
-		[](const std::pair<size_t, double>& s1, const std::pair<size_t, double>& s2){return(s1.second < s2.second);});
-	return((it != candidates.end()) ? (int)(it->first) : -1);
-};
-
 GeoUtils::laneTracking_t LocAware::projectPt2Lane(uint8_t intersectionIndex, uint8_t approachIndex, uint8_t laneIndex,
 	const GeoUtils::point2D_t& ptENU, const GeoUtils::motion_t& motionState) const
-{
+{ // project ptENU onto lane segments in batches, then check projections on segments with heading matching motionState:
+	// the vehicle is approaching the lane when it is before the first segment, and leaving the lane when it is
+	// after the last segment. Otherwise, it is inside on the segment that has projection_t.t in [0,1],
+	// projection_t.d within laneWidth * laneWidthRatio, and the minimum projection_t.d. Special case:
+	// it is between two consecutive segments (after the end of one and before the start of the next one).
+	const size_t batchSize = 32;
 	const auto& appObj  = mpIntersection[intersectionIndex].mpApproaches[approachIndex];
 	const auto& laneObj = appObj.mpLanes[laneIndex];
+	const auto& segObj  = appObj.mpSegments;
 	double headingErrorBound = getHeadingErrorBound(motionState.speed);
-	std::vector<GeoUtils::laneProjection_t> aProj2Lane;
-	GeoUtils::laneProjection_t proj2lane;
-
-	if (appObj.type == MsgEnum::approachType::inbound)
+	double dwidth = laneObj.width * NmapData::laneWidthRatio;
+	double t[batchSize];
+	double d[batchSize];
+	size_t projCnt = 0;
+	int minLatCnt = 0;
+	int specialCnt = 0;
+	double minLatDist = 0.0;
+	double specialDist = 0.0;
+	GeoUtils::laneProjection_t firstProj, lastProj, minLatProj, specialProj;
+
+	for (size_t k = segObj.laneStart[laneIndex], end = segObj.laneStart[laneIndex + 1]; k < end; k += batchSize)
 	{
-		for (uint8_t i = (uint8_t)(laneObj.mpNodes.size() - 1); i > 0; i--)
+		size_t size = std::min(batchSize, end - k);
+		GeoUtils::projectPt2Lines(ptENU, &segObj.x0[k], &segObj.y0[k], &segObj.ux[k], &segObj.uy[k], &segObj.length[k], size, t, d);
+		for (size_t i = 0; i < size; i++)
 		{
-			if (std::abs(getHeadingDifference(laneObj.mpNodes[i].heading, motionState.heading)) > headingErrorBound)
+			if (std::abs(getHeadingDifference(segObj.heading[k + i], motionState.heading)) > headingErrorBound)
 				continue;
-			proj2lane.nodeIndex = i;
-			GeoUtils::projectPt2Line(laneObj.mpNodes[i].ptNode, laneObj.mpNodes[i-1].ptNode, ptENU, proj2lane.proj2segment);
-			aProj2Lane.push_back(proj2lane);
-		}
-	}
-	else
-	{
-		for (uint8_t i = 0, j = (uint8_t)(laneObj.mpNodes.size() - 1); i < j; i++)
-		{
-			if (std::abs(getHeadingDifference(laneObj.mpNodes[i].heading, motionState.heading)) > headingErrorBound)
-				continue;
-			proj2lane.nodeIndex = i;
-			GeoUtils::projectPt2Line(laneObj.mpNodes[i].ptNode, laneObj.mpNodes[i+1].ptNode, ptENU, proj2lane.proj2segment);
-			aProj2Lane.push_back(proj2lane);
+			GeoUtils::laneProjection_t proj2lane{segObj.nodeIndex[k + i], {t[i], d[i], segObj.length[k + i]}};
+			double dist = std::abs(d[i]);
+			if (projCnt == 0)
+				firstProj = proj2lane;
+			else
+			{
+				double lastDist = std::abs(lastProj.proj2segment.d);
+				if ((lastProj.proj2segment.t > 1.0) && (lastDist < dwidth) && (t[i] < 0.0) && (dist < dwidth)
+					&& ((specialCnt == 0) || (std::min(lastDist, dist) < specialDist)))
+				{
+					specialProj = (lastDist < dist) ? lastProj : proj2lane;
+					specialDist = std::min(lastDist, dist);
+					specialCnt++;
+				}
+			}
+			if ((t[i] >= 0.0) && (t[i] <= 1.0) && (dist < dwidth) && ((minLatCnt == 0) || (dist < minLatDist)))
+			{
+				minLatProj = proj2lane;
+				minLatDist = dist;
+				minLatCnt++;
+			}
+			lastProj = proj2lane;
+			projCnt++;
 		}
 	}
 
 	GeoUtils::laneTracking_t laneTrackingState{MsgEnum::laneLocType::outside,{0, {0.0, 0.0, 0.0}}};
-	if (aProj2Lane.empty())
+	if (projCnt == 0)
 		return(laneTrackingState);
-	if (aProj2Lane.front().proj2segment.t < 0)
+	if (firstProj.proj2segment.t < 0)
 	{
 		laneTrackingState.vehicleLaneStatus = MsgEnum::laneLocType::approaching;
-		laneTrackingState.laneProj = aProj2Lane.front();
-		return(laneTrackingState);
+		laneTrackingState.laneProj = firstProj;
 	}
-	if (aProj2Lane.back().proj2segment.t > 1)
+	else if (lastProj.proj2segment.t > 1)
 	{
 		laneTrackingState.vehicleLaneStatus = MsgEnum::laneLocType::leaving;
-		laneTrackingState.laneProj = aProj2Lane.back();
-		return(laneTrackingState);
+		laneTrackingState.laneProj = lastProj;
 	}
-	// get index of the lane segment on which projection_t.t is between [0,1],
-	// projection_t.d is within laneWidth * laneWidthRatio, and has the minimum
-	// projection_t.d among all success projected segments
-	int idx = getIdx4minLatNode(aProj2Lane, laneObj.width);
-	if (idx >= 0)
+	else if (minLatCnt > 0)
 	{
 		laneTrackingState.vehicleLaneStatus = MsgEnum::laneLocType::inside;
-		laneTrackingState.laneProj = aProj2Lane[idx];
-		return(laneTrackingState);
+		laneTrackingState.laneProj = minLatProj;
 	}
-	// special case:
-	idx = getIdx4specicalCase(aProj2Lane, laneObj.width);
-	if (idx >= 0)
+	else if (specialCnt > 0)
 	{
 		laneTrackingState.vehicleLaneStatus = MsgEnum::laneLocType::inside;
-		laneTrackingState.laneProj = aProj2Lane[idx];
-		return(laneTrackingState);
+		laneTrackingState.laneProj = specialProj;
 	}
 	return(laneTrackingState);
 }
 
+auto setApproachTrackingState = [](uint8_t intersectionIndex, uint8_t approachIndex, uint8_t laneIndex,
+	const NmapData::ApproachStruct& appObj, GeoUtils::vehicleTracking_t& vehicleTrackingState)->void
+{
+	if (appObj.type == MsgEnum::approachType::inbound)
+		vehicleTrackingState.intsectionTrackingState.vehicleIntersectionStatus = MsgEnum::mapLocType::onInbound;
+	else
+		vehicleTrackingState.intsectionTrackingState.vehicleIntersectionStatus = MsgEnum::mapLocType::onOutbound;
+	vehicleTrackingState.intsectionTrackingState.intersectionIndex = intersectionIndex;
+	vehicleTrackingState.intsectionTrackingState.approachIndex = approachIndex;
+	vehicleTrackingState.intsectionTrackingState.laneIndex = laneIndex;
+};
+
 bool LocAware::locateVehicleOnApproach(uint8_t intersectionIndex, uint8_t approachIndex, const GeoUtils::point2D_t& ptENU,
 	const GeoUtils::motion_t& motionState, GeoUtils::vehicleTracking_t& vehicleTrackingState) const
 {
 	vehicleTrackingState.reset();
 	const auto& appObj = mpIntersection[intersectionIndex].mpApproaches[approachIndex];
-	std::vector<GeoUtils::laneTracking_t> aLaneTrackingState(appObj.mpLanes.size());
-		// one record per lane regardless whether the vehicle is on lane or not
-
-	for (uint8_t i = 0, j = (uint8_t)appObj.mpLanes.size(); i < j; i++)
-		aLaneTrackingState[i] = LocAware::projectPt2Lane(intersectionIndex, approachIndex, i, ptENU, motionState);
+	const auto& segObj = appObj.mpSegments;
+	double ptA = segObj.axisX * ptENU.x + segObj.axisY * ptENU.y;
+	double ptC = segObj.axisY * ptENU.x - segObj.axisX * ptENU.y;
 	// when project to multiple lanes, find the lane with minimum distance away from it
-	int idx = getIdx4minLatLane(aLaneTrackingState);
+	double minLatDist = 1000.0; // in centimetres
+	int idx = -1;
+	for (uint8_t i = 0, j = (uint8_t)appObj.mpLanes.size(); i < j; i++)
+	{ // skip lanes that can not have the vehicle inside
+		if ((ptA < segObj.laneMinA[i]) || (ptA > segObj.laneMaxA[i]) || (ptC < segObj.laneMinC[i]) || (ptC > segObj.laneMaxC[i]))
+			continue;
+		GeoUtils::laneTracking_t laneTrackingState = LocAware::projectPt2Lane(intersectionIndex, approachIndex, i, ptENU, motionState);
+		double dist = std::abs(laneTrackingState.laneProj.proj2segment.d);
+		if ((laneTrackingState.vehicleLaneStatus == MsgEnum::laneLocType::inside) && (dist < minLatDist))
+		{
+			minLatDist = dist;
+			idx = i;
+			vehicleTrackingState.laneProj = laneTrackingState.laneProj;
+		}
+	}
 	if (idx >= 0)
 	{
-		if (appObj.type == MsgEnum::approachType::inbound)
-			vehicleTrackingState.intsectionTrackingState.vehicleIntersectionStatus = MsgEnum::mapLocType::onInbound;
-		else
-			vehicleTrackingState.intsectionTrackingState.vehicleIntersectionStatus = MsgEnum::mapLocType::onOutbound;
-		vehicleTrackingState.intsectionTrackingState.intersectionIndex = intersectionIndex;
-		vehicleTrackingState.intsectionTrackingState.approachIndex = approachIndex;
-		vehicleTrackingState.intsectionTrackingState.laneIndex = static_cast<uint8_t>(idx);
-		vehicleTrackingState.laneProj = aLaneTrackingState[idx].laneProj;
+		setApproachTrackingState(intersectionIndex, approachIndex, static_cast<uint8_t>(idx), appObj, vehicleTrackingState);
 		return(true);
 	}
+	vehicleTrackingState.laneProj.reset();
 	return(false);
 }
 
+bool LocAware::locateVehicleOnApproach(uint8_t intersectionIndex, uint8_t approachIndex, uint8_t hintLaneIndex, const GeoUtils::point2D_t& ptENU,
+	const GeoUtils::motion_t& motionState, GeoUtils::vehicleTracking_t& vehicleTrackingState) const
+{ // resume from the lane the vehicle was located on. When the vehicle remains inside that lane, another lane can only be
+	// the located lane when the point is inside its box and its distance to the foot box is no more than the distance to the
+	// hint lane, other lanes are not projected. When the vehicle left the hint lane, fall back to projecting onto all lanes of the approach.
+	// The located lane is the same as the one without the hint: minimum distance, the first lane on ties
+	const auto& appObj = mpIntersection[intersectionIndex].mpApproaches[approachIndex];
+	const auto& segObj = appObj.mpSegments;
+	if (!laneHint || (hintLaneIndex >= appObj.mpLanes.size()))
+		return(LocAware::locateVehicleOnApproach(intersectionIndex, approachIndex, ptENU, motionState, vehicleTrackingState));
+	double ptA = segObj.axisX * ptENU.x + segObj.axisY * ptENU.y;
+	double ptC = segObj.axisY * ptENU.x - segObj.axisX * ptENU.y;
+	auto isInLaneBox = [&segObj, ptA, ptC](uint8_t i)
+		{return((ptA >= segObj.laneMinA[i]) && (ptA <= segObj.laneMaxA[i]) && (ptC >= segObj.laneMinC[i]) && (ptC <= segObj.laneMaxC[i]));};
+	if (!isInLaneBox(hintLaneIndex))
+		return(LocAware::locateVehicleOnApproach(intersectionIndex, approachIndex, ptENU, motionState, vehicleTrackingState));
+	GeoUtils::laneTracking_t laneTrackingState = LocAware::projectPt2Lane(intersectionIndex, approachIndex, hintLaneIndex, ptENU, motionState);
+	double minLatDist = std::abs(laneTrackingState.laneProj.proj2segment.d);
+	if ((laneTrackingState.vehicleLaneStatus != MsgEnum::laneLocType::inside) || !(minLatDist < 1000.0))
+		return(LocAware::locateVehicleOnApproach(intersectionIndex, approachIndex, ptENU, motionState, vehicleTrackingState));
+	vehicleTrackingState.reset();
+	vehicleTrackingState.laneProj = laneTrackingState.laneProj;
+	uint8_t idx = hintLaneIndex;
+	for (uint8_t i = 0, j = (uint8_t)appObj.mpLanes.size(); i < j; i++)
+	{
+		if ((i == hintLaneIndex) || !isInLaneBox(i))
+			continue;
+		double da = std::max(std::max(segObj.footMinA[i] - ptA, ptA - segObj.footMaxA[i]), 0.0);
+		double dc = std::max(std::max(segObj.footMinC[i] - ptC, ptC - segObj.footMaxC[i]), 0.0);
+		if (std::sqrt(da * da + dc * dc) > minLatDist)
+			continue;
+		laneTrackingState = LocAware::projectPt2Lane(intersectionIndex, approachIndex, i, ptENU, motionState);
+		double dist = std::abs(laneTrackingState.laneProj.proj2segment.d);
+		if ((laneTrackingState.vehicleLaneStatus == MsgEnum::laneLocType::inside)
+			&& ((dist < minLatDist) || ((dist == minLatDist) && (i < idx))))
+		{
+			minLatDist = dist;
+			idx = i;
+			vehicleTrackingState.laneProj = laneTrackingState.laneProj;
+		}
+	}
+	setApproachTrackingState(intersectionIndex, approachIndex, idx, appObj, vehicleTrackingState);
+	return(true);
+}
+
 bool LocAware::isEgressConnect2Ingress(uint8_t intersectionIndex, uint8_t approachIndex, uint8_t laneIndex,
 	const GeoUtils::geoPoint_t& geoPoint, const GeoUtils::motion_t& motionState, GeoUtils::vehicleTracking_t& vehicleTrackingState) const
 {
@@ -1274,7 +1565,7 @@ bool LocAware::isEgressConnect2Ingress(uint8_t intersectionIndex, uint8_t approa
 		std::vector<uint8_t> connectToindex = LocAware::getIndexesByIds(connectTo[0].intersectionId, connectTo[0].laneId);
 		// convert geoPoint to ptENU at connectTo intersection
 		GeoUtils::point2D_t ptENU;
-		GeoUtils::lla2enu(mpIntersection[connectToindex[0]].enuCoord, geoPoint, ptENU);
+		GeoUtils::lla2enuLocal(mpIntersection[connectToindex[0]].enuCoord, geoPoint, ptENU);
 		// check whether ptENU is onInbound
 		if (LocAware::isPointOnApproach(connectToindex[0], connectToindex[1], ptENU)
 				&& LocAware::locateVehicleOnApproach(connectToindex[0], connectToindex[1], ptENU, motionState, vehicleTrackingState))
@@ -1313,7 +1604,7 @@ bool LocAware::locateVehicleInMap(const GeoUtils::connectedVehicle_t& cv, GeoUti
 		std::vector<GeoUtils::vehicleTracking_t> aVehicleTrackingState; // at most one record per intersection
 		for (const auto& intIndx : intersectionList)
 		{ // convert cv.geoPoint to ptENU
-			GeoUtils::lla2enu(mpIntersection[intIndx].enuCoord, cv.geoPoint, ptENU);
+			GeoUtils::lla2enuLocal(mpIntersection[intIndx].enuCoord, cv.geoPoint, ptENU);
 			// check whether ptENU is inside intersection box first
 			if (LocAware::isPointInsideIntersectionBox(intIndx,ptENU))
 			{
@@ -1357,7 +1648,7 @@ bool LocAware::locateVehicleInMap(const GeoUtils::connectedVehicle_t& cv, GeoUti
 	const auto& intersectionIndex = cv.vehicleTrackingState.intsectionTrackingState.intersectionIndex;
 	const auto& intObj = mpIntersection[intersectionIndex];
 	// convert cv.geoPoint to ptENU
-	GeoUtils::lla2enu(intObj.enuCoord, cv.geoPoint,ptENU);
+	GeoUtils::lla2enuLocal(intObj.enuCoord, cv.geoPoint,ptENU);
 
 	if (cv.vehicleTrackingState.intsectionTrackingState.vehicleIntersectionStatus == MsgEnum::mapLocType::insideIntersectionBox)
 	{ // vehicle was initiated inside the intersection box, so approachIndex & laneIndex are unknown.
@@ -1423,7 +1714,7 @@ bool LocAware::locateVehicleInMap(const GeoUtils::connectedVehicle_t& cv, GeoUti
 		const auto& laneObj = intObj.mpApproaches[approachIndex].mpLanes[laneIndex];
 		// check whether vehicle remains onInbound
 		if (LocAware::isPointOnApproach(intersectionIndex, approachIndex, ptENU)
-			&& LocAware::locateVehicleOnApproach(intersectionIndex, approachIndex, ptENU, cv.motionState, vehicleTrackingState))
+			&& LocAware::locateVehicleOnApproach(intersectionIndex, approachIndex, laneIndex, ptENU, cv.motionState, vehicleTrackingState))
 		{
 			cvTrackingState = vehicleTrackingState;
 			return(true);
@@ -1501,7 +1792,7 @@ bool LocAware::locateVehicleInMap(const GeoUtils::connectedVehicle_t& cv, GeoUti
 		}
 		// vehicle not switching to onInbound, check whether it remains onOutbound
 		if (LocAware::isPointOnApproach(intersectionIndex, approachIndex, ptENU)
-			&& LocAware::locateVehicleOnApproach(intersectionIndex, approachIndex, ptENU, cv.motionState, vehicleTrackingState))
+			&& LocAware::locateVehicleOnApproach(intersectionIndex, approachIndex, laneIndex, ptENU, cv.motionState, vehicleTrackingState))
 		{ // remains onOutbound
 			cvTrackingState = vehicleTrackingState;
 			return(true);
@@ -1568,7 +1859,7 @@ bool LocAware::locateVehicleInMap(const GeoUtils::connectedVehicle_t& cv, GeoUti
 
 		// vehicle not onOutbound, check whether ptENU is on the approach it enters the intersection box (onInbound)
 		if (LocAware::isPointOnApproach(intersectionIndex, approachIndex, ptENU)
-			&& LocAware::locateVehicleOnApproach(intersectionIndex, approachIndex, ptENU, cv.motionState, vehicleTrackingState))
+			&& LocAware::locateVehicleOnApproach(intersectionIndex, approachIndex, laneIndex, ptENU, cv.motionState, vehicleTrackingState))
 		{
 			cvTrackingState = vehicleTrackingState;
 			return(true);
@@ -1604,6 +1895,11 @@ bool LocAware::locateVehicleInMap(const GeoUtils::connectedVehicle_t& cv, GeoUti
 	}
 }
 
+void LocAware::setLaneHint(bool on)
+{
+	laneHint = on;
+}
+
 void LocAware::updateLocationAware(const GeoUtils::vehicleTracking_t& vehicleTrackingState, GeoUtils::locationAware_t& vehicleLocationAware) const
 {
 	vehicleLocationAware.reset();
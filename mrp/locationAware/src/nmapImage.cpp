@@ -0,0 +1,365 @@
+//********************************************************************************************************
+//
+// © 2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "locAware.h"
+
+/// binary nmap image: a fixed-size header followed by the payload, which holds the intersections
+/// with all derived geometry (local offsets, headings, polygons, lane segment tables) and encoded MAP payloads.
+/// header:
+///   magic             8 bytes
+///   version           uint32_t
+///   byte order mark   uint32_t
+///   payload size      uint64_t
+///   payload checksum  uint64_t (FNV-1a)
+/// All fields are in host byte order, an image is rejected on a host with a different byte order.
+namespace
+{
+	const char     imageMagic[8] = {'M', 'R', 'P', 'N', 'M', 'A', 'P', '\0'};
+	const uint32_t imageVersion = 2;
+	const uint32_t imageByteOrder = 0x01020304;
+	const size_t   imageHeaderSize = 32;
+
+	uint64_t getChecksum(const uint8_t* ptr, size_t size)
+	{
+		uint64_t hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= ptr[i];
+			hash *= 1099511628211ULL;
+		}
+		return(hash);
+	}
+
+	class imageWriter
+	{
+		public:
+			std::vector<uint8_t> buf;
+			template<class T>
+			void put(const T& v)
+			{
+				const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&v);
+				buf.insert(buf.end(), ptr, ptr + sizeof(T));
+			};
+			template<class T>
+			void putVec(const std::vector<T>& v)
+			{ /// T has no padding bytes
+				put<uint32_t>(static_cast<uint32_t>(v.size()));
+				const uint8_t* ptr = reinterpret_cast<const uint8_t*>(v.data());
+				buf.insert(buf.end(), ptr, ptr + v.size() * sizeof(T));
+			};
+			void putStr(const std::string& s)
+			{
+				put<uint32_t>(static_cast<uint32_t>(s.size()));
+				buf.insert(buf.end(), s.begin(), s.end());
+			};
+	};
+
+	class imageReader
+	{
+		private:
+			const uint8_t* ptr;
+			const uint8_t* end;
+			bool ok;
+			bool has(size_t size)
+			{
+				ok = ok && (static_cast<size_t>(end - ptr) >= size);
+				return(ok);
+			};
+		public:
+			imageReader(const uint8_t* ptr_, size_t size) : ptr(ptr_), end(ptr_ + size), ok(true) {};
+			bool fail(void) const {return(!ok);};
+			bool eof(void) const {return(ptr == end);};
+			template<class T>
+			T get(void)
+			{
+				T v;
+				std::memset(&v, 0, sizeof(T));
+				if (has(sizeof(T)))
+				{
+					std::memcpy(&v, ptr, sizeof(T));
+					ptr += sizeof(T);
+				}
+				return(v);
+			};
+			template<class T>
+			void getVec(std::vector<T>& v)
+			{
+				size_t size = get<uint32_t>();
+				if (!has(size * sizeof(T)))
+					return;
+				v.resize(size);
+				std::memcpy(v.data(), ptr, size * sizeof(T));
+				ptr += size * sizeof(T);
+			};
+			void getStr(std::string& s)
+			{
+				size_t size = get<uint32_t>();
+				if (!has(size))
+					return;
+				s.assign(reinterpret_cast<const char*>(ptr), size);
+				ptr += size;
+			};
+	};
+
+	void putNode(imageWriter& w, const NmapData::NodeStruct& nodeObj)
+	{ /// field by field, NodeStruct has padding bytes
+		w.put(nodeObj.geoNode);
+		w.put(nodeObj.ptNode);
+		w.put(nodeObj.dTo1stNode);
+		w.put(nodeObj.heading);
+	}
+
+	void getNode(imageReader& r, NmapData::NodeStruct& nodeObj)
+	{
+		nodeObj.geoNode = r.get<GeoUtils::geoRefPoint_t>();
+		nodeObj.ptNode = r.get<GeoUtils::point2D_t>();
+		nodeObj.dTo1stNode = r.get<uint32_t>();
+		nodeObj.heading = r.get<uint16_t>();
+	}
+
+	void putSegments(imageWriter& w, const NmapData::SegmentsStruct& segObj)
+	{
+		w.putVec(segObj.laneStart);
+		w.putVec(segObj.x0);
+		w.putVec(segObj.y0);
+		w.putVec(segObj.ux);
+		w.putVec(segObj.uy);
+		w.putVec(segObj.length);
+		w.putVec(segObj.heading);
+		w.putVec(segObj.nodeIndex);
+		w.put(segObj.axisX);
+		w.put(segObj.axisY);
+		w.putVec(segObj.laneMinA);
+		w.putVec(segObj.laneMaxA);
+		w.putVec(segObj.laneMinC);
+		w.putVec(segObj.laneMaxC);
+		w.putVec(segObj.footMinA);
+		w.putVec(segObj.footMaxA);
+		w.putVec(segObj.footMinC);
+		w.putVec(segObj.footMaxC);
+	}
+
+	void getSegments(imageReader& r, NmapData::SegmentsStruct& segObj)
+	{
+		r.getVec(segObj.laneStart);
+		r.getVec(segObj.x0);
+		r.getVec(segObj.y0);
+		r.getVec(segObj.ux);
+		r.getVec(segObj.uy);
+		r.getVec(segObj.length);
+		r.getVec(segObj.heading);
+		r.getVec(segObj.nodeIndex);
+		segObj.axisX = r.get<double>();
+		segObj.axisY = r.get<double>();
+		r.getVec(segObj.laneMinA);
+		r.getVec(segObj.laneMaxA);
+		r.getVec(segObj.laneMinC);
+		r.getVec(segObj.laneMaxC);
+		r.getVec(segObj.footMinA);
+		r.getVec(segObj.footMaxA);
+		r.getVec(segObj.footMinC);
+		r.getVec(segObj.footMaxC);
+	}
+}
+
+bool LocAware::saveNmapImage(const std::string& fname) const
+{
+	imageWriter w;
+	w.put(static_cast<uint32_t>(mpIntersection.size()));
+	for (const auto& intObj : mpIntersection)
+	{
+		w.put(intObj.mapVersion);
+		w.putStr(intObj.name);
+		w.putStr(intObj.rsuId);
+		w.put(intObj.id);
+		w.put(static_cast<uint8_t>(intObj.attributes.to_ulong()));
+		w.put(intObj.geoRef);
+		w.put(intObj.enuCoord);
+		w.put(intObj.radius);
+		w.putVec(intObj.speeds);
+		w.putVec(intObj.mpPolygon);
+		w.put(static_cast<uint8_t>(intObj.mpPolygonType));
+		w.putVec(intObj.mapPayload);
+		w.put(static_cast<uint32_t>(intObj.mpApproaches.size()));
+		for (const auto& appObj : intObj.mpApproaches)
+		{
+			w.put(appObj.id);
+			w.put(appObj.speed_limit);
+			w.put(static_cast<uint8_t>(appObj.type));
+			w.putVec(appObj.mpPolygon);
+			w.put(static_cast<uint8_t>(appObj.mpPolygonType));
+			w.put(appObj.mindist2intsectionCentralLine);
+			putSegments(w, appObj.mpSegments);
+			w.put(static_cast<uint32_t>(appObj.mpLanes.size()));
+			for (const auto& laneObj : appObj.mpLanes)
+			{
+				w.put(laneObj.id);
+				w.put(static_cast<uint8_t>(laneObj.type));
+				w.put(static_cast<uint32_t>(laneObj.attributes.to_ulong()));
+				w.put(laneObj.width);
+				w.put(laneObj.controlPhase);
+				w.put(static_cast<uint32_t>(laneObj.mpConnectTo.size()));
+				for (const auto& connObj : laneObj.mpConnectTo)
+				{
+					w.put(connObj.intersectionId);
+					w.put(connObj.laneId);
+					w.put(static_cast<uint8_t>(connObj.laneManeuver));
+				}
+				w.put(static_cast<uint32_t>(laneObj.mpNodes.size()));
+				for (const auto& nodeObj : laneObj.mpNodes)
+					putNode(w, nodeObj);
+			}
+		}
+	}
+
+	std::ofstream OS_IMAGE(fname, std::ios::binary | std::ios::trunc);
+	if (!OS_IMAGE.is_open())
+	{
+		std::cerr << "saveNmapImage: failed open " << fname << std::endl;
+		return(false);
+	}
+	uint64_t payloadSize = w.buf.size();
+	uint64_t checksum = getChecksum(w.buf.data(), w.buf.size());
+	OS_IMAGE.write(imageMagic, sizeof(imageMagic));
+	OS_IMAGE.write(reinterpret_cast<const char*>(&imageVersion), sizeof(imageVersion));
+	OS_IMAGE.write(reinterpret_cast<const char*>(&imageByteOrder), sizeof(imageByteOrder));
+	OS_IMAGE.write(reinterpret_cast<const char*>(&payloadSize), sizeof(payloadSize));
+	OS_IMAGE.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+	OS_IMAGE.write(reinterpret_cast<const char*>(w.buf.data()), static_cast<std::streamsize>(w.buf.size()));
+	OS_IMAGE.close();
+	return(!OS_IMAGE.fail());
+}
+
+bool LocAware::isNmapImage(const std::string& fname)
+{
+	char magic[sizeof(imageMagic)];
+	std::ifstream IS_IMAGE(fname, std::ios::binary);
+	return(IS_IMAGE.read(magic, sizeof(magic)) && (std::memcmp(magic, imageMagic, sizeof(imageMagic)) == 0));
+}
+
+bool LocAware::readNmapImage(const std::string& fname)
+{ // map the image read-only and shared, so that processes loading the same image share its page cache
+	int fd = open(fname.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		std::cerr << "readNmapImage: failed open " << fname << std::endl;
+		return(false);
+	}
+	struct stat st;
+	if ((fstat(fd, &st) < 0) || (static_cast<size_t>(st.st_size) < imageHeaderSize))
+	{
+		std::cerr << "readNmapImage: invalid image size " << fname << std::endl;
+		close(fd);
+		return(false);
+	}
+	size_t fileSize = static_cast<size_t>(st.st_size);
+	void* addr = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED)
+	{
+		std::cerr << "readNmapImage: failed mmap " << fname << std::endl;
+		return(false);
+	}
+	const uint8_t* ptr = static_cast<const uint8_t*>(addr);
+	imageReader header(ptr + sizeof(imageMagic), imageHeaderSize - sizeof(imageMagic));
+	uint32_t version = header.get<uint32_t>();
+	uint32_t byteOrder = header.get<uint32_t>();
+	uint64_t payloadSize = header.get<uint64_t>();
+	uint64_t checksum = header.get<uint64_t>();
+	bool ret = false;
+	if ((std::memcmp(ptr, imageMagic, sizeof(imageMagic)) != 0) || (version != imageVersion) || (byteOrder != imageByteOrder))
+		std::cerr << "readNmapImage: unsupported image version " << fname << std::endl;
+	else if ((payloadSize != fileSize - imageHeaderSize) || (getChecksum(ptr + imageHeaderSize, fileSize - imageHeaderSize) != checksum))
+		std::cerr << "readNmapImage: corrupted image " << fname << std::endl;
+	else
+	{
+		imageReader r(ptr + imageHeaderSize, fileSize - imageHeaderSize);
+		std::vector<NmapData::IntersectionStruct> aIntersection(r.get<uint32_t>());
+		for (auto& intObj : aIntersection)
+		{
+			intObj.mapVersion = r.get<uint8_t>();
+			r.getStr(intObj.name);
+			r.getStr(intObj.rsuId);
+			intObj.id = r.get<uint16_t>();
+			intObj.attributes = std::bitset<8>(r.get<uint8_t>());
+			intObj.geoRef = r.get<GeoUtils::geoRefPoint_t>();
+			intObj.enuCoord = r.get<GeoUtils::enuCoord_t>();
+			intObj.radius = r.get<uint32_t>();
+			r.getVec(intObj.speeds);
+			r.getVec(intObj.mpPolygon);
+			intObj.mpPolygonType = static_cast<MsgEnum::polygonType>(r.get<uint8_t>());
+			r.getVec(intObj.mapPayload);
+			intObj.mpApproaches.resize(r.get<uint32_t>());
+			for (auto& appObj : intObj.mpApproaches)
+			{
+				appObj.id = r.get<uint8_t>();
+				appObj.speed_limit = r.get<uint8_t>();
+				appObj.type = static_cast<MsgEnum::approachType>(r.get<uint8_t>());
+				r.getVec(appObj.mpPolygon);
+				appObj.mpPolygonType = static_cast<MsgEnum::polygonType>(r.get<uint8_t>());
+				appObj.mindist2intsectionCentralLine = r.get<uint32_t>();
+				getSegments(r, appObj.mpSegments);
+				appObj.mpLanes.resize(r.get<uint32_t>());
+				for (auto& laneObj : appObj.mpLanes)
+				{
+					laneObj.id = r.get<uint8_t>();
+					laneObj.type = static_cast<MsgEnum::laneType>(r.get<uint8_t>());
+					laneObj.attributes = std::bitset<20>(r.get<uint32_t>());
+					laneObj.width = r.get<uint16_t>();
+					laneObj.controlPhase = r.get<uint8_t>();
+					laneObj.mpConnectTo.resize(r.get<uint32_t>());
+					for (auto& connObj : laneObj.mpConnectTo)
+					{
+						connObj.intersectionId = r.get<uint16_t>();
+						connObj.laneId = r.get<uint8_t>();
+						connObj.laneManeuver = static_cast<MsgEnum::maneuverType>(r.get<uint8_t>());
+					}
+					laneObj.mpNodes.resize(r.get<uint32_t>());
+					for (auto& nodeObj : laneObj.mpNodes)
+						getNode(r, nodeObj);
+					if (r.fail())
+						break;
+				}
+			}
+		}
+		if (r.fail() || !r.eof())
+			std::cerr << "readNmapImage: corrupted image " << fname << std::endl;
+		else
+		{
+			mpIntersection.swap(aIntersection);
+			// rebuild IndexMap
+			IndexMap.clear();
+			uint32_t intIndx = 0;
+			for (const auto& intObj : mpIntersection)
+			{
+				uint32_t appIndx = 0;
+				for (const auto& appObj : intObj.mpApproaches)
+				{
+					uint32_t laneIndx = 0;
+					for (const auto& laneObj : appObj.mpLanes)
+					{
+						uint32_t key = (intObj.id << 8) | laneObj.id;
+						IndexMap[key] = (intIndx << 16) | (appIndx << 8) | laneIndx;
+						laneIndx++;
+					}
+					appIndx++;
+				}
+				intIndx++;
+			}
+			ret = true;
+		}
+	}
+	munmap(addr, fileSize);
+	return(ret);
+}
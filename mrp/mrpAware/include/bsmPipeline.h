@@ -0,0 +1,111 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#ifndef _MRP_BSM_PIPELINE_H
+#define _MRP_BSM_PIPELINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "dsrcBSM.h"
+#include "geoUtils.h"
+#include "locAware.h"
+#include "queueUtils.h"
+#include "tableUtils.h"
+
+/// inbound BSM going through the decode & map-matching stage. The receiving thread fills the input
+/// fields, the stage sets the result fields.
+struct bsmJob_t
+{
+	enum class result : uint8_t {located, duplicate, farAway, stale, failed};
+	/// input
+	unsigned long long msec;        // time the BSM was received
+	uint32_t msOfDay;               // local time of day the BSM was received
+	std::vector<uint8_t> datagram;  // MMITSS header + BSM payload, kept for the payload log
+	size_t offset;                  // start of the BSM payload in datagram
+	size_t length;                  // length of the BSM payload
+	bool peeked;                    // header holds the leading BSMcoreData fields, false decodes without the filter
+	BSM_header_t header;
+	/// result
+	result status;
+	BSM_element_t bsm;              // valid when status is located
+	bool doMapping;                 // cv has been located on the MAP, otherwise it keeps the previous result
+	GeoUtils::connectedVehicle_t cv;
+};
+
+/// decode & map-matching stage of inbound BSMs, run on a pool of worker threads.
+/// - BSMs are sharded by TemporaryID, so all BSMs of a vehicle go to the same worker, in order;
+/// - each worker keeps the last located point of the vehicles on its shard (to skip map matching of
+///   stopped vehicles, to drop duplicate BSMs and BSMs of new vehicles that are away from all
+///   intersections), and forgets a vehicle after timeout_msec without BSM;
+/// - the receiving thread hands BSMs to the workers and takes the results back through
+///   queueUtils::StageRing, in the order the BSMs were received, so the signal decision logic that
+///   consumes the results stays single-threaded and deterministic.
+/// With zero workers, the stage runs on the receiving thread when a BSM is published.
+class BsmPipeline
+{
+	private:
+		struct track_t
+		{
+			uint8_t  msgCnt;
+			uint16_t timeStampSec;
+			GeoUtils::connectedVehicle_t last;  // the latest located point
+		};
+		struct shard_t
+		{
+			queueUtils::StageRing<bsmJob_t> ring;
+			tableUtils::KeyedTable<track_t> tracks;
+			tableUtils::TimerWheel expiry;
+			GeoUtils::connectedVehicle_t scratch;  // starting point of a vehicle that is not kept in tracks
+			std::thread worker;
+			std::mutex mtx;
+			std::condition_variable cond;
+			std::atomic<bool> sleeping;
+			shard_t(size_t queueSize, size_t maxVehicles, unsigned long long timeout_msec, unsigned long long now_msec);
+		};
+		const LocAware& locAware;
+		int32_t elevation;              // elevation of the intersection reference point
+		double stopSpeed;               // in m/s
+		double stopDist;                // in meters
+		unsigned long long timeout;     // in milliseconds
+		std::vector<shard_t*> shards;
+		size_t workerNums;
+		std::atomic<bool> stopping;
+		std::vector<uint8_t> order;     // shard of each BSM in flight, in the order received
+		uint64_t orderHead;
+		uint64_t orderTail;
+		uint8_t claimed;                // shard of the claimed job
+
+		void run(shard_t& shard);
+		void locate(shard_t& shard, bsmJob_t& job);
+
+	public:
+		BsmPipeline(const LocAware& locAware_, int32_t elevation_, double stopSpeed_, double stopDist_,
+			size_t workers, size_t queueSize, size_t maxVehicles, unsigned long long timeout_msec, unsigned long long now_msec);
+		~BsmPipeline(void);
+
+		size_t workers(void) const {return(workerNums);};
+		/// receiving thread: job to fill for a BSM of vehicle vehId, nullptr when the shard is full
+		/// (take results with ready() or wait() to make room). vehId is the TemporaryID of the BSM, so
+		/// a BSM whose header cannot be peeked has no shard and is dropped before claim()
+		bsmJob_t* claim(uint32_t vehId);
+		/// receiving thread: hand the claimed job to the stage
+		void publish(void);
+		/// receiving thread: oldest BSM in flight when its result is available, otherwise nullptr
+		bsmJob_t* ready(void);
+		/// receiving thread: oldest BSM in flight, waits for its result. nullptr when no BSM is in flight
+		bsmJob_t* wait(void);
+		/// receiving thread: done with the job returned by ready() or wait()
+		void release(void);
+		bool pending(void) const {return(orderTail != orderHead);};
+};
+
+#endif
@@ -14,14 +14,52 @@
 
 #include "dsrcBSM.h"
 #include "dsrcSRM.h"
+#include "dsrcSSM.h"
 #include "geoUtils.h"
 #include "msgDefs.h"
 #include "msgEnum.h"
+#include "tableUtils.h"
 #include "timeUtils.h"
 
+/// default capacity of vehList and srmList (SSM holds at most 32 request status entries)
+static const size_t defaultMaxVehicles = 2000;
+static const size_t defaultMaxRequests = 32;
+
 enum class prioGrantType : uint8_t {none, earlyGreen, greenExtension};
 enum class phaseExtType  : uint8_t {none, called, cancelled};
 
+/// structure to hold trajectory history of a vehicle. Only what msgid_traj needs is kept:
+/// the first tracked point, and counts of tracked points and of stopped points.
+/// The last tracked point is cvStatusAware_t::cvStatus.
+struct trajHistory_t
+{
+	unsigned long long entry_msec;
+	double   entryDist2go;       // in meters
+	uint8_t  entryLaneId;
+	uint8_t  entryControlPhase;
+	uint16_t pointCnt;           // number of tracked points, 0 when there is no tracked point
+	uint16_t stoppedCnt;         // number of tracked points with speed <= stopSpeed
+	void reset(void)
+	{
+		pointCnt = 0;
+		stoppedCnt = 0;
+	};
+	void add(const GeoUtils::connectedVehicle_t& cv, double stopSpeed)
+	{
+		if (pointCnt == 0)
+		{
+			entry_msec = cv.msec;
+			entryDist2go = cv.vehicleLocationAware.dist2go.distLong;
+			entryLaneId = cv.vehicleLocationAware.laneId;
+			entryControlPhase = cv.vehicleLocationAware.controlPhase;
+		}
+		if (pointCnt < UINT16_MAX)
+			pointCnt++;
+		if ((cv.motionState.speed <= stopSpeed) && (stoppedCnt < UINT16_MAX))
+			stoppedCnt++;
+	};
+};
+
 /// structure to hold connected vehicle status including geo-location, map matched location,
 /// location/signal aware, and status of vehicular phase call and/or phase extension request
 struct cvStatusAware_t
@@ -31,13 +69,26 @@ struct cvStatusAware_t
 	bool isExtensionCalled;  // extend vehicle phase green at most once for each vehicle when it's needed
 	unsigned long long msec;
 	BSM_element_t bsm;
-	std::vector<GeoUtils::connectedVehicle_t> cvStatus;
+	GeoUtils::connectedVehicle_t cvStatus;  // the latest tracked point (valid when traj.pointCnt > 0)
+	trajHistory_t traj;
 	void reset(void)
 	{
 		isOnInbound = false;
 		isPhaseCalled = false;
 		isExtensionCalled = false;
-		cvStatus.clear();
+		traj.reset();
+	};
+	/// start a new trajectory from cv
+	void restart(const GeoUtils::connectedVehicle_t& cv, double stopSpeed)
+	{
+		traj.reset();
+		append(cv, stopSpeed);
+	};
+	/// add tracked point cv to the trajectory
+	void append(const GeoUtils::connectedVehicle_t& cv, double stopSpeed)
+	{
+		cvStatus = cv;  /// copy assignment reuses capacity of connect2go
+		traj.add(cv, stopSpeed);
 	};
 };
 
@@ -50,6 +101,26 @@ struct srmStatus_t
 	SRM_element_t srm;
 };
 
+/// structure to hold footprint counters of vehList and srmList
+struct listStats_t
+{
+	unsigned long long vehEvicted;  // vehicles removed after dsrcTimeout without BSM
+	unsigned long long srmEvicted;  // requests removed after dsrcTimeout without SRM
+	unsigned long long vehDropped;  // new vehicles dropped as vehList is full
+	unsigned long long srmDropped;  // new requests dropped as srmList is full
+	unsigned long long bsmDuplicate;  // BSMs dropped before decoding, not newer than the one on vehList
+	unsigned long long bsmFarAway;    // BSMs dropped before decoding, new vehicle outside radius of every intersection
+	void reset(void)
+	{
+		vehEvicted = 0;
+		srmEvicted = 0;
+		vehDropped = 0;
+		srmDropped = 0;
+		bsmDuplicate = 0;
+		bsmFarAway = 0;
+	};
+};
+
 struct prioRequestCadidate_t
 {
 	uint32_t vehId;
@@ -112,13 +183,13 @@ size_t packMsg(std::vector<uint8_t>& buf, uint8_t callPhase, MsgEnum::softCallOb
 size_t packMsg(std::vector<uint8_t>& buf, std::bitset<8> callPhases, MsgEnum::softCallObj callObj,
 	MsgEnum::softCallType callType, uint32_t msOfDay, uint8_t msgid);
 size_t packMsg(std::vector<uint8_t>& buf, const cvStatusAware_t& cvStatusAware, const timeUtils::dateStamp_t& curDateStamp,
-	uint32_t msOfDay, uint32_t laneLen, double stopSpeed, uint8_t msgid);
-void packMsg(SSM_element_t& ssm, const std::vector<srmStatus_t> list, const timeUtils::dateTimeStamp_t utcDateTimeStamp);
+	uint32_t msOfDay, uint32_t laneLen, uint8_t msgid);
+void packMsg(SSM_element_t& ssm, const tableUtils::KeyedTable<srmStatus_t>& list, const timeUtils::dateTimeStamp_t utcDateTimeStamp);
 uint16_t getTime2Go(double dist2go, double speed, double stopSpeed);
 bool withinTimeWindow(uint16_t windowStartTime, uint16_t windowLength, uint16_t arrivalTime);
 bool isTimeBefore(uint16_t timePoint_1, uint16_t timePoint_2);
 uint16_t getDuration(uint16_t fromTimePoint, uint16_t toTimePoint);
 size_t getCandidateIndex(const std::vector<prioRequestCadidate_t>& candidates);
-void setGrantStatus(std::vector<srmStatus_t>& list, const std::vector<prioRequestCadidate_t>& candidates);
+void setGrantStatus(tableUtils::KeyedTable<srmStatus_t>& list, const std::vector<prioRequestCadidate_t>& candidates);
 
 #endif
@@ -0,0 +1,217 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#include <cmath>
+#include <thread>
+
+#include "AsnJ2735Lib.h"
+#include "msgEnum.h"
+#include "bsmPipeline.h"
+
+BsmPipeline::shard_t::shard_t(size_t queueSize, size_t maxVehicles, unsigned long long timeout_msec, unsigned long long now_msec)
+	: ring(queueSize), tracks(maxVehicles), expiry(tracks.capacity(), timeout_msec, 100LL, now_msec), sleeping(false)
+{}
+
+BsmPipeline::BsmPipeline(const LocAware& locAware_, int32_t elevation_, double stopSpeed_, double stopDist_,
+	size_t workers, size_t queueSize, size_t maxVehicles, unsigned long long timeout_msec, unsigned long long now_msec)
+	: locAware(locAware_), elevation(elevation_), stopSpeed(stopSpeed_), stopDist(stopDist_), timeout(timeout_msec),
+		workerNums(workers), stopping(false), orderHead(0), orderTail(0), claimed(0)
+{
+	size_t shardNums = (workers > 0) ? workers : 1;
+	if (shardNums > 255)
+		shardNums = 255;
+	workerNums = (workers > 0) ? shardNums : 0;
+	for (size_t i = 0; i < shardNums; i++)
+		shards.push_back(new shard_t(queueSize, maxVehicles, timeout_msec, now_msec));
+	order.resize(shardNums * shards[0]->ring.capacity());
+	for (size_t i = 0; i < workerNums; i++)
+		shards[i]->worker = std::thread(&BsmPipeline::run, this, std::ref(*shards[i]));
+}
+
+BsmPipeline::~BsmPipeline(void)
+{
+	stopping.store(true);
+	for (auto& shard : shards)
+	{
+		if (shard->worker.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(shard->mtx);
+				shard->cond.notify_one();
+			}
+			shard->worker.join();
+		}
+		delete shard;
+	}
+}
+
+bsmJob_t* BsmPipeline::claim(uint32_t vehId)
+{ /// Fibonacci hashing spreads consecutive TemporaryIDs over the shards
+	claimed = (uint8_t)((((uint64_t)(uint32_t)(vehId * 2654435769U)) * shards.size()) >> 32);
+	return(shards[claimed]->ring.claim());
+}
+
+void BsmPipeline::publish(void)
+{
+	shard_t& shard = *shards[claimed];
+	order[orderHead % order.size()] = claimed;
+	orderHead++;
+	shard.ring.publish();
+	if (workerNums == 0)
+	{ /// run the stage on the receiving thread
+		locate(shard, *shard.ring.next());
+		shard.ring.finish();
+		return;
+	}
+	/// pairs with the worker going to sleep in run(): either the worker sees the job when it re-checks
+	/// its ring, or this thread sees it sleeping
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (shard.sleeping.load(std::memory_order_relaxed))
+	{
+		std::lock_guard<std::mutex> lock(shard.mtx);
+		shard.cond.notify_one();
+	}
+}
+
+bsmJob_t* BsmPipeline::ready(void)
+{
+	if (orderTail == orderHead)
+		return(nullptr);
+	return(shards[order[orderTail % order.size()]]->ring.ready());
+}
+
+bsmJob_t* BsmPipeline::wait(void)
+{
+	if (orderTail == orderHead)
+		return(nullptr);
+	queueUtils::StageRing<bsmJob_t>& ring = shards[order[orderTail % order.size()]]->ring;
+	bsmJob_t* job;
+	while ((job = ring.ready()) == nullptr)
+		std::this_thread::yield();
+	return(job);
+}
+
+void BsmPipeline::release(void)
+{
+	shards[order[orderTail % order.size()]]->ring.release();
+	orderTail++;
+}
+
+void BsmPipeline::run(shard_t& shard)
+{
+	const int spinNums = 64;  // polls of an empty ring before going to sleep
+	int spins = 0;
+	while (!stopping.load(std::memory_order_relaxed))
+	{
+		bsmJob_t* job = shard.ring.next();
+		if (job != nullptr)
+		{
+			locate(shard, *job);
+			shard.ring.finish();
+			spins = 0;
+		}
+		else if (++spins < spinNums)
+			std::this_thread::yield();
+		else
+		{
+			std::unique_lock<std::mutex> lock(shard.mtx);
+			shard.sleeping.store(true, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			while ((shard.ring.next() == nullptr) && !stopping.load())
+				shard.cond.wait(lock);
+			shard.sleeping.store(false, std::memory_order_relaxed);
+			spins = 0;
+		}
+	}
+}
+
+void BsmPipeline::locate(shard_t& shard, bsmJob_t& job)
+{ /// forget vehicles that have not sent a BSM within timeout
+	shard.expiry.expire(job.msec, [&shard](uint32_t slot)
+		{shard.tracks.erase(shard.tracks.keyOf(slot));});
+	/// drop duplicate BSMs (e.g., the same vehicle heard by two RSUs) and BSMs from new vehicles
+	/// that are away from all intersections before decoding
+	const uint8_t* payload = &job.datagram[job.offset];
+	if (job.peeked)
+	{
+		const track_t* it = shard.tracks.find(job.header.id);
+		if ((it != nullptr) && (job.header.msgCnt <= it->msgCnt) && (job.header.timeStampSec <= it->timeStampSec))
+		{
+			job.status = bsmJob_t::result::duplicate;
+			return;
+		}
+		if (it == nullptr)
+		{
+			GeoUtils::geoRefPoint_t geoRef{job.header.latitude, job.header.longitude, elevation};
+			GeoUtils::geoPoint_t geoPoint;
+			GeoUtils::geoRefPoint2geoPoint(geoRef, geoPoint);
+			if (!locAware.isPointNearAnyIntersection(geoPoint))
+			{
+				job.status = bsmJob_t::result::farAway;
+				return;
+			}
+		}
+	}
+	/// decode BSM, only BSMcoreData is used
+	BSM_element_t& bsm = job.bsm;
+	if (AsnJ2735Lib::decode_bsm_coredata(payload, job.length, bsm) == 0)
+	{
+		job.status = bsmJob_t::result::failed;
+		return;
+	}
+	/// when elevation is not included, use elevation of intersection reference point
+	if (bsm.elevation == MsgEnum::unknown_elevation)
+		bsm.elevation = elevation;
+	track_t* it = shard.tracks.find(bsm.id);
+	if ((it != nullptr) && (bsm.msgCnt <= it->msgCnt) && (bsm.timeStampSec <= it->timeStampSec))
+	{
+		job.status = bsmJob_t::result::stale;
+		return;
+	}
+	/// construct GeoUtils::connectedVehicle_t from the newly received BSM
+	GeoUtils::connectedVehicle_t& cvIn = job.cv;
+	cvIn.reset();
+	GeoUtils::geoRefPoint_t geoRef{bsm.latitude, bsm.longitude, bsm.elevation};
+	GeoUtils::geoRefPoint2geoPoint(geoRef, cvIn.geoPoint);
+	cvIn.id = bsm.id;
+	cvIn.msec = job.msec;
+	cvIn.motionState.speed = (double)bsm.speed * 0.02;
+	cvIn.motionState.heading = (double)bsm.heading * 0.0125;
+	/// a new vehicle starts from the newly received BSM (it is located on MAP when the table is full as well)
+	bool first_bsm = (it == nullptr);
+	if (first_bsm && ((it = shard.tracks.insert(bsm.id)) != nullptr))
+		it->last = cvIn;
+	if (it != nullptr)
+	{
+		it->msgCnt = bsm.msgCnt;
+		it->timeStampSec = bsm.timeStampSec;
+		shard.expiry.schedule(shard.tracks.slotOf(it), job.msec + timeout);
+	}
+	/// determining whether or not to conduct locating vehicle on MAP,
+	/// no need to re-do mapping when speed < stopSpeed & distance_traveled < stopDist.
+	job.doMapping = first_bsm || (it == nullptr) || (cvIn.motionState.speed >= stopSpeed)
+		|| (fabs(GeoUtils::distlla2lla(cvIn.geoPoint, it->last.geoPoint)) >= stopDist);
+	if (!job.doMapping)
+	{ /// keep the latest result of locating vehicle on MAP
+		cvIn.isVehicleInMap = it->last.isVehicleInMap;
+		cvIn.vehicleTrackingState = it->last.vehicleTrackingState;
+		cvIn.vehicleLocationAware = it->last.vehicleLocationAware;
+	}
+	else
+	{ /// locate the vehicle on MAP, starting from the latest located point
+		if (it == nullptr)
+			shard.scratch = cvIn;
+		GeoUtils::connectedVehicle_t& cvLast = (it != nullptr) ? it->last : shard.scratch;
+		cvLast.geoPoint = cvIn.geoPoint;
+		cvLast.motionState = cvIn.motionState;
+		cvIn.isVehicleInMap = locAware.locateVehicleInMap(cvLast, cvIn.vehicleTrackingState);
+		/// update locationAware
+		locAware.updateLocationAware(cvIn.vehicleTrackingState, cvIn.vehicleLocationAware);
+		if (it != nullptr)
+			it->last = cvIn;
+	}
+	job.status = bsmJob_t::result::located;
+}
@@ -1,6 +1,6 @@
 //********************************************************************************************************
 //
-//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+// � 2016 Regents of the University of California on behalf of the University of California at Berkeley
 //       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
 //
 //*********************************************************************************************************
@@ -72,7 +72,6 @@
  */
 
 #include <algorithm>
-#include <chrono>
 #include <cmath>
 #include <csignal>
 #include <fstream>
@@ -80,14 +79,16 @@
 #include <string>
 #include <sys/socket.h>
 #include <sys/types.h>
-#include <thread>
 #include <unistd.h>
 
 #include "AsnJ2735Lib.h"
+#include "bsmPipeline.h"
 #include "locAware.h"
 #include "cnfUtils.h"
+#include "eventUtils.h"
 #include "logUtils.h"
 #include "msgUtils.h"
+#include "paceUtils.h"
 #include "socketUtils.h"
 #include "mrpAware.h"
 
@@ -148,7 +149,14 @@ int main(int argc, char** argv)
 	}
 	unsigned long long logInterval = pmycnf->getIntegerParaValue(std::string("logInterval")) * 60 * 1000;   // in milliseconds
 	unsigned long long timeouInterval = pmycnf->getIntegerParaValue(std::string("dsrcTimeout")) * 1000;     // in milliseconds
+	int maxVehicles = pmycnf->getIntegerParaValue(std::string("maxVehicles"));  // capacity of vehList
+	int maxRequests = pmycnf->getIntegerParaValue(std::string("maxRequests"));  // capacity of srmList
 	int logType = pmycnf->getIntegerParaValue(std::string("logType"));
+	bool logCompress = (pmycnf->getIntegerParaValue(std::string("logCompress")) > 0);
+	int ssmInterval = pmycnf->getIntegerParaValue(std::string("ssmInterval"));        // in milliseconds
+	int ssmMinInterval = pmycnf->getIntegerParaValue(std::string("ssmMinInterval"));  // in milliseconds
+	int ssmBurst = pmycnf->getIntegerParaValue(std::string("ssmBurst"));
+	int bsmWorkers = pmycnf->getIntegerParaValue(std::string("bsmWorkers"));  // 0 = decode & map-match BSMs on the main thread
 	logUtils::logType log_type = ((logInterval == 0) || ((logType != 1) && (logType != 2)))
 		? logUtils::logType::none : static_cast<logUtils::logType>(logType);
 	uint16_t maxGreenExtenstion     = (uint16_t)(pmycnf->getIntegerParaValue(std::string("maxGreenExtenstion")) * 10);  // in tenths of a second
@@ -157,7 +165,6 @@ int main(int argc, char** argv)
 	uint16_t maxTime2phaseExt       = (uint16_t)(pmycnf->getIntegerParaValue(std::string("maxTime4phaseExt")) * 10);    // in tenths of a second
 	std::string fnmap = pmycnf->getStringParaValue(std::string("nmapFile"));
 	std::string logPath = pmycnf->getStringParaValue(std::string("logPath"));
-	unsigned long long logfile_msec = 0;
 
 	/// open error log
 	std::ofstream OS_ERR(logPath + std::string("/awr.err"), std::ofstream::app);
@@ -181,30 +188,20 @@ int main(int argc, char** argv)
 		return(-1);
 	}
 	unsigned long long displayLogInterval = 15 * 60 * 1000;  /// 15 minutes in milliseconds
-	unsigned long long displayfile_msec = fullTimeStamp.msec;
 
-	/// open log files
-	std::vector<logUtils::Logfile_t> logFiles;
-	if (log_type != logUtils::logType::none)
+	/// open log files, written by a background thread
+	logUtils::Logger logger(logPath + std::string("/") + intersectionName, logCompress);
+	const size_t payloadLog = logger.addChannel(std::string("payload"));  // encoded payload of inbound BSM, SRM, PSRM and outbound SSM
+	const size_t reqLog = logger.addChannel(std::string("req"));          // log soft-call request message send to MRP_DataMgr
+	const size_t trajLog = logger.addChannel(std::string("traj"));        // log vehicle trajectory message sent to MRP_DataMgr
+	if ((log_type != logUtils::logType::none) && !logger.open(fullTimeStamp.localDateTimeStamp.to_fileName()))
 	{
-		std::vector<std::string> logtypes;
-		logtypes.push_back(std::string("payload"));  // encoded payload of inbound BSM, SRM, PSRM and outbound SSM
-		logtypes.push_back(std::string("req"));      // log soft-call request message send to MRP_DataMgr
-		logtypes.push_back(std::string("traj"));     // log vehicle trajectory message sent to MRP_DataMgr
-		std::string prefix = logPath + std::string("/") + intersectionName;
-		for (auto& type : logtypes)
-			{logFiles.push_back(logUtils::Logfile_t(prefix, type));}
-		if (!openLogFiles(logFiles, fullTimeStamp.localDateTimeStamp.to_fileName()))
-		{
-			OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-			OS_ERR << ", failed openLogFiles" << std::endl;
-			OS_ERR.close();
-			OS_Display.close();
-			logUtils::closeLogFiles(logFiles);
-			delete pmycnf;
-			return(-1);
-		}
-		logfile_msec = fullTimeStamp.msec;
+		OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+		OS_ERR << ", failed openLogFiles" << std::endl;
+		OS_ERR.close();
+		OS_Display.close();
+		delete pmycnf;
+		return(-1);
 	}
 
 	/// instance class LocAware
@@ -216,8 +213,7 @@ int main(int argc, char** argv)
 		OS_ERR << ", failed initiating locAwareLib " << fnmap << "(" << intersectionName << ")" << std::endl;
 		OS_ERR.close();
 		OS_Display.close();
-		if (log_type != logUtils::logType::none)
-			logUtils::closeLogFiles(logFiles);
+		logger.close();
 		delete pmycnf;
 		delete plocAwareLib;
 		return(-1);
@@ -228,7 +224,7 @@ int main(int argc, char** argv)
 	plocAwareLib->getSpeedLimits(speedLimits, intersectionId);
 	SSM_element_t ssm;
 	ssm.id = intersectionId;
-	unsigned long long sentSSM_msec = 0;
+	unsigned long long ssmVersion = 0;  // incremented when ssm is re-packed from srmList
 
 	/// open sockets
 	if (!pmycnf->connectAll())
@@ -237,8 +233,7 @@ int main(int argc, char** argv)
 		OS_ERR << ", failed initiating sockets" << std::endl;
 		OS_ERR.close();
 		OS_Display.close();
-		if (log_type != logUtils::logType::none)
-			logUtils::closeLogFiles(logFiles);
+		logger.close();
 		delete pmycnf;
 		delete plocAwareLib;
 		return(-1);
@@ -262,16 +257,201 @@ int main(int argc, char** argv)
 	unsigned long long vehPhaseCallInterval = 1000LL;  // in milliseconds
 	/// receive & send UDP socket buffer
 	const size_t bufSize = 2000;
-	std::vector<uint8_t> recvbuf(bufSize, 0);
+	const size_t batchSize = 64;
+	socketUtils::DgramBatch rxBatch(batchSize, bufSize);  // drains fd_Listen with one recvmmsg call per batch
 	std::vector<uint8_t> sendbuf(bufSize, 0);
-	/// vehList to store BSMs and results of locating BSMs on MAP
-	std::vector<cvStatusAware_t> vehList;
-	/// srmList to store SRMs and status of priority request
-	std::vector<srmStatus_t> srmList;
+	/// outbound SSM slot: the encoded SSM (after 9 bytes room for the MMITSS header) is re-broadcast every ssmInterval
+	/// while the priority list does not change, an updated list goes out paced by ssmMinInterval and ssmBurst
+	unsigned long long ssmRefresh = (ssmInterval > 0) ? (unsigned long long)ssmInterval : MsgEnum::ssmInterval;
+	paceUtils::TxSlot ssmSlot(bufSize, 9, ssmRefresh, (ssmMinInterval >= 0) ? (unsigned long long)ssmMinInterval : ssmRefresh,
+		(ssmBurst > 0) ? (unsigned long long)ssmBurst : 1);
+	/// at most maxDrainCnt datagrams are processed between two runs of the control logic
+	const size_t maxDrainCnt = 4 * batchSize;
+	size_t drainCnt = 0;
+	/// reactor to wait on fd_Listen and periodic tasks. The control logic runs on every wake-up,
+	/// controlTimer makes sure it runs at least every controlInterval when no message arrives.
+	const unsigned long long controlInterval = 100LL;  // in milliseconds
+	eventUtils::Reactor reactor;
+	reactor.addFd(fd_Listen);
+	size_t controlTimer = reactor.addTimer(controlInterval, controlInterval);
+	size_t logTimer = reactor.addTimer(logInterval, logInterval);
+	if (log_type == logUtils::logType::none)
+		reactor.disarmTimer(logTimer);
+	size_t displayTimer = reactor.addTimer(displayLogInterval, displayLogInterval);
+	/// vehList to store BSMs and results of locating BSMs on MAP, keyed by BSM TemporaryID
+	tableUtils::KeyedTable<cvStatusAware_t> vehList((maxVehicles > 0) ? (size_t)maxVehicles : defaultMaxVehicles);
+	/// srmList to store SRMs and status of priority request, keyed by SRM vehId
+	tableUtils::KeyedTable<srmStatus_t> srmList((maxRequests > 0) ? (size_t)maxRequests : defaultMaxRequests);
+	/// timer wheels to expire vehList & srmList entries that have not been updated within timeouInterval
+	const unsigned long long expiryTick = 100LL;  // in milliseconds
+	tableUtils::TimerWheel vehExpiry(vehList.capacity(), timeouInterval, expiryTick, fullTimeStamp.msec);
+	tableUtils::TimerWheel srmExpiry(srmList.capacity(), timeouInterval, expiryTick, fullTimeStamp.msec);
+	listStats_t listStats;
+	listStats.reset();
+	const unsigned long long listStatsInterval = 60 * 1000LL;  /// 1 minute in milliseconds
+	size_t listStatsTimer = reactor.addTimer(listStatsInterval, listStatsInterval);
+	/// decode & map-matching stage of inbound BSMs, sharded by TemporaryID over bsmWorkers threads
+	BsmPipeline bsmPipeline(*plocAwareLib, intGeoRef.elevation, stopSpeed, stopDist, (bsmWorkers > 0) ? (size_t)bsmWorkers : 0,
+		maxDrainCnt, vehList.capacity(), timeouInterval, fullTimeStamp.msec);
 	/// awareStatus to trace status of MRP_Aware component
 	aware_status_t awareStatus;
 	awareStatus.reset();
 
+	/// track a BSM that went through the decode & map-matching stage on vehList, in the order BSMs were received
+	auto trackBsm = [&](bsmJob_t& job)
+	{
+		if (job.status == bsmJob_t::result::duplicate)
+			listStats.bsmDuplicate++;
+		else if (job.status == bsmJob_t::result::farAway)
+			listStats.bsmFarAway++;
+		else if (job.status == bsmJob_t::result::failed)
+		{
+			OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+			OS_ERR << ", failed decode_bsm_coredata, payload=";
+			logUtils::logMsgHex(OS_ERR, &job.datagram[job.offset], job.length);
+			OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+			OS_Display << ", failed decode_bsm_coredata" << std::endl;
+		}
+		if (job.status != bsmJob_t::result::located)
+			return;
+		/// check whether it is an update BSM on vehList
+		const auto& bsm = job.bsm;
+		cvStatusAware_t* it = vehList.find(bsm.id);
+		if (it == nullptr)
+		{ /// add BSM to vehList (BSM is dropped when vehList is full)
+			if ((it = vehList.insert(bsm.id)) == nullptr)
+			{
+				listStats.vehDropped++;
+				return;
+			}
+			it->reset();
+		}
+		else if ((bsm.msgCnt <= it->bsm.msgCnt) && (bsm.timeStampSec <= it->bsm.timeStampSec))
+			return;
+		it->msec = job.msec;
+		it->bsm = bsm;
+		vehExpiry.schedule(vehList.slotOf(it), job.msec + timeouInterval);
+		if (log_type != logUtils::logType::none)
+			logger.log(payloadLog, &job.datagram[0], job.datagram.size(), job.msOfDay);
+		/// the newly received BSM, located on MAP by the stage
+		GeoUtils::connectedVehicle_t& cvIn = job.cv;
+		/// update signalAware
+		cvIn.vehicleSignalAware.reset();
+		if (cvIn.isVehicleInMap
+			&& (cvIn.vehicleTrackingState.intsectionTrackingState.intersectionIndex == intersectionIndex)
+			&& (cvIn.vehicleLocationAware.controlPhase > 0)
+			&& (awareStatus.cntrlState.signalStatus.mode != MsgEnum::controlMode::unavailable))
+		{
+			const auto& phaseState = awareStatus.cntrlState.spatRaw.phaseState[cvIn.vehicleLocationAware.controlPhase - 1];
+			cvIn.vehicleSignalAware.currState = phaseState.currState;
+			cvIn.vehicleSignalAware.startTime = phaseState.startTime;
+			cvIn.vehicleSignalAware.minEndTime = phaseState.minEndTime;
+			cvIn.vehicleSignalAware.maxEndTime = phaseState.maxEndTime;
+		}
+
+		/// update cvStatusAware with the current mapping result
+		if (it->isOnInbound)
+		{	/// the vehicle was onInbound of this intersection, possible current vehicleIntersectionStatus:
+			/// case 1: the vehicle remains on the same inbound approach or moved inside intersection box
+			if (cvIn.isVehicleInMap
+				&& (cvIn.vehicleTrackingState.intsectionTrackingState.intersectionIndex == intersectionIndex)
+				&& ((cvIn.vehicleTrackingState.intsectionTrackingState.vehicleIntersectionStatus == MsgEnum::mapLocType::onInbound)
+					|| (cvIn.vehicleTrackingState.intsectionTrackingState.vehicleIntersectionStatus == MsgEnum::mapLocType::atIntersectionBox))
+				&& (cvIn.vehicleTrackingState.intsectionTrackingState.approachIndex == it->cvStatus.vehicleTrackingState.intsectionTrackingState.approachIndex))
+			{ /// add tracked point to cvStatusAware trajectory
+				if (job.doMapping)
+					it->append(cvIn, stopSpeed);
+			}
+			/// case 2: the vehicle moved to outbound approach of this intersection
+			else if (cvIn.isVehicleInMap
+				&& (cvIn.vehicleTrackingState.intsectionTrackingState.intersectionIndex == intersectionIndex)
+				&& (cvIn.vehicleTrackingState.intsectionTrackingState.vehicleIntersectionStatus == MsgEnum::mapLocType::onOutbound))
+			{
+				if (it->traj.pointCnt >= 10)
+				{ /// send msgid_traj message to MRP_dataMgr
+					uint32_t laneLen = plocAwareLib->getLaneLength(intersectionId, it->traj.entryLaneId);
+					size_t msgSize = packMsg(sendbuf, *it, fullTimeStamp.localDateTimeStamp.dateStamp,
+						fullTimeStamp.localDateTimeStamp.msOfDay,	laneLen, msgUtils::msgid_traj);
+					socketUtils::sendall(sendConn, &sendbuf[0], msgSize);
+					if (log_type != logUtils::logType::none)
+						logger.log(trajLog, &sendbuf[0], msgSize);
+				}
+				/// reset cvStatusAware
+				it->reset();
+				it->restart(cvIn, stopSpeed);
+				OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+				OS_Display << " vehicle " << cvIn.id << " entered outbound lane ";
+				OS_Display << static_cast<unsigned int>(cvIn.vehicleLocationAware.laneId) << std::endl;
+			}
+			/// case 3: the vehicle changed intersection
+			else if (cvIn.isVehicleInMap
+				&& (cvIn.vehicleTrackingState.intsectionTrackingState.intersectionIndex != intersectionIndex))
+			{
+				if (it->traj.pointCnt >= 10)
+				{ /// send msgid_traj message to MRP_dataMgr
+					uint32_t laneLen = plocAwareLib->getLaneLength(intersectionId, it->traj.entryLaneId);
+					size_t msgSize = packMsg(sendbuf, *it, fullTimeStamp.localDateTimeStamp.dateStamp,
+						fullTimeStamp.localDateTimeStamp.msOfDay,	laneLen, msgUtils::msgid_traj);
+					socketUtils::sendall(sendConn, &sendbuf[0], msgSize);
+					if (log_type != logUtils::logType::none)
+						logger.log(trajLog, &sendbuf[0], msgSize);
+				}
+				/// reset cvStatusAware
+				it->reset();
+				it->restart(cvIn, stopSpeed);
+				OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+				OS_Display << " vehicle " << cvIn.id << " entered intersection ";
+				OS_Display << plocAwareLib->getIntersectionNameByIndex(cvIn.vehicleTrackingState.intsectionTrackingState.intersectionIndex);
+				OS_Display << " on lane " << static_cast<unsigned int>(cvIn.vehicleLocationAware.laneId);
+				OS_Display << ", phase " << static_cast<unsigned int>(cvIn.vehicleLocationAware.controlPhase) << std::endl;
+			}
+			/// case 4: the vehicle moved outside of the MAP area
+			else if (!cvIn.isVehicleInMap)
+			{
+				if (it->traj.pointCnt >= 10)
+				{ /// send msgid_traj message to MRP_dataMgr
+					uint32_t laneLen = plocAwareLib->getLaneLength(intersectionId, it->traj.entryLaneId);
+					size_t msgSize = packMsg(sendbuf, *it, fullTimeStamp.localDateTimeStamp.dateStamp,
+						fullTimeStamp.localDateTimeStamp.msOfDay,	laneLen, msgUtils::msgid_traj);
+					socketUtils::sendall(sendConn, &sendbuf[0], msgSize);
+					if (log_type != logUtils::logType::none)
+						logger.log(trajLog, &sendbuf[0], msgSize);
+				}
+				/// reset cvStatusAware
+				it->reset();
+				it->restart(cvIn, stopSpeed);
+				OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+				OS_Display << " vehicle " << cvIn.id << " left MAP area" << std::endl;
+			}
+		}
+		/// the vehicle was not on any inbound approach and now entered on an inbound approach of this intersection
+		else if (cvIn.isVehicleInMap
+			&& (cvIn.vehicleTrackingState.intsectionTrackingState.intersectionIndex == intersectionIndex)
+			&& (cvIn.vehicleTrackingState.intsectionTrackingState.vehicleIntersectionStatus == MsgEnum::mapLocType::onInbound))
+		{	/// this is the first record of vehicle onInbound at this intersection
+			it->isOnInbound = true;
+			it->restart(cvIn, stopSpeed);
+			OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+			OS_Display << " vehicle " << cvIn.id << " entered inbound lane ";
+			OS_Display << static_cast<unsigned int>(cvIn.vehicleLocationAware.laneId) << ", phase ";
+			OS_Display << static_cast<unsigned int>(cvIn.vehicleLocationAware.controlPhase) << ", dist2go ";
+			OS_Display << cvIn.vehicleLocationAware.dist2go.distLong << std::endl;
+		}
+		///  the vehicle neither was nor currently on any inbound approach of this intersection
+		else if (job.doMapping || (it->traj.pointCnt == 0))
+			it->restart(cvIn, stopSpeed);
+	};
+	/// take the results of the BSMs in flight, all of them when waitAll is true, otherwise those available
+	auto drainBsms = [&](bool waitAll)
+	{
+		bsmJob_t* job;
+		while ((job = (waitAll) ? bsmPipeline.wait() : bsmPipeline.ready()) != nullptr)
+		{
+			trackBsm(*job);
+			bsmPipeline.release();
+		}
+	};
+
 	if (verbose)
 	{
 		std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
@@ -279,9 +459,10 @@ int main(int argc, char** argv)
 	}
 
 	while(terminate == 0)
-	{ /// receiving UDP message (non-blocking)
-		uint32_t bsm_vehId = 0;  // set to BSM::TemporaryID when received an BSM
-		ssize_t bytesReceived = recv(fd_Listen, &recvbuf[0], bufSize, 0);
+	{ /// receiving UDP message (non-blocking), one datagram per pass until fd_Listen is drained
+		bool received = (drainCnt < maxDrainCnt) && rxBatch.next(fd_Listen);
+		std::vector<uint8_t>& recvbuf = rxBatch.buf();
+		ssize_t bytesReceived = (received) ? (ssize_t)rxBatch.len() : 0;
 		if (bytesReceived >= 9)
 		{ /// MMITSS header + message body
 			timeUtils::getFullTimeStamp(fullTimeStamp);
@@ -290,42 +471,39 @@ int main(int argc, char** argv)
 			msgUtils::unpackHeader(recvbuf, offset, udpHeader);
 			if (udpHeader.msgheader == msgUtils::msg_header)
 			{ /// actions based on message ID
+				/// SRM, PSRM and controller status are processed after the BSMs received before them have been tracked
+				if (udpHeader.msgid != msgUtils::msgid_bsm)
+					drainBsms(true);
 				if ((udpHeader.msgid == msgUtils::msgid_bsm)
 					&& (awareStatus.cntrlState.signalStatus.mode != MsgEnum::controlMode::unavailable))
-				{ /// decode BSM
-					BSM_element_t bsm;
-					if (AsnJ2735Lib::decode_bsm_payload(&recvbuf[offset], udpHeader.length, bsm) > 0)
-					{ /// when elevation is not included, use elevation of intersection reference point
-						if (bsm.elevation == MsgEnum::unknown_elevation)
-							bsm.elevation = intGeoRef.elevation;
-						/// check whether it is an update BSM on vehList
-						auto it = std::find_if(vehList.begin(), vehList.end(), [&bsm](cvStatusAware_t& obj){return(obj.bsm.id == bsm.id);});
-						if (it == vehList.end())
-						{ /// add BSM to vehList
-							cvStatusAware_t cvStatusAware;
-							cvStatusAware.reset();
-							cvStatusAware.msec = fullTimeStamp.msec;
-							cvStatusAware.bsm = bsm;
-							vehList.push_back(cvStatusAware);
-							bsm_vehId = bsm.id;
-						}
-						else if ((bsm.msgCnt > it->bsm.msgCnt) || (bsm.timeStampSec > it->bsm.timeStampSec))
-						{ /// this is an update BSM on vehList
-							it->msec = fullTimeStamp.msec;
-							it->bsm = bsm;
-							bsm_vehId = bsm.id;
-						}
-						if ((bsm_vehId > 0) && (log_type != logUtils::logType::none))
-							logUtils::logMsg(logFiles, std::string("payload"), recvbuf, (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
+				{ /// hand the BSM to the decode & map-matching stage
+					size_t payloadLen = std::min((size_t)udpHeader.length, (size_t)bytesReceived - offset);
+					BSM_header_t bsmHeader;
+					if (!AsnJ2735Lib::peek_bsm_header(&recvbuf[offset], payloadLen, bsmHeader))
+					{ /// shorter than the leading BSMcoreData fields: it cannot be decoded, and without TemporaryID
+						/// it has no shard, so it is dropped before it reaches the track state of any shard
+						OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+						OS_ERR << ", dropped BSM of " << payloadLen << " bytes, payload=";
+						logUtils::logMsgHex(OS_ERR, &recvbuf[offset], payloadLen);
 					}
 					else
 					{
-						OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-						OS_ERR << ", failed decode_bsm_payload, payload=";
-						logUtils::logMsgHex(OS_ERR, &recvbuf[offset], udpHeader.length);
-						OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-						OS_Display << ", failed decode_bsm_payload" << std::endl;
+						bsmJob_t* job;
+						while ((job = bsmPipeline.claim(bsmHeader.id)) == nullptr)
+						{ /// the shard is full, track the oldest BSM in flight to make room
+							trackBsm(*bsmPipeline.wait());
+							bsmPipeline.release();
+						}
+						job->msec = fullTimeStamp.msec;
+						job->msOfDay = fullTimeStamp.localDateTimeStamp.msOfDay;
+						job->datagram.assign(recvbuf.begin(), recvbuf.begin() + bytesReceived);
+						job->offset = offset;
+						job->length = payloadLen;
+						job->peeked = true;
+						job->header = bsmHeader;
+						bsmPipeline.publish();
 					}
+					drainBsms(false);
 				}
 				else if ((udpHeader.msgid == msgUtils::msgid_srm)
 					&& (awareStatus.cntrlState.signalStatus.mode != MsgEnum::controlMode::unavailable))
@@ -343,16 +521,19 @@ int main(int argc, char** argv)
 								srm.outApproachId = plocAwareLib->getApproachIdByLaneId(srm.intId, srm.outLaneId);
 							uint8_t requestedPhase = plocAwareLib->getControlPhaseByIds(intersectionId, srm.inApprochId, srm.inLaneId);
 							/// check whether it is an update SRM on srmList
-							auto it = std::find_if(srmList.begin(), srmList.end(), [&srm](srmStatus_t obj){return(obj.srm.vehId == srm.vehId);});
+							srmStatus_t* it = srmList.find(srm.vehId);
 							/// check whether the requesting vehicle has BSM on vehList
-							auto it_veh = std::find_if(vehList.begin(), vehList.end(), [&srm](cvStatusAware_t& obj){return(obj.bsm.id == srm.vehId);});
-							if (it_veh != vehList.end())
+							const cvStatusAware_t* it_veh = vehList.find(srm.vehId);
+							if (it_veh != nullptr)
 							{ /// the requesting vehicle should broadcast BSMs as well.
 								/// SRMs are not required to send at a constant rate rather than need-basis,
 								/// so BSMs from the requesting vehicles are used for locating vehicle on MAP.
-								if (it == srmList.end())
-								{ /// add SRM to srmList
-									srmStatus_t srmStatus;
+								if ((it == nullptr) && srmList.full())
+									listStats.srmDropped++;
+								else if (it == nullptr)
+								{ /// add SRM to srmList (SRM is dropped when srmList is full)
+									srmStatus_t& srmStatus = *(srmList.insert(srm.vehId));
+									srmExpiry.schedule(srmList.slotOf(&srmStatus), fullTimeStamp.msec + timeouInterval);
 									srmStatus.msec = fullTimeStamp.msec;
 									srmStatus.requestedPhase = requestedPhase;
 									srmStatus.srm = srm;
@@ -367,17 +548,17 @@ int main(int argc, char** argv)
 										srmStatus.status = MsgEnum::requestStatus::requested;
 									else
 										srmStatus.status = MsgEnum::requestStatus::rejected;
-									srmList.push_back(srmStatus);
 									awareStatus.requestStatusUpdated = true;
 								}
-								else if ((srm.msgCnt > it->srm.msgCnt) || (srm.timeStampSec > it->srm.timeStampSec))
+								else if ((it != nullptr) && ((srm.msgCnt > it->srm.msgCnt) || (srm.timeStampSec > it->srm.timeStampSec)))
 								{ /// this is an update SRM on srmList, it should maintain requestedPhase
 									it->msec = fullTimeStamp.msec;
 									it->srm = srm;
+									srmExpiry.schedule(srmList.slotOf(it), fullTimeStamp.msec + timeouInterval);
 									awareStatus.requestStatusUpdated = true;
 								}
 								if (log_type != logUtils::logType::none)
-									logUtils::logMsg(logFiles, std::string("payload"), recvbuf, (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
+									logger.log(payloadLog, &recvbuf[0], (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
 							}
 						}
 					}
@@ -416,12 +597,12 @@ int main(int argc, char** argv)
 										fullTimeStamp.localDateTimeStamp.msOfDay, msgUtils::msgid_softcall);
 									socketUtils::sendall(sendConn, &sendbuf[0], msgSize);
 									if (log_type != logUtils::logType::none)
-										logUtils::logMsg(logFiles, std::string("req"), sendbuf, msgSize);
+										logger.log(reqLog, &sendbuf[0], msgSize);
 									OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
 									OS_Display << ", sent pedestrian call on phase " << static_cast<unsigned int>(requestedPhase) << std::endl;
 								}
 								if (log_type != logUtils::logType::none)
-									logUtils::logMsg(logFiles, std::string("payload"), recvbuf, (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
+									logger.log(payloadLog, &recvbuf[0], (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
 							}
 							else
 							{
@@ -474,161 +655,53 @@ int main(int argc, char** argv)
 			}
 		}
 
-		if (bsm_vehId > 0)
-		{ /// received a new BSM, the vehicle has already been added to vehList
-			auto it = std::find_if(vehList.begin(), vehList.end(), [&bsm_vehId](cvStatusAware_t& obj){return(obj.bsm.id == bsm_vehId);});
-			const auto& bsm = it->bsm;
-			/// construct GeoUtils::connectedVehicle_t from the newly received BSM
-			GeoUtils::connectedVehicle_t cvIn;
-			cvIn.reset();
-			GeoUtils::geoRefPoint_t geoRef{bsm.latitude, bsm.longitude, bsm.elevation};
-			GeoUtils::geoRefPoint2geoPoint(geoRef, cvIn.geoPoint);
-			cvIn.id = bsm_vehId;
-			cvIn.msec = it->msec;
-			cvIn.motionState.speed = (double)bsm.speed * 0.02;
-			cvIn.motionState.heading = (double)bsm.heading * 0.0125;
-			bool first_bsm = (it->cvStatus.empty()) ? true : false;
-			if (first_bsm)
-				it->cvStatus.push_back(cvIn);
-			/// get the latest result of locating vehicle on MAP
-			auto cv = it->cvStatus.back();
-			/// determining whether or not to conduct locating vehicle on MAP
-			bool doMapping = (first_bsm) ? true : false;
-			if (!first_bsm)
-			{ /// get distance traveled from the last geoPoint
-				double distTravelled = GeoUtils::distlla2lla(cvIn.geoPoint, cv.geoPoint);
-				if ((cvIn.motionState.speed  >= stopSpeed) || (fabs(distTravelled) >= stopDist))
-					doMapping = true;
-			}
-			if (!doMapping)
-			{ /// keep the latest result of locating vehicle on MAP
-				cvIn.isVehicleInMap = cv.isVehicleInMap;
-				cvIn.vehicleTrackingState = cv.vehicleTrackingState;
-				cvIn.vehicleLocationAware = cv.vehicleLocationAware;
-			}
-			else
-			{ /// locate the vehicle on MAP
-				cv.geoPoint = cvIn.geoPoint;
-				cv.motionState = cvIn.motionState;
-				cvIn.isVehicleInMap = plocAwareLib->locateVehicleInMap(cv, cvIn.vehicleTrackingState);
-				/// update locationAware
-				plocAwareLib->updateLocationAware(cvIn.vehicleTrackingState, cvIn.vehicleLocationAware);
-			}
-			/// update signalAware
-			cvIn.vehicleSignalAware.reset();
-			if (cvIn.isVehicleInMap
-				&& (cvIn.vehicleTrackingState.intsectionTrackingState.intersectionIndex == intersectionIndex)
-				&& (cvIn.vehicleLocationAware.controlPhase > 0)
-				&& (awareStatus.cntrlState.signalStatus.mode != MsgEnum::controlMode::unavailable))
-			{
-				const auto& phaseState = awareStatus.cntrlState.spatRaw.phaseState[cvIn.vehicleLocationAware.controlPhase - 1];
-				cvIn.vehicleSignalAware.currState = phaseState.currState;
-				cvIn.vehicleSignalAware.startTime = phaseState.startTime;
-				cvIn.vehicleSignalAware.minEndTime = phaseState.minEndTime;
-				cvIn.vehicleSignalAware.maxEndTime = phaseState.maxEndTime;
-			}
+		/// keep processing pending datagrams before running the control logic
+		if (received)
+		{
+			drainCnt++;
+			continue;
+		}
+		/// track the BSMs still in the decode & map-matching stage
+		drainBsms(true);
+		/// fd_Listen was not drained when maxDrainCnt stopped receiving, do not sleep on it (messages in an
+		/// SHM ring do not make fd_Listen readable until the ring is drained and armed)
+		bool moreDatagrams = (drainCnt >= maxDrainCnt);
+		drainCnt = 0;
+		timeUtils::getFullTimeStamp(fullTimeStamp);
 
-			/// update cvStatusAware with the current mapping result
-			if (it->isOnInbound)
-			{	/// the vehicle was onInbound of this intersection, possible current vehicleIntersectionStatus:
-				/// case 1: the vehicle remains on the same inbound approach or moved inside intersection box
-				if (cvIn.isVehicleInMap
-					&& (cvIn.vehicleTrackingState.intsectionTrackingState.intersectionIndex == intersectionIndex)
-					&& ((cvIn.vehicleTrackingState.intsectionTrackingState.vehicleIntersectionStatus == MsgEnum::mapLocType::onInbound)
-						|| (cvIn.vehicleTrackingState.intsectionTrackingState.vehicleIntersectionStatus == MsgEnum::mapLocType::atIntersectionBox))
-					&& (cvIn.vehicleTrackingState.intsectionTrackingState.approachIndex == cv.vehicleTrackingState.intsectionTrackingState.approachIndex))
-				{ /// add tracked point to cvStatusAware::cvStatus
-					if (doMapping)
-						it->cvStatus.push_back(cvIn);
-				}
-				/// case 2: the vehicle moved to outbound approach of this intersection
-				else if (cvIn.isVehicleInMap
-					&& (cvIn.vehicleTrackingState.intsectionTrackingState.intersectionIndex == intersectionIndex)
-					&& (cvIn.vehicleTrackingState.intsectionTrackingState.vehicleIntersectionStatus == MsgEnum::mapLocType::onOutbound))
-				{
-					if (it->cvStatus.size() >= 10)
-					{ /// send msgid_traj message to MRP_dataMgr
-						uint32_t laneLen = plocAwareLib->getLaneLength(intersectionId, it->cvStatus[0].vehicleLocationAware.laneId);
-						size_t msgSize = packMsg(sendbuf, *it, fullTimeStamp.localDateTimeStamp.dateStamp,
-							fullTimeStamp.localDateTimeStamp.msOfDay,	laneLen, stopSpeed, msgUtils::msgid_traj);
-						socketUtils::sendall(sendConn, &sendbuf[0], msgSize);
-						if (log_type != logUtils::logType::none)
-							logUtils::logMsg(logFiles, std::string("traj"), sendbuf, msgSize);
-					}
-					/// reset cvStatusAware
-					it->reset();
-					it->cvStatus.push_back(cvIn);
-					OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-					OS_Display << " vehicle " << cvIn.id << " entered outbound lane ";
-					OS_Display << static_cast<unsigned int>(cvIn.vehicleLocationAware.laneId) << std::endl;
-				}
-				/// case 3: the vehicle changed intersection
-				else if (cvIn.isVehicleInMap
-					&& (cvIn.vehicleTrackingState.intsectionTrackingState.intersectionIndex != intersectionIndex))
-				{
-					if (it->cvStatus.size() >= 10)
-					{ /// send msgid_traj message to MRP_dataMgr
-						uint32_t laneLen = plocAwareLib->getLaneLength(intersectionId, it->cvStatus[0].vehicleLocationAware.laneId);
-						size_t msgSize = packMsg(sendbuf, *it, fullTimeStamp.localDateTimeStamp.dateStamp,
-							fullTimeStamp.localDateTimeStamp.msOfDay,	laneLen, stopSpeed, msgUtils::msgid_traj);
-						socketUtils::sendall(sendConn, &sendbuf[0], msgSize);
-						if (log_type != logUtils::logType::none)
-							logUtils::logMsg(logFiles, std::string("traj"), sendbuf, msgSize);
-					}
-					/// reset cvStatusAware
-					it->reset();
-					it->cvStatus.push_back(cvIn);
-					OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-					OS_Display << " vehicle " << cvIn.id << " entered intersection ";
-					OS_Display << plocAwareLib->getIntersectionNameByIndex(cvIn.vehicleTrackingState.intsectionTrackingState.intersectionIndex);
-					OS_Display << " on lane " << static_cast<unsigned int>(cvIn.vehicleLocationAware.laneId);
-					OS_Display << ", phase " << static_cast<unsigned int>(cvIn.vehicleLocationAware.controlPhase) << std::endl;
-				}
-				/// case 4: the vehicle moved outside of the MAP area
-				else if (!cvIn.isVehicleInMap)
-				{
-					if (it->cvStatus.size() >= 10)
-					{ /// send msgid_traj message to MRP_dataMgr
-						uint32_t laneLen = plocAwareLib->getLaneLength(intersectionId, it->cvStatus[0].vehicleLocationAware.laneId);
-						size_t msgSize = packMsg(sendbuf, *it, fullTimeStamp.localDateTimeStamp.dateStamp,
-							fullTimeStamp.localDateTimeStamp.msOfDay,	laneLen, stopSpeed, msgUtils::msgid_traj);
-						socketUtils::sendall(sendConn, &sendbuf[0], msgSize);
-						if (log_type != logUtils::logType::none)
-							logUtils::logMsg(logFiles, std::string("traj"), sendbuf, msgSize);
-					}
-					/// reset cvStatusAware
-					it->reset();
-					it->cvStatus.push_back(cvIn);
-					OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-					OS_Display << " vehicle " << cvIn.id << " left MAP area" << std::endl;
-				}
-			}
-			/// the vehicle was not on any inbound approach and now entered on an inbound approach of this intersection
-			else if (cvIn.isVehicleInMap
-				&& (cvIn.vehicleTrackingState.intsectionTrackingState.intersectionIndex == intersectionIndex)
-				&& (cvIn.vehicleTrackingState.intsectionTrackingState.vehicleIntersectionStatus == MsgEnum::mapLocType::onInbound))
-			{	/// this is the first record of vehicle onInbound at this intersection
-				it->isOnInbound = true;
-				it->cvStatus[0] = cvIn;
-				OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-				OS_Display << " vehicle " << cvIn.id << " entered inbound lane ";
-				OS_Display << static_cast<unsigned int>(cvIn.vehicleLocationAware.laneId) << ", phase ";
-				OS_Display << static_cast<unsigned int>(cvIn.vehicleLocationAware.controlPhase) << ", dist2go ";
-				OS_Display << cvIn.vehicleLocationAware.dist2go.distLong << std::endl;
-			}
-			///  the vehicle neither was nor currently on any inbound approach of this intersection
-			else if (doMapping)
-				it->cvStatus[0] = cvIn;
+		/// log footprint of vehList & srmList
+		if (reactor.expired(listStatsTimer))
+		{
+			OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+			OS_Display << ", vehList " << vehList.size() << "/" << vehList.capacity();
+			OS_Display << " (evicted " << listStats.vehEvicted << ", dropped " << listStats.vehDropped << ")";
+			OS_Display << ", srmList " << srmList.size() << "/" << srmList.capacity();
+			OS_Display << " (evicted " << listStats.srmEvicted << ", dropped " << listStats.srmDropped << ")";
+			OS_Display << ", BSM filtered (duplicate " << listStats.bsmDuplicate << ", far away " << listStats.bsmFarAway << ")";
+			OS_Display << ", SSM encoded " << ssmSlot.getStats().encodes << ", sent " << ssmSlot.getStats().sends;
+			OS_Display << " (reused " << ssmSlot.getStats().reuses << ")" << std::endl;
+		}
+
+		/// check reopen log files
+		if (reactor.expired(logTimer))
+			logger.reopen(fullTimeStamp.localDateTimeStamp.to_fileName());
+
+		/// check reopen display log file
+		if (reactor.expired(displayTimer))
+		{
+			OS_Display.close();
+			OS_Display.open(displayLog);
 		}
 
 		/// wait until started receiving msgid_cntrlstatus messages (controller and signal status)
 		if (awareStatus.cntrlState.signalStatus.mode == MsgEnum::controlMode::unavailable)
 		{
-			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			reactor.expired(controlTimer);
+			if (!moreDatagrams)
+				reactor.wait();
 			continue;
 		}
 
-		timeUtils::getFullTimeStamp(fullTimeStamp);
 		const auto& spat = awareStatus.cntrlState.spatRaw;
 		const auto& signalStatus = awareStatus.cntrlState.signalStatus;
 		auto& prioServingStatus = awareStatus.prioServingStatus;
@@ -643,28 +716,31 @@ int main(int argc, char** argv)
 			bool phaseInGreen = ((phaseState.currState == MsgEnum::phaseState::permissiveGreen)
 				|| (phaseState.currState == MsgEnum::phaseState::protectedGreen));
 			/// find grantVehicle on vehList
-			auto it = std::find_if(vehList.begin(), vehList.end(), [&grantingVehId](cvStatusAware_t& obj){return(obj.bsm.id == grantingVehId);});
+			const cvStatusAware_t* it = vehList.find(grantingVehId);
 			/// find grantVehicle on srmList
-			auto it_srm = std::find_if(srmList.begin(), srmList.end(), [&grantingVehId](srmStatus_t& obj){return(obj.srm.vehId == grantingVehId);});
+			const srmStatus_t* it_srm = srmList.find(grantingVehId);
 			/// 1. cancel earlyGreen if grantingPhase turned green
 			/// 2. cancel greenExtension if green on grantingPhase expired
 			/// 3. cancel priority if grantVehicle has passed the intersection (not onInbound)
 			/// 4. cancel priority if grantVehicle sent cancel SRM
 			if (((grantingType == prioGrantType::earlyGreen) && phaseInGreen)
 				|| ((grantingType == prioGrantType::greenExtension) && !phaseInGreen)
-				|| ((it == vehList.end()) || !it->isOnInbound)
-				|| ((it_srm != srmList.end()) && (it_srm->srm.reqType == MsgEnum::requestType::priorityCancellation)))
+				|| ((it == nullptr) || !it->isOnInbound)
+				|| ((it_srm != nullptr) && (it_srm->srm.reqType == MsgEnum::requestType::priorityCancellation)))
 			{ /// reset grantingType
 				grantingType = prioGrantType::none;
 				/// remove grantVehicle from srmList
-				if (it_srm != srmList.end())
-					it_srm = srmList.erase(it_srm);
+				if (it_srm != nullptr)
+				{
+					srmExpiry.cancel(srmList.slotOf(it_srm));
+					srmList.erase(grantingVehId);
+				}
 				/// send Cancel priority request to MRP_DataMgr
 				size_t msgSize = packMsg(sendbuf, grantingPhase, MsgEnum::softCallObj::priority, MsgEnum::softCallType::cancel,
 					fullTimeStamp.localDateTimeStamp.msOfDay, msgUtils::msgid_softcall);
 				socketUtils::sendall(sendConn, &sendbuf[0], msgSize);
 				if (log_type != logUtils::logType::none)
-					logUtils::logMsg(logFiles, std::string("req"), sendbuf, msgSize);
+					logger.log(reqLog, &sendbuf[0], msgSize);
 				OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
 				OS_Display << ", cancel priority on phase " << static_cast<unsigned int>(grantingPhase) << std::endl;
 			}
@@ -693,11 +769,11 @@ int main(int argc, char** argv)
 					awareStatus.requestStatusUpdated = true;
 				}
 				/// find the vehicle on vehList, and check whether it is onInbound
-				auto it = std::find_if(vehList.begin(), vehList.end(), [&srm](cvStatusAware_t& obj){return(obj.bsm.id == srm.vehId);});
-				if (it == vehList.end() || !it->isOnInbound)
+				const cvStatusAware_t* it = vehList.find(srm.vehId);
+				if ((it == nullptr) || !it->isOnInbound)
 					continue;
 				/// get the latest result of locating vehicle on MAP
-				const auto& cv = it->cvStatus.back();
+				const auto& cv = it->cvStatus;
 				/// estimate time-to-arrival at the stop-bar (tenths of a second in the current or next hour)
 				uint16_t time2go = getTime2Go(cv.vehicleLocationAware.dist2go.distLong, cv.motionState.speed, stopSpeed);
 				uint16_t time2arrival = (uint16_t)((fullTimeStamp.msec / 100 + time2go) % 36000);
@@ -764,7 +840,7 @@ int main(int argc, char** argv)
 					fullTimeStamp.localDateTimeStamp.msOfDay, msgUtils::msgid_softcall);
 				socketUtils::sendall(sendConn, &sendbuf[0], msgSize);
 				if (log_type != logUtils::logType::none)
-					logUtils::logMsg(logFiles, std::string("req"), sendbuf, msgSize);
+					logger.log(reqLog, &sendbuf[0], msgSize);
 				OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
 				if (grantingType == prioGrantType::greenExtension)
 					OS_Display << ", call greenExtension on phase ";
@@ -784,7 +860,7 @@ int main(int argc, char** argv)
 		{ /// loop through all BSMs to get every vehicular phase that should be called
 			if (cv.isOnInbound && !cv.isPhaseCalled)
 			{ /// get the latest result of locating vehicle on MAP
-				const auto& cvStatus = cv.cvStatus.back();
+				const auto& cvStatus = cv.cvStatus;
 				uint16_t time2go = getTime2Go(cvStatus.vehicleLocationAware.dist2go.distLong, cvStatus.motionState.speed, stopSpeed);
 				uint8_t controlPhase = (uint8_t)(cvStatus.vehicleLocationAware.controlPhase - 1);
 				bool phaseInGreen = ((cvStatus.vehicleSignalAware.currState == MsgEnum::phaseState::permissiveGreen)
@@ -808,7 +884,7 @@ int main(int argc, char** argv)
 				fullTimeStamp.localDateTimeStamp.msOfDay, msgUtils::msgid_softcall);
 			socketUtils::sendall(sendConn, &sendbuf[0], msgSize);
 			if (log_type != logUtils::logType::none)
-				logUtils::logMsg(logFiles, std::string("req"), sendbuf, msgSize);
+				logger.log(reqLog, &sendbuf[0], msgSize);
 			OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
 			OS_Display << ", call vehicle phases " << phases2call.to_string() << std::endl;
 			phases2call.reset();
@@ -832,8 +908,8 @@ int main(int argc, char** argv)
 			{	/// remove vehicle from servingVehIds if the vehicle is no long onInbound
 				auto& servingVehIds = phaseExtStatus.servingVehIds;
 				servingVehIds.erase(std::remove_if(servingVehIds.begin(), servingVehIds.end(), [&vehList](uint32_t& vehId)->bool
-					{	auto it = std::find_if(vehList.begin(), vehList.end(), [&vehId](cvStatusAware_t& obj){return(obj.bsm.id == vehId);});
-						return((it == vehList.end()) || !it->isOnInbound);}), servingVehIds.end());
+					{	const cvStatusAware_t* it = vehList.find(vehId);
+						return((it == nullptr) || !it->isOnInbound);}), servingVehIds.end());
 				if (phaseInGreen  && servingVehIds.empty())
 				{
 					phases2call.set(i);
@@ -847,7 +923,7 @@ int main(int argc, char** argv)
 				fullTimeStamp.localDateTimeStamp.msOfDay, msgUtils::msgid_softcall);
 			socketUtils::sendall(sendConn, &sendbuf[0], msgSize);
 			if (log_type != logUtils::logType::none)
-				logUtils::logMsg(logFiles, std::string("req"), sendbuf, msgSize);
+				logger.log(reqLog, &sendbuf[0], msgSize);
 			OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
 			OS_Display << ", cancel vehicle extension on phases " << phases2call.to_string() << std::endl;
 			phases2call.reset();
@@ -867,7 +943,7 @@ int main(int argc, char** argv)
 			{ /// loop through all BSMs to get every vehicular phase that could be extended
 				if (cv.isOnInbound && !cv.isExtensionCalled)
 				{ /// get the latest result of locating vehicle on MAP
-					const auto& cvStatus = cv.cvStatus.back();
+					const auto& cvStatus = cv.cvStatus;
 					uint16_t time2go = getTime2Go(cvStatus.vehicleLocationAware.dist2go.distLong, cvStatus.motionState.speed, stopSpeed);
 					uint16_t time2arrival = (uint16_t)((fullTimeStamp.msec / 100 + time2go) % 36000);
 					uint16_t curr_time = (uint16_t)(fullTimeStamp.msec / 100 % 36000);
@@ -900,59 +976,65 @@ int main(int argc, char** argv)
 				fullTimeStamp.localDateTimeStamp.msOfDay, msgUtils::msgid_softcall);
 			socketUtils::sendall(sendConn, &sendbuf[0], msgSize);
 			if (log_type != logUtils::logType::none)
-				logUtils::logMsg(logFiles, std::string("req"), sendbuf, msgSize);
+				logger.log(reqLog, &sendbuf[0], msgSize);
 			OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
 			OS_Display << ", call non-TSP extension on phases " << phases2call.to_string() << std::endl;
 			phases2call.reset();
 		}
 
 		/// check whether need to send SSM
-		if ((fullTimeStamp.msec > sentSSM_msec +  MsgEnum::ssmInterval) && !srmList.empty())
-		{	/// pack new SSM only when priority list got updated
-			if (awareStatus.requestStatusUpdated)
+		unsigned long long now_msec = eventUtils::Reactor::now();
+		if (!srmList.empty())
+		{	/// pack new SSM only when priority list got updated and the pacing allows sending it
+			if (awareStatus.requestStatusUpdated && ssmSlot.due(now_msec, ssmVersion + 1))
+			{
 				packMsg(ssm, srmList, fullTimeStamp.utcDateTimeStamp);
-			/// reset update flag
-			awareStatus.requestStatusUpdated = false;
-			sentSSM_msec = fullTimeStamp.msec;
-			/// encode SSM
-			ssize_t payload_size = AsnJ2735Lib::encode_ssm_payload(ssm, &sendbuf[9], bufSize);
-			if (payload_size > 0)
-			{ /// add MMITSS header and send to MRP_DataMgr
-				size_t offset = 0;
-				msgUtils::packHeader(sendbuf, offset, msgUtils::msgid_ssm, fullTimeStamp.localDateTimeStamp.msOfDay, (uint16_t)payload_size);
-				socketUtils::sendall(sendConn, &sendbuf[0], (size_t)payload_size + offset);
-				if (log_type == logUtils::logType::detailLog)
-					logUtils::logMsg(logFiles, std::string("payload"), sendbuf, (size_t)payload_size + offset);
+				ssmVersion++;
+				/// reset update flag
+				awareStatus.requestStatusUpdated = false;
 			}
-			else
-			{
-				OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-				OS_ERR << ", failed encode_spat_payload" << std::endl;
+			if ((ssmVersion > 0) && ssmSlot.due(now_msec, ssmVersion))
+			{	/// encode SSM only when it is not cached, otherwise re-broadcast the cached payload
+				if (ssmSlot.stale(ssmVersion))
+				{
+					size_t payload_size = AsnJ2735Lib::encode_ssm_payload(ssm, ssmSlot.payload(), ssmSlot.capacity());
+					if (payload_size > 0)
+						ssmSlot.store(payload_size, ssmVersion);
+					else
+					{
+						ssmSlot.drop(ssmVersion);
+						OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+						OS_ERR << ", failed encode_ssm_payload" << std::endl;
+					}
+				}
+				if (ssmSlot.size() > 0)
+				{ /// add MMITSS header and send to MRP_DataMgr
+					std::vector<uint8_t>& ssmbuf = ssmSlot.buf();
+					size_t offset = 0;
+					msgUtils::packHeader(ssmbuf, offset, msgUtils::msgid_ssm, fullTimeStamp.localDateTimeStamp.msOfDay, (uint16_t)ssmSlot.size());
+					socketUtils::sendall(sendConn, &ssmbuf[0], ssmSlot.size() + offset);
+					ssmSlot.sent(now_msec);
+					if (log_type == logUtils::logType::detailLog)
+						logger.log(payloadLog, &ssmbuf[0], ssmSlot.size() + offset);
+				}
 			}
 		}
 
-		/// remove outdated entries from vehList & srmList
-		vehList.erase(std::remove_if(vehList.begin(), vehList.end(), [&fullTimeStamp, &timeouInterval](cvStatusAware_t& obj)
-			{return(obj.msec > fullTimeStamp.msec + timeouInterval);}), vehList.end());
-		srmList.erase(std::remove_if(srmList.begin(), srmList.end(), [&fullTimeStamp, &timeouInterval](srmStatus_t& obj)
-			{return(obj.msec > fullTimeStamp.msec + timeouInterval);}), srmList.end());
-
-		/// check reopen log files
-		if ((log_type != logUtils::logType::none) && (fullTimeStamp.msec > logfile_msec + logInterval))
-		{
-			logUtils::reOpenLogFiles(logFiles, fullTimeStamp.localDateTimeStamp.to_fileName());
-			logfile_msec = fullTimeStamp.msec;
-		}
-
-		/// check reopen display log file
-		if (fullTimeStamp.msec > displayfile_msec + displayLogInterval)
-		{
-			OS_Display.close();
-			OS_Display.open(displayLog);
-			displayfile_msec = fullTimeStamp.msec;
+		/// remove outdated entries from vehList & srmList (only buckets of elapsed ticks are visited)
+		listStats.vehEvicted += vehExpiry.expire(fullTimeStamp.msec, [&vehList](uint32_t slot)
+			{vehList.erase(vehList.keyOf(slot));});
+		size_t srmEvicted = srmExpiry.expire(fullTimeStamp.msec, [&srmList](uint32_t slot)
+			{srmList.erase(srmList.keyOf(slot));});
+		if (srmEvicted > 0)
+		{	/// re-pack SSM so that the cached one does not keep broadcasting the expired requests
+			awareStatus.requestStatusUpdated = true;
+			listStats.srmEvicted += srmEvicted;
 		}
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		/// wait for the next datagram or timer
+		reactor.expired(controlTimer);
+		if (!moreDatagrams)
+			reactor.wait();
 	}
 	/// exit
 	timeUtils::getFullTimeStamp(fullTimeStamp);
@@ -960,10 +1042,11 @@ int main(int argc, char** argv)
 	OS_ERR << ", received user termination signal " << terminate << ", exit!" << std::endl;
 	OS_Display << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
 	OS_Display << ", received user termination signal " << terminate << ", exit!" << std::endl;
+	if (logger.dropped() > 0)
+		OS_ERR << "\tdropped " << logger.dropped() << " log records on a full log ring" << std::endl;
 	OS_ERR.close();
 	OS_Display.close();
-	if (log_type != logUtils::logType::none)
-		logUtils::closeLogFiles(logFiles);
+	logger.close();
 	pmycnf->disconnectAll();
 	delete pmycnf;
 	delete plocAwareLib;
@@ -985,7 +1068,7 @@ size_t packMsg(std::vector<uint8_t>& buf, std::bitset<8> callPhases, MsgEnum::so
 }
 
 size_t packMsg(std::vector<uint8_t>& buf, const cvStatusAware_t& cvStatusAware, const timeUtils::dateStamp_t& curDateStamp,
-	uint32_t msOfDay, uint32_t laneLen, double stopSpeed, uint8_t msgid)
+	uint32_t msOfDay, uint32_t laneLen, uint8_t msgid)
 {
 	static uint32_t trojCnt = 0;
 	static timeUtils::dateStamp_t dateStamp{0, 0, 0};
@@ -997,24 +1080,22 @@ size_t packMsg(std::vector<uint8_t>& buf, const cvStatusAware_t& cvStatusAware,
 	trojCnt++;
 	msgDefs::vehTraj_t vehTraj;
 	const auto& cvStatus = cvStatusAware.cvStatus;
+	const auto& traj = cvStatusAware.traj;
 	vehTraj.ms_since_midnight = msOfDay;
 	vehTraj.count = trojCnt;
-	vehTraj.vehId = cvStatus[0].id;
-	vehTraj.entryLaneId = cvStatus[0].vehicleLocationAware.laneId;
-	vehTraj.entryControlPhase = cvStatus[0].vehicleLocationAware.controlPhase;
-	vehTraj.leaveLaneId = cvStatus.back().vehicleLocationAware.laneId;
-	vehTraj.leaveControlPhase = cvStatus.back().vehicleLocationAware.controlPhase;
-	vehTraj.distTraveled = static_cast<uint16_t>((cvStatus[0].vehicleLocationAware.dist2go.distLong
-		- cvStatus.back().vehicleLocationAware.dist2go.distLong) * 10);
-	vehTraj.timeTraveled = static_cast<uint16_t>((cvStatus.back().msec - cvStatus[0].msec) / 100);
-	size_t stoppedCnt = std::count_if(cvStatus.begin(), cvStatus.end(), [&stopSpeed](const GeoUtils::connectedVehicle_t& item)
-		{return(item.motionState.speed <= stopSpeed);});
-	vehTraj.stoppedTime = static_cast<uint16_t>(stoppedCnt);
+	vehTraj.vehId = cvStatus.id;
+	vehTraj.entryLaneId = traj.entryLaneId;
+	vehTraj.entryControlPhase = traj.entryControlPhase;
+	vehTraj.leaveLaneId = cvStatus.vehicleLocationAware.laneId;
+	vehTraj.leaveControlPhase = cvStatus.vehicleLocationAware.controlPhase;
+	vehTraj.distTraveled = static_cast<uint16_t>((traj.entryDist2go - cvStatus.vehicleLocationAware.dist2go.distLong) * 10);
+	vehTraj.timeTraveled = static_cast<uint16_t>((cvStatus.msec - traj.entry_msec) / 100);
+	vehTraj.stoppedTime = traj.stoppedCnt;
 	vehTraj.inboundLaneLen = static_cast<uint16_t>(laneLen / 10);
 	return(msgDefs::packMsg(buf, vehTraj, msgid));
 }
 
-void packMsg(SSM_element_t& ssm, const std::vector<srmStatus_t> list, const timeUtils::dateTimeStamp_t utcDateTimeStamp)
+void packMsg(SSM_element_t& ssm, const tableUtils::KeyedTable<srmStatus_t>& list, const timeUtils::dateTimeStamp_t utcDateTimeStamp)
 {
 	static uint8_t msgCnt = 0;
 	static uint8_t updateCnt = 0;
@@ -1103,12 +1184,12 @@ size_t getCandidateIndex(const std::vector<prioRequestCadidate_t>& candidates)
 	return(retn);
 }
 
-void setGrantStatus(std::vector<srmStatus_t>& list, const std::vector<prioRequestCadidate_t>& candidates)
+void setGrantStatus(tableUtils::KeyedTable<srmStatus_t>& list, const std::vector<prioRequestCadidate_t>& candidates)
 {
 	for (const auto& item : candidates)
 	{
-		auto it = std::find_if(list.begin(), list.end(), [&item](srmStatus_t obj){return(obj.srm.vehId == item.vehId);});
-		if (it != list.end())
+		srmStatus_t* it = list.find(item.vehId);
+		if (it != nullptr)
 			it->status = MsgEnum::requestStatus::granted;
 	}
 }
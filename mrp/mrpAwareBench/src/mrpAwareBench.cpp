@@ -0,0 +1,808 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+/* mrpAwareBench.cpp
+ * benchmarks of the MRP_Aware data paths, run offline:
+ *   vehlist - per-BSM cost of looking up a vehicle on vehList (two lookups per BSM, as the receive and
+ *             locate path does), std::vector with std::find_if against tableUtils::KeyedTable, and the
+ *             cost of replacing a vehicle in the KeyedTable (erase and insert).
+ *   pipeline - BSM rate and latency of the decode & map-matching stage (BsmPipeline) with 0 to 4 worker
+ *             threads, on vehicles driving the inbound lanes of the nmap intersection with the most of them.
+ *             The per-BSM results have to be identical for every worker count.
+ *   traj     - bytes per vehicle, heap allocations and ns per BSM of the trajectory history kept on vehList,
+ *             the fixed-size cvStatusAware_t (last tracked point and trajHistory_t) against the earlier
+ *             vector of tracked points, on queued vehicles on the inbound lanes of the nmap intersection.
+ *             The msgid_traj content of the two has to be identical.
+ *   dup      - ns per BSM and drop counters of BsmPipeline with duplicate BSMs (heard twice) and vehicles away
+ *             from all intersections, dropping them from the peeked BSM header against decoding every BSM.
+ *             The BSMs located on the MAP have to be the same.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "AsnJ2735Lib.h"
+#include "bsmPipeline.h"
+#include "mrpAware.h"
+#include "msgUtils.h"
+
+/// count heap allocations of the whole process by interposing on glibc malloc (workers of pipeline allocate too)
+static std::atomic<unsigned long long> allocCnt(0);
+
+extern "C"
+{
+	void* __libc_malloc(size_t size);
+	void* __libc_calloc(size_t nmemb, size_t size);
+	void* __libc_realloc(void* ptr, size_t size);
+
+	void* malloc(size_t size) throw()
+	{
+		allocCnt.fetch_add(1, std::memory_order_relaxed);
+		return(__libc_malloc(size));
+	}
+	void* calloc(size_t nmemb, size_t size) throw()
+	{
+		allocCnt.fetch_add(1, std::memory_order_relaxed);
+		return(__libc_calloc(nmemb, size));
+	}
+	void* realloc(void* ptr, size_t size) throw()
+	{
+		allocCnt.fetch_add(1, std::memory_order_relaxed);
+		return(__libc_realloc(ptr, size));
+	}
+}
+
+void do_usage(const char* progname)
+{
+	std::cerr << "Usage " << progname << " [options] <benchmark> [nmap file]" << std::endl;
+	std::cerr << "\t-n number of iterations (default 200000)" << std::endl;
+	std::cerr << "\t-? print this message" << std::endl;
+	std::cerr << "benchmarks:" << std::endl;
+	std::cerr << "\tvehlist  vehList lookup, std::vector against KeyedTable, 10 to 5000 vehicles" << std::endl;
+	std::cerr << "\tpipeline BsmPipeline with 0 to 4 workers, 200 vehicles on the nmap file, -n BSMs" << std::endl;
+	std::cerr << "\tdup      BsmPipeline drops with 0 to 100% duplicate and 0 or 50% far-away BSMs, 300 vehicles, -n BSMs" << std::endl;
+	std::cerr << "\ttraj     trajectory history, fixed-size against vector, 200 queued vehicles on the nmap file, -n BSMs" << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+static double nsSince(const std::chrono::steady_clock::time_point& t0)
+	{return((double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());}
+
+static bool benchVehList(size_t iterations)
+{
+	std::mt19937 rng(1);
+	std::cout << std::setw(10) << "vehicles" << std::setw(18) << "vector find_if" << std::setw(14) << "KeyedTable";
+	std::cout << std::setw(16) << "erase+insert" << "  (ns)" << std::endl;
+	for (size_t vehNums : {10, 100, 500, 1000, 2000, 5000})
+	{
+		std::vector<uint32_t> ids(vehNums);
+		for (auto& id : ids)
+			id = (uint32_t)rng();
+		std::vector<cvStatusAware_t> vehVec(vehNums);
+		tableUtils::KeyedTable<cvStatusAware_t> vehTable(std::max(vehNums, defaultMaxVehicles));
+		for (size_t i = 0; i < vehNums; i++)
+		{
+			vehVec[i].reset();
+			vehVec[i].msec = 0;
+			vehVec[i].bsm.id = ids[i];
+			cvStatusAware_t* p = vehTable.insert(ids[i]);
+			p->reset();
+			p->msec = 0;
+			p->bsm.id = ids[i];
+		}
+		std::vector<uint32_t> queries(iterations);
+		for (auto& id : queries)
+			id = ids[rng() % vehNums];
+		/// both lookups count the same BSMs, so the sums of the two must agree
+		unsigned long long vecSum = 0;
+		unsigned long long tableSum = 0;
+		auto t0 = std::chrono::steady_clock::now();
+		for (const auto& id : queries)
+		{
+			auto it = std::find_if(vehVec.begin(), vehVec.end(), [&id](const cvStatusAware_t& obj){return(obj.bsm.id == id);});
+			it->msec++;
+			it = std::find_if(vehVec.begin(), vehVec.end(), [&id](const cvStatusAware_t& obj){return(obj.bsm.id == id);});
+			vecSum += it->msec;
+		}
+		double vecNs = nsSince(t0);
+		t0 = std::chrono::steady_clock::now();
+		for (const auto& id : queries)
+		{
+			cvStatusAware_t* p = vehTable.find(id);
+			p->msec++;
+			p = vehTable.find(id);
+			tableSum += p->msec;
+		}
+		double tableNs = nsSince(t0);
+		t0 = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; i++)
+		{
+			uint32_t& id = ids[rng() % vehNums];
+			vehTable.erase(id);
+			id = (uint32_t)rng();
+			vehTable.insert(id)->bsm.id = id;
+		}
+		double churnNs = nsSince(t0);
+		if (vecSum != tableSum)
+		{
+			std::cerr << "KeyedTable lookups differ from std::vector lookups with " << vehNums << " vehicles" << std::endl;
+			return(false);
+		}
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << std::setw(10) << vehNums << std::setw(18) << vecNs / (double)iterations;
+		std::cout << std::setw(14) << tableNs / (double)iterations << std::setw(16) << churnNs / (double)iterations << std::endl;
+	}
+	return(true);
+}
+
+/// result of a BSM taken from the pipeline
+struct bsmResult_t
+{
+	bsmJob_t::result status;
+	bool doMapping;
+	bool isVehicleInMap;
+	GeoUtils::vehicleTracking_t vehicleTrackingState;
+};
+
+static bool isSameResult(const bsmResult_t& r1, const bsmResult_t& r2)
+{
+	if ((r1.status != r2.status) || (r1.doMapping != r2.doMapping) || (r1.isVehicleInMap != r2.isVehicleInMap))
+		return(false);
+	if (!r1.isVehicleInMap)
+		return(true);
+	const GeoUtils::vehicleTracking_t& s1 = r1.vehicleTrackingState;
+	const GeoUtils::vehicleTracking_t& s2 = r2.vehicleTrackingState;
+	return((s1.intsectionTrackingState == s2.intsectionTrackingState)
+		&& (s1.laneProj.nodeIndex == s2.laneProj.nodeIndex)
+		&& (s1.laneProj.proj2segment.t == s2.laneProj.proj2segment.t)
+		&& (s1.laneProj.proj2segment.d == s2.laneProj.proj2segment.d));
+}
+
+/// LocAware of the nmap file and the inbound traffic lanes of the intersection with the most of them, nodes
+/// in centimeters east and north of its reference point, starting at the stop-bar
+struct testMap_t
+{
+	LocAware* plocAware;
+	uint8_t intersectionIndex;
+	GeoUtils::geoRefPoint_t ref;
+	std::vector< std::vector<GeoUtils::point2D_t> > lanes;
+};
+
+static bool getTestMap(LocAware& locAware, const std::string& fnmap, testMap_t& testMap)
+{
+	if (!locAware.isInitiated())
+	{
+		std::cerr << "Failed initiating LocAware with " << fnmap << std::endl;
+		return(false);
+	}
+	testMap.plocAware = &locAware;
+	testMap.intersectionIndex = 0;
+	testMap.lanes.clear();
+	for (const auto& intersectionId : locAware.getIntersectionIds())
+	{
+		std::vector<uint8_t> mapPayload = locAware.getMapdataPayload(intersectionId);
+		MapData_element_t mapData;
+		if (mapPayload.empty() || (AsnJ2735Lib::decode_mapdata_payload(&mapPayload[0], mapPayload.size(), mapData) == 0))
+		{
+			std::cerr << "Failed decode_mapdata_payload for intersection " << intersectionId << std::endl;
+			return(false);
+		}
+		std::vector< std::vector<GeoUtils::point2D_t> > inboundLanes;
+		for (const auto& approach : mapData.mpApproaches)
+		{
+			if (approach.type != MsgEnum::approachType::inbound)
+				continue;
+			for (const auto& lane : approach.mpLanes)
+			{
+				std::vector<GeoUtils::point2D_t> nodes;
+				GeoUtils::point2D_t pt{0, 0};
+				for (const auto& node : lane.mpNodes)
+				{ // node offsets are from the previous node, the first one from the reference point
+					pt.x += node.offset_x;
+					pt.y += node.offset_y;
+					nodes.push_back(pt);
+				}
+				if (nodes.size() > 1)
+					inboundLanes.push_back(nodes);
+			}
+		}
+		if (inboundLanes.size() > testMap.lanes.size())
+		{
+			testMap.intersectionIndex = locAware.getIndexByIntersectionId(intersectionId);
+			testMap.lanes = inboundLanes;
+		}
+	}
+	testMap.ref = locAware.getIntersectionRefPoint(testMap.intersectionIndex);
+	if (testMap.lanes.empty())
+	{
+		std::cerr << "No inbound lane in " << fnmap << std::endl;
+		return(false);
+	}
+	return(true);
+}
+
+/// BSM datagrams of 'vehNums' vehicles, 10 BSMs per second each, round by round. Vehicle 'veh' drives lane
+/// veh % lanes.size(), 5 meters behind the previous vehicle on the lane, at 5 m/s toward the stop-bar and on
+/// 20 meters into the intersection box, then starts over. With 'stopAndGo', vehicles move for 1 second out of
+/// every 3 and stand still in between (a queue). With 'halfFar', odd vehicles drive 5 km north of their lane,
+/// away from all intersections.
+static bool getBsmDatagrams(const testMap_t& testMap, size_t vehNums, size_t bsmNums, bool stopAndGo, bool halfFar,
+	std::vector< std::vector<uint8_t> >& datagrams)
+{
+	const size_t headerSize = 9;
+	const auto& lanes = testMap.lanes;
+	const auto& ref = testMap.ref;
+	datagrams.clear();
+	datagrams.reserve(bsmNums);
+	for (size_t i = 0; i < bsmNums; i++)
+	{
+		size_t round = i / vehNums;
+		size_t veh = i % vehNums;
+		size_t movingRounds = (stopAndGo) ? (round / 30) * 10 + std::min(round % 30, (size_t)10) : round;
+		bool moving = !stopAndGo || (round % 30 < 10);
+		const std::vector<GeoUtils::point2D_t>& nodes = lanes[veh % lanes.size()];
+		double laneLen = 0.0;
+		for (size_t k = 1; k < nodes.size(); k++)
+			laneLen += nodes[k].distance2pt(nodes[k - 1]) / 100.0;
+		double dist = laneLen - std::fmod((double)movingRounds * 0.5 + (double)(veh / lanes.size()) * 5.0, laneLen + 20.0);
+		/// segment holding the point dist meters upstream of the stop-bar (extended past the stop-bar)
+		size_t seg = 1;
+		double segStart = 0.0;
+		while ((seg + 1 < nodes.size()) && (segStart + nodes[seg].distance2pt(nodes[seg - 1]) / 100.0 < dist))
+		{
+			segStart += nodes[seg].distance2pt(nodes[seg - 1]) / 100.0;
+			seg++;
+		}
+		double dx = (double)(nodes[seg].x - nodes[seg - 1].x) / 100.0;
+		double dy = (double)(nodes[seg].y - nodes[seg - 1].y) / 100.0;
+		double segLen = std::sqrt(dx * dx + dy * dy);
+		double east = (double)nodes[seg - 1].x / 100.0 + dx / segLen * (dist - segStart);
+		double north = (double)nodes[seg - 1].y / 100.0 + dy / segLen * (dist - segStart);
+		if (halfFar && (veh % 2 == 1))
+			north += 5000.0;
+		double heading = std::atan2(-dx, -dy) * 180.0 / M_PI;
+		if (heading < 0.0)
+			heading += 360.0;
+		BSM_element_t bsm;
+		bsm.reset();
+		bsm.msgCnt = (uint8_t)(round % 128);
+		bsm.id = 1000 + (uint32_t)veh;
+		bsm.timeStampSec = (uint16_t)((round * 100) % 60000);
+		bsm.latitude = ref.latitude + (int32_t)(north / 111320.0 * 1e7);
+		bsm.longitude = ref.longitude + (int32_t)(east / (111320.0 * std::cos(ref.latitude * 1e-7 * M_PI / 180.0)) * 1e7);
+		bsm.elevation = ref.elevation;
+		bsm.speed = (moving) ? 250 : 0;
+		bsm.heading = (uint16_t)(heading / 0.0125);
+		bsm.vehLen = 500;
+		bsm.vehWidth = 200;
+		std::vector<uint8_t> datagram(400, 0);
+		size_t payloadLen = AsnJ2735Lib::encode_bsm_payload(bsm, &datagram[headerSize], datagram.size() - headerSize);
+		if (payloadLen == 0)
+		{
+			std::cerr << "Failed encode_bsm_payload" << std::endl;
+			return(false);
+		}
+		size_t offset = 0;
+		msgUtils::packHeader(datagram, offset, msgUtils::msgid_bsm, 0, (uint16_t)payloadLen);
+		datagram.resize(headerSize + payloadLen);
+		datagrams.push_back(datagram);
+	}
+	return(true);
+}
+
+static bool benchPipeline(const std::string& fnmap, size_t bsmNums)
+{
+	const size_t vehNums = 200;
+	const size_t batchSize = 64;  // BSMs per drain batch, as maxDrainCnt in conf/mrpAwr.conf
+	const size_t headerSize = 9;
+	/// LocAware reports loading on std::cout, keep it out of the benchmark output
+	std::ostringstream oss;
+	std::streambuf* coutBuf = std::cout.rdbuf(oss.rdbuf());
+	LocAware locAware(fnmap);
+	std::cout.rdbuf(coutBuf);
+	testMap_t testMap;
+	std::vector< std::vector<uint8_t> > datagrams;
+	if (!getTestMap(locAware, fnmap, testMap) || !getBsmDatagrams(testMap, vehNums, bsmNums, false, false, datagrams))
+		return(false);
+	uint8_t intersectionIndex = testMap.intersectionIndex;
+	const GeoUtils::geoRefPoint_t& ref = testMap.ref;
+
+	std::cout << bsmNums << " BSMs of " << vehNums << " vehicles at " << locAware.getIntersectionNameByIndex(intersectionIndex);
+	std::cout << ", drain batches of " << batchSize << std::endl;
+	std::cout << std::setw(8) << "workers" << std::setw(12) << "BSM/s" << std::setw(10) << "mapped";
+	std::cout << std::setw(10) << "in MAP" << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::endl;
+	std::vector<bsmResult_t> results0;
+	bool ret = true;
+	for (size_t workers : {0, 1, 2, 4})
+	{
+		BsmPipeline pipeline(locAware, ref.elevation, 2.0, 5.0, workers, 256, 2000, 2000, 0);
+		std::vector<bsmResult_t> results;
+		results.reserve(bsmNums);
+		std::vector<std::chrono::steady_clock::time_point> published(bsmNums);
+		std::vector<double> latency;
+		latency.reserve(bsmNums);
+		size_t mapped = 0;
+		size_t inMap = 0;
+		auto take = [&](bsmJob_t* job)
+		{
+			bool located = (job->status == bsmJob_t::result::located);
+			results.push_back(bsmResult_t{job->status, located && job->doMapping, located && job->cv.isVehicleInMap,
+				job->cv.vehicleTrackingState});
+			if (located && job->doMapping)
+				mapped++;
+			if (located && job->cv.isVehicleInMap)
+				inMap++;
+			pipeline.release();
+		};
+		auto t0 = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < bsmNums; )
+		{
+			size_t first = i;
+			size_t last = std::min(bsmNums, i + batchSize);
+			for (; i < last; i++)
+			{
+				const std::vector<uint8_t>& datagram = datagrams[i];
+				BSM_header_t bsmHeader;
+				if (!AsnJ2735Lib::peek_bsm_header(&datagram[headerSize], datagram.size() - headerSize, bsmHeader))
+					continue;
+				bsmJob_t* job;
+				while ((job = pipeline.claim(bsmHeader.id)) == nullptr)
+					take(pipeline.wait());
+				job->msec = (unsigned long long)(i / vehNums) * 100;
+				job->msOfDay = 0;
+				job->datagram = datagram;
+				job->offset = headerSize;
+				job->length = datagram.size() - headerSize;
+				job->peeked = true;
+				job->header = bsmHeader;
+				published[i] = std::chrono::steady_clock::now();
+				pipeline.publish();
+				while ((job = pipeline.ready()) != nullptr)
+					take(job);
+			}
+			/// the control logic runs once the batch has been tracked: latency from publish to the end of the batch
+			bsmJob_t* job;
+			while ((job = pipeline.wait()) != nullptr)
+				take(job);
+			auto t1 = std::chrono::steady_clock::now();
+			for (size_t k = first; k < last; k++)
+				latency.push_back((double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - published[k]).count() / 1000.0);
+		}
+		double ns = nsSince(t0);
+		std::sort(latency.begin(), latency.end());
+		std::cout << std::fixed << std::setprecision(1);
+		std::cout << std::setw(8) << workers << std::setw(12) << std::setprecision(0) << (double)bsmNums * 1e9 / ns;
+		std::cout << std::setw(10) << mapped << std::setw(10) << inMap << std::setprecision(1);
+		std::cout << std::setw(12) << latency[latency.size() / 2] << std::setw(12) << latency[latency.size() * 99 / 100] << std::endl;
+		if (workers == 0)
+			results0.swap(results);
+		else
+		{
+			size_t mismatches = 0;
+			for (size_t i = 0; i < bsmNums; i++)
+			{
+				if ((i >= results.size()) || !isSameResult(results[i], results0[i]))
+					mismatches++;
+			}
+			if (mismatches > 0)
+			{
+				std::cerr << mismatches << " BSMs with " << workers << " workers differ from the results without workers" << std::endl;
+				ret = false;
+			}
+		}
+	}
+	return(ret);
+}
+
+/// the earlier cvStatusAware_t, holding every tracked point of the vehicle
+struct earlierStatusAware_t
+{
+	bool isOnInbound;
+	unsigned long long msec;
+	BSM_element_t bsm;
+	std::vector<GeoUtils::connectedVehicle_t> cvStatus;
+	void reset(void)
+	{
+		isOnInbound = false;
+		cvStatus.clear();
+	};
+};
+
+/// msgid_traj content that comes from the trajectory history
+struct trajSummary_t
+{
+	unsigned long long entry_msec;
+	unsigned long long leave_msec;
+	double entryDist2go;
+	double leaveDist2go;
+	uint8_t entryLaneId;
+	uint8_t leaveLaneId;
+	uint8_t entryControlPhase;
+	uint8_t leaveControlPhase;
+	size_t pointCnt;
+	size_t stoppedCnt;
+	bool operator==(const trajSummary_t& p) const
+	{
+		return((entry_msec == p.entry_msec) && (leave_msec == p.leave_msec) && (entryDist2go == p.entryDist2go)
+			&& (leaveDist2go == p.leaveDist2go) && (entryLaneId == p.entryLaneId) && (leaveLaneId == p.leaveLaneId)
+			&& (entryControlPhase == p.entryControlPhase) && (leaveControlPhase == p.leaveControlPhase)
+			&& (pointCnt == p.pointCnt) && (stoppedCnt == p.stoppedCnt));
+	};
+};
+
+/// a located BSM as taken from BsmPipeline
+struct locatedBsm_t
+{
+	BSM_element_t bsm;
+	bool doMapping;
+	GeoUtils::connectedVehicle_t cv;
+};
+
+/// whether the vehicle that was onInbound stays on the same approach of intersectionIndex
+static bool staysOnApproach(const GeoUtils::connectedVehicle_t& cvIn, const GeoUtils::connectedVehicle_t& cvLast,
+	uint8_t intersectionIndex)
+{
+	const auto& state = cvIn.vehicleTrackingState.intsectionTrackingState;
+	return(cvIn.isVehicleInMap && (state.intersectionIndex == intersectionIndex)
+		&& ((state.vehicleIntersectionStatus == MsgEnum::mapLocType::onInbound)
+			|| (state.vehicleIntersectionStatus == MsgEnum::mapLocType::atIntersectionBox))
+		&& (state.approachIndex == cvLast.vehicleTrackingState.intsectionTrackingState.approachIndex));
+}
+
+static bool entersInbound(const GeoUtils::connectedVehicle_t& cvIn, uint8_t intersectionIndex)
+{
+	const auto& state = cvIn.vehicleTrackingState.intsectionTrackingState;
+	return(cvIn.isVehicleInMap && (state.intersectionIndex == intersectionIndex)
+		&& (state.vehicleIntersectionStatus == MsgEnum::mapLocType::onInbound));
+}
+
+/// the vehList update of the mrpAware BSM path (trackBsm), with the earlier trajectory store
+template<class T>
+static T* findOrInsert(tableUtils::KeyedTable<T>& vehList, const BSM_element_t& bsm)
+{
+	T* it = vehList.find(bsm.id);
+	if (it == nullptr)
+	{
+		if ((it = vehList.insert(bsm.id)) != nullptr)
+			it->reset();
+	}
+	else if ((bsm.msgCnt <= it->bsm.msgCnt) && (bsm.timeStampSec <= it->bsm.timeStampSec))
+		return(nullptr);
+	return(it);
+}
+
+static void trackEarlier(tableUtils::KeyedTable<earlierStatusAware_t>& vehList, const locatedBsm_t& job,
+	uint8_t intersectionIndex, double stopSpeed, std::vector<trajSummary_t>& trajs)
+{
+	earlierStatusAware_t* it = findOrInsert(vehList, job.bsm);
+	if (it == nullptr)
+		return;
+	it->msec = job.cv.msec;
+	it->bsm = job.bsm;
+	const GeoUtils::connectedVehicle_t& cvIn = job.cv;
+	if (it->cvStatus.empty())
+		it->cvStatus.push_back(cvIn);
+	auto cv = it->cvStatus.back();
+	if (it->isOnInbound)
+	{
+		if (staysOnApproach(cvIn, cv, intersectionIndex))
+		{
+			if (job.doMapping)
+				it->cvStatus.push_back(cvIn);
+		}
+		else
+		{ /// left the inbound approach, msgid_traj when there are at least 10 tracked points
+			const auto& cvStatus = it->cvStatus;
+			if (cvStatus.size() >= 10)
+			{
+				size_t stoppedCnt = (size_t)std::count_if(cvStatus.begin(), cvStatus.end(),
+					[stopSpeed](const GeoUtils::connectedVehicle_t& p){return(p.motionState.speed <= stopSpeed);});
+				trajs.push_back(trajSummary_t{cvStatus[0].msec, cvStatus.back().msec,
+					cvStatus[0].vehicleLocationAware.dist2go.distLong, cvStatus.back().vehicleLocationAware.dist2go.distLong,
+					cvStatus[0].vehicleLocationAware.laneId, cvStatus.back().vehicleLocationAware.laneId,
+					cvStatus[0].vehicleLocationAware.controlPhase, cvStatus.back().vehicleLocationAware.controlPhase,
+					cvStatus.size(), stoppedCnt});
+			}
+			it->reset();
+			it->cvStatus.push_back(cvIn);
+		}
+	}
+	else if (entersInbound(cvIn, intersectionIndex))
+	{
+		it->isOnInbound = true;
+		it->cvStatus[0] = cvIn;
+	}
+	else if (job.doMapping)
+		it->cvStatus[0] = cvIn;
+}
+
+static void trackFixed(tableUtils::KeyedTable<cvStatusAware_t>& vehList, const locatedBsm_t& job,
+	uint8_t intersectionIndex, double stopSpeed, std::vector<trajSummary_t>& trajs)
+{
+	cvStatusAware_t* it = findOrInsert(vehList, job.bsm);
+	if (it == nullptr)
+		return;
+	it->msec = job.cv.msec;
+	it->bsm = job.bsm;
+	const GeoUtils::connectedVehicle_t& cvIn = job.cv;
+	if (it->isOnInbound)
+	{
+		if (staysOnApproach(cvIn, it->cvStatus, intersectionIndex))
+		{
+			if (job.doMapping)
+				it->append(cvIn, stopSpeed);
+		}
+		else
+		{ /// left the inbound approach, msgid_traj when there are at least 10 tracked points
+			const auto& cvStatus = it->cvStatus;
+			const auto& traj = it->traj;
+			if (traj.pointCnt >= 10)
+			{
+				trajs.push_back(trajSummary_t{traj.entry_msec, cvStatus.msec,
+					traj.entryDist2go, cvStatus.vehicleLocationAware.dist2go.distLong,
+					traj.entryLaneId, cvStatus.vehicleLocationAware.laneId,
+					traj.entryControlPhase, cvStatus.vehicleLocationAware.controlPhase,
+					traj.pointCnt, traj.stoppedCnt});
+			}
+			it->reset();
+			it->restart(cvIn, stopSpeed);
+		}
+	}
+	else if (entersInbound(cvIn, intersectionIndex))
+	{
+		it->isOnInbound = true;
+		it->restart(cvIn, stopSpeed);
+	}
+	else if (job.doMapping || (it->traj.pointCnt == 0))
+		it->restart(cvIn, stopSpeed);
+}
+
+/// heap bytes held by the connect2go of cv
+static size_t heapBytes(const GeoUtils::connectedVehicle_t& cv)
+	{return(cv.vehicleLocationAware.connect2go.capacity() * sizeof(GeoUtils::connectTo_t));}
+
+static bool benchTraj(const std::string& fnmap, size_t bsmNums)
+{
+	const size_t vehNums = 200;
+	const double stopSpeed = 2.0;
+	const double stopDist = 5.0;
+	std::ostringstream oss;
+	std::streambuf* coutBuf = std::cout.rdbuf(oss.rdbuf());
+	LocAware locAware(fnmap);
+	std::cout.rdbuf(coutBuf);
+	testMap_t testMap;
+	std::vector< std::vector<uint8_t> > datagrams;
+	if (!getTestMap(locAware, fnmap, testMap) || !getBsmDatagrams(testMap, vehNums, bsmNums, true, false, datagrams))
+		return(false);
+	/// decode & map-match once, both trajectory stores take the same located BSMs
+	std::vector<locatedBsm_t> located;
+	located.reserve(bsmNums);
+	{
+		const size_t headerSize = 9;
+		BsmPipeline pipeline(locAware, testMap.ref.elevation, stopSpeed, stopDist, 0, 256, 2000, 2000, 0);
+		for (size_t i = 0; i < bsmNums; i++)
+		{
+			const std::vector<uint8_t>& datagram = datagrams[i];
+			BSM_header_t bsmHeader;
+			if (!AsnJ2735Lib::peek_bsm_header(&datagram[headerSize], datagram.size() - headerSize, bsmHeader))
+				continue;
+			bsmJob_t* job = pipeline.claim(bsmHeader.id);
+			job->msec = (unsigned long long)(i / vehNums) * 100;
+			job->msOfDay = 0;
+			job->datagram = datagram;
+			job->offset = headerSize;
+			job->length = datagram.size() - headerSize;
+			job->peeked = true;
+			job->header = bsmHeader;
+			pipeline.publish();
+			while ((job = pipeline.ready()) != nullptr)
+			{
+				if (job->status == bsmJob_t::result::located)
+					located.push_back(locatedBsm_t{job->bsm, job->doMapping, job->cv});
+				pipeline.release();
+			}
+		}
+	}
+	size_t mapped = (size_t)std::count_if(located.begin(), located.end(), [](const locatedBsm_t& p){return(p.doMapping);});
+
+	tableUtils::KeyedTable<earlierStatusAware_t> earlierList(defaultMaxVehicles);
+	std::vector<trajSummary_t> earlierTrajs;
+	unsigned long long allocStart = allocCnt.load();
+	auto t0 = std::chrono::steady_clock::now();
+	for (const auto& job : located)
+		trackEarlier(earlierList, job, testMap.intersectionIndex, stopSpeed, earlierTrajs);
+	double earlierNs = nsSince(t0);
+	unsigned long long earlierAllocs = allocCnt.load() - allocStart;
+
+	tableUtils::KeyedTable<cvStatusAware_t> fixedList(defaultMaxVehicles);
+	std::vector<trajSummary_t> fixedTrajs;
+	allocStart = allocCnt.load();
+	t0 = std::chrono::steady_clock::now();
+	for (const auto& job : located)
+		trackFixed(fixedList, job, testMap.intersectionIndex, stopSpeed, fixedTrajs);
+	double fixedNs = nsSince(t0);
+	unsigned long long fixedAllocs = allocCnt.load() - allocStart;
+
+	/// bytes per vehicle at the end of the run: the vehList entry and the heap it holds
+	size_t earlierBytes = 0;
+	size_t earlierMax = 0;
+	for (const auto& veh : earlierList)
+	{
+		size_t bytes = sizeof(earlierStatusAware_t) + veh.cvStatus.capacity() * sizeof(GeoUtils::connectedVehicle_t);
+		for (const auto& cv : veh.cvStatus)
+			bytes += heapBytes(cv);
+		earlierBytes += bytes;
+		earlierMax = std::max(earlierMax, bytes);
+	}
+	size_t fixedBytes = 0;
+	size_t fixedMax = 0;
+	for (const auto& veh : fixedList)
+	{
+		size_t bytes = sizeof(cvStatusAware_t) + heapBytes(veh.cvStatus);
+		fixedBytes += bytes;
+		fixedMax = std::max(fixedMax, bytes);
+	}
+
+	std::cout << bsmNums << " BSMs (" << located.size() << " located, " << mapped << " mapped) of " << vehNums;
+	std::cout << " queued vehicles at " << locAware.getIntersectionNameByIndex(testMap.intersectionIndex) << ", ";
+	std::cout << fixedTrajs.size() << " trajectories" << std::endl;
+	std::cout << std::setw(14) << "history" << std::setw(16) << "bytes/vehicle" << std::setw(12) << "max bytes";
+	std::cout << std::setw(14) << "allocs/BSM" << std::setw(10) << "ns/BSM" << std::endl;
+	std::cout << std::fixed << std::setprecision(0);
+	std::cout << std::setw(14) << "vector" << std::setw(16) << (double)earlierBytes / (double)earlierList.size();
+	std::cout << std::setw(12) << earlierMax << std::setw(14) << std::setprecision(3) << (double)earlierAllocs / (double)located.size();
+	std::cout << std::setw(10) << std::setprecision(1) << earlierNs / (double)located.size() << std::endl;
+	std::cout << std::setw(14) << "fixed-size" << std::setw(16) << std::setprecision(0) << (double)fixedBytes / (double)fixedList.size();
+	std::cout << std::setw(12) << fixedMax << std::setw(14) << std::setprecision(3) << (double)fixedAllocs / (double)located.size();
+	std::cout << std::setw(10) << std::setprecision(1) << fixedNs / (double)located.size() << std::endl;
+
+	if (fixedTrajs.empty())
+	{ /// the first vehicles leave the queue after about 70 s of BSMs (-n 150000)
+		std::cerr << "no vehicle left its inbound approach within " << bsmNums << " BSMs, nothing to compare" << std::endl;
+		return(false);
+	}
+	if ((fixedTrajs.size() != earlierTrajs.size()) || !std::equal(fixedTrajs.begin(), fixedTrajs.end(), earlierTrajs.begin()))
+	{
+		std::cerr << "msgid_traj content of the fixed-size history differs from the vector history" << std::endl;
+		return(false);
+	}
+	return(true);
+}
+
+static bool benchDup(const std::string& fnmap, size_t bsmNums)
+{
+	const size_t vehNums = 300;
+	const size_t headerSize = 9;
+	std::ostringstream oss;
+	std::streambuf* coutBuf = std::cout.rdbuf(oss.rdbuf());
+	LocAware locAware(fnmap);
+	std::cout.rdbuf(coutBuf);
+	testMap_t testMap;
+	if (!getTestMap(locAware, fnmap, testMap))
+		return(false);
+	std::cout << bsmNums << " BSMs of " << vehNums << " vehicles at 10 Hz at ";
+	std::cout << locAware.getIntersectionNameByIndex(testMap.intersectionIndex) << ", duplicates follow the BSM they repeat" << std::endl;
+	std::cout << std::setw(6) << "dup%" << std::setw(6) << "far%" << std::setw(10) << "filter" << std::setw(10) << "BSMs";
+	std::cout << std::setw(10) << "located" << std::setw(10) << "in MAP" << std::setw(11) << "duplicate" << std::setw(9) << "farAway";
+	std::cout << std::setw(8) << "stale" << std::setw(10) << "ns/BSM" << std::endl;
+	bool ret = true;
+	for (bool halfFar : {false, true})
+	{
+		std::vector< std::vector<uint8_t> > datagrams;
+		if (!getBsmDatagrams(testMap, vehNums, bsmNums, false, halfFar, datagrams))
+			return(false);
+		for (unsigned int dupPct : {0, 50, 100})
+		{ /// each BSM is heard a second time (e.g., by another RSU) with probability dupPct
+			std::mt19937 rng(1);
+			std::vector<const std::vector<uint8_t>*> stream;
+			stream.reserve(2 * bsmNums);
+			std::vector<unsigned long long> msecs;
+			msecs.reserve(2 * bsmNums);
+			for (size_t i = 0; i < bsmNums; i++)
+			{
+				unsigned long long msec = (unsigned long long)(i / vehNums) * 100;
+				stream.push_back(&datagrams[i]);
+				msecs.push_back(msec);
+				if (rng() % 100 < dupPct)
+				{
+					stream.push_back(&datagrams[i]);
+					msecs.push_back(msec);
+				}
+			}
+			size_t inMap[2] = {0, 0};
+			for (bool filter : {false, true})
+			{
+				BsmPipeline pipeline(locAware, testMap.ref.elevation, 2.0, 5.0, 0, 256, 2000, 2000, 0);
+				size_t counts[5] = {0, 0, 0, 0, 0};
+				auto t0 = std::chrono::steady_clock::now();
+				for (size_t i = 0; i < stream.size(); i++)
+				{
+					const std::vector<uint8_t>& datagram = *stream[i];
+					BSM_header_t bsmHeader;
+					if (!AsnJ2735Lib::peek_bsm_header(&datagram[headerSize], datagram.size() - headerSize, bsmHeader))
+						continue;
+					bsmJob_t* job = pipeline.claim(bsmHeader.id);
+					job->msec = msecs[i];
+					job->msOfDay = 0;
+					job->datagram = datagram;
+					job->offset = headerSize;
+					job->length = datagram.size() - headerSize;
+					/// without the filter, every BSM is decoded without looking at its peeked header
+					job->peeked = filter;
+					job->header = bsmHeader;
+					pipeline.publish();
+					while ((job = pipeline.ready()) != nullptr)
+					{
+						counts[static_cast<size_t>(job->status)]++;
+						if ((job->status == bsmJob_t::result::located) && job->cv.isVehicleInMap)
+							inMap[(filter) ? 1 : 0]++;
+						pipeline.release();
+					}
+				}
+				double ns = nsSince(t0);
+				std::cout << std::setw(6) << dupPct << std::setw(6) << ((halfFar) ? 50 : 0);
+				std::cout << std::setw(10) << ((filter) ? "peek" : "decode") << std::setw(10) << stream.size();
+				std::cout << std::setw(10) << counts[static_cast<size_t>(bsmJob_t::result::located)] << std::setw(10) << inMap[(filter) ? 1 : 0];
+				std::cout << std::setw(11) << counts[static_cast<size_t>(bsmJob_t::result::duplicate)];
+				std::cout << std::setw(9) << counts[static_cast<size_t>(bsmJob_t::result::farAway)];
+				std::cout << std::setw(8) << counts[static_cast<size_t>(bsmJob_t::result::stale)];
+				std::cout << std::fixed << std::setprecision(1) << std::setw(10) << ns / (double)stream.size() << std::endl;
+			}
+			if (inMap[0] != inMap[1])
+			{
+				std::cerr << "BSMs located on the MAP differ with the peek filter, " << dupPct << "% duplicates" << std::endl;
+				ret = false;
+			}
+		}
+	}
+	return(ret);
+}
+
+int main(int argc, char** argv)
+{
+	int option;
+	size_t iterations = 200000;
+
+	while ((option = getopt(argc, argv, "n:?")) != EOF)
+	{
+		switch(option)
+		{
+		case 'n':
+			iterations = (size_t)strtoul(optarg, NULL, 10);
+			break;
+		case '?':
+		default:
+			do_usage(argv[0]);
+			break;
+		}
+	}
+	if ((optind > argc - 1) || (optind < argc - 2) || (iterations == 0))
+		do_usage(argv[0]);
+	std::string benchmark = std::string(argv[optind]);
+	std::string fnmap = (optind == argc - 2) ? std::string(argv[optind + 1]) : std::string();
+
+	bool ret = false;
+	if (benchmark == "vehlist")
+		ret = benchVehList(iterations);
+	else if ((benchmark == "pipeline") && !fnmap.empty())
+		ret = benchPipeline(fnmap, iterations);
+	else if ((benchmark == "dup") && !fnmap.empty())
+		ret = benchDup(fnmap, iterations);
+	else if ((benchmark == "traj") && !fnmap.empty())
+		ret = benchTraj(fnmap, iterations);
+	else
+		do_usage(argv[0]);
+	exit(ret ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,48 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+/* nmapCompiler.cpp
+ * compiles an intersection nmap file into a binary nmap image. The image holds intersections with
+ * local offsets, headings, approach polygons, lane segment tables and UPER encoded MAP payloads,
+ * so that LocAware loads it without parsing, geometry building and UPER encoding.
+ * LocAware accepts either a nmap file or a nmap image as nmapFile in mrpAwr.conf and dataMgr.conf.
+ */
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "locAware.h"
+
+void do_usage(const char* progname)
+{
+	std::cerr << "Usage " << progname << " <nmap file> <nmap image file>" << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 3)
+		do_usage(argv[0]);
+	std::string fnmap = std::string(argv[1]);
+	std::string fimage = std::string(argv[2]);
+
+	LocAware* plocAwareLib = new LocAware(fnmap);
+	if (!plocAwareLib->isInitiated())
+	{
+		std::cerr << "Failed initiating locAwareLib " << fnmap << std::endl;
+		delete plocAwareLib;
+		exit(EXIT_FAILURE);
+	}
+	if (!plocAwareLib->saveNmapImage(fimage))
+	{
+		std::cerr << "Failed saving nmap image " << fimage << std::endl;
+		delete plocAwareLib;
+		exit(EXIT_FAILURE);
+	}
+	std::cout << "Compiled " << plocAwareLib->getIntersectionIds().size() << " intersections into " << fimage << std::endl;
+	delete plocAwareLib;
+	exit(EXIT_SUCCESS);
+}
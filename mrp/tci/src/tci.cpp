@@ -35,7 +35,6 @@
  *
  */
 
-#include <chrono>
 #include <cmath>
 #include <csignal>
 #include <cstdio>
@@ -48,12 +47,12 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <termios.h>
-#include <thread>
 #include <unistd.h>
 
 #include "ab3418fcs.h"
 #include "cnfUtils.h"
 #include "cntlrPolls.h"
+#include "eventUtils.h"
 #include "logUtils.h"
 #include "msgUtils.h"
 #include "socketUtils.h"
@@ -128,6 +127,7 @@ int main(int argc, char** argv)
 	bool send2controller = (pmycnf->getIntegerParaValue(std::string("sendCommand")) == 1) ? true : false;
 	unsigned long long logInterval = pmycnf->getIntegerParaValue(std::string("logInterval")) * 60 * 1000;  // in milliseconds
 	int logType = pmycnf->getIntegerParaValue(std::string("logType"));
+	bool logCompress = (pmycnf->getIntegerParaValue(std::string("logCompress")) > 0);
 	logUtils::logType log_type = ((logInterval == 0) || ((logType != 1) && (logType != 2)))
 		? logUtils::logType::none : static_cast<logUtils::logType>(logType);
 	std::string spatPort  = pmycnf->getStringParaValue(std::string("spatPort"));
@@ -135,7 +135,6 @@ int main(int argc, char** argv)
 	std::string logPath   = pmycnf->getStringParaValue(std::string("logPath"));
 	std::string cardName  = pmycnf->getStringParaValue(std::string("timeCardPath"))
 		+ std::string("/") + intersectionName + std::string(".timecard");
-	unsigned long long logfile_msec = 0;
 
 	/// open error log
 	std::ofstream OS_ERR(logPath + std::string("/tci.err"), std::ofstream::app);
@@ -147,30 +146,21 @@ int main(int argc, char** argv)
 		return(-1);
 	}
 
-	/// open log files
-	std::vector<logUtils::Logfile_t> logFiles;
-	if (log_type != logUtils::logType::none)
+	/// open log files, written by a background thread
+	logUtils::Logger logger(logPath + std::string("/") + intersectionName, logCompress);
+	const size_t sigRawLog = logger.addChannel(std::string("sigRaw"));  // log controller pushing out controller and signal status message
+	const size_t callLog = logger.addChannel(std::string("call"));      // log soft-call message send to controller
+	const size_t sigLog = logger.addChannel(std::string("sig"));        // log controller status message send to MRP_DataMgr
+	const size_t cntLog = logger.addChannel(std::string("cnt"));        // log count/volume message send to MRP_DataMgr
+	const size_t presLog = logger.addChannel(std::string("pres"));      // log detector presence message send to MRP_DataMgr
+	const size_t reqLog = logger.addChannel(std::string("req"));        // log soft-call request message received from MRP_DataMgr
+	if ((log_type != logUtils::logType::none) && !logger.open(fullTimeStamp.localDateTimeStamp.to_fileName()))
 	{
-		std::vector<std::string> logtypes;
-		logtypes.push_back(std::string("sigRaw")); // log controller pushing out controller and signal status message
-		logtypes.push_back(std::string("call"));   // log soft-call message send to controller
-		logtypes.push_back(std::string("sig"));    // log controller status message send to MRP_DataMgr
-		logtypes.push_back(std::string("cnt"));    // log count/volume message send to MRP_DataMgr
-		logtypes.push_back(std::string("pres"));   // log detector presence message send to MRP_DataMgr
-		logtypes.push_back(std::string("req"));    // log soft-call request message received from MRP_DataMgr
-		std::string prefix = logPath + std::string("/") + intersectionName;
-		for (auto& type : logtypes)
-			{logFiles.push_back(logUtils::Logfile_t(prefix, type));}
-		if (!logUtils::openLogFiles(logFiles, fullTimeStamp.localDateTimeStamp.to_fileName()))
-		{
-			OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
-			OS_ERR << ", failed openLogFiles" << std::endl;
-			OS_ERR.close();
-			logUtils::closeLogFiles(logFiles);
-			delete pmycnf;
-			return(-1);
-		}
-		logfile_msec = fullTimeStamp.msec;
+		OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
+		OS_ERR << ", failed openLogFiles" << std::endl;
+		OS_ERR.close();
+		delete pmycnf;
+		return(-1);
 	}
 
 	/// open sockets (bidirectional from/to DataMgr)
@@ -179,8 +169,7 @@ int main(int argc, char** argv)
 		OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
 		OS_ERR << ", failed initiating sockets" << std::endl;
 		OS_ERR.close();
-		if (log_type != logUtils::logType::none)
-			logUtils::closeLogFiles(logFiles);
+		logger.close();
 		delete pmycnf;
 		return(-1);
 	}
@@ -196,8 +185,7 @@ int main(int argc, char** argv)
 		OS_ERR << ", failed open port" << ((fd_spat < 0) ? spatPort : std::string());
 		OS_ERR << std::string(" ") << ((fd_spat2 < 0) ? spat2Port : std::string()) << std::endl;
 		OS_ERR.close();
-		if (log_type != logUtils::logType::none)
-			logUtils::closeLogFiles(logFiles);
+		logger.close();
 		pmycnf->disconnectAll();
 		delete pmycnf;
 		if (fd_spat > 0)
@@ -253,7 +241,7 @@ int main(int argc, char** argv)
 	AB3418MSG::longstatus8e_mess_t   longstatus8e_mess;
 	/// receive and send socket buffer
 	const size_t maxUDPmsgSize = 2000;
-	std::vector<uint8_t> recvbuf_socket(maxUDPmsgSize, 0);
+	socketUtils::DgramBatch rxBatch(16, maxUDPmsgSize);  // drains fd_Listen (UDP socket or SHM ring)
 	std::vector<uint8_t> sendbuf_socket(maxUDPmsgSize, 0);
 
 	/// interval to send soft-call to the traffic controller
@@ -263,20 +251,25 @@ int main(int argc, char** argv)
 	softcall_state.reset();
 
 	/// set up serial ports and sockets poll structure
-	nfds_t nfds = 3;
-	struct pollfd ufds[3];
-	ufds[0].fd = fd_spat;
-	ufds[1].fd = fd_spat2;
-	ufds[2].fd = fd_Listen;
-	for (nfds_t i = 0; i < nfds; i++)
-		ufds[i].events = POLLIN;
-  int pollTimeout = 20; // in milliseconds, B38400 = 48 bytes in 10 milliseconds
+	const size_t nfds = 3;
+	const int fds[nfds] = {fd_spat, fd_spat2, fd_Listen};
+	eventUtils::Reactor reactor;
+	for (size_t i = 0; i < nfds; i++)
+		reactor.addFd(fds[i]);
+	/// timers armed only while there is timing card polling or soft-call to send. The soft-call timer is a
+	/// one-shot timer armed for the time the next soft-call is due, counted from the last one sent
+	size_t pollTimer = reactor.addTimer(poll_interval, 0);
+	size_t softcallTimer = reactor.addTimer(0, softcall_interval);
+	reactor.disarmTimer(softcallTimer);
+	size_t logTimer = reactor.addTimer(logInterval, logInterval);
+	if (log_type == logUtils::logType::none)
+		reactor.disarmTimer(logTimer);
 
 	while(terminate == 0)
 	{
 		bool process_spat = false;
 		bool process_spat2 = false;
-		int retval = poll(ufds, nfds, pollTimeout);
+		int retval = reactor.wait();
 		timeUtils::getFullTimeStamp(fullTimeStamp);
 		if (dateStamp != fullTimeStamp.localDateTimeStamp.dateStamp)
 		{ /// poll controller configuration data once per day
@@ -290,11 +283,11 @@ int main(int argc, char** argv)
 
 		if (retval > 0)
 		{
-			for (nfds_t i = 0; i < nfds; i++)
+			for (size_t i = 0; i < nfds; i++)
 			{
-				if ((ufds[i].revents & POLLIN) != POLLIN)
+				if (!reactor.readable(fds[i]))
 					continue;
-				if (ufds[i].fd == fd_spat)
+				if (fds[i] == fd_spat)
 				{	/// events on fd_spat, read all available bytes
 					ssize_t bytes_read = read(fd_spat, (void*)&recvbuf_spat[bytenums_spat], maxAB3418msgSize - bytenums_spat);
 					if (bytes_read > 0)
@@ -305,7 +298,7 @@ int main(int argc, char** argv)
 							process_spat = true;
 					}
 				}
-				else if (ufds[i].fd == fd_spat2)
+				else if (fds[i] == fd_spat2)
 				{	/// events on fd_spat2, read all available bytes
 					ssize_t bytes_read = read(fd_spat2, (void*)&recvbuf_spat2[bytenums_spat2], maxAB3418msgSize - bytenums_spat2);
 					if (bytes_read > 0)
@@ -316,11 +309,14 @@ int main(int argc, char** argv)
 							process_spat2 = true;
 					}
 				}
-				else if (ufds[i].fd == fd_Listen)
+				else if (fds[i] == fd_Listen)
 				{	/// MMITSS header + message body
-					ssize_t bytesReceived = recv(fd_Listen, (void*)&recvbuf_socket[0], recvbuf_socket.size(), 0);
-					if (bytesReceived >= 9)
+					while (rxBatch.next(fd_Listen))
 					{
+						std::vector<uint8_t>& recvbuf_socket = rxBatch.buf();
+						ssize_t bytesReceived = (ssize_t)rxBatch.len();
+						if (bytesReceived < 9)
+							continue;
 						size_t offset = 0;
 						msgUtils::mmitss_udp_header_t udpHeader;
 						msgUtils::unpackHeader(recvbuf_socket, offset, udpHeader);
@@ -331,7 +327,7 @@ int main(int argc, char** argv)
 							msgDefs::unpackMsg(recvbuf_socket, offset, softcall_request);
 							updateSoftcallState(softcall_state, softcall_request);
 							if (log_type != logUtils::logType::none)
-								logUtils::logMsg(logFiles, std::string("req"), recvbuf_socket, (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
+								logger.log(reqLog, &recvbuf_socket[0], (size_t)bytesReceived, fullTimeStamp.localDateTimeStamp.msOfDay);
 						}
 					}
 				}
@@ -359,7 +355,7 @@ int main(int argc, char** argv)
 						if (log_type == logUtils::logType::detailLog)
 						{
 							size_t msgSize = AB3418MSG::packMsg(sendbuf_socket, signal_status_mess, msgUtils::msgid_signalraw, fullTimeStamp.localDateTimeStamp.msOfDay);
-							logUtils::logMsg(logFiles, std::string("sigRaw"), sendbuf_socket, msgSize);
+							logger.log(sigRawLog, &sendbuf_socket[0], msgSize);
 						}
 					}
 					else
@@ -412,7 +408,7 @@ int main(int argc, char** argv)
 							bool sendFlag = socketUtils::sendall(sendConn, &sendbuf_socket[0], msgSize);
 							/// log to file
 							if (log_type == logUtils::logType::detailLog)
-								logUtils::logMsg(logFiles, std::string("pres"), sendbuf_socket, msgSize);
+								logger.log(presLog, &sendbuf_socket[0], msgSize);
 							if (verbose)
 							{
 								std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
@@ -430,7 +426,7 @@ int main(int argc, char** argv)
 							bool sendFlag = socketUtils::sendall(sendConn, &sendbuf_socket[0], msgSize);
 							/// log to file
 							if (log_type == logUtils::logType::detailLog)
-								logUtils::logMsg(logFiles, std::string("cnt"), sendbuf_socket, msgSize);
+								logger.log(cntLog, &sendbuf_socket[0], msgSize);
 							if (verbose)
 							{
 								std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
@@ -1200,7 +1196,7 @@ int main(int argc, char** argv)
 			size_t msgSize = packMsg(sendbuf_socket, controller_status, msgUtils::msgid_cntrlstatus, fullTimeStamp);
 			bool sendFlag = socketUtils::sendall(sendConn, &sendbuf_socket[0], msgSize);
 			if (log_type == logUtils::logType::detailLog)
-				logUtils::logMsg(logFiles, std::string("sig"), sendbuf_socket, msgSize);
+				logger.log(sigLog, &sendbuf_socket[0], msgSize);
 			if (verbose)
 			{
 				std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
@@ -1209,6 +1205,7 @@ int main(int argc, char** argv)
 		}
 
 		/// check sending soft-call
+		bool softcallSent = false;
 		if ((fullTimeStamp.msec > softcall_state.msec + softcall_interval) && softcall_state.any())
 		{
 			std::bitset<8> pedCallPhases;
@@ -1239,6 +1236,7 @@ int main(int argc, char** argv)
 					{
 						softcall_state.ped_call.reset();
 						softcall_state.msec = fullTimeStamp.msec;
+						softcallSent = true;
 						if (verbose)
 						{
 							std::cout << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
@@ -1250,7 +1248,7 @@ int main(int argc, char** argv)
 						{
 							size_t msgSize = AB3418MSG::packMsg(sendbuf_socket, vehCallPahses, pedCallPhases, prioCallPhases,
 								msgUtils::msgid_placecall, fullTimeStamp.localDateTimeStamp.msOfDay);
-							logUtils::logMsg(logFiles, std::string("call"), sendbuf_socket, msgSize);
+							logger.log(callLog, &sendbuf_socket[0], msgSize);
 						}
 					}
 					else
@@ -1265,21 +1263,34 @@ int main(int argc, char** argv)
 		}
 
 		/// check reopen log files
-		if ((log_type != logUtils::logType::none) && (fullTimeStamp.msec > logfile_msec + logInterval))
+		if (reactor.expired(logTimer))
+			logger.reopen(fullTimeStamp.localDateTimeStamp.to_fileName());
+
+		/// wake up every poll_interval while polling timing card, and when the next soft-call is due while placing
+		/// soft-calls: softcall_interval after the last one was sent (the check above needs it passed), otherwise
+		/// after softcall_interval
+		if (!pollTimeCard)
+			reactor.disarmTimer(pollTimer);
+		else if (!reactor.isArmed(pollTimer))
+			reactor.armTimer(pollTimer, 0);
+		reactor.expired(pollTimer);
+		reactor.expired(softcallTimer);
+		if (!softcall_state.any())
+			reactor.disarmTimer(softcallTimer);
+		else if (softcallSent || !reactor.isArmed(softcallTimer))
 		{
-			logUtils::reOpenLogFiles(logFiles, fullTimeStamp.localDateTimeStamp.to_fileName());
-			logfile_msec = fullTimeStamp.msec;
+			unsigned long long due = softcall_state.msec + softcall_interval + 1;
+			reactor.armTimer(softcallTimer, (due > fullTimeStamp.msec) ? due - fullTimeStamp.msec : softcall_interval);
 		}
-
-		std::this_thread::sleep_for(std::chrono::milliseconds(5));
 	}
 	/// exit
 	timeUtils::getFullTimeStamp(fullTimeStamp);
 	OS_ERR << fullTimeStamp.localDateTimeStamp.to_dateTimeStr('-', ':');
 	OS_ERR << ", received user termination signal " << terminate << ", exit!" << std::endl;
+	if (logger.dropped() > 0)
+		OS_ERR << "\tdropped " << logger.dropped() << " log records on a full log ring" << std::endl;
 	OS_ERR.close();
-	if (log_type != logUtils::logType::none)
-		logUtils::closeLogFiles(logFiles);
+	logger.close();
 	pmycnf->disconnectAll();
 	close_port(fd_spat, true);
 	close_port(fd_spat2, true);
@@ -0,0 +1,65 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#ifndef _EVENT_UTILS_H
+#define _EVENT_UTILS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <poll.h>
+
+namespace eventUtils
+{
+	/// single-threaded reactor for the MRP main loops: waits until a watched descriptor is readable
+	/// or the earliest timer is due, so that the process does not wake up when there is no work.
+	/// Timers run on the monotonic clock and are identified by the index returned by addTimer().
+	///   while (terminate == 0)
+	///   {
+	///     reactor.wait();
+	///     if (reactor.readable(fd)) {...}
+	///     if (reactor.expired(timerId)) {...}
+	///   }
+	class Reactor
+	{
+		private:
+			struct timerEntry_t
+			{
+				bool armed;
+				unsigned long long period;    // in milliseconds, 0 for one-shot timer
+				unsigned long long deadline;  // monotonic time in milliseconds
+			};
+			int maxWait;  // in milliseconds, upper bound of a single wait
+			std::vector<struct pollfd> ufds;
+			std::vector<timerEntry_t> timers;
+			unsigned long long wakeupCnt;
+
+		public:
+			Reactor(int maxWait_ = 1000);
+			/// monotonic clock in milliseconds
+			static unsigned long long now(void);
+			/// watch fd for readability
+			void addFd(int fd);
+			/// add a timer which expires first after 'delay' milliseconds, and then every 'period' milliseconds.
+			/// A timer with period 0 is a one-shot timer, it stays disarmed after it expired until armTimer().
+			size_t addTimer(unsigned long long period, unsigned long long delay);
+			/// (re)arm timer 'id' to expire after 'delay' milliseconds
+			void armTimer(size_t id, unsigned long long delay);
+			void disarmTimer(size_t id);
+			bool isArmed(size_t id) const {return(timers[id].armed);};
+			/// block until a watched fd is readable, a timer is due or maxWait elapsed.
+			/// returns the number of readable descriptors, -1 on error (e.g., interrupted by a signal)
+			int wait(void);
+			/// whether fd was readable at the last wait()
+			bool readable(int fd) const;
+			/// returns true once per expiry of timer 'id'. A periodic timer is moved to its next deadline,
+			/// skipping periods missed altogether.
+			bool expired(size_t id);
+			unsigned long long wakeups(void) const {return(wakeupCnt);};
+	};
+}
+
+#endif
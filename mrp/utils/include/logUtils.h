@@ -7,39 +7,85 @@
 #ifndef _LOGFILE_UTILS_H
 #define _LOGFILE_UTILS_H
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <fstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "mlogUtils.h"
+
 namespace logUtils
 {
 	enum class logType {none, simpleLog, detailLog};
 
-	struct Logfile_t
+	/// framed binary log files (see mlogUtils.h), one per channel ('prefix'.'type'.'suffix'.mlog), written by a
+	/// background thread. log() copies a record into a preallocated lock-free ring with the current time and
+	/// returns without any system call. The writer drains the ring every 'flushInterval' milliseconds into
+	/// blocks, a block is written when it is full or holds records for a second, compressed when 'compress_'.
+	/// Rotation (reopen()) is queued in order with the records and done by the writer too.
+	/// log() and reopen() are called from one thread (the main loop of the component). A record that does
+	/// not fit into a full ring is dropped and counted (see dropped()).
+	class Logger
 	{
-		bool isOpened;
-		std::ofstream* OS;
-		std::string prefix;
-		std::string type;
-		std::string suffix;
-		std::string fullname;
-		unsigned long logrows;
-		Logfile_t(std::string prefix_, std::string type_)
-		{
-			isOpened = false;
-			prefix = prefix_;
-			type = type_;
-			logrows = 0;
-		};
+		private:
+			struct channel_t
+			{
+				std::string type;
+				std::string fullname;
+				mlogUtils::Writer* file;
+			};
+			static const uint64_t blockAge = 1000;  // in milliseconds
+			std::string prefix;
+			bool compress;
+			std::vector<channel_t> channels;
+			bool isOpened;
+			std::vector<uint8_t> ring;
+			uint64_t mask;
+			unsigned long long flushInterval;  // in milliseconds
+			/// cursors are 64 bytes apart, so that producer and writer each write their own cache line
+			uint8_t pad0[64];
+			std::atomic<uint64_t> head;     // next byte to be written (producer)
+			uint64_t reserved;              // end of the record being written (producer)
+			uint64_t drops;                 // records dropped (producer)
+			uint8_t pad1[64 - sizeof(std::atomic<uint64_t>) - 2 * sizeof(uint64_t)];
+			std::atomic<uint64_t> tail;     // next byte to be drained (writer)
+			std::atomic<bool> running;
+			std::thread writer;
+
+			/// producer: room for a record body of 'len' bytes, nullptr when the ring is full
+			uint8_t* reserve(uint16_t channel, uint8_t flag, size_t len);
+			/// producer: pass the reserved record to the writer
+			void commit(void) {head.store(reserved, std::memory_order_release);};
+			bool openFiles(const std::string& suffix);
+			void closeFiles(void);
+			void drain(void);
+			void run(void);
+
+		public:
+			/// 'ringSize' bytes of records in flight (rounded up to a power of 2)
+			Logger(const std::string& prefix_, bool compress_ = false, size_t ringSize = (1 << 22), unsigned long long flushInterval_ = 50);
+			~Logger(void);
+			/// add a channel before open(), returns its index to pass to log()
+			size_t addChannel(const std::string& type);
+			/// open the files of all channels and start the writer
+			bool open(const std::string& suffix);
+			bool opened(void) const {return(isOpened);};
+			/// log a message (no-op when not opened), the record flag tells whether it was received or sent
+			void log(size_t channel, const uint8_t* msg, size_t size, bool receive=false);
+			/// log a received message with msOfDay inserted after the first 3 bytes (the MMITSS header
+			/// then has the time the message was received before the time it was sent)
+			void log(size_t channel, const uint8_t* msg, size_t size, uint32_t msOfDay);
+			/// close the current files and open those with 'suffix', after the records logged so far.
+			/// Files without records are removed. Waits for room when the ring is full.
+			void reopen(const std::string& suffix);
+			/// write the remaining records, stop the writer and close the files
+			void close(void);
+			unsigned long long dropped(void) const {return(drops);};
 	};
 
-	bool openLogFiles(std::vector<logUtils::Logfile_t>& filelist, const std::string& suffix);
-	bool reOpenLogFiles(std::vector<logUtils::Logfile_t>& filelist, const std::string& suffix);
-	void closeLogFiles(std::vector<logUtils::Logfile_t>& filelist);
-	void logMsg(std::vector<logUtils::Logfile_t>& filelist, const std::string& type, std::vector<uint8_t>& msg, size_t size, bool receive=false);
-	void logMsg(std::vector<logUtils::Logfile_t>& filelist, const std::string& type, std::vector<uint8_t>& msg, size_t size, uint32_t  msOfDay);
 	void logMsgHex(std::ofstream& OS, const uint8_t* buf, size_t size);
 }
 
@@ -0,0 +1,122 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#ifndef _MLOG_UTILS_H
+#define _MLOG_UTILS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/// framed binary log files (*.mlog), in host byte order (little-endian on the MRP platforms):
+///   file header : magic "MRPMLOG1" (8 bytes), block size (4 bytes), flags (2 bytes, bit 0 = compressed blocks),
+///                 index span (2 bytes)
+///   blocks      : block header (40 bytes) + block body
+///   trailer     : offset of the last index block (8 bytes), magic "MLOGEND1" (8 bytes), written by close()
+/// Block header: magic "MLB1" (4 bytes), kind (2 bytes, 0 = records, 1 = index, 2 = full index), flags (2 bytes, bit 0 =
+/// body is zlib compressed), stored body length (4 bytes), raw body length (4 bytes), number of records or
+/// index entries (4 bytes), unused (4 bytes), timestamps of the first and the last record (8 bytes each).
+/// Records (in the raw body of a record block): timestamp (8 bytes, milliseconds since the epoch),
+/// length (4 bytes), message ID (1 byte, from the MMITSS header, 0 when the message has none),
+/// flag (1 byte, 1 = message received, 0 = message sent), unused (2 bytes), message.
+/// Every 'indexSpan' record blocks an index block is written: offset of the previous index block (8 bytes,
+/// 0 for the first) and, for each record block, timestamps of its first and last record and its offset
+/// (8 bytes each). close() writes a full index block (same layout, all record blocks) that the trailer points to.
+/// Timestamps never decrease within a file, so a reader finds a time by binary search on the index. When the
+/// file was not closed, the reader looks back from the end for the last index block and walks the record
+/// blocks after it.
+namespace mlogUtils
+{
+	struct record_t
+	{
+		uint64_t timestamp;  // milliseconds since the epoch
+		uint8_t  msgid;
+		uint8_t  flag;
+		const uint8_t* msg;
+		size_t   size;
+	};
+
+	class Writer
+	{
+		private:
+			std::FILE* fp;
+			bool compress;
+			size_t blockSize;
+			size_t indexSpan;
+			uint64_t offset;         // end of the file
+			uint64_t lastIndex;      // offset of the last index block, 0 when none
+			uint64_t lastTs;         // timestamp of the last record
+			unsigned long recordNums;
+			std::vector<uint8_t> block;       // raw body of the current record block
+			uint32_t blockRecords;
+			uint64_t blockFirstTs;
+			std::vector<uint64_t> entries;    // index entries of all record blocks
+			size_t pending;                   // entries since the last index block
+			std::vector<uint8_t> packed;      // compressed body
+
+			bool writeBlock(uint16_t kind, const uint8_t* body, size_t len, uint32_t nums, uint64_t firstTs, uint64_t lastTs_);
+			bool writeIndex(uint16_t kind, size_t from);
+
+		public:
+			Writer(void) : fp(NULL), compress(false), blockSize(0), indexSpan(0), offset(0), lastIndex(0), lastTs(0),
+				recordNums(0), blockRecords(0), blockFirstTs(0), pending(0) {};
+			~Writer(void) {close();};
+			/// blocks of 'blockSize' bytes of records, compressed with zlib when 'compress_'
+			bool open(const std::string& fname, bool compress_, size_t blockSize_ = 65536, size_t indexSpan_ = 256);
+			bool isOpened(void) const {return(fp != NULL);};
+			/// append a record, the timestamp is raised to that of the previous record when the clock stepped back
+			void append(uint64_t timestamp, uint8_t flag, const uint8_t* msg, size_t size);
+			/// write the current block if it has records for 'maxAge' milliseconds or more at 'now'
+			void flush(uint64_t now, uint64_t maxAge);
+			/// write the current block, the last index block and the trailer, returns the number of records
+			unsigned long close(void);
+			unsigned long records(void) const {return(recordNums);};
+	};
+
+	/// random access by timestamp to a (memory-mapped) .mlog file
+	class Reader
+	{
+		private:
+			struct index_t
+			{
+				uint64_t firstTs;
+				uint64_t lastTs;
+				uint64_t offset;
+			};
+			const uint8_t* base;
+			size_t fileSize;
+			size_t blockSize;
+			size_t indexSpan;
+			std::vector<index_t> index;   // record blocks in file order
+			size_t curBlock;              // block being read by next()
+			size_t curPos;                // position of the next record in the raw body of curBlock
+			const uint8_t* body;          // raw body of curBlock
+			size_t bodyLen;
+			std::vector<uint8_t> unpacked;
+
+			bool loadIndex(void);
+			bool loadIndexBlock(uint64_t pos, bool chain);
+			bool recoverIndex(void);
+			void walkBlocks(uint64_t pos);
+			bool loadBlock(size_t blk);
+
+		public:
+			Reader(void) : base(NULL), fileSize(0), blockSize(0), indexSpan(0), curBlock(0), curPos(0), body(NULL), bodyLen(0) {};
+			~Reader(void) {close();};
+			bool open(const std::string& fname);
+			void close(void);
+			size_t blocks(void) const {return(index.size());};
+			/// move to the first record with timestamp at or after 'timestamp', false when there is none
+			bool seek(uint64_t timestamp);
+			/// the next record (from the start of the file after open()), false at the end of the file.
+			/// rec.msg is valid until the next call.
+			bool next(record_t& rec);
+	};
+}
+
+#endif
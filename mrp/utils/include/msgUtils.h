@@ -35,6 +35,7 @@ namespace msgUtils
 	static const uint8_t msgid_perm           = 0x61;
 	static const uint8_t msgid_signalraw      = 0x62;
 	static const uint8_t msgid_placecall      = 0x63;
+	static const uint8_t msgid_detAggr        = 0x64;
 	/// message poll request
 	static const uint8_t msgid_pollReq        = 0x80;
 	/// Savari cloud message type
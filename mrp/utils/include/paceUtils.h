@@ -0,0 +1,90 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#ifndef _PACE_UTILS_H
+#define _PACE_UTILS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace paceUtils
+{
+	/// token bucket pacing (virtual scheduling): on average one message every 'interval' milliseconds,
+	/// with up to 'burst' messages back-to-back. Time is the monotonic clock in milliseconds.
+	class TokenBucket
+	{
+		private:
+			unsigned long long interval;   // 0 for no pacing
+			unsigned long long tolerance;  // (burst - 1) * interval
+			unsigned long long tat;        // theoretical arrival time of the next message
+
+		public:
+			TokenBucket(unsigned long long interval_, unsigned long long burst);
+			/// milliseconds until the next message is allowed, 0 when it is allowed now
+			unsigned long long wait(unsigned long long now) const;
+			/// account for a message sent at 'now'
+			void take(unsigned long long now);
+	};
+
+	/// outbound message slot: caches the encoded payload of a message under the version of the content
+	/// it was encoded from, and paces its transmission. A payload is due when the content version changed
+	/// since the last send, or when 'refresh' milliseconds elapsed (periodic re-broadcast of unchanged
+	/// content), and the token bucket allows it. Content versions skipped while pacing are never encoded.
+	///   if (slot.due(now, version))
+	///   {
+	///     if (slot.stale(version)) slot.store(encode(content, slot.payload(), slot.capacity()), version);
+	///     pack header into slot.buf(), send slot.buf() (header + slot.size() bytes of payload);
+	///     slot.sent(now);
+	///   }
+	class TxSlot
+	{
+		public:
+			struct stats_t
+			{
+				unsigned long long encodes;  // payloads stored
+				unsigned long long sends;    // payloads sent
+				unsigned long long reuses;   // sends of a payload that has been sent before
+			};
+
+		private:
+			std::vector<uint8_t> msgbuf;  // header room followed by the encoded payload
+			size_t headroom;
+			size_t payloadSize;
+			bool cached;
+			bool fresh;                   // stored payload not yet sent
+			unsigned long long version;   // content version of the stored payload
+			unsigned long long refresh;   // in milliseconds, 0 for no re-broadcast of unchanged content
+			unsigned long long lastSent;
+			TokenBucket bucket;
+			stats_t stats;
+
+		public:
+			TxSlot(size_t bufSize, size_t headroom_, unsigned long long refresh_,
+				unsigned long long interval, unsigned long long burst);
+			/// whether content 'version_' needs to be encoded, i.e., the cached payload is of another version
+			bool stale(unsigned long long version_) const {return(!cached || (version_ != version));};
+			/// encode the payload into payload(), which holds up to capacity() bytes
+			uint8_t* payload(void) {return(&msgbuf[headroom]);};
+			size_t capacity(void) const {return(msgbuf.size() - headroom);};
+			/// keep the payload of 'size' bytes just encoded from content 'version_'
+			void store(size_t size, unsigned long long version_);
+			/// give up content 'version_' (e.g., failed encoding), nothing is sent until the next version
+			void drop(unsigned long long version_);
+			/// milliseconds until content 'version_' is due, ULLONG_MAX when nothing needs to be sent
+			unsigned long long wait(unsigned long long now, unsigned long long version_) const;
+			bool due(unsigned long long now, unsigned long long version_) const {return(wait(now, version_) == 0);};
+			/// message buffer holding the payload at offset headroom, the header is packed in front of it
+			std::vector<uint8_t>& buf(void) {return(msgbuf);};
+			size_t size(void) const {return(payloadSize);};
+			/// account for the cached payload sent at 'now'
+			void sent(unsigned long long now);
+			const stats_t& getStats(void) const {return(stats);};
+			void resetStats(void) {stats = stats_t{0, 0, 0};};
+	};
+}
+
+#endif
@@ -0,0 +1,91 @@
+//********************************************************************************************************
+//
+// © 2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#ifndef _QUEUE_UTILS_H
+#define _QUEUE_UTILS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace queueUtils
+{
+	/// fixed-capacity lock-free ring connecting three pipeline stages running on at most three threads:
+	/// a producer fills entries, a worker processes them in place, and a consumer takes the processed
+	/// entries. Each stage owns one cursor and only reads the cursors of the other stages, so no stage
+	/// ever waits on a lock. Entries leave the ring in the order they entered.
+	/// - all entries are allocated at construction and reused as they are (e.g., a std::vector member
+	///   keeps its capacity), claim() does not re-initialize the entry;
+	/// - claim() fails when 'capacity' entries have been published and not yet released.
+	/// Producer and consumer may be the same thread.
+	template<class T>
+	class StageRing
+	{
+		private:
+			std::vector<T> slots;
+			uint64_t mask;
+			/// cursors are 64 bytes apart, so that each stage writes its own cache line
+			/// (padding instead of alignas, operator new does not honor extended alignment in C++11)
+			uint8_t pad0[64];
+			std::atomic<uint64_t> head;  // next entry to be published (producer)
+			uint8_t pad1[64 - sizeof(std::atomic<uint64_t>)];
+			std::atomic<uint64_t> done;  // next entry to be processed (worker)
+			uint8_t pad2[64 - sizeof(std::atomic<uint64_t>)];
+			std::atomic<uint64_t> tail;  // next entry to be released (consumer)
+			uint8_t pad3[64 - sizeof(std::atomic<uint64_t>)];
+
+		public:
+			StageRing(size_t capacity_) : mask(0), head(0), done(0), tail(0)
+			{
+				size_t cap = 1;
+				while (cap < capacity_)
+					cap <<= 1;
+				slots.resize(cap);
+				mask = cap - 1;
+			};
+
+			size_t capacity(void) const {return(slots.size());};
+
+			/// producer: entry to fill, nullptr when the ring is full
+			T* claim(void)
+			{
+				uint64_t h = head.load(std::memory_order_relaxed);
+				if (h - tail.load(std::memory_order_acquire) > mask)
+					return(nullptr);
+				return(&slots[h & mask]);
+			};
+			/// producer: hand the claimed entry to the worker
+			void publish(void) {head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);};
+
+			/// worker: oldest published entry not yet processed, nullptr when there is none
+			T* next(void)
+			{
+				uint64_t d = done.load(std::memory_order_relaxed);
+				if (d == head.load(std::memory_order_acquire))
+					return(nullptr);
+				return(&slots[d & mask]);
+			};
+			/// worker: hand the processed entry to the consumer
+			void finish(void) {done.store(done.load(std::memory_order_relaxed) + 1, std::memory_order_release);};
+
+			/// consumer: oldest processed entry, nullptr when it is still published or in process
+			T* ready(void)
+			{
+				uint64_t t = tail.load(std::memory_order_relaxed);
+				if (t == done.load(std::memory_order_acquire))
+					return(nullptr);
+				return(&slots[t & mask]);
+			};
+			/// consumer: return the entry taken by ready() to the producer
+			void release(void) {tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);};
+
+			/// consumer: whether any published entry has not been released yet
+			bool pending(void) const {return(tail.load(std::memory_order_relaxed) != head.load(std::memory_order_acquire));};
+	};
+}
+
+#endif
@@ -0,0 +1,93 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#ifndef _SHM_UTILS_H
+#define _SHM_UTILS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace shmUtils
+{
+	/// shared-memory message rings between MRP processes on the same host.
+	/// A segment (POSIX shared memory '/mrp_ring_<port>') belongs to the receiving end of a link and holds
+	/// maxLanes single-producer/single-consumer rings. Each sending process claims a lane of its own, so
+	/// that several processes can send to the same receiver (e.g., MRP_TCI and MRP_Aware to MRP_DataMgr).
+	/// Messages are length-prefixed records copied in and out of the lane, no system call is involved.
+	/// The receiver arms the segment before it goes to sleep, the next sender then rings the doorbell
+	/// (a zero-length UDP datagram to the receiver's socket, which the receiver is polling anyway).
+	/// An all-zero segment is an empty one, whichever side comes first creates it. The receiving end
+	/// unlinks the segment when it detaches. Senders then send on the socket, and attach to the segment
+	/// of the next receiver once it has created one.
+	/// When a lane is full, the sender sends on the socket instead (spills). It keeps sending on the socket
+	/// until the receiver has drained the socket past the last spilled message, so that a message pushed
+	/// into the lane is never received ahead of a message spilled before it.
+	class MsgRing
+	{
+		public:
+			static const size_t maxLanes = 4;
+			static const size_t laneBytes = 64 * 1024;  // power of two
+
+		private:
+			struct lane_t
+			{
+				uint32_t owner;                // pid of the sending process, 0 when free
+				alignas(64) uint64_t head;     // bytes written, advanced by the sender
+				uint64_t spilled;              // messages sent on the socket, counted by the sender
+				alignas(64) uint64_t tail;     // bytes read, advanced by the receiver
+				uint64_t settled;              // spilled messages the receiver has drained the socket past
+				alignas(64) uint8_t data[laneBytes];
+			};
+			struct segment_t
+			{
+				alignas(64) uint32_t armed;    // receiver is waiting for a doorbell
+				uint32_t receiver;             // pid of the receiving process, 0 when none
+				uint32_t closed;               // unlinked by the receiver, senders attach again
+				lane_t lanes[maxLanes];
+			};
+			segment_t* seg;
+			lane_t* lane;                    // lane claimed by the sender, NULL on the receiving end
+			size_t next;                     // lane the receiver visits first, for fairness
+			std::string name;                // shared memory object name
+			bool sending;                    // attached as a sender
+			uint64_t carried;                // sender: spills not yet settled when the lane was lost
+			unsigned long long retryAt;      // sender: monotonic time in milliseconds to look for the next receiver
+			uint64_t marks[maxLanes];        // receiver: spilled counts read by markSpills()
+
+			/// map the segment 'name' (create it when 'create'), and claim a lane when 'sender'
+			bool map(bool sender, bool create);
+
+		public:
+			MsgRing(void) : seg(NULL), lane(NULL), next(0), sending(false), carried(0), retryAt(0), marks() {};
+			~MsgRing(void) {MsgRing::detach();};
+			/// map the segment of 'port', and claim a lane when 'sender'
+			bool attach(const std::string& port, bool sender);
+			/// unmap the segment, the receiving end also unlinks it
+			void detach(void);
+			bool isAttached(void) const {return(seg != NULL);};
+			/// whether the other end is attached: the receiver for a sender, any sender for the receiver
+			bool peerAttached(void) const;
+			/// sender: copy a message into the lane, returns false when the lane is full
+			bool push(const uint8_t* buf, size_t len);
+			/// sender: whether the receiver needs a doorbell for the messages pushed so far (disarms it)
+			bool needDoorbell(void);
+			/// sender: whether messages spilled to the socket may still be unread, send on the socket meanwhile
+			bool spilling(void) const;
+			/// sender: account for 'n' messages sent on the socket (after they were sent)
+			void spill(size_t n);
+			/// receiver: copy the next message into buf (truncated to size), returns its length, 0 when empty
+			size_t pop(uint8_t* buf, size_t size);
+			/// receiver: arm the doorbell before going to sleep, returns false when a message arrived meanwhile
+			bool arm(void);
+			/// receiver: read the spilled counts before draining the lanes and the socket, and settle them
+			/// once both have been drained: every message spilled before markSpills() has then been received
+			void markSpills(void);
+			void settleSpills(void);
+	};
+}
+
+#endif
@@ -10,7 +10,9 @@
 #include <cstddef>
 #include <cstdint>
 #include <string>
+#include <vector>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 namespace socketUtils
 {
@@ -26,14 +28,14 @@ namespace socketUtils
 	{
 		std::string id;       // destination OR source
 		std::string role;     // server OR client
-		std::string protocol; // UDP OR TCP
+		std::string protocol; // UDP, TCP OR SHM
 		std::string name;     // hostname OR IP address
 		std::string port;     // port number
 		socketUtils::Conn_t conn;
 		bool valid(void)
 		{
 			return(!id.empty() && !role.empty() && !protocol.empty() && !name.empty()
-				&& !port.empty() && ((protocol == "UDP") || (protocol == "TCP")));
+				&& !port.empty() && ((protocol == "UDP") || (protocol == "TCP") || (protocol == "SHM")));
 		};
 		void reset(void)
 		{
@@ -47,9 +49,50 @@ namespace socketUtils
 	};
 
 	bool setAddress(const std::string& str, socketUtils::Address_t& addr);
+	/// protocol "SHM" creates a UDP socket as "UDP" does, and attaches it to the shared-memory message ring
+	/// of the port (see shmUtils.h). sendall() and DgramBatch then carry messages through the ring, and
+	/// the UDP socket only carries doorbells, and messages that did not fit into a full ring. After such a
+	/// spill, messages keep going out on the socket until the receiver has read the spilled ones, so that
+	/// they arrive in the order sent. The receiving end unlinks the ring when the socket is destroyed.
 	bool create(socketUtils::Address_t& addr);
 	bool sendall(socketUtils::Conn_t conn, const uint8_t* buf, size_t len);
 	bool destroy(int fid);
+
+	/// fixed set of datagram buffers, filled by one recvmmsg() call or by add() and sent with one sendmmsg() call.
+	/// On an SHM socket, messages are taken from and put into the shared-memory ring first.
+	/// Use separate instances for receiving and sending.
+	class DgramBatch
+	{
+		private:
+			size_t bufSize;
+			size_t cnt;  // number of datagrams held
+			size_t cur;  // datagram being visited by next()
+			std::vector< std::vector<uint8_t> > bufs;
+			std::vector<size_t> lens;
+			std::vector<struct iovec> iovs;
+			std::vector<struct mmsghdr> msgs;
+			std::vector<struct sockaddr_storage> names;  // source addresses of received datagrams
+
+		public:
+			DgramBatch(size_t capacity_, size_t bufSize_);
+			size_t capacity(void) const {return(bufs.size());};
+			size_t size(void) const {return(cnt);};
+			/// receive up to capacity() datagrams without blocking, returns the number received
+			size_t recv(int fd);
+			/// visit pending datagrams on fd one by one, receiving another batch when the current one is used up:
+			///   while (batch.next(fd)) {process batch.buf() and batch.len()}
+			/// returns false once the socket is drained. Do not break out of the loop, it must reach false.
+			bool next(int fd);
+			std::vector<uint8_t>& buf(void) {return(bufs[cur]);};
+			size_t len(void) const {return(lens[cur]);};
+			/// connection to reply to the sender of the datagram visited by next() on fd, false when the
+			/// sender is unknown (e.g., the datagram came through a shared-memory ring)
+			bool source(int fd, socketUtils::Conn_t& conn) const;
+			/// queue a datagram for conn, flushes first when the batch is full
+			bool add(socketUtils::Conn_t conn, const uint8_t* buf, size_t len);
+			/// send all queued datagrams to conn
+			bool flush(socketUtils::Conn_t conn);
+	};
 }
 
 #endif
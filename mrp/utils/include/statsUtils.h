@@ -0,0 +1,117 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#ifndef _STATS_UTILS_H
+#define _STATS_UTILS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace statsUtils
+{
+	/// count, mean and variance of a sample stream in one pass (Welford), mergeable (Chan et al.)
+	struct moments_t
+	{
+		uint32_t count;
+		double mean;
+		double m2;    // sum of squared differences from the mean
+		void reset(void)
+		{
+			count = 0;
+			mean = 0.0;
+			m2 = 0.0;
+		};
+		void add(double x);
+		void merge(const moments_t& other);
+		/// population variance and standard deviation
+		double variance(void) const {return((count > 0) ? m2 / (double)count : 0.0);};
+		double stddev(void) const;
+	};
+
+	/// histogram of non-negative integer values with log-linear bins: values below 16 have a bin of
+	/// their own, larger values share 8 bins per power of two (quantiles are within 1/16 of the value),
+	/// up to maxValue (larger values are counted as maxValue). Memory is fixed, histograms are mergeable.
+	class Histogram
+	{
+		public:
+			static const uint32_t maxValue = UINT16_MAX;
+			static const size_t binNums = 16 + 12 * 8;
+
+		private:
+			uint16_t bins[binNums];  // saturating counts
+			uint32_t total;
+
+			static size_t binOf(uint32_t value);
+			static uint32_t valueOf(size_t bin);  // middle of the values sharing the bin
+
+		public:
+			Histogram(void) {reset();};
+			void reset(void);
+			void add(uint32_t value);
+			void merge(const Histogram& other);
+			uint32_t count(void) const {return(total);};
+			/// value at quantile q (0..1), 0 when the histogram is empty
+			uint32_t quantile(double q) const;
+	};
+
+	/// sliding-window statistics as a ring of 'bucketNums' buckets of T, each covering 'bucketLen'
+	/// milliseconds of the monotonic clock. Samples go into the bucket of the current time, a window
+	/// merges the last completed buckets. T provides reset(). Memory is fixed whatever the sample rate.
+	template<class T>
+	class WindowRing
+	{
+		private:
+			std::vector<T> buckets;
+			unsigned long long bucketLen;  // in milliseconds
+			unsigned long long curIdx;     // index of the current bucket since the epoch
+
+			/// move the current bucket to now, resetting the buckets skipped
+			void advance(unsigned long long now)
+			{
+				unsigned long long idx = now / bucketLen;
+				if (idx <= curIdx)
+					return;
+				unsigned long long steps = idx - curIdx;
+				if (steps > buckets.size())
+					steps = buckets.size();
+				for (unsigned long long i = idx - steps + 1; i <= idx; i++)
+					buckets[i % buckets.size()].reset();
+				curIdx = idx;
+			};
+
+		public:
+			WindowRing(size_t bucketNums, unsigned long long bucketLen_, unsigned long long now)
+				: buckets(bucketNums), bucketLen(bucketLen_), curIdx(now / bucketLen_)
+			{
+				for (auto& bucket : buckets)
+					bucket.reset();
+			};
+
+			unsigned long long span(void) const {return(bucketLen * buckets.size());};
+			/// bucket to add samples received at 'now'
+			T& at(unsigned long long now)
+			{
+				advance(now);
+				return(buckets[curIdx % buckets.size()]);
+			};
+			/// calls f(bucket) for the window / bucketLen completed buckets before the bucket of 'now' (at most
+			/// all buckets but the current one). Windows taken at consecutive multiples of 'window' (a multiple
+			/// of bucketLen) are back to back, no sample is counted twice
+			template<class F>
+			void window(unsigned long long now, unsigned long long window, F f)
+			{
+				advance(now);
+				unsigned long long nums = window / bucketLen;
+				if (nums > buckets.size() - 1)
+					nums = buckets.size() - 1;
+				for (unsigned long long i = 1; i <= nums; i++)
+					f(static_cast<const T&>(buckets[(curIdx - i) % buckets.size()]));
+			};
+	};
+}
+
+#endif
@@ -0,0 +1,299 @@
+//********************************************************************************************************
+//
+// © 2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#ifndef _TABLE_UTILS_H
+#define _TABLE_UTILS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tableUtils
+{
+	/// fixed-capacity table of T keyed by a uint32_t identifier (e.g., BSM TemporaryID).
+	/// - all slots are allocated at construction. An entry never moves while it is in the table,
+	///   so pointers returned by find() and insert() remain valid until the entry is erased;
+	/// - key lookup goes through an open-addressing hash index (linear probing with backward-shift
+	///   deletion), the cost of find/insert/erase does not depend on the number of entries;
+	/// - live entries are also kept in a dense list, iteration visits only live entries;
+	/// - insert fails when the table already holds 'capacity' entries.
+	/// Slots are reused as they are, insert() does not re-initialize the entry.
+	template<class T>
+	class KeyedTable
+	{
+		private:
+			static const uint32_t emptyBucket = 0xFFFFFFFF;
+			std::vector<T> slots;
+			std::vector<uint32_t> slotKeys;   // key of the entry held in each slot
+			std::vector<uint32_t> slotPos;    // position of each slot in liveSlots
+			std::vector<uint32_t> liveSlots;  // slot indexes of live entries
+			std::vector<uint32_t> freeSlots;  // stack of free slot indexes
+			std::vector<uint32_t> buckets;    // hash index, holds slot index or emptyBucket
+			uint32_t mask;
+			int shift;
+
+			uint32_t home(uint32_t key) const
+				{return((uint32_t)((key * 2654435769U) >> shift) & mask);};
+			uint32_t locate(uint32_t key) const
+			{ /// returns bucket holding key, or the empty bucket ending the probe sequence
+				uint32_t i = home(key);
+				while ((buckets[i] != emptyBucket) && (slotKeys[buckets[i]] != key))
+					i = (i + 1) & mask;
+				return(i);
+			};
+			void removeBucket(uint32_t i)
+			{ /// backward-shift deletion keeps probe sequences intact without tombstones
+				uint32_t j = i;
+				while (1)
+				{
+					j = (j + 1) & mask;
+					if (buckets[j] == emptyBucket)
+						break;
+					uint32_t k = home(slotKeys[buckets[j]]);
+					if (((j > i) && ((k <= i) || (k > j))) || ((j < i) && (k <= i) && (k > j)))
+					{
+						buckets[i] = buckets[j];
+						i = j;
+					}
+				}
+				buckets[i] = emptyBucket;
+			};
+
+		public:
+			template<class V, class P>
+			class iterator_t
+			{
+				private:
+					V* base;
+					P  pos;
+				public:
+					iterator_t(V* base_, P pos_) : base(base_), pos(pos_) {};
+					V& operator*(void) const {return(base[*pos]);};
+					V* operator->(void) const {return(&base[*pos]);};
+					iterator_t& operator++(void) {++pos; return(*this);};
+					bool operator==(const iterator_t& p) const {return(pos == p.pos);};
+					bool operator!=(const iterator_t& p) const {return(pos != p.pos);};
+			};
+			typedef iterator_t<T, std::vector<uint32_t>::const_iterator> iterator;
+			typedef iterator_t<const T, std::vector<uint32_t>::const_iterator> const_iterator;
+
+			KeyedTable(size_t capacity_)
+			{
+				size_t bucketNums = 2;
+				shift = 31;
+				while (bucketNums < 2 * capacity_)
+				{
+					bucketNums <<= 1;
+					shift--;
+				}
+				mask = (uint32_t)(bucketNums - 1);
+				slots.resize(capacity_);
+				slotKeys.assign(capacity_, 0);
+				slotPos.assign(capacity_, 0);
+				liveSlots.reserve(capacity_);
+				freeSlots.resize(capacity_);
+				for (size_t i = 0; i < capacity_; i++)
+					freeSlots[i] = (uint32_t)(capacity_ - 1 - i);
+				buckets.assign(bucketNums, emptyBucket);
+			};
+
+			size_t size(void) const {return(liveSlots.size());};
+			size_t capacity(void) const {return(slots.size());};
+			bool   empty(void) const {return(liveSlots.empty());};
+			bool   full(void) const {return(freeSlots.empty());};
+
+			T* find(uint32_t key)
+			{
+				uint32_t i = locate(key);
+				return((buckets[i] == emptyBucket) ? nullptr : &slots[buckets[i]]);
+			};
+			const T* find(uint32_t key) const
+			{
+				uint32_t i = locate(key);
+				return((buckets[i] == emptyBucket) ? nullptr : &slots[buckets[i]]);
+			};
+
+			/// returns nullptr when key is already in the table or the table is full
+			T* insert(uint32_t key)
+			{
+				uint32_t i = locate(key);
+				if ((buckets[i] != emptyBucket) || freeSlots.empty())
+					return(nullptr);
+				uint32_t slot = freeSlots.back();
+				freeSlots.pop_back();
+				slotKeys[slot] = key;
+				slotPos[slot] = (uint32_t)liveSlots.size();
+				liveSlots.push_back(slot);
+				buckets[i] = slot;
+				return(&slots[slot]);
+			};
+
+			bool erase(uint32_t key)
+			{
+				uint32_t i = locate(key);
+				if (buckets[i] == emptyBucket)
+					return(false);
+				uint32_t slot = buckets[i];
+				removeBucket(i);
+				/// move the last live entry into the vacated position of the dense list
+				uint32_t pos = slotPos[slot];
+				liveSlots[pos] = liveSlots.back();
+				slotPos[liveSlots[pos]] = pos;
+				liveSlots.pop_back();
+				freeSlots.push_back(slot);
+				return(true);
+			};
+
+			/// erase all entries for which pred(entry) is true, returns number of erased entries
+			template<class Pred>
+			size_t erase_if(Pred pred)
+			{
+				size_t cnt = 0;
+				for (size_t pos = liveSlots.size(); pos > 0; pos--)
+				{ /// backwards so that the entry moved into pos - 1 by erase has already been visited
+					uint32_t slot = liveSlots[pos - 1];
+					if (pred(slots[slot]))
+					{
+						erase(slotKeys[slot]);
+						cnt++;
+					}
+				}
+				return(cnt);
+			};
+
+			void clear(void)
+			{
+				for (auto slot : liveSlots)
+					freeSlots.push_back(slot);
+				liveSlots.clear();
+				buckets.assign(buckets.size(), emptyBucket);
+			};
+
+			/// slot handles (0..capacity-1) identify entries for TimerWheel
+			uint32_t slotOf(const T* entry) const {return((uint32_t)(entry - slots.data()));};
+			uint32_t keyOf(uint32_t slot) const {return(slotKeys[slot]);};
+			bool isLive(uint32_t slot) const
+				{return((slot < slots.size()) && (slotPos[slot] < liveSlots.size()) && (liveSlots[slotPos[slot]] == slot));};
+
+			iterator begin(void) {return(iterator(slots.data(), liveSlots.cbegin()));};
+			iterator end(void) {return(iterator(slots.data(), liveSlots.cend()));};
+			const_iterator begin(void) const {return(const_iterator(slots.data(), liveSlots.cbegin()));};
+			const_iterator end(void) const {return(const_iterator(slots.data(), liveSlots.cend()));};
+	};
+
+	template<class T>
+	const uint32_t KeyedTable<T>::emptyBucket;
+
+	/// hashed timing wheel over a fixed set of handles (e.g., KeyedTable slots).
+	/// - each handle has at most one pending deadline, schedule() replaces the previous one;
+	/// - schedule() and cancel() unlink/link a handle in O(1);
+	/// - expire() walks only the buckets of ticks that have fully elapsed since its last call,
+	///   a handle fires at most one tick after its deadline.
+	/// Deadlines beyond the wheel span stay in their bucket until the matching rotation.
+	class TimerWheel
+	{
+		private:
+			enum : uint32_t {npos = 0xFFFFFFFF};
+			unsigned long long tick;     // in milliseconds
+			unsigned long long curTick;  // the first tick not processed yet
+			uint32_t mask;
+			size_t scheduled;
+			std::vector<uint32_t> heads;
+			std::vector<uint32_t> next;
+			std::vector<uint32_t> prev;
+			std::vector<uint32_t> bucket;  // bucket holding each handle, npos when not scheduled
+			std::vector<unsigned long long> deadline;
+
+			void unlink(uint32_t h)
+			{
+				if (prev[h] != npos)
+					next[prev[h]] = next[h];
+				else
+					heads[bucket[h]] = next[h];
+				if (next[h] != npos)
+					prev[next[h]] = prev[h];
+				bucket[h] = npos;
+				scheduled--;
+			};
+
+		public:
+			TimerWheel(size_t handles, unsigned long long span_msec, unsigned long long tick_msec, unsigned long long now_msec)
+			{
+				tick = (tick_msec > 0) ? tick_msec : 1;
+				curTick = now_msec / tick;
+				size_t bucketNums = 2;
+				while (bucketNums * tick <= span_msec)
+					bucketNums <<= 1;
+				mask = (uint32_t)(bucketNums - 1);
+				scheduled = 0;
+				heads.assign(bucketNums, npos);
+				next.assign(handles, npos);
+				prev.assign(handles, npos);
+				bucket.assign(handles, npos);
+				deadline.assign(handles, 0);
+			};
+
+			size_t size(void) const {return(scheduled);};
+
+			void schedule(uint32_t h, unsigned long long expire_msec)
+			{
+				if (bucket[h] != npos)
+					unlink(h);
+				unsigned long long t = expire_msec / tick;
+				if (t < curTick)
+					t = curTick;
+				uint32_t b = (uint32_t)(t & mask);
+				deadline[h] = expire_msec;
+				bucket[h] = b;
+				prev[h] = npos;
+				next[h] = heads[b];
+				if (heads[b] != npos)
+					prev[heads[b]] = h;
+				heads[b] = h;
+				scheduled++;
+			};
+
+			void cancel(uint32_t h)
+			{
+				if (bucket[h] != npos)
+					unlink(h);
+			};
+
+			/// calls onExpire(handle) for every handle whose deadline is within the elapsed ticks,
+			/// returns number of expired handles. onExpire must not schedule or cancel other handles.
+			template<class F>
+			size_t expire(unsigned long long now_msec, F onExpire)
+			{
+				unsigned long long nowTick = now_msec / tick;
+				if (nowTick <= curTick)
+					return(0);
+				size_t cnt = 0;
+				unsigned long long ticks = nowTick - curTick;
+				if (ticks > (unsigned long long)mask + 1)
+					ticks = (unsigned long long)mask + 1;
+				unsigned long long expireTick = nowTick - 1;  // last fully elapsed tick
+				for (unsigned long long t = nowTick - ticks; t < nowTick; t++)
+				{
+					uint32_t h = heads[(uint32_t)(t & mask)];
+					while (h != npos)
+					{
+						uint32_t h_next = next[h];
+						if (deadline[h] / tick <= expireTick)
+						{
+							unlink(h);
+							onExpire(h);
+							cnt++;
+						}
+						h = h_next;
+					}
+				}
+				curTick = nowTick;
+				return(cnt);
+			};
+	};
+}
+
+#endif
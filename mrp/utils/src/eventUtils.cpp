@@ -0,0 +1,99 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#include <ctime>
+
+#include "eventUtils.h"
+
+eventUtils::Reactor::Reactor(int maxWait_)
+{
+	maxWait = (maxWait_ > 0) ? maxWait_ : 1000;
+	wakeupCnt = 0;
+}
+
+unsigned long long eventUtils::Reactor::now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return((unsigned long long)ts.tv_sec * 1000 + (unsigned long long)(ts.tv_nsec / 1000000));
+}
+
+void eventUtils::Reactor::addFd(int fd)
+{
+	struct pollfd ufd;
+	ufd.fd = fd;
+	ufd.events = POLLIN;
+	ufd.revents = 0;
+	ufds.push_back(ufd);
+}
+
+size_t eventUtils::Reactor::addTimer(unsigned long long period, unsigned long long delay)
+{
+	timerEntry_t timer{true, period, now() + delay};
+	timers.push_back(timer);
+	return(timers.size() - 1);
+}
+
+void eventUtils::Reactor::armTimer(size_t id, unsigned long long delay)
+{
+	timers[id].armed = true;
+	timers[id].deadline = now() + delay;
+}
+
+void eventUtils::Reactor::disarmTimer(size_t id)
+	{timers[id].armed = false;}
+
+int eventUtils::Reactor::wait(void)
+{
+	unsigned long long msec = now();
+	int timeout = maxWait;
+	for (const auto& timer : timers)
+	{
+		if (!timer.armed)
+			continue;
+		if (timer.deadline <= msec)
+		{
+			timeout = 0;
+			break;
+		}
+		if (timer.deadline - msec < (unsigned long long)timeout)
+			timeout = (int)(timer.deadline - msec);
+	}
+	for (auto& ufd : ufds)
+		ufd.revents = 0;
+	int retval = poll(ufds.empty() ? NULL : &ufds[0], (nfds_t)ufds.size(), timeout);
+	wakeupCnt++;
+	return(retval);
+}
+
+bool eventUtils::Reactor::readable(int fd) const
+{
+	for (const auto& ufd : ufds)
+	{
+		if (ufd.fd == fd)
+			return((ufd.revents & POLLIN) == POLLIN);
+	}
+	return(false);
+}
+
+bool eventUtils::Reactor::expired(size_t id)
+{
+	timerEntry_t& timer = timers[id];
+	if (!timer.armed)
+		return(false);
+	unsigned long long msec = now();
+	if (msec < timer.deadline)
+		return(false);
+	if (timer.period == 0)
+		timer.armed = false;
+	else
+	{
+		timer.deadline += timer.period;
+		if (timer.deadline <= msec)
+			timer.deadline = msec + timer.period;
+	}
+	return(true);
+}
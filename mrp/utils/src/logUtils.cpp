@@ -4,95 +4,225 @@
 //       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
 //
 //*********************************************************************************************************
-#include <algorithm>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 
 #include "logUtils.h"
 
-bool logUtils::openLogFiles(std::vector<logUtils::Logfile_t>& filelist, const std::string& suffix)
+namespace
 {
-	bool has_error = false;
-	for (auto& log : filelist)
+	/// record in the ring: length of the record body (4 bytes), channel (2 bytes), flag (1 byte), unused (1 byte),
+	/// timestamp (8 bytes, milliseconds since the epoch), body
+	const size_t recordHeader = 16;
+	const uint32_t wrapMarker = 0xFFFFFFFF;  // record length telling the rest of the ring is unused
+	const uint16_t rotateChannel = 0xFFFF;   // record body is the suffix of the files to reopen
+
+	size_t recordSize(size_t len)
+		{return((recordHeader + len + 7) & ~((size_t)7));}
+
+	uint64_t epochMsec(void)
 	{
-		log.OS = new std::ofstream();
-		log.logrows = 0;
-		log.suffix = suffix;
-		log.fullname = log.prefix + std::string(".") + log.type + std::string(".")  + suffix;
-		log.OS->open(log.fullname, std::ofstream::out | std::ofstream::binary);
-		log.isOpened = log.OS->is_open();
-		if (!log.isOpened)
-		{
-			has_error = true;
-			delete log.OS;
-			break;
-		}
+		return((uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count());
 	}
-	return(!has_error);
 }
 
-bool logUtils::reOpenLogFiles(std::vector<logUtils::Logfile_t>& filelist, const std::string& suffix)
+logUtils::Logger::Logger(const std::string& prefix_, bool compress_, size_t ringSize, unsigned long long flushInterval_)
+	: prefix(prefix_), compress(compress_), isOpened(false), mask(0), flushInterval(flushInterval_), head(0), reserved(0), drops(0),
+		tail(0), running(false)
+{
+	size_t cap = 1024;
+	while (cap < ringSize)
+		cap <<= 1;
+	ring.assign(cap, 0);
+	mask = cap - 1;
+}
+
+logUtils::Logger::~Logger(void)
+	{close();}
+
+size_t logUtils::Logger::addChannel(const std::string& type)
+{
+	channel_t channel;
+	channel.type = type;
+	channel.file = nullptr;
+	channels.push_back(channel);
+	return(channels.size() - 1);
+}
+
+bool logUtils::Logger::openFiles(const std::string& suffix)
 {
 	bool has_error = false;
-	for (auto& log : filelist)
+	for (auto& channel : channels)
 	{
-		if (log.isOpened)
-		{
-			log.OS->close();
-			if (log.logrows == 0)
-				std::remove(log.fullname.c_str());
-			delete log.OS;
-		}
-		log.OS = new std::ofstream();
-		log.logrows = 0;
-		log.suffix = suffix;
-		log.fullname = log.prefix + std::string(".") + log.type + std::string(".")  + suffix;
-		log.OS->open(log.fullname, std::ofstream::out | std::ofstream::binary);
-		log.isOpened = log.OS->is_open();
-		if (!log.isOpened)
+		channel.fullname = prefix + std::string(".") + channel.type + std::string(".") + suffix + std::string(".mlog");
+		channel.file = new mlogUtils::Writer();
+		if (!channel.file->open(channel.fullname, compress))
 		{
 			has_error = true;
-			delete log.OS;
+			delete channel.file;
+			channel.file = nullptr;
 		}
 	}
 	return(!has_error);
 }
 
-void logUtils::closeLogFiles(std::vector<logUtils::Logfile_t>& filelist)
+void logUtils::Logger::closeFiles(void)
 {
-	for (auto& log : filelist)
+	for (auto& channel : channels)
 	{
-		if (log.isOpened)
-		{
-			log.OS->close();
-			if (log.logrows == 0)
-				std::remove(log.fullname.c_str());
-			delete log.OS;
-		}
+		if (channel.file == nullptr)
+			continue;
+		if (channel.file->close() == 0)
+			std::remove(channel.fullname.c_str());
+		delete channel.file;
+		channel.file = nullptr;
+	}
+}
+
+bool logUtils::Logger::open(const std::string& suffix)
+{
+	close();
+	if (!openFiles(suffix))
+	{
+		closeFiles();
+		return(false);
 	}
+	isOpened = true;
+	running.store(true);
+	writer = std::thread(&logUtils::Logger::run, this);
+	return(true);
 }
 
-void logUtils::logMsg(std::vector<logUtils::Logfile_t>& filelist, const std::string& type, std::vector<uint8_t>& msg, size_t size, bool receive /*=false*/)
+void logUtils::Logger::close(void)
 {
-	auto it = std::find_if(filelist.begin(), filelist.end(), [&type](Logfile_t& log){return(log.type == type);});
-	if ((it != filelist.end()) && (it->isOpened))
+	if (!isOpened)
+		return;
+	running.store(false);
+	if (writer.joinable())
+		writer.join();
+	closeFiles();
+	isOpened = false;
+}
+
+uint8_t* logUtils::Logger::reserve(uint16_t channel, uint8_t flag, size_t len)
+{
+	size_t rec = recordSize(len);
+	uint64_t h = head.load(std::memory_order_relaxed);
+	uint64_t t = tail.load(std::memory_order_acquire);
+	size_t pos = (size_t)(h & mask);
+	size_t skip = (ring.size() - pos < rec) ? ring.size() - pos : 0;  // record does not fit before the end of the ring
+	if (h + skip + rec - t > ring.size())
+		return(nullptr);
+	if (skip > 0)
 	{
-		char flag = receive ? 1 : 0;
-		it->OS->write(&flag, 1);
-		it->OS->write((char *)&msg[0], size);
-		*(it->OS) << std::endl;
-		(it->logrows)++;
+		std::memcpy(&ring[pos], &wrapMarker, sizeof(wrapMarker));
+		pos = 0;
 	}
+	uint32_t len32 = (uint32_t)len;
+	std::memcpy(&ring[pos], &len32, sizeof(len32));
+	std::memcpy(&ring[pos + sizeof(len32)], &channel, sizeof(channel));
+	ring[pos + 6] = flag;
+	uint64_t timestamp = epochMsec();
+	std::memcpy(&ring[pos + 8], &timestamp, sizeof(timestamp));
+	reserved = h + skip + rec;
+	return(&ring[pos + recordHeader]);
 }
 
-void logUtils::logMsg(std::vector<logUtils::Logfile_t>& filelist, const std::string& type, std::vector<uint8_t>& msg, size_t size, uint32_t  msOfDay)
-{ /// add message received msOfDay before message sent msOfDay
-	std::vector<uint8_t> timestampe(4);
+void logUtils::Logger::log(size_t channel, const uint8_t* msg, size_t size, bool receive /*=false*/)
+{
+	if (!isOpened || (channel >= channels.size()))
+		return;
+	uint8_t* p = reserve((uint16_t)channel, receive ? 1 : 0, size);
+	if (p == nullptr)
+	{
+		drops++;
+		return;
+	}
+	std::memcpy(p, msg, size);
+	commit();
+}
+
+void logUtils::Logger::log(size_t channel, const uint8_t* msg, size_t size, uint32_t msOfDay)
+{
+	if (!isOpened || (channel >= channels.size()))
+		return;
+	uint8_t* p = reserve((uint16_t)channel, 1, size + 4);
+	if (p == nullptr)
+	{
+		drops++;
+		return;
+	}
+	size_t split = (size < 3) ? size : 3;
+	std::memcpy(p, msg, split);
 	for (int i = 0; i < 4; i++)
-		timestampe[i] = (uint8_t)((msOfDay >> (3-i)*8) & 0xFF);
-	msg.insert(msg.begin() + 3, timestampe.begin(), timestampe.end());
-	logUtils::logMsg(filelist, type, msg, size + 4, true);
+		p[split + i] = (uint8_t)((msOfDay >> (3 - i) * 8) & 0xFF);
+	std::memcpy(p + split + 4, msg + split, size - split);
+	commit();
+}
+
+void logUtils::Logger::reopen(const std::string& suffix)
+{
+	if (!isOpened)
+		return;
+	uint8_t* p;
+	while ((p = reserve(rotateChannel, 0, suffix.size())) == nullptr)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	std::memcpy(p, suffix.c_str(), suffix.size());
+	commit();
+}
+
+void logUtils::Logger::drain(void)
+{
+	uint64_t t = tail.load(std::memory_order_relaxed);
+	uint64_t h = head.load(std::memory_order_acquire);
+	while (t < h)
+	{
+		size_t pos = (size_t)(t & mask);
+		uint32_t len32;
+		std::memcpy(&len32, &ring[pos], sizeof(len32));
+		if (len32 == wrapMarker)
+		{
+			t += ring.size() - pos;
+			continue;
+		}
+		uint16_t channel;
+		std::memcpy(&channel, &ring[pos + sizeof(len32)], sizeof(channel));
+		const uint8_t* body = &ring[pos + recordHeader];
+		if (channel == rotateChannel)
+		{
+			closeFiles();
+			openFiles(std::string(reinterpret_cast<const char*>(body), len32));
+		}
+		else if ((channel < channels.size()) && (channels[channel].file != nullptr))
+		{
+			uint64_t timestamp;
+			std::memcpy(&timestamp, &ring[pos + 8], sizeof(timestamp));
+			channels[channel].file->append(timestamp, ring[pos + 6], body, len32);
+		}
+		t += recordSize(len32);
+	}
+	tail.store(t, std::memory_order_release);
+	/// write blocks that hold records for a second, so that files lag behind by a second at most
+	uint64_t now = epochMsec();
+	for (auto& channel : channels)
+	{
+		if (channel.file != nullptr)
+			channel.file->flush(now, blockAge);
+	}
+}
+
+void logUtils::Logger::run(void)
+{
+	while (running.load(std::memory_order_relaxed))
+	{
+		drain();
+		std::this_thread::sleep_for(std::chrono::milliseconds(flushInterval));
+	}
+	drain();
 }
 
 void logUtils::logMsgHex(std::ofstream& OS, const uint8_t* buf, size_t size)
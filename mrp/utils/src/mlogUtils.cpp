@@ -0,0 +1,385 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "mlogUtils.h"
+
+namespace
+{
+	const char fileMagic[8]  = {'M', 'R', 'P', 'M', 'L', 'O', 'G', '1'};
+	const char endMagic[8]   = {'M', 'L', 'O', 'G', 'E', 'N', 'D', '1'};
+	const char blockMagic[4] = {'M', 'L', 'B', '1'};
+	const size_t fileHeaderSize = 16;
+	const size_t trailerSize = 16;
+	const size_t blockHeaderSize = 40;
+	const size_t recordHeaderSize = 16;
+	const uint16_t kindRecords = 0;
+	const uint16_t kindIndex = 1;
+	const uint16_t kindFullIndex = 2;
+	const uint16_t flagCompressed = 1;
+
+	template<class T>
+	void put(uint8_t* p, T value)
+		{std::memcpy(p, &value, sizeof(T));}
+
+	template<class T>
+	T get(const uint8_t* p)
+	{
+		T value;
+		std::memcpy(&value, p, sizeof(T));
+		return(value);
+	}
+
+	struct blockHeader_t
+	{
+		uint16_t kind;
+		uint16_t flags;
+		uint32_t storedLen;
+		uint32_t rawLen;
+		uint32_t nums;
+		uint64_t firstTs;
+		uint64_t lastTs;
+	};
+
+	/// block header at 'pos', false when it is not a complete block of the file
+	bool readBlockHeader(const uint8_t* base, size_t fileSize, uint64_t pos, blockHeader_t& header)
+	{
+		if ((pos < fileHeaderSize) || (pos + blockHeaderSize > fileSize) || (std::memcmp(base + pos, blockMagic, 4) != 0))
+			return(false);
+		const uint8_t* p = base + pos;
+		header.kind = get<uint16_t>(p + 4);
+		header.flags = get<uint16_t>(p + 6);
+		header.storedLen = get<uint32_t>(p + 8);
+		header.rawLen = get<uint32_t>(p + 12);
+		header.nums = get<uint32_t>(p + 16);
+		header.firstTs = get<uint64_t>(p + 24);
+		header.lastTs = get<uint64_t>(p + 32);
+		return(pos + blockHeaderSize + header.storedLen <= fileSize);
+	}
+}
+
+bool mlogUtils::Writer::open(const std::string& fname, bool compress_, size_t blockSize_, size_t indexSpan_)
+{
+	close();
+	fp = std::fopen(fname.c_str(), "wb");
+	if (fp == NULL)
+		return(false);
+	compress = compress_;
+	blockSize = blockSize_;
+	indexSpan = ((indexSpan_ > 0) && (indexSpan_ <= UINT16_MAX)) ? indexSpan_ : 256;
+	lastIndex = 0;
+	lastTs = 0;
+	recordNums = 0;
+	blockRecords = 0;
+	block.clear();
+	block.reserve(blockSize + 4096);
+	entries.clear();
+	pending = 0;
+	uint8_t header[fileHeaderSize];
+	std::memcpy(header, fileMagic, 8);
+	put<uint32_t>(header + 8, (uint32_t)blockSize);
+	put<uint16_t>(header + 12, compress ? 1 : 0);
+	put<uint16_t>(header + 14, (uint16_t)indexSpan);
+	offset = std::fwrite(header, 1, fileHeaderSize, fp);
+	return(offset == fileHeaderSize);
+}
+
+bool mlogUtils::Writer::writeBlock(uint16_t kind, const uint8_t* body, size_t len, uint32_t nums, uint64_t firstTs, uint64_t lastTs_)
+{
+	uint16_t flags = 0;
+	const uint8_t* data = body;
+	size_t stored = len;
+	if (compress && (kind == kindRecords))
+	{ /// keep the block as it is when it does not compress
+		uLongf packedLen = compressBound((uLong)len);
+		packed.resize(packedLen);
+		if ((compress2(&packed[0], &packedLen, body, (uLong)len, 1) == Z_OK) && (packedLen < len))
+		{
+			flags = flagCompressed;
+			data = &packed[0];
+			stored = packedLen;
+		}
+	}
+	uint8_t header[blockHeaderSize];
+	std::memcpy(header, blockMagic, 4);
+	put<uint16_t>(header + 4, kind);
+	put<uint16_t>(header + 6, flags);
+	put<uint32_t>(header + 8, (uint32_t)stored);
+	put<uint32_t>(header + 12, (uint32_t)len);
+	put<uint32_t>(header + 16, nums);
+	put<uint32_t>(header + 20, 0);
+	put<uint64_t>(header + 24, firstTs);
+	put<uint64_t>(header + 32, lastTs_);
+	bool ret = (std::fwrite(header, 1, blockHeaderSize, fp) == blockHeaderSize) && (std::fwrite(data, 1, stored, fp) == stored);
+	offset += blockHeaderSize + stored;
+	return(ret);
+}
+
+bool mlogUtils::Writer::writeIndex(uint16_t kind, size_t from)
+{ /// index entries of the record blocks from 'from' on
+	size_t nums = entries.size() / 3 - from;
+	if (nums == 0)
+		return(true);
+	std::vector<uint8_t> body(8 + nums * 24);
+	put<uint64_t>(&body[0], lastIndex);
+	std::memcpy(&body[8], &entries[from * 3], nums * 24);
+	uint64_t pos = offset;
+	bool ret = writeBlock(kind, &body[0], body.size(), (uint32_t)nums, entries[from * 3], entries[entries.size() - 2]);
+	lastIndex = pos;
+	return(ret);
+}
+
+void mlogUtils::Writer::append(uint64_t timestamp, uint8_t flag, const uint8_t* msg, size_t size)
+{
+	if (fp == NULL)
+		return;
+	if (timestamp < lastTs)
+		timestamp = lastTs;
+	lastTs = timestamp;
+	if (blockRecords == 0)
+		blockFirstTs = timestamp;
+	size_t pos = block.size();
+	block.resize(pos + recordHeaderSize + size);
+	uint8_t* p = &block[pos];
+	put<uint64_t>(p, timestamp);
+	put<uint32_t>(p + 8, (uint32_t)size);
+	p[12] = ((size >= 3) && (msg[0] == 0xFF) && (msg[1] == 0xFF)) ? msg[2] : 0;  // MMITSS header
+	p[13] = flag;
+	p[14] = 0;
+	p[15] = 0;
+	if (size > 0)
+		std::memcpy(p + recordHeaderSize, msg, size);
+	blockRecords++;
+	recordNums++;
+	if (block.size() >= blockSize)
+		flush(0, 0);
+}
+
+void mlogUtils::Writer::flush(uint64_t now, uint64_t maxAge)
+{
+	if ((fp == NULL) || (blockRecords == 0) || ((maxAge > 0) && (now < blockFirstTs + maxAge)))
+		return;
+	uint64_t pos = offset;
+	writeBlock(kindRecords, &block[0], block.size(), blockRecords, blockFirstTs, lastTs);
+	entries.push_back(blockFirstTs);
+	entries.push_back(lastTs);
+	entries.push_back(pos);
+	block.clear();
+	blockRecords = 0;
+	if (++pending >= indexSpan)
+	{
+		writeIndex(kindIndex, entries.size() / 3 - pending);
+		pending = 0;
+	}
+	std::fflush(fp);
+}
+
+unsigned long mlogUtils::Writer::close(void)
+{
+	if (fp == NULL)
+		return(recordNums);
+	flush(0, 0);
+	writeIndex(kindFullIndex, 0);
+	uint8_t trailer[trailerSize];
+	put<uint64_t>(trailer, lastIndex);
+	std::memcpy(trailer + 8, endMagic, 8);
+	std::fwrite(trailer, 1, trailerSize, fp);
+	std::fclose(fp);
+	fp = NULL;
+	return(recordNums);
+}
+
+bool mlogUtils::Reader::open(const std::string& fname)
+{
+	close();
+	int fd = ::open(fname.c_str(), O_RDONLY);
+	if (fd == -1)
+		return(false);
+	struct stat st;
+	if ((fstat(fd, &st) == -1) || ((size_t)st.st_size < fileHeaderSize))
+	{
+		::close(fd);
+		return(false);
+	}
+	void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED)
+		return(false);
+	base = static_cast<const uint8_t*>(p);
+	fileSize = (size_t)st.st_size;
+	if (std::memcmp(base, fileMagic, 8) != 0)
+	{
+		close();
+		return(false);
+	}
+	blockSize = get<uint32_t>(base + 8);
+	indexSpan = get<uint16_t>(base + 14);
+	if (!loadIndex() && !recoverIndex())
+		walkBlocks(fileHeaderSize);
+	curBlock = 0;
+	curPos = 0;
+	body = NULL;
+	return(true);
+}
+
+void mlogUtils::Reader::close(void)
+{
+	if (base != NULL)
+		munmap(const_cast<uint8_t*>(base), fileSize);
+	base = NULL;
+	fileSize = 0;
+	index.clear();
+	body = NULL;
+	bodyLen = 0;
+}
+
+bool mlogUtils::Reader::loadIndexBlock(uint64_t pos, bool chain)
+{ /// index entries of the index block at 'pos', and of the index blocks before it when 'chain'
+	std::vector<uint64_t> blocks;
+	while (pos != 0)
+	{
+		blockHeader_t header;
+		if (!readBlockHeader(base, fileSize, pos, header) || ((header.kind != kindIndex) && (header.kind != kindFullIndex))
+			|| (header.flags != 0) || (header.rawLen != header.storedLen) || (header.rawLen != 8 + (uint64_t)header.nums * 24)
+			|| (blocks.size() > fileSize / blockHeaderSize))
+			return(false);
+		blocks.push_back(pos);
+		if (!chain || (header.kind == kindFullIndex))
+			break;
+		pos = get<uint64_t>(base + pos + blockHeaderSize);
+	}
+	index.clear();
+	for (auto it = blocks.rbegin(); it != blocks.rend(); ++it)
+	{
+		const uint8_t* p = base + *it + blockHeaderSize + 8;
+		uint32_t nums = get<uint32_t>(base + *it + 16);
+		for (uint32_t i = 0; i < nums; i++, p += 24)
+		{
+			index_t entry;
+			entry.firstTs = get<uint64_t>(p);
+			entry.lastTs = get<uint64_t>(p + 8);
+			entry.offset = get<uint64_t>(p + 16);
+			index.push_back(entry);
+		}
+	}
+	/// the entries have to point at record blocks
+	blockHeader_t header;
+	return(!index.empty() && readBlockHeader(base, fileSize, index.front().offset, header) && (header.kind == kindRecords)
+		&& readBlockHeader(base, fileSize, index.back().offset, header) && (header.kind == kindRecords));
+}
+
+bool mlogUtils::Reader::loadIndex(void)
+{ /// the full index block the trailer points to
+	index.clear();
+	if ((fileSize < fileHeaderSize + trailerSize) || (std::memcmp(base + fileSize - 8, endMagic, 8) != 0))
+		return(false);
+	uint64_t pos = get<uint64_t>(base + fileSize - trailerSize);
+	return((pos == 0) || loadIndexBlock(pos, true));
+}
+
+bool mlogUtils::Reader::recoverIndex(void)
+{ /// the file was not closed: look back from the end for the last index block (within the span of two index
+	/// blocks of uncompressed record blocks), load the chain of index blocks, then walk the record blocks after it
+	uint64_t span = 2 * (indexSpan + 1) * (2 * (uint64_t)blockSize + blockHeaderSize);
+	uint64_t stop = (fileSize > span + fileHeaderSize) ? fileSize - span : fileHeaderSize;
+	for (uint64_t pos = fileSize - blockHeaderSize; (pos >= stop) && (pos <= fileSize); pos--)
+	{
+		if ((base[pos] != blockMagic[0]) || (std::memcmp(base + pos, blockMagic, 4) != 0) || !loadIndexBlock(pos, true))
+			continue;
+		blockHeader_t header;
+		if (readBlockHeader(base, fileSize, index.back().offset, header))
+			walkBlocks(index.back().offset + blockHeaderSize + header.storedLen);
+		return(true);
+	}
+	index.clear();
+	return(false);
+}
+
+void mlogUtils::Reader::walkBlocks(uint64_t pos)
+{ /// add the complete record blocks from 'pos' on
+	blockHeader_t header;
+	for (; readBlockHeader(base, fileSize, pos, header); pos += blockHeaderSize + header.storedLen)
+	{
+		if (header.kind != kindRecords)
+			continue;
+		index_t entry;
+		entry.firstTs = header.firstTs;
+		entry.lastTs = header.lastTs;
+		entry.offset = pos;
+		index.push_back(entry);
+	}
+}
+
+bool mlogUtils::Reader::loadBlock(size_t blk)
+{
+	/// a block that cannot be read is left as an empty one
+	curBlock = blk;
+	curPos = 0;
+	body = base;
+	bodyLen = 0;
+	blockHeader_t header;
+	if ((blk >= index.size()) || !readBlockHeader(base, fileSize, index[blk].offset, header))
+		return(false);
+	const uint8_t* data = base + index[blk].offset + blockHeaderSize;
+	if ((header.flags & flagCompressed) == 0)
+	{
+		body = data;
+		bodyLen = header.storedLen;
+		return(true);
+	}
+	unpacked.resize(header.rawLen);
+	uLongf len = header.rawLen;
+	if ((header.rawLen == 0) || (uncompress(&unpacked[0], &len, data, header.storedLen) != Z_OK) || (len != header.rawLen))
+		return(false);
+	body = &unpacked[0];
+	bodyLen = len;
+	return(true);
+}
+
+bool mlogUtils::Reader::seek(uint64_t timestamp)
+{
+	auto it = std::lower_bound(index.begin(), index.end(), timestamp,
+		[](const index_t& entry, uint64_t ts){return(entry.lastTs < ts);});
+	if ((it == index.end()) || !loadBlock((size_t)(it - index.begin())))
+	{
+		loadBlock(index.size());
+		return(false);
+	}
+	while ((curPos + recordHeaderSize <= bodyLen) && (get<uint64_t>(body + curPos) < timestamp))
+		curPos += recordHeaderSize + get<uint32_t>(body + curPos + 8);
+	return(curPos + recordHeaderSize <= bodyLen);
+}
+
+bool mlogUtils::Reader::next(mlogUtils::record_t& rec)
+{
+	while ((body == NULL) || (curPos + recordHeaderSize > bodyLen))
+	{
+		size_t blk = (body == NULL) ? curBlock : curBlock + 1;
+		if (blk >= index.size())
+			return(false);
+		loadBlock(blk);
+	}
+	const uint8_t* p = body + curPos;
+	rec.timestamp = get<uint64_t>(p);
+	rec.size = get<uint32_t>(p + 8);
+	rec.msgid = p[12];
+	rec.flag = p[13];
+	rec.msg = p + recordHeaderSize;
+	if (curPos + recordHeaderSize + rec.size > bodyLen)
+	{ /// corrupted block, skip the rest of it
+		curPos = bodyLen;
+		return(next(rec));
+	}
+	curPos += recordHeaderSize + rec.size;
+	return(true);
+}
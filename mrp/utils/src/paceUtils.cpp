@@ -0,0 +1,74 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#include <climits>
+
+#include "paceUtils.h"
+
+paceUtils::TokenBucket::TokenBucket(unsigned long long interval_, unsigned long long burst)
+{
+	interval = interval_;
+	tolerance = (burst > 1) ? (burst - 1) * interval : 0;
+	tat = 0;
+}
+
+unsigned long long paceUtils::TokenBucket::wait(unsigned long long now) const
+	{return((now + tolerance >= tat) ? 0 : tat - tolerance - now);}
+
+void paceUtils::TokenBucket::take(unsigned long long now)
+	{tat = ((tat > now) ? tat : now) + interval;}
+
+paceUtils::TxSlot::TxSlot(size_t bufSize, size_t headroom_, unsigned long long refresh_,
+	unsigned long long interval, unsigned long long burst) : bucket(interval, burst)
+{
+	headroom = headroom_;
+	msgbuf.resize(headroom + bufSize, 0);
+	payloadSize = 0;
+	cached = false;
+	fresh = false;
+	version = 0;
+	refresh = refresh_;
+	lastSent = 0;
+	resetStats();
+}
+
+void paceUtils::TxSlot::store(size_t size, unsigned long long version_)
+{
+	payloadSize = (size < capacity()) ? size : capacity();
+	version = version_;
+	cached = true;
+	fresh = true;
+	stats.encodes++;
+}
+
+void paceUtils::TxSlot::drop(unsigned long long version_)
+{
+	payloadSize = 0;
+	version = version_;
+	cached = true;
+	fresh = false;
+}
+
+unsigned long long paceUtils::TxSlot::wait(unsigned long long now, unsigned long long version_) const
+{
+	unsigned long long pace = bucket.wait(now);
+	if (stale(version_) || fresh)
+		return(pace);
+	if ((refresh == 0) || (payloadSize == 0))
+		return(ULLONG_MAX);
+	unsigned long long period = (lastSent + refresh > now) ? lastSent + refresh - now : 0;
+	return((period > pace) ? period : pace);
+}
+
+void paceUtils::TxSlot::sent(unsigned long long now)
+{
+	bucket.take(now);
+	lastSent = now;
+	stats.sends++;
+	if (!fresh)
+		stats.reuses++;
+	fresh = false;
+}
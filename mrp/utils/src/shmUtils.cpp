@@ -0,0 +1,270 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "shmUtils.h"
+
+namespace
+{
+	const uint32_t wrapMarker = 0xFFFFFFFF;  // record length telling the rest of the lane is unused
+	const size_t recordAlign = 8;
+	const unsigned long long reattachInterval = 1000;  // in milliseconds, between attempts to find the next receiver
+
+	size_t recordSize(size_t len)
+		{return((sizeof(uint32_t) + len + recordAlign - 1) & ~(recordAlign - 1));}
+
+	bool processExists(uint32_t pid)
+		{return((pid != 0) && ((kill((pid_t)pid, 0) == 0) || (errno != ESRCH)));}
+
+	unsigned long long monotonicMsec(void)
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return((unsigned long long)ts.tv_sec * 1000ULL + (unsigned long long)ts.tv_nsec / 1000000ULL);
+	}
+}
+
+bool shmUtils::MsgRing::attach(const std::string& port, bool sender)
+{
+	detach();
+	name = std::string("/mrp_ring_") + port;
+	sending = sender;
+	carried = 0;
+	return(map(sender, true));
+}
+
+bool shmUtils::MsgRing::map(bool sender, bool create)
+{
+	int fd = shm_open(name.c_str(), create ? (O_RDWR | O_CREAT) : O_RDWR, 0666);
+	if (fd == -1)
+	{
+		if (create || (errno != ENOENT))
+			perror("shmUtils.attach.shm_open");
+		return(false);
+	}
+	struct stat st;
+	if ((fstat(fd, &st) == -1) || (((size_t)st.st_size < sizeof(segment_t)) && (ftruncate(fd, sizeof(segment_t)) == -1)))
+	{
+		perror("shmUtils.attach.ftruncate");
+		close(fd);
+		return(false);
+	}
+	void* p = mmap(NULL, sizeof(segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED)
+	{
+		perror("shmUtils.attach.mmap");
+		return(false);
+	}
+	seg = static_cast<segment_t*>(p);
+	if (!sender)
+	{ /// the receiver has not drained anything yet, so the first message rings the doorbell
+		__atomic_store_n(&seg->receiver, (uint32_t)getpid(), __ATOMIC_RELEASE);
+		__atomic_store_n(&seg->armed, 1, __ATOMIC_SEQ_CST);
+		return(true);
+	}
+	/// claim a free lane, or the lane of a sender that no longer exists
+	uint32_t pid = (uint32_t)getpid();
+	for (size_t i = 0; (i < maxLanes) && (lane == NULL); i++)
+	{
+		uint32_t owner = __atomic_load_n(&seg->lanes[i].owner, __ATOMIC_ACQUIRE);
+		if ((owner != 0) && ((owner == pid) || processExists(owner)))
+			continue;
+		if (__atomic_compare_exchange_n(&seg->lanes[i].owner, &owner, pid, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			lane = &seg->lanes[i];
+	}
+	if (lane == NULL)
+	{
+		std::fprintf(stderr, "shmUtils.attach: no free lane in %s\n", name.c_str());
+		detach();
+		return(false);
+	}
+	/// messages spilled by the previous owner of the lane are none of ours, ours may still wait on the socket
+	__atomic_store_n(&lane->spilled, __atomic_load_n(&lane->settled, __ATOMIC_ACQUIRE) + carried, __ATOMIC_RELEASE);
+	carried = 0;
+	if (!peerAttached())
+		std::fprintf(stderr, "shmUtils.attach: no receiver attached to %s yet, messages wait in the ring\n", name.c_str());
+	return(true);
+}
+
+void shmUtils::MsgRing::detach(void)
+{
+	if (seg == NULL)
+		return;
+	if (lane != NULL)
+		__atomic_store_n(&lane->owner, 0, __ATOMIC_RELEASE);
+	else
+	{ /// unlink before closing, so that a sender seeing 'closed' does not attach to this segment again
+		shm_unlink(name.c_str());
+		__atomic_store_n(&seg->receiver, 0, __ATOMIC_RELEASE);
+		__atomic_store_n(&seg->closed, 1, __ATOMIC_RELEASE);
+	}
+	munmap(seg, sizeof(segment_t));
+	seg = NULL;
+	lane = NULL;
+}
+
+bool shmUtils::MsgRing::peerAttached(void) const
+{
+	if (seg == NULL)
+		return(false);
+	if (lane != NULL)
+		return(processExists(__atomic_load_n(&seg->receiver, __ATOMIC_ACQUIRE)));
+	for (size_t i = 0; i < maxLanes; i++)
+	{
+		if (processExists(__atomic_load_n(&seg->lanes[i].owner, __ATOMIC_ACQUIRE)))
+			return(true);
+	}
+	return(false);
+}
+
+bool shmUtils::MsgRing::push(const uint8_t* buf, size_t len)
+{
+	if ((len == 0) || (len >= wrapMarker))
+		return(false);
+	if ((lane == NULL) || (__atomic_load_n(&seg->closed, __ATOMIC_ACQUIRE) != 0))
+	{ /// the receiver went away, attach to the segment of the next one once it has created it
+		if (!sending)
+			return(false);
+		if (lane != NULL)
+		{
+			std::fprintf(stderr, "shmUtils: receiver of %s detached, sending on the socket\n", name.c_str());
+			carried = (lane->spilled != __atomic_load_n(&lane->settled, __ATOMIC_ACQUIRE)) ? 1 : 0;
+			detach();
+			retryAt = 0;
+		}
+		unsigned long long now = monotonicMsec();
+		if ((now < retryAt) || !map(true, false))
+		{
+			if (now >= retryAt)
+				retryAt = now + reattachInterval;
+			return(false);
+		}
+		if (spilling())
+			return(false);
+	}
+	size_t rec = recordSize(len);
+	uint64_t head = lane->head;
+	uint64_t tail = __atomic_load_n(&lane->tail, __ATOMIC_ACQUIRE);
+	size_t pos = (size_t)(head & (laneBytes - 1));
+	size_t skip = (laneBytes - pos < rec) ? laneBytes - pos : 0;  // record does not fit before the end of the lane
+	if (head + skip + rec - tail > laneBytes)
+		return(false);
+	if (skip > 0)
+	{
+		uint32_t marker = wrapMarker;
+		std::memcpy(&lane->data[pos], &marker, sizeof(marker));
+		pos = 0;
+	}
+	uint32_t len32 = (uint32_t)len;
+	std::memcpy(&lane->data[pos], &len32, sizeof(len32));
+	std::memcpy(&lane->data[pos + sizeof(len32)], buf, len);
+	__atomic_store_n(&lane->head, head + skip + rec, __ATOMIC_RELEASE);
+	return(true);
+}
+
+bool shmUtils::MsgRing::needDoorbell(void)
+{ /// pairs with arm(): either the receiver sees the message when it re-checks, or the sender sees armed
+	if (seg == NULL)
+		return(false);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	return((__atomic_load_n(&seg->armed, __ATOMIC_RELAXED) != 0)
+		&& (__atomic_exchange_n(&seg->armed, 0, __ATOMIC_ACQ_REL) != 0));
+}
+
+bool shmUtils::MsgRing::spilling(void) const
+{ /// nothing settles the lane of a closed segment, push() then attaches to the next receiver and carries the spill
+	return((lane != NULL) && (__atomic_load_n(&seg->closed, __ATOMIC_ACQUIRE) == 0)
+		&& (lane->spilled != __atomic_load_n(&lane->settled, __ATOMIC_ACQUIRE)));
+}
+
+void shmUtils::MsgRing::spill(size_t n)
+{ /// counted after the messages were sent, so that a count read by markSpills() covers messages already on the socket
+	if (n == 0)
+		return;
+	if (lane == NULL)
+	{ /// no receiver, the next lane starts out spilling
+		carried = 1;
+		return;
+	}
+	uint64_t spilled = lane->spilled;
+	if (spilled == __atomic_load_n(&lane->settled, __ATOMIC_ACQUIRE))
+	{
+		std::fprintf(stderr, "shmUtils: %s lane full%s, sending on the socket until the receiver catches up\n",
+			name.c_str(), peerAttached() ? "" : " and no receiver attached");
+	}
+	__atomic_store_n(&lane->spilled, spilled + n, __ATOMIC_RELEASE);
+}
+
+size_t shmUtils::MsgRing::pop(uint8_t* buf, size_t size)
+{
+	if (seg == NULL)
+		return(0);
+	for (size_t n = 0; n < maxLanes; n++)
+	{
+		lane_t& ln = seg->lanes[(next + n) % maxLanes];
+		uint64_t tail = ln.tail;
+		uint64_t head = __atomic_load_n(&ln.head, __ATOMIC_ACQUIRE);
+		if (tail == head)
+			continue;
+		size_t pos = (size_t)(tail & (laneBytes - 1));
+		uint32_t len32;
+		std::memcpy(&len32, &ln.data[pos], sizeof(len32));
+		if (len32 == wrapMarker)
+		{
+			tail += laneBytes - pos;
+			pos = 0;
+			std::memcpy(&len32, &ln.data[0], sizeof(len32));
+		}
+		std::memcpy(buf, &ln.data[pos + sizeof(len32)], (len32 < size) ? len32 : size);
+		__atomic_store_n(&ln.tail, tail + recordSize(len32), __ATOMIC_RELEASE);
+		next = (next + n + 1) % maxLanes;
+		return((len32 < size) ? len32 : size);
+	}
+	return(0);
+}
+
+bool shmUtils::MsgRing::arm(void)
+{
+	if (seg == NULL)
+		return(true);
+	__atomic_store_n(&seg->armed, 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	for (size_t i = 0; i < maxLanes; i++)
+	{
+		if (__atomic_load_n(&seg->lanes[i].head, __ATOMIC_ACQUIRE) != seg->lanes[i].tail)
+			return(false);
+	}
+	return(true);
+}
+
+void shmUtils::MsgRing::markSpills(void)
+{
+	if (seg == NULL)
+		return;
+	for (size_t i = 0; i < maxLanes; i++)
+		marks[i] = __atomic_load_n(&seg->lanes[i].spilled, __ATOMIC_ACQUIRE);
+}
+
+void shmUtils::MsgRing::settleSpills(void)
+{
+	if (seg == NULL)
+		return;
+	for (size_t i = 0; i < maxLanes; i++)
+	{
+		if (seg->lanes[i].settled != marks[i])
+			__atomic_store_n(&seg->lanes[i].settled, marks[i], __ATOMIC_RELEASE);
+	}
+}
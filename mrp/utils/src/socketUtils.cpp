@@ -15,8 +15,33 @@
 #include <unistd.h>
 #include <netdb.h>
 
+#include "shmUtils.h"
 #include "socketUtils.h"
 
+namespace
+{
+	/// shared-memory message rings of the SHM sockets, by socket descriptor
+	struct shmLink_t
+	{
+		int fd;
+		shmUtils::MsgRing* ring;
+	};
+	std::vector<shmLink_t> shmLinks;
+
+	shmUtils::MsgRing* shmRingOf(int fd)
+	{
+		for (const auto& link : shmLinks)
+		{
+			if (link.fd == fd)
+				return(link.ring);
+		}
+		return(NULL);
+	}
+
+	bool ringDoorbell(const socketUtils::Conn_t& conn)
+		{return(sendto(conn.fd, NULL, 0, 0, &conn.ai_addr, conn.ai_addrlen) == 0);}
+}
+
 bool socketUtils::setAddress(const std::string& str, socketUtils::Address_t& addr)
 { // str formate: destination/source protocol name port
 	addr.reset();
@@ -126,11 +151,31 @@ bool socketUtils::create(socketUtils::Address_t& addr)
 		addr.conn.ai_addrlen = p->ai_addrlen;
 	}
 	freeaddrinfo(res);
+	if ((addr.conn.fd != -1) && (addr.protocol == "SHM"))
+	{ // attach to the message ring, the sending end claims a lane of it
+		shmUtils::MsgRing* ring = new shmUtils::MsgRing();
+		if (!ring->attach(addr.port, (addr.role == "client")))
+		{
+			delete ring;
+			close(addr.conn.fd);
+			addr.conn.fd = -1;
+			return(false);
+		}
+		shmLinks.push_back(shmLink_t{addr.conn.fd, ring});
+	}
 	return(addr.conn.fd != -1);
 }
 
 bool socketUtils::destroy(int fid)
-	{return(close(fid) == 0);}
+{
+	auto it = std::find_if(shmLinks.begin(), shmLinks.end(), [fid](const shmLink_t& link){return(link.fd == fid);});
+	if (it != shmLinks.end())
+	{
+		delete it->ring;
+		shmLinks.erase(it);
+	}
+	return(close(fid) == 0);
+}
 
 auto tcpSendAll = [](int fd, const uint8_t* buf, size_t len)->bool
 {
@@ -172,6 +217,164 @@ bool socketUtils::sendall(socketUtils::Conn_t conn, const uint8_t* buf, size_t l
 {
 	if ((conn.fd < 0) || (buf == NULL) || (len == 0))
 		return(false);
-	return ((conn.socktype == SOCK_STREAM) ? tcpSendAll(conn.fd, buf, len)
-		: udpSendAll(conn.fd, buf, len, &conn.ai_addr, conn.ai_addrlen));
+	shmUtils::MsgRing* ring = shmLinks.empty() ? NULL : shmRingOf(conn.fd);
+	if ((ring != NULL) && !ring->spilling() && ring->push(buf, len))
+		return(!ring->needDoorbell() || ringDoorbell(conn));
+	bool ret = (conn.socktype == SOCK_STREAM) ? tcpSendAll(conn.fd, buf, len)
+		: udpSendAll(conn.fd, buf, len, &conn.ai_addr, conn.ai_addrlen);
+	if ((ring != NULL) && ret)
+		ring->spill(1);
+	return(ret);
+}
+
+socketUtils::DgramBatch::DgramBatch(size_t capacity_, size_t bufSize_)
+{
+	bufSize = bufSize_;
+	cnt = 0;
+	cur = 0;
+	bufs.resize(capacity_, std::vector<uint8_t>(bufSize_, 0));
+	lens.assign(capacity_, 0);
+	iovs.resize(capacity_);
+	msgs.resize(capacity_);
+	names.resize(capacity_);
+	for (size_t i = 0; i < capacity_; i++)
+	{
+		iovs[i].iov_base = &bufs[i][0];
+		iovs[i].iov_len = bufSize_;
+		std::memset(&msgs[i], 0, sizeof(struct mmsghdr));
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+}
+
+size_t socketUtils::DgramBatch::recv(int fd)
+{
+	cnt = 0;
+	cur = 0;
+	shmUtils::MsgRing* ring = shmLinks.empty() ? NULL : shmRingOf(fd);
+	if (ring != NULL)
+		ring->markSpills();
+	while ((ring != NULL) && (cnt < bufs.size()) && ((lens[cnt] = ring->pop(&bufs[cnt][0], bufSize)) > 0))
+		msgs[cnt++].msg_hdr.msg_namelen = 0;
+	if (cnt == bufs.size())
+		return(cnt);
+	for (size_t i = cnt; i < msgs.size(); i++)
+	{
+		iovs[i].iov_len = bufSize;
+		msgs[i].msg_hdr.msg_name = &names[i];
+		msgs[i].msg_hdr.msg_namelen = (socklen_t)sizeof(struct sockaddr_storage);
+		msgs[i].msg_hdr.msg_flags = 0;
+	}
+	int retval = recvmmsg(fd, &msgs[cnt], (unsigned int)(msgs.size() - cnt), MSG_DONTWAIT, NULL);
+	if ((ring != NULL) && ((retval == -1) ? ((errno == EAGAIN) || (errno == EWOULDBLOCK)) : ((size_t)retval < msgs.size() - cnt)))
+	{ /// lanes and socket drained, messages spilled before markSpills() have all been received
+		ring->settleSpills();
+	}
+	size_t last = cnt + (size_t)((retval > 0) ? retval : 0);
+	for (size_t i = cnt; i < last; i++)
+	{ /// zero-length datagrams are doorbells of the ring, keep the others
+		if (msgs[i].msg_len == 0)
+			continue;
+		if (i != cnt)
+		{
+			bufs[cnt].swap(bufs[i]);
+			iovs[cnt].iov_base = &bufs[cnt][0];
+			iovs[i].iov_base = &bufs[i][0];
+			names[cnt] = names[i];
+			msgs[cnt].msg_hdr.msg_namelen = msgs[i].msg_hdr.msg_namelen;
+		}
+		lens[cnt++] = msgs[i].msg_len;
+	}
+	if ((cnt == 0) && (ring != NULL) && !ring->arm())
+		return(recv(fd));
+	return(cnt);
+}
+
+bool socketUtils::DgramBatch::next(int fd)
+{
+	if (cur + 1 < cnt)
+	{
+		cur++;
+		return(true);
+	}
+	if ((cnt > 0) && (cnt < bufs.size()))
+	{ /// the last batch was not full, the socket has been drained (arm the ring doorbell before sleeping)
+		cnt = 0;
+		cur = 0;
+		shmUtils::MsgRing* ring = shmLinks.empty() ? NULL : shmRingOf(fd);
+		if ((ring == NULL) || ring->arm())
+			return(false);
+	}
+	return(recv(fd) > 0);
+}
+
+bool socketUtils::DgramBatch::source(int fd, socketUtils::Conn_t& conn) const
+{
+	if (cur >= cnt)
+		return(false);
+	socklen_t namelen = msgs[cur].msg_hdr.msg_namelen;
+	if ((namelen == 0) || (namelen > (socklen_t)sizeof(conn.ai_addr)))
+		return(false);
+	conn.fd = fd;
+	conn.socktype = SOCK_DGRAM;
+	std::memcpy(&conn.ai_addr, &names[cur], namelen);
+	conn.ai_addrlen = namelen;
+	return(true);
+}
+
+bool socketUtils::DgramBatch::add(socketUtils::Conn_t conn, const uint8_t* buf, size_t len)
+{
+	if ((buf == NULL) || (len == 0) || (len > bufSize))
+		return(false);
+	bool ret = (cnt < bufs.size()) ? true : flush(conn);
+	std::memcpy(&bufs[cnt][0], buf, len);
+	lens[cnt++] = len;
+	return(ret);
+}
+
+bool socketUtils::DgramBatch::flush(socketUtils::Conn_t conn)
+{
+	if (cnt == 0)
+		return(true);
+	bool ret = true;
+	size_t first = 0;  // first datagram not yet sent
+	shmUtils::MsgRing* ring = shmLinks.empty() ? NULL : shmRingOf(conn.fd);
+	if ((ring != NULL) && !ring->spilling())
+	{ /// through the ring with at most one doorbell, what does not fit into the ring goes out on the socket
+		while ((first < cnt) && ring->push(&bufs[first][0], lens[first]))
+			first++;
+		if ((first > 0) && ring->needDoorbell())
+			ret = ringDoorbell(conn);
+	}
+	if ((conn.fd < 0) || (conn.socktype == SOCK_STREAM))
+	{
+		for (size_t i = first; i < cnt; i++)
+			ret = socketUtils::sendall(conn, &bufs[i][0], lens[i]) && ret;
+	}
+	else
+	{
+		for (size_t i = first; i < cnt; i++)
+		{
+			iovs[i].iov_len = lens[i];
+			msgs[i].msg_hdr.msg_name = &conn.ai_addr;
+			msgs[i].msg_hdr.msg_namelen = conn.ai_addrlen;
+		}
+		size_t totalSent = first;
+		while (totalSent < cnt)
+		{
+			int retval = sendmmsg(conn.fd, &msgs[totalSent], (unsigned int)(cnt - totalSent), 0);
+			if (retval == -1)
+			{
+				perror("socketUtils.DgramBatch.flush");
+				ret = false;
+				break;
+			}
+			totalSent += (size_t)retval;
+		}
+		if (ring != NULL)
+			ring->spill(totalSent - first);
+	}
+	cnt = 0;
+	cur = 0;
+	return(ret);
 }
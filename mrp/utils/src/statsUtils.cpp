@@ -0,0 +1,106 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+#include <cmath>
+#include <cstring>
+
+#include "statsUtils.h"
+
+void statsUtils::moments_t::add(double x)
+{
+	count++;
+	double delta = x - mean;
+	mean += delta / (double)count;
+	m2 += delta * (x - mean);
+}
+
+void statsUtils::moments_t::merge(const statsUtils::moments_t& other)
+{
+	if (other.count == 0)
+		return;
+	if (count == 0)
+	{
+		*this = other;
+		return;
+	}
+	double n = (double)count + (double)other.count;
+	double delta = other.mean - mean;
+	mean += delta * (double)other.count / n;
+	m2 += other.m2 + delta * delta * (double)count * (double)other.count / n;
+	count += other.count;
+}
+
+double statsUtils::moments_t::stddev(void) const
+	{return(std::sqrt(variance()));}
+
+const uint32_t statsUtils::Histogram::maxValue;
+const size_t statsUtils::Histogram::binNums;
+
+size_t statsUtils::Histogram::binOf(uint32_t value)
+{
+	if (value < 16)
+		return(value);
+	if (value > maxValue)
+		value = maxValue;
+	int octave = 31 - __builtin_clz(value);  // 4..15
+	return(16 + (size_t)(octave - 4) * 8 + ((value >> (octave - 3)) & 7));
+}
+
+uint32_t statsUtils::Histogram::valueOf(size_t bin)
+{
+	if (bin < 16)
+		return((uint32_t)bin);
+	int octave = (int)((bin - 16) / 8) + 4;
+	uint32_t low = (uint32_t)(8 + (bin - 16) % 8) << (octave - 3);
+	return(low + ((1U << (octave - 3)) >> 1));
+}
+
+void statsUtils::Histogram::reset(void)
+{
+	std::memset(bins, 0, sizeof(bins));
+	total = 0;
+}
+
+void statsUtils::Histogram::add(uint32_t value)
+{
+	uint16_t& bin = bins[binOf(value)];
+	if (bin < UINT16_MAX)
+	{
+		bin++;
+		total++;
+	}
+}
+
+void statsUtils::Histogram::merge(const statsUtils::Histogram& other)
+{
+	if (other.total == 0)
+		return;
+	for (size_t i = 0; i < binNums; i++)
+	{
+		uint32_t sum = (uint32_t)bins[i] + other.bins[i];
+		uint16_t cnt = (sum > UINT16_MAX) ? (uint16_t)UINT16_MAX : (uint16_t)sum;
+		total += (uint32_t)(cnt - bins[i]);
+		bins[i] = cnt;
+	}
+}
+
+uint32_t statsUtils::Histogram::quantile(double q) const
+{
+	if (total == 0)
+		return(0);
+	/// rank of the sample at quantile q (nearest-rank method)
+	uint32_t rank = (uint32_t)std::ceil(q * (double)total);
+	if (rank == 0)
+		rank = 1;
+	uint32_t cnt = 0;
+	for (size_t i = 0; i < binNums; i++)
+	{
+		cnt += bins[i];
+		if (cnt >= rank)
+			return(valueOf(i));
+	}
+	return(maxValue);
+}
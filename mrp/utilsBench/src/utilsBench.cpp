@@ -0,0 +1,1411 @@
+//********************************************************************************************************
+//
+//  2016 Regents of the University of California on behalf of the University of California at Berkeley
+//       with rights granted for USDOT OSADP distribution with the ECL-2.0 open source license.
+//
+//*********************************************************************************************************
+/* utilsBench.cpp
+ * benchmarks of the utils library APIs, run offline:
+ *   pace - encode and send calls of the MAP, SPaT and SSM paths driven by paceUtils::TxSlot against the
+ *          earlier encode-and-send-every-time paths, over a simulated steady-state intersection.
+ *   logger - main-loop cost of logUtils::Logger against the earlier ofstream logging (channel looked up by
+ *          type string, std::endl flush per record), and a check that the Logger files replay the records logged.
+ *   reactor - wake-ups and receive latency of sparse traffic from a forked sender with eventUtils::Reactor against
+ *          the earlier poll-and-sleep loops, and the interval between soft-calls of the tci soft-call timer.
+ *   mlog   - write, open, seek-to-timestamp and replay of mlogUtils files, raw and compressed, with cold and warm
+ *          page cache, and a check of round-trip, seek, recovery of a file that was not closed and the Logger path.
+ *   shm    - round trips to a forked echo process over UDP and SHM sockets, and a check that SHM messages arrive
+ *          in order through lane spills, a receiver restart and a sender killed while spilling.
+ */
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <netinet/in.h>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "eventUtils.h"
+#include "logUtils.h"
+#include "mlogUtils.h"
+#include "paceUtils.h"
+#include "socketUtils.h"
+#include "tableUtils.h"
+
+void do_usage(const char* progname)
+{
+	std::cerr << "Usage " << progname << " [options] <benchmark> [log directory] [hex payload file]" << std::endl;
+	std::cerr << "\t-n number of iterations (default 200000, 20000 for logger, 100 messages for reactor, 10000000 records for mlog," << std::endl;
+	std::cerr << "\t   10000 pings for shm)" << std::endl;
+	std::cerr << "\t-? print this message" << std::endl;
+	std::cerr << "benchmarks:" << std::endl;
+	std::cerr << "\tpace     MAP, SPaT and SSM encode and send calls with and without TxSlot pacing" << std::endl;
+	std::cerr << "\tlogger   Logger against ofstream logging, -n main-loop iterations at 2000/s (default /tmp)" << std::endl;
+	std::cerr << "\treactor  Reactor against poll-and-sleep loops, -n messages at 10/s, and the soft-call timer" << std::endl;
+	std::cerr << "\tmlog     mlog files of -n payload records at 2000/s, from the hex file (e.g. a codecBench corpus)" << std::endl;
+	std::cerr << "\tshm      UDP against SHM round trips, -n pings, and SHM ordering through spills and restarts" << std::endl;
+	exit(EXIT_FAILURE);
+}
+
+struct paceCount_t
+{
+	unsigned long long encodes;
+	unsigned long long sends;
+};
+
+/// simulates 'statusNums' controller status messages at 10 Hz (+-5 ms jitter, 2% back-to-back pairs), with
+/// 'reqNums' priority requests whose SRMs are re-sent every 'srmPeriod' milliseconds (0 for not re-sent, the
+/// requests then stay on the list). With 'oneExpires', the last request re-sends for 10 s out of every 15 s, so
+/// it expires and comes back every 15 s.
+/// Parameters are those in conf/dataMgr.conf and conf/mrpAwr.conf, the TxSlot calls follow dataMgr and mrpAware.
+static bool simPace(size_t statusNums, unsigned long long srmPeriod, int reqNums, bool oneExpires)
+{
+	const unsigned long long mapInterval = 1000;
+	const unsigned long long spatInterval = 100;
+	const unsigned long long spatBurst = 2;
+	const unsigned long long ssmInterval = 1000;
+	const unsigned long long ssmMinInterval = 1000;
+	const unsigned long long ssmBurst = 1;
+	const unsigned long long dsrcTimeout = 2000;
+	const unsigned long long expiryTick = 100;
+
+	std::mt19937 rng(1);
+	std::vector<unsigned long long> statusTimes;
+	for (unsigned long long t = 37; statusTimes.size() < statusNums; t += 100)
+	{
+		unsigned long long arrival = t + rng() % 11 - 5;
+		statusTimes.push_back(arrival);
+		if (rng() % 50 == 0)
+			statusTimes.push_back(arrival + 1);
+	}
+	const unsigned long long duration = statusTimes.back() + 100;
+	std::vector< std::pair<unsigned long long, int> > srmTimes;  // arrival time and request
+	if (srmPeriod > 0)
+	{
+		for (int i = 0; i < reqNums; i++)
+		{
+			unsigned long long start = 500 + (unsigned long long)i * 333;
+			for (unsigned long long t = start; t < duration; t += srmPeriod)
+			{
+				if (!oneExpires || (i < reqNums - 1) || ((t - start) % 15000 < 10000))
+					srmTimes.push_back(std::make_pair(t, i));
+			}
+		}
+	}
+	std::sort(srmTimes.begin(), srmTimes.end());
+
+	/// earlier paths: dataMgr encoded and sent every controller status (one send to RSE_MessageTX and one to
+	/// the cloud server) and MAP every second, mrpAware encoded and sent SSM every ssmInterval
+	paceCount_t oldMgr{statusTimes.size(), 2 * statusTimes.size() + 2 * (duration / mapInterval)};
+	paceCount_t oldAwr{0, 0};
+	if (reqNums > 0)
+	{
+		for (unsigned long long lastSent = 0, t = 1; t < duration; t++)
+		{
+			if (t > lastSent + ssmInterval)
+			{
+				lastSent = t;
+				oldAwr.encodes++;
+				oldAwr.sends++;
+			}
+		}
+	}
+	/// dataMgr forwards every SSM, one send each
+	oldMgr.sends += oldAwr.sends;
+
+	/// TxSlot paths, one wake-up per event and per timer expiry, mrpAware checks SSM every 100 ms
+	paceUtils::TxSlot spatSlot(2000, 9, 0, spatInterval, spatBurst);
+	paceUtils::TxSlot mapSlot(2000, 9, mapInterval, mapInterval, 1);
+	paceUtils::TxSlot ssmSlot(2000, 9, ssmInterval, ssmMinInterval, ssmBurst);
+	mapSlot.store(100, 0);
+	paceCount_t newMgr{0, 0};
+	paceCount_t newAwr{0, 0};
+	unsigned long long spatVersion = 0;
+	unsigned long long ssmVersion = 0;
+	unsigned long long mapTimer = 0;
+	unsigned long long spatTimer = ULLONG_MAX;
+	unsigned long long maxSpatDelay = 0;
+	unsigned long long maxMapGap = 0;
+	unsigned long long lastMap = 0;
+	std::deque<unsigned long long> ssmArrivals;
+	/// srmList as a bitmask of requests, expired the way mrpAware does. SSM content is the list when packed
+	unsigned long long srmList = (srmPeriod > 0) ? 0 : (1ULL << reqNums) - 1;
+	unsigned long long ssmContent = 0;
+	unsigned long long srmEvicted = 0;  // requests expired and not sent in an SSM since
+	size_t srmExpiredCnt = 0;
+	size_t expiredSent = 0;
+	tableUtils::TimerWheel srmExpiry((size_t)reqNums, dsrcTimeout, expiryTick, 0);
+	bool listUpdated = (srmList != 0);
+	size_t statusIndex = 0;
+	size_t pendingIndex = 0;  // earliest controller status not carried by a SPaT yet
+	size_t srmIndex = 0;
+	for (unsigned long long t = 0; t < duration; t++)
+	{
+		bool wakeup = false;
+		size_t ssmIn = 0;
+		while ((statusIndex < statusTimes.size()) && (statusTimes[statusIndex] <= t))
+		{
+			spatVersion++;
+			statusIndex++;
+			wakeup = true;
+		}
+		while (!ssmArrivals.empty() && (ssmArrivals.front() <= t))
+		{
+			ssmArrivals.pop_front();
+			ssmIn++;
+			wakeup = true;
+		}
+		bool mapExpired = (t >= mapTimer);
+		bool spatExpired = (t >= spatTimer);
+		if (wakeup || mapExpired || spatExpired)
+		{
+			size_t wmeMsgs = ssmIn;
+			size_t cloudMsgs = 0;
+			bool spatSent = false;
+			if (spatExpired)
+				spatTimer = ULLONG_MAX;
+			if ((spatVersion > 0) && spatSlot.due(t, spatVersion))
+			{
+				spatSlot.store(80, spatVersion);
+				spatSlot.sent(t);
+				wmeMsgs++;
+				cloudMsgs++;
+				spatSent = true;
+				/// the SPaT carries the latest controller status, the earliest one not sent before waited longest
+				maxSpatDelay = std::max(maxSpatDelay, t - statusTimes[pendingIndex]);
+				pendingIndex = statusIndex;
+			}
+			else if ((spatVersion > 0) && spatSlot.stale(spatVersion))
+				spatTimer = t + spatSlot.wait(t, spatVersion);
+			if ((mapExpired || spatSent) && mapSlot.due(t, 0))
+			{
+				mapSlot.sent(t);
+				maxMapGap = std::max(maxMapGap, t - lastMap);
+				lastMap = t;
+				wmeMsgs++;
+				cloudMsgs++;
+				mapTimer = t + mapSlot.wait(t, 0) + spatInterval;
+			}
+			else if (mapExpired)
+				mapTimer = t + mapSlot.wait(t, 0) + spatInterval;
+			/// one sendmmsg per destination
+			newMgr.sends += ((wmeMsgs > 0) ? 1 : 0) + ((cloudMsgs > 0) ? 1 : 0);
+		}
+		bool srmIn = false;
+		while ((srmIndex < srmTimes.size()) && (srmTimes[srmIndex].first <= t))
+		{
+			int req = srmTimes[srmIndex].second;
+			srmList |= (1ULL << req);
+			srmEvicted &= ~(1ULL << req);
+			srmExpiry.schedule((uint32_t)req, t + dsrcTimeout);
+			listUpdated = true;
+			srmIndex++;
+			srmIn = true;
+		}
+		if ((reqNums > 0) && (srmIn || (t % 100 == 0)))
+		{
+			if (srmList != 0)
+			{
+				if (listUpdated && ssmSlot.due(t, ssmVersion + 1))
+				{
+					ssmContent = srmList;
+					ssmVersion++;
+					listUpdated = false;
+				}
+				if ((ssmVersion > 0) && ssmSlot.due(t, ssmVersion))
+				{
+					if (ssmSlot.stale(ssmVersion))
+						ssmSlot.store(40, ssmVersion);
+					ssmSlot.sent(t);
+					newAwr.sends++;
+					ssmArrivals.push_back(t + 1);
+					if ((ssmContent & srmEvicted) != 0)
+						expiredSent++;
+					srmEvicted = 0;
+				}
+			}
+			size_t evicted = srmExpiry.expire(t, [&srmList, &srmEvicted](uint32_t req)
+				{srmList &= ~(1ULL << req); srmEvicted |= (1ULL << req);});
+			if (evicted > 0)
+			{
+				srmExpiredCnt += evicted;
+				listUpdated = true;
+			}
+		}
+	}
+	newMgr.encodes = spatSlot.getStats().encodes;
+	newAwr.encodes = ssmSlot.getStats().encodes;
+
+	double minutes = (double)duration / 60000.0;
+	std::cout << "SRM re-sent every " << srmPeriod << " ms (0 for not re-sent), " << reqNums << " requests, ";
+	std::cout << statusTimes.size() << " controller status messages over " << std::fixed << std::setprecision(1);
+	std::cout << minutes << " minutes" << std::endl;
+	std::cout << std::setw(10) << "per minute" << std::setw(16) << "earlier encode" << std::setw(14) << "earlier send";
+	std::cout << std::setw(14) << "TxSlot encode" << std::setw(12) << "TxSlot send" << std::endl;
+	std::cout << std::setw(10) << "dataMgr" << std::setw(16) << (double)oldMgr.encodes / minutes << std::setw(14) << (double)oldMgr.sends / minutes;
+	std::cout << std::setw(14) << (double)newMgr.encodes / minutes << std::setw(12) << (double)newMgr.sends / minutes << std::endl;
+	std::cout << std::setw(10) << "mrpAware" << std::setw(16) << (double)oldAwr.encodes / minutes << std::setw(14) << (double)oldAwr.sends / minutes;
+	std::cout << std::setw(14) << (double)newAwr.encodes / minutes << std::setw(12) << (double)newAwr.sends / minutes << std::endl;
+	std::cout << "longest wait of a controller status for SPaT " << maxSpatDelay << " ms, longest MAP interval ";
+	std::cout << maxMapGap << " ms, " << mapSlot.getStats().sends << " MAP sends, " << srmExpiredCnt;
+	std::cout << " requests expired, " << expiredSent << " SSMs sent with an expired request" << std::endl << std::endl;
+
+	/// a controller status waits for pacing no longer than spatInterval, and MAP rides along with SPaT or
+	/// goes out on its own within spatInterval after its refresh is due
+	if (maxSpatDelay > spatInterval)
+	{
+		std::cerr << "a controller status waited " << maxSpatDelay << " ms for SPaT" << std::endl;
+		return(false);
+	}
+	if (maxMapGap > mapInterval + spatInterval)
+	{
+		std::cerr << "MAP was not sent for " << maxMapGap << " ms" << std::endl;
+		return(false);
+	}
+	/// an expired request leaves the next SSM
+	if (oneExpires && ((srmExpiredCnt == 0) || (expiredSent > 0)))
+	{
+		std::cerr << srmExpiredCnt << " requests expired, " << expiredSent << " SSMs sent with an expired request" << std::endl;
+		return(false);
+	}
+	return(true);
+}
+
+static bool benchPace(size_t iterations)
+{
+	bool ret = simPace(iterations, 0, 2, false);
+	ret = simPace(iterations, 1000, 2, false) && ret;
+	ret = simPace(iterations, 1700, 2, true) && ret;
+	return(ret);
+}
+
+/// the earlier logging of tci, dataMgr and mrpAware: files looked up by type string, the record written
+/// with a std::endl flush, and msOfDay inserted into the caller's message
+class OfstreamLogs
+{
+	private:
+		struct logfile_t
+		{
+			std::ofstream* OS;
+			std::string type;
+			std::string fullname;
+			unsigned long logrows;
+		};
+		std::string prefix;
+		std::vector<logfile_t> files;
+
+	public:
+		OfstreamLogs(const std::string& prefix_, const std::vector<std::string>& types) : prefix(prefix_)
+		{
+			for (const auto& type : types)
+				files.push_back(logfile_t{nullptr, type, std::string(), 0});
+		};
+		~OfstreamLogs(void) {close();};
+		bool open(const std::string& suffix)
+		{
+			bool ret = true;
+			for (auto& log : files)
+			{
+				log.logrows = 0;
+				log.fullname = prefix + std::string(".") + log.type + std::string(".") + suffix;
+				log.OS = new std::ofstream(log.fullname, std::ofstream::out | std::ofstream::binary);
+				if (!log.OS->is_open())
+					ret = false;
+			}
+			return(ret);
+		};
+		void close(void)
+		{
+			for (auto& log : files)
+			{
+				if (log.OS == nullptr)
+					continue;
+				log.OS->close();
+				if (log.logrows == 0)
+					std::remove(log.fullname.c_str());
+				delete log.OS;
+				log.OS = nullptr;
+			}
+		};
+		bool reopen(const std::string& suffix)
+		{
+			close();
+			return(open(suffix));
+		};
+		void log(const std::string& type, std::vector<uint8_t>& msg, size_t size, bool receive = false)
+		{
+			auto it = std::find_if(files.begin(), files.end(), [&type](const logfile_t& log){return(log.type == type);});
+			if ((it == files.end()) || (it->OS == nullptr))
+				return;
+			char flag = receive ? 1 : 0;
+			it->OS->write(&flag, 1);
+			it->OS->write((char*)&msg[0], size);
+			*(it->OS) << std::endl;
+			(it->logrows)++;
+		};
+		void log(const std::string& type, std::vector<uint8_t>& msg, size_t size, uint32_t msOfDay)
+		{
+			uint8_t timestamp[4];
+			for (int i = 0; i < 4; i++)
+				timestamp[i] = (uint8_t)((msOfDay >> (3 - i) * 8) & 0xFF);
+			msg.insert(msg.begin() + 3, timestamp, timestamp + 4);
+			log(type, msg, size + 4, true);
+		};
+};
+
+static void reportNs(const std::string& name, std::vector<unsigned long long>& ns)
+{
+	std::sort(ns.begin(), ns.end());
+	std::cout << std::setw(24) << name << std::setw(10) << ns[ns.size() / 2] << std::setw(10) << ns[ns.size() * 99 / 100];
+	std::cout << std::setw(10) << ns[ns.size() * 999 / 1000] << std::setw(10) << ns.back() << std::endl;
+}
+
+static bool benchLogger(size_t iterations, const std::string& dir)
+{
+	std::string tmpl = dir + std::string("/utilsBench.XXXXXX");
+	std::vector<char> path(tmpl.begin(), tmpl.end());
+	path.push_back('\0');
+	if (mkdtemp(&path[0]) == nullptr)
+	{
+		std::cerr << "Failed creating a directory in " << dir << std::endl;
+		return(false);
+	}
+	std::string logDir(&path[0]);
+	std::vector<std::string> removes;  // files written, removed at the end
+	bool ret = true;
+
+	/// replay: 20000 records of 3 to 259 bytes on two of three channels (the file of the third one is removed),
+	/// a rotation half way, and a 64 kB ring that wraps around many times. The files read back with
+	/// mlogUtils::Reader have to hold the records logged, in order, with msOfDay inserted after 3 bytes
+	{
+		const std::vector<std::string> types = {"a", "b", "c"};
+		const std::vector<std::string> suffixes = {"1", "2"};
+		struct expected_t
+		{
+			uint8_t flag;
+			std::vector<uint8_t> msg;
+		};
+		std::vector< std::vector<expected_t> > expected(types.size() * suffixes.size());
+		logUtils::Logger logger(logDir + std::string("/log"), false, 65536, 1);
+		for (const auto& type : types)
+			logger.addChannel(type);
+		logger.open(suffixes[0]);
+		for (int i = 0; i < 20000; i++)
+		{
+			std::vector<uint8_t> msg(3 + i % 257);
+			for (size_t j = 0; j < msg.size(); j++)
+				msg[j] = (uint8_t)(i * 7 + j);
+			size_t channel = (size_t)(i % 2);
+			std::vector<expected_t>& records = expected[((i <= 10000) ? 0 : 1) * types.size() + channel];
+			if (i % 3 == 0)
+			{
+				logger.log(channel, &msg[0], msg.size(), (uint32_t)i * 13);
+				uint32_t msOfDay = (uint32_t)i * 13;
+				uint8_t timestamp[4] = {(uint8_t)(msOfDay >> 24), (uint8_t)(msOfDay >> 16), (uint8_t)(msOfDay >> 8), (uint8_t)msOfDay};
+				msg.insert(msg.begin() + 3, timestamp, timestamp + 4);
+				records.push_back(expected_t{1, msg});
+			}
+			else
+			{
+				logger.log(channel, &msg[0], msg.size(), (i % 5 == 0));
+				records.push_back(expected_t{(uint8_t)((i % 5 == 0) ? 1 : 0), msg});
+			}
+			if (i == 10000)
+				logger.reopen(suffixes[1]);
+			if (i % 16 == 0)
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+		logger.close();
+		size_t diffs = 0;
+		for (size_t k = 0; k < suffixes.size(); k++)
+		{
+			for (size_t channel = 0; channel < types.size(); channel++)
+			{
+				std::string fname = logDir + std::string("/log.") + types[channel] + std::string(".") + suffixes[k] + std::string(".mlog");
+				const std::vector<expected_t>& records = expected[k * types.size() + channel];
+				mlogUtils::Reader reader;
+				if (!reader.open(fname))
+				{ /// a channel without records has no file
+					if (!records.empty())
+						diffs++;
+					continue;
+				}
+				removes.push_back(fname);
+				mlogUtils::record_t rec;
+				size_t n = 0;
+				while (reader.next(rec))
+				{
+					if ((n >= records.size()) || (rec.flag != records[n].flag) || (rec.size != records[n].msg.size())
+							|| !std::equal(records[n].msg.begin(), records[n].msg.end(), rec.msg))
+						diffs++;
+					n++;
+				}
+				if (n != records.size())
+					diffs++;
+			}
+		}
+		std::cout << "20000 records on 3 channels with a rotation, records differing on replay " << diffs;
+		std::cout << ", dropped " << logger.dropped() << std::endl;
+		if ((diffs > 0) || (logger.dropped() > 0))
+		{
+			std::cerr << "Logger files do not replay the records logged" << std::endl;
+			ret = false;
+		}
+	}
+
+	/// main-loop cost: 2000 iterations per second, each logging a 300-byte payload record with msOfDay and
+	/// a 103-byte sig record as dataMgr does when forwarding, with a rotation every 2 seconds
+	const std::vector<std::string> types = {"sig", "cnt", "pres", "req", "traj", "perm", "payload"};
+	const unsigned long long period = 500000;  // in nanoseconds
+	std::cout << iterations << " iterations at 2000/s in " << logDir << ", latency in ns" << std::endl;
+	std::cout << std::setw(24) << " " << std::setw(10) << "p50" << std::setw(10) << "p99";
+	std::cout << std::setw(10) << "p99.9" << std::setw(10) << "max" << std::endl;
+	for (int mode = 0; mode < 2; mode++)
+	{
+		std::string prefix = logDir + std::string((mode == 0) ? "/ofstream" : "/logger");
+		OfstreamLogs oldLogs(prefix, types);
+		logUtils::Logger logger(prefix);
+		for (const auto& type : types)
+			logger.addChannel(type);
+		if (mode == 0)
+			oldLogs.open("0");
+		else
+			logger.open("0");
+		std::vector<uint8_t> msg(300, 0x5A);
+		std::vector<unsigned long long> recordNs;
+		std::vector<unsigned long long> iterationNs;
+		recordNs.reserve(iterations * 2);
+		iterationNs.reserve(iterations);
+		std::vector<std::string> suffixes = {"0"};
+		unsigned long long next = (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+		for (size_t k = 0; k < iterations; k++)
+		{
+			unsigned long long t = 0;
+			while ((t = (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count()) < next)
+			{
+				if (next - t > 60000)
+					std::this_thread::sleep_for(std::chrono::nanoseconds(next - t - 50000));
+			}
+			next += period;
+			auto t0 = std::chrono::steady_clock::now();
+			for (int r = 0; r < 2; r++)
+			{
+				auto t1 = std::chrono::steady_clock::now();
+				size_t channel = (r == 0) ? 6 : 0;
+				size_t len = (r == 0) ? 300 : 103;
+				if ((mode == 0) && (r == 0))
+					oldLogs.log(types[channel], msg, len, (uint32_t)k);
+				else if (mode == 0)
+					oldLogs.log(types[channel], msg, len);
+				else if (r == 0)
+					logger.log(channel, &msg[0], len, (uint32_t)k);
+				else
+					logger.log(channel, &msg[0], len);
+				recordNs.push_back((unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - t1).count());
+			}
+			msg.resize(300);  // undo the msOfDay insert of the ofstream logging
+			if ((k + 1) % 4000 == 0)
+			{
+				suffixes.push_back(std::to_string(k + 1));
+				if (mode == 0)
+					oldLogs.reopen(suffixes.back());
+				else
+					logger.reopen(suffixes.back());
+			}
+			iterationNs.push_back((unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - t0).count());
+		}
+		if (mode == 0)
+			oldLogs.close();
+		else
+			logger.close();
+		for (const auto& type : types)
+		{
+			for (const auto& suffix : suffixes)
+			{
+				removes.push_back(prefix + std::string(".") + type + std::string(".") + suffix);
+				removes.push_back(prefix + std::string(".") + type + std::string(".") + suffix + std::string(".mlog"));
+			}
+		}
+		reportNs((mode == 0) ? "ofstream, per record" : "Logger, per record", recordNs);
+		reportNs((mode == 0) ? "ofstream, per iteration" : "Logger, per iteration", iterationNs);
+		if ((mode == 1) && (logger.dropped() > 0))
+		{
+			std::cerr << "Logger dropped " << logger.dropped() << " records" << std::endl;
+			ret = false;
+		}
+	}
+	for (const auto& fname : removes)
+		std::remove(fname.c_str());
+	rmdir(logDir.c_str());
+	return(ret);
+}
+
+/// write dirty pages of fname and drop it from the page cache, for cold reads
+static void dropCache(const std::string& fname)
+{
+	int fd = open(fname.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+	fdatasync(fd);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	close(fd);
+}
+
+static double secondsSince(const std::chrono::steady_clock::time_point& t0)
+{
+	return(std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+}
+
+/// round-trip, seek and recovery of mlog files, raw and compressed, and the Logger path
+static bool checkMlog(const std::string& logDir, std::vector<std::string>& removes)
+{
+	struct expected_t
+	{
+		uint64_t timestamp;
+		uint8_t flag;
+		std::vector<uint8_t> msg;
+	};
+	/// 200000 records of 0 to 399 bytes, a quarter of the bytes are '\n', half of them with an MMITSS header,
+	/// several records per millisecond
+	std::mt19937 rng(3);
+	std::vector<expected_t> records;
+	uint64_t timestamp = 1700000000000ULL;
+	for (int i = 0; i < 200000; i++)
+	{
+		timestamp += rng() % 3;
+		expected_t record{timestamp, (uint8_t)(i & 1), std::vector<uint8_t>(rng() % 400)};
+		for (auto& byte : record.msg)
+			byte = (uint8_t)((rng() % 4 == 0) ? 0x0A : rng());
+		if ((record.msg.size() >= 3) && (i % 2 == 1))
+		{
+			record.msg[0] = 0xFF;
+			record.msg[1] = 0xFF;
+			record.msg[2] = 0x40;
+		}
+		records.push_back(record);
+	}
+	auto isSame = [](const mlogUtils::record_t& rec, const expected_t& record)
+	{
+		uint8_t msgid = ((record.msg.size() >= 3) && (record.msg[0] == 0xFF) && (record.msg[1] == 0xFF)) ? record.msg[2] : 0;
+		return((rec.timestamp == record.timestamp) && (rec.flag == record.flag) && (rec.msgid == msgid)
+			&& (rec.size == record.msg.size()) && std::equal(record.msg.begin(), record.msg.end(), rec.msg));
+	};
+	size_t mismatches = 0;
+	for (int compress = 0; compress < 2; compress++)
+	{
+		std::string fname = logDir + std::string("/check") + std::to_string(compress) + std::string(".mlog");
+		removes.push_back(fname);
+		mlogUtils::Writer writer;
+		writer.open(fname, (compress == 1), 65536, 16);
+		for (const auto& record : records)
+			writer.append(record.timestamp, record.flag, &record.msg[0], record.msg.size());
+		writer.close();
+		mlogUtils::Reader reader;
+		if (!reader.open(fname))
+		{
+			std::cerr << "Failed opening " << fname << std::endl;
+			return(false);
+		}
+		/// round-trip
+		mlogUtils::record_t rec;
+		size_t n = 0;
+		while (reader.next(rec))
+		{
+			if ((n >= records.size()) || !isSame(rec, records[n]))
+				mismatches++;
+			n++;
+		}
+		if (n != records.size())
+			mismatches++;
+		/// seek lands on the first record at or after the timestamp, and next() goes on from there
+		for (int q = 0; q < 2000; q++)
+		{
+			uint64_t target = records.front().timestamp - 5 + rng() % (records.back().timestamp - records.front().timestamp + 10);
+			auto it = std::lower_bound(records.begin(), records.end(), target,
+				[](const expected_t& record, uint64_t ts){return(record.timestamp < ts);});
+			bool found = reader.seek(target);
+			if (it == records.end())
+			{
+				if (found)
+					mismatches++;
+				continue;
+			}
+			if (!found || !reader.next(rec) || !isSame(rec, *it))
+				mismatches++;
+			else if ((it + 1 != records.end()) && (!reader.next(rec) || !isSame(rec, *(it + 1))))
+				mismatches++;
+		}
+		std::cout << ((compress == 1) ? "compressed" : "raw") << ": " << n << " records in " << reader.blocks();
+		std::cout << " blocks read back, 2000 seeks";
+		reader.close();
+		/// a file that was not closed: cut to 2/3, the records of the complete blocks are read in order
+		std::ifstream IS(fname, std::ifstream::binary);
+		std::vector<char> buf((std::istreambuf_iterator<char>(IS)), std::istreambuf_iterator<char>());
+		IS.close();
+		std::string cutName = fname + std::string(".cut");
+		removes.push_back(cutName);
+		std::ofstream OS(cutName, std::ofstream::binary);
+		OS.write(&buf[0], (std::streamsize)(buf.size() * 2 / 3));
+		OS.close();
+		size_t cutNums = 0;
+		if (!reader.open(cutName))
+			mismatches++;
+		else
+		{
+			while (reader.next(rec))
+			{
+				if ((cutNums >= records.size()) || !isSame(rec, records[cutNums]))
+					mismatches++;
+				cutNums++;
+			}
+			if (cutNums == 0)
+				mismatches++;
+		}
+		std::cout << ", cut to 2/3: " << cutNums << " records in " << reader.blocks() << " blocks" << std::endl;
+		reader.close();
+	}
+	/// through the compressed Logger: msOfDay inserted after the first 3 bytes, rotation, the file of a channel
+	/// without records removed
+	logUtils::Logger logger(logDir + std::string("/log"), true);
+	size_t channel = logger.addChannel("a");
+	logger.addChannel("empty");
+	logger.open("1");
+	const std::vector<uint8_t> msg = {0xFF, 0xFF, 0x40, 0x0A, 0x0A, 0x0A, 0x0A, 0, 5, 1, 2, 3, 4, 5};
+	std::vector<uint8_t> inserted = msg;
+	const uint8_t msOfDay[4] = {1, 2, 3, 4};
+	inserted.insert(inserted.begin() + 3, msOfDay, msOfDay + 4);
+	for (int i = 0; i < 1000; i++)
+	{
+		logger.log(channel, &msg[0], msg.size(), (uint32_t)0x01020304);
+		logger.log(channel, &msg[0], msg.size());
+	}
+	logger.reopen("2");
+	logger.log(channel, &msg[0], 3);
+	logger.close();
+	const std::string names[] = {"/log.a.1.mlog", "/log.a.2.mlog", "/log.empty.1.mlog", "/log.empty.2.mlog"};
+	for (const auto& name : names)
+		removes.push_back(logDir + name);
+	mlogUtils::Reader reader;
+	mlogUtils::record_t rec;
+	size_t n1 = 0;
+	size_t n2 = 0;
+	if (reader.open(logDir + names[0]))
+	{
+		while (reader.next(rec))
+		{
+			const std::vector<uint8_t>& want = (n1 % 2 == 0) ? inserted : msg;
+			if ((rec.size != want.size()) || !std::equal(want.begin(), want.end(), rec.msg)
+					|| (rec.flag != ((n1 % 2 == 0) ? 1 : 0)) || (rec.msgid != 0x40))
+				mismatches++;
+			n1++;
+		}
+	}
+	reader.close();
+	if (reader.open(logDir + names[1]))
+	{
+		while (reader.next(rec))
+			n2++;
+	}
+	reader.close();
+	bool emptyRemoved = (access((logDir + names[2]).c_str(), F_OK) != 0) && (access((logDir + names[3]).c_str(), F_OK) != 0);
+	std::cout << "Logger: " << n1 << " + " << n2 << " records, empty channel files ";
+	std::cout << (emptyRemoved ? "removed" : "kept") << ", mismatches " << mismatches << std::endl;
+	if ((n1 != 2000) || (n2 != 1) || !emptyRemoved)
+		mismatches++;
+	if (mismatches > 0)
+	{
+		std::cerr << "mlog files do not hold the records written" << std::endl;
+		return(false);
+	}
+	return(true);
+}
+
+/// payload records of 'recordNums' messages at 2000 per second, as the payload channel logs them: MMITSS header
+/// with msOfDay inserted (13 bytes) followed by a UPER payload of the hex file (one per line, '#' for comments)
+static bool benchMlog(size_t recordNums, const std::string& dir, const std::string& fhex)
+{
+	std::vector< std::vector<uint8_t> > payloads;
+	std::ifstream IS(fhex);
+	std::string line;
+	while (std::getline(IS, line))
+	{
+		if (line.empty() || (line[0] == '#'))
+			continue;
+		std::vector<uint8_t> msg = {0xFF, 0xFF, 0x40, 0, 0, 0, 0, 0, 0, 0, 0, 0, (uint8_t)(line.size() / 2)};
+		for (size_t i = 0; i + 1 < line.size(); i += 2)
+			msg.push_back((uint8_t)strtoul(line.substr(i, 2).c_str(), NULL, 16));
+		payloads.push_back(msg);
+	}
+	IS.close();
+	if (payloads.empty())
+	{
+		std::cerr << "No payload in " << fhex << std::endl;
+		return(false);
+	}
+	std::string tmpl = dir + std::string("/utilsBench.XXXXXX");
+	std::vector<char> path(tmpl.begin(), tmpl.end());
+	path.push_back('\0');
+	if (mkdtemp(&path[0]) == nullptr)
+	{
+		std::cerr << "Failed creating a directory in " << dir << std::endl;
+		return(false);
+	}
+	std::string logDir(&path[0]);
+	std::vector<std::string> removes;
+	bool ret = checkMlog(logDir, removes);
+
+	std::mt19937 rng(5);
+	std::cout << recordNums << " records of " << payloads.size() << " payloads from " << fhex << " at 2000/s in " << logDir << std::endl;
+	for (int compress = 0; (compress < 2) && ret; compress++)
+	{
+		std::string fname = logDir + std::string("/bench") + std::to_string(compress) + std::string(".mlog");
+		removes.push_back(fname);
+		const uint64_t ts0 = 1760000000000ULL;
+		uint64_t ts = ts0;
+		double bytes = 0.0;
+		auto t0 = std::chrono::steady_clock::now();
+		{
+			mlogUtils::Writer writer;
+			if (!writer.open(fname, (compress == 1)))
+			{
+				std::cerr << "Failed opening " << fname << std::endl;
+				ret = false;
+				break;
+			}
+			for (size_t n = 0; n < recordNums; n++)
+			{
+				std::vector<uint8_t>& msg = payloads[n % payloads.size()];
+				uint32_t msOfDay = (uint32_t)(ts % 86400000ULL);
+				for (int i = 0; i < 4; i++)
+					msg[3 + i] = (uint8_t)(msOfDay >> (24 - 8 * i));
+				writer.append(ts, 1, &msg[0], msg.size());
+				bytes += (double)(16 + msg.size());
+				if (n % 2 == 1)
+					ts++;
+			}
+			writer.close();
+		}
+		dropCache(fname);
+		double writeSecs = secondsSince(t0);
+		struct stat st;
+		double fileSize = (stat(fname.c_str(), &st) == 0) ? (double)st.st_size : 0.0;
+		std::cout << std::fixed << std::setprecision(2) << ((compress == 1) ? "compressed" : "raw") << ": ";
+		std::cout << bytes / 1e9 << " GB of records over " << (double)(ts - ts0) / 3.6e6 << " h, file " << fileSize / 1e9 << " GB" << std::endl;
+		std::cout << std::setprecision(1) << "  write          " << bytes / 1e6 / writeSecs << " MB/s of records including fdatasync" << std::endl;
+		mlogUtils::Reader reader;
+		t0 = std::chrono::steady_clock::now();
+		reader.open(fname);
+		std::cout << std::setprecision(2) << "  open (cold)    " << secondsSince(t0) * 1e3 << " ms, " << reader.blocks() << " blocks" << std::endl;
+		for (int cold = 1; cold >= 0; cold--)
+		{
+			std::vector<double> us;
+			size_t wrong = 0;
+			mlogUtils::record_t rec;
+			for (int q = 0; q < ((cold == 1) ? 200 : 20000); q++)
+			{
+				uint64_t target = ts0 + rng() % (ts - ts0);
+				if (cold == 1)
+					dropCache(fname);
+				t0 = std::chrono::steady_clock::now();
+				bool found = reader.seek(target) && reader.next(rec);
+				us.push_back(secondsSince(t0) * 1e6);
+				if (!found || (rec.timestamp != target))
+					wrong++;
+			}
+			std::sort(us.begin(), us.end());
+			std::cout << std::setprecision(1) << ((cold == 1) ? "  seek (cold)    p50 " : "  seek (warm)    p50 ") << us[us.size() / 2];
+			std::cout << " us, p99 " << us[us.size() * 99 / 100] << " us, max " << us.back() << " us, not on the exact record " << wrong << std::endl;
+			if (wrong > 0)
+				ret = false;
+		}
+		/// replay from the middle of the file
+		dropCache(fname);
+		t0 = std::chrono::steady_clock::now();
+		reader.seek(ts0 + (ts - ts0) / 2);
+		mlogUtils::record_t rec;
+		size_t replayed = 0;
+		while ((replayed < 5000000) && reader.next(rec))
+			replayed++;
+		std::cout << std::setprecision(2) << "  replay (cold)  " << (double)replayed / 1e6 / secondsSince(t0) << " M records/s from mid-file" << std::endl;
+		reader.close();
+		/// finding a time without an index: a sequential read of half the file
+		dropCache(fname);
+		t0 = std::chrono::steady_clock::now();
+		std::ifstream IS_SCAN(fname, std::ifstream::binary);
+		std::vector<char> buf(1 << 20);
+		double scanned = 0.0;
+		while ((scanned < fileSize / 2) && IS_SCAN.read(&buf[0], (std::streamsize)buf.size()))
+			scanned += (double)IS_SCAN.gcount();
+		IS_SCAN.close();
+		std::cout << std::setprecision(1) << "  scan (cold)    " << secondsSince(t0) * 1e3 << " ms to read half the file without the index" << std::endl;
+		/// a file that was not closed: cut to 2/3, no trailer
+		if (truncate(fname.c_str(), (off_t)(fileSize * 2 / 3)) == 0)
+		{
+			dropCache(fname);
+			t0 = std::chrono::steady_clock::now();
+			reader.open(fname);
+			std::cout << "  recover (cold) " << secondsSince(t0) * 1e3 << " ms to open the file cut to 2/3, " << reader.blocks() << " blocks" << std::endl;
+			reader.close();
+		}
+	}
+	for (const auto& fname : removes)
+		std::remove(fname.c_str());
+	rmdir(logDir.c_str());
+	return(ret);
+}
+
+/// steady clock in nanoseconds, the same in a forked process
+static unsigned long long steadyNs(void)
+{
+	return(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/// receive loops of the MRP processes: the earlier poll with a timeout followed by a 5 ms sleep (pollTimeout > 0),
+/// and eventUtils::Reactor (pollTimeout 0)
+static bool runReactorLoop(size_t msgNums, int pollTimeout, unsigned long long& wakeups, std::vector<double>& latencyMs)
+{
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	struct sockaddr_in addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = 0;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t addrLen = sizeof(addr);
+	if ((fd < 0) || (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+		|| (getsockname(fd, (struct sockaddr*)&addr, &addrLen) < 0) || (fcntl(fd, F_SETFL, O_NONBLOCK) == -1))
+	{
+		std::cerr << "Failed creating loopback socket" << std::endl;
+		if (fd >= 0)
+			close(fd);
+		return(false);
+	}
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		std::cerr << "Failed fork" << std::endl;
+		close(fd);
+		return(false);
+	}
+	if (pid == 0)
+	{ /// sender: 10 messages per second at random times, each carrying the time it was sent
+		close(fd);
+		int sendFd = socket(AF_INET, SOCK_DGRAM, 0);
+		std::mt19937 rng((unsigned int)getpid());
+		for (size_t n = 0; n < msgNums; n++)
+		{
+			usleep((useconds_t)(rng() % 200000));
+			unsigned long long ns = steadyNs();
+			sendto(sendFd, &ns, sizeof(ns), 0, (struct sockaddr*)&addr, sizeof(addr));
+		}
+		close(sendFd);
+		_exit(EXIT_SUCCESS);
+	}
+	eventUtils::Reactor reactor;
+	reactor.addFd(fd);
+	size_t received = 0;
+	unsigned long long deadline = steadyNs() + (unsigned long long)msgNums * 200000000ULL + 1000000000ULL;
+	auto drain = [&](void)
+	{
+		unsigned long long ns;
+		while (recv(fd, &ns, sizeof(ns), 0) == (ssize_t)sizeof(ns))
+		{
+			latencyMs.push_back((double)(steadyNs() - ns) / 1e6);
+			received++;
+		}
+	};
+	wakeups = 0;
+	while ((received < msgNums) && (steadyNs() < deadline))
+	{
+		if (pollTimeout > 0)
+		{
+			struct pollfd pfd = {fd, POLLIN, 0};
+			poll(&pfd, 1, pollTimeout);
+			wakeups++;
+			drain();
+			usleep(5000);
+		}
+		else
+		{
+			reactor.wait();
+			if (reactor.readable(fd))
+				drain();
+		}
+	}
+	if (pollTimeout == 0)
+		wakeups = reactor.wakeups();
+	waitpid(pid, NULL, 0);
+	close(fd);
+	return(received == msgNums);
+}
+
+/// the tci soft-call path with calls pending for 'duration' milliseconds: a soft-call goes out once more than
+/// 'interval' milliseconds passed since the last one. The earlier timer runs on its own period, the current one is
+/// armed from the time the last soft-call was sent. Returns the intervals between soft-calls.
+static void runSoftcall(unsigned long long duration, unsigned long long interval, bool rearm, std::vector<double>& intervals)
+{
+	eventUtils::Reactor reactor;
+	size_t softcallTimer = (rearm) ? reactor.addTimer(0, interval) : reactor.addTimer(interval, interval);
+	unsigned long long start = eventUtils::Reactor::now();
+	unsigned long long lastSent = start;
+	unsigned long long msec = start;
+	while (msec < start + duration)
+	{
+		reactor.wait();
+		msec = eventUtils::Reactor::now();
+		bool sent = false;
+		if (msec > lastSent + interval)
+		{
+			intervals.push_back((double)(msec - lastSent));
+			lastSent = msec;
+			sent = true;
+		}
+		if (!rearm)
+		{
+			if (!reactor.isArmed(softcallTimer))
+				reactor.armTimer(softcallTimer, interval);
+			reactor.expired(softcallTimer);
+		}
+		else
+		{
+			reactor.expired(softcallTimer);
+			if (sent || !reactor.isArmed(softcallTimer))
+			{
+				unsigned long long due = lastSent + interval + 1;
+				reactor.armTimer(softcallTimer, (due > msec) ? due - msec : interval);
+			}
+		}
+	}
+}
+
+static bool benchReactor(size_t msgNums)
+{
+	std::cout << msgNums << " messages at random times, 10 per second, over loopback from a forked sender" << std::endl;
+	std::cout << std::setw(24) << "receive loop" << std::setw(12) << "wake-ups/s" << std::setw(10) << "p50 ms";
+	std::cout << std::setw(10) << "p90 ms" << std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << std::endl;
+	struct loopCase_t
+	{
+		const char* name;
+		int pollTimeout;
+	};
+	const loopCase_t loops[] = {{"poll 10 ms + sleep 5 ms", 10}, {"poll 20 ms + sleep 5 ms", 20}, {"Reactor", 0}};
+	bool ret = true;
+	for (const auto& loop : loops)
+	{
+		unsigned long long wakeups = 0;
+		std::vector<double> latency;
+		auto t0 = std::chrono::steady_clock::now();
+		bool complete = runReactorLoop(msgNums, loop.pollTimeout, wakeups, latency);
+		double secs = secondsSince(t0);
+		if (!complete || latency.empty())
+		{
+			std::cerr << loop.name << " received " << latency.size() << " of " << msgNums << " messages" << std::endl;
+			ret = false;
+			continue;
+		}
+		std::sort(latency.begin(), latency.end());
+		std::cout << std::fixed << std::setprecision(1) << std::setw(24) << loop.name << std::setw(12) << (double)wakeups / secs;
+		std::cout << std::setprecision(2) << std::setw(10) << latency[latency.size() / 2] << std::setw(10) << latency[latency.size() * 9 / 10];
+		std::cout << std::setw(10) << latency[latency.size() * 99 / 100] << std::setw(10) << latency.back() << std::endl;
+	}
+
+	const unsigned long long softcallInterval = 20;
+	std::cout << std::endl << "soft-calls pending for 2 s, sent once more than " << softcallInterval << " ms passed since the last one" << std::endl;
+	std::cout << std::setw(24) << "soft-call timer" << std::setw(12) << "soft-calls" << std::setw(10) << "p50 ms";
+	std::cout << std::setw(10) << "max ms" << std::endl;
+	for (bool rearm : {false, true})
+	{
+		std::vector<double> intervals;
+		runSoftcall(2000, softcallInterval, rearm, intervals);
+		std::sort(intervals.begin(), intervals.end());
+		std::cout << std::setw(24) << ((rearm) ? "armed from the last sent" : "periodic") << std::setw(12) << intervals.size();
+		std::cout << std::setprecision(0) << std::setw(10) << intervals[intervals.size() / 2] << std::setw(10) << intervals.back() << std::endl;
+		/// armed from the time it was sent, the next soft-call goes out on the first tick it is allowed
+		if (rearm && (intervals[intervals.size() / 2] > (double)(softcallInterval + 2)))
+		{
+			std::cerr << "soft-calls went out every " << intervals[intervals.size() / 2] << " ms" << std::endl;
+			ret = false;
+		}
+	}
+	return(ret);
+}
+
+/// socket of an MRP socket configuration line (e.g., "fromOrder SHM 127.0.0.1 30000"), fd -1 on failure
+static socketUtils::Conn_t openConn(const std::string& line)
+{
+	socketUtils::Address_t addr;
+	if (!socketUtils::setAddress(line, addr) || !socketUtils::create(addr))
+		addr.conn.fd = -1;
+	return(addr.conn);
+}
+
+/// a pair of ports (and SHM ring names) of this process, unlikely to be used by another one
+static unsigned int benchPort(unsigned int n)
+	{return(30000 + ((unsigned int)getpid() % 10000) * 3 + n);}
+
+/// echo process of the ping check: sends every message received on inPort back to outPort, until an all-zero ping
+static void runEcho(const std::string& protocol, const std::string& inPort, const std::string& outPort)
+{
+	socketUtils::Conn_t in = openConn("fromPing " + protocol + " 127.0.0.1 " + inPort);
+	socketUtils::Conn_t out = openConn("toPing " + protocol + " 127.0.0.1 " + outPort);
+	socketUtils::DgramBatch batch(16, 256);
+	const unsigned long long stop = 0;
+	bool done = ((in.fd < 0) || (out.fd < 0));
+	int idle = 0;
+	while (!done && (idle < 10))
+	{
+		while (batch.next(in.fd))
+		{
+			if ((batch.len() == sizeof(stop)) && (std::memcmp(&batch.buf()[0], &stop, sizeof(stop)) == 0))
+				done = true;
+			else
+				socketUtils::sendall(out, &batch.buf()[0], batch.len());
+		}
+		struct pollfd pfd = {in.fd, POLLIN, 0};
+		idle = (done || (poll(&pfd, 1, 1000) > 0)) ? 0 : idle + 1;
+	}
+	if (in.fd >= 0)
+		socketUtils::destroy(in.fd);
+	if (out.fd >= 0)
+		socketUtils::destroy(out.fd);
+}
+
+/// round trips of 8-byte pings to a forked echo process over 'protocol' sockets (UDP or SHM). The first 100 pings
+/// are a warm-up, which may be lost while the echo process starts. Returns false when a measured ping is lost.
+static bool runPing(const std::string& protocol, size_t pingNums, std::vector<double>& rttUs)
+{
+	std::string pingPort = std::to_string(benchPort(0));
+	std::string echoPort = std::to_string(benchPort(1));
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		std::cerr << "Failed fork" << std::endl;
+		return(false);
+	}
+	if (pid == 0)
+	{
+		runEcho(protocol, pingPort, echoPort);
+		_exit(EXIT_SUCCESS);
+	}
+	/// sockets are created after the fork, so that neither process holds the other's socket and ring
+	socketUtils::Conn_t out = openConn("toEcho " + protocol + " 127.0.0.1 " + pingPort);
+	socketUtils::Conn_t in = openConn("fromEcho " + protocol + " 127.0.0.1 " + echoPort);
+	socketUtils::DgramBatch batch(16, 256);
+	const size_t warmup = 100;
+	bool ret = ((in.fd >= 0) && (out.fd >= 0));
+	for (size_t n = 0; ret && (n < pingNums + warmup); n++)
+	{
+		unsigned long long value = n + 1;
+		unsigned long long sent = steadyNs();
+		unsigned long long deadline = sent + ((n < warmup) ? 100000000ULL : 1000000000ULL);
+		unsigned long long replied = 0;
+		socketUtils::sendall(out, (const uint8_t*)&value, sizeof(value));
+		while ((replied == 0) && (steadyNs() < deadline))
+		{
+			while (batch.next(in.fd))
+			{
+				if ((batch.len() == sizeof(value)) && (std::memcmp(&batch.buf()[0], &value, sizeof(value)) == 0))
+					replied = steadyNs();
+			}
+			if (replied == 0)
+			{
+				struct pollfd pfd = {in.fd, POLLIN, 0};
+				poll(&pfd, 1, 10);
+			}
+		}
+		if (n < warmup)
+			continue;
+		if (replied == 0)
+		{
+			std::cerr << protocol << " ping " << n - warmup + 1 << " got no reply" << std::endl;
+			ret = false;
+		}
+		else
+			rttUs.push_back((double)(replied - sent) / 1e3);
+	}
+	const unsigned long long stop = 0;
+	if (out.fd >= 0)
+		socketUtils::sendall(out, (const uint8_t*)&stop, sizeof(stop));
+	waitpid(pid, NULL, 0);
+	if (in.fd >= 0)
+		socketUtils::destroy(in.fd);
+	if (out.fd >= 0)
+		socketUtils::destroy(out.fd);
+	return(ret);
+}
+
+/// message of the ordering check, 200 bytes
+struct orderMsg_t
+{
+	uint32_t gen;       // sender
+	uint32_t pad;
+	uint64_t seq;       // from 1, per sender
+	uint8_t filler[184];
+};
+
+/// sender of the ordering check: from 'start' until 'stop' (steadyNs) bursts of 64 messages through a
+/// DgramBatch, a 2 ms pause after every 8 bursts
+static void runOrderSender(const std::string& port, uint32_t gen, unsigned long long start, unsigned long long stop)
+{ /// the ring reports every spill and lost receiver on stderr
+	int devNull = open("/dev/null", O_WRONLY);
+	if (devNull >= 0)
+		dup2(devNull, STDERR_FILENO);
+	while (steadyNs() < start)
+		usleep(1000);
+	socketUtils::Conn_t out = openConn("toOrder SHM 127.0.0.1 " + port);
+	socketUtils::DgramBatch batch(64, 256);
+	orderMsg_t msg;
+	std::memset(&msg, 0, sizeof(msg));
+	msg.gen = gen;
+	for (size_t burst = 0; (out.fd >= 0) && (steadyNs() < stop); burst++)
+	{
+		for (size_t i = 0; i < batch.capacity(); i++)
+		{
+			msg.seq++;
+			batch.add(out, (const uint8_t*)&msg, sizeof(msg));
+		}
+		batch.flush(out);
+		if (burst % 8 == 7)
+			usleep(2000);
+	}
+}
+
+/// messages received from one sender of the ordering check
+struct orderStats_t
+{
+	uint64_t lastSeq;
+	size_t received;
+	size_t ring;         // taken from the shared-memory lane
+	size_t socket;       // spilled to the UDP socket
+	size_t outOfOrder;   // not newer than the last one received
+	size_t ringAfterRestart;
+};
+
+/// ordering of SHM messages from three forked senders to this process, which reads 2000 messages and then
+/// sleeps for 20 ms, so that the lanes fill up and messages spill to the socket:
+///   sender 1 sends from 0 to 3 s, the receiver detaches (unlinking the ring) and attaches again at 1.5 s;
+///   sender 2 sends from 3.5 s and is killed at 4.5 s;
+///   sender 3 sends from 5 s to 6.5 s, in the lane of sender 2 once that has been reaped.
+/// Every sender's messages have to arrive in the order sent, messages lost on a full socket buffer or in
+/// the ring of the receiver that detached are counted, not failed.
+static bool runOrder(std::vector<orderStats_t>& stats)
+{
+	const unsigned long long ms = 1000000ULL;
+	std::string port = std::to_string(benchPort(2));
+	unsigned long long t0 = steadyNs() + 200 * ms;
+	struct senderCase_t
+	{
+		unsigned long long start;
+		unsigned long long stop;
+	};
+	const senderCase_t senders[] = {{0, 3000}, {3500, 10000}, {5000, 6500}};
+	std::vector<pid_t> pids;
+	for (size_t i = 0; i < sizeof(senders) / sizeof(senders[0]); i++)
+	{ /// all senders are forked before the receiver socket is created, so that none of them holds it
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			runOrderSender(port, (uint32_t)(i + 1), t0 + senders[i].start * ms, t0 + senders[i].stop * ms);
+			_exit(EXIT_SUCCESS);
+		}
+		pids.push_back(pid);
+		if (pid < 0)
+		{
+			std::cerr << "Failed fork" << std::endl;
+			break;
+		}
+	}
+	socketUtils::Conn_t in = openConn("fromOrder SHM 127.0.0.1 " + port);
+	socketUtils::DgramBatch batch(64, 256);
+	stats.assign(pids.size() + 1, orderStats_t{0, 0, 0, 0, 0, 0});
+	bool ret = ((in.fd >= 0) && (std::find(pids.begin(), pids.end(), -1) == pids.end()));
+	bool restarted = false;
+	size_t sinceSleep = 0;
+	while (ret && (steadyNs() < t0 + 7500 * ms))
+	{
+		unsigned long long now = steadyNs();
+		if (!restarted && (now > t0 + 1500 * ms))
+		{
+			socketUtils::destroy(in.fd);
+			in = openConn("fromOrder SHM 127.0.0.1 " + port);
+			restarted = true;
+			if (in.fd < 0)
+			{
+				ret = false;
+				break;
+			}
+		}
+		if ((pids[1] > 0) && (now > t0 + 4500 * ms))
+			kill(pids[1], SIGKILL);
+		/// reap the senders, a lane is only taken over from a process that no longer exists
+		for (auto& pid : pids)
+		{
+			if ((pid > 0) && (waitpid(pid, NULL, WNOHANG) == pid))
+				pid = 0;
+		}
+		while (batch.next(in.fd))
+		{
+			orderMsg_t msg;
+			socketUtils::Conn_t from;
+			if (batch.len() != sizeof(msg))
+				continue;
+			std::memcpy(&msg, &batch.buf()[0], sizeof(msg));
+			if ((msg.gen == 0) || (msg.gen >= stats.size()))
+				continue;
+			orderStats_t& st = stats[msg.gen];
+			if (msg.seq <= st.lastSeq)
+				st.outOfOrder++;
+			else
+				st.lastSeq = msg.seq;
+			st.received++;
+			if (batch.source(in.fd, from))
+				st.socket++;
+			else
+			{
+				st.ring++;
+				if (restarted)
+					st.ringAfterRestart++;
+			}
+			if (++sinceSleep == 2000)
+			{
+				sinceSleep = 0;
+				usleep(20000);
+			}
+		}
+		struct pollfd pfd = {in.fd, POLLIN, 0};
+		poll(&pfd, 1, 10);
+	}
+	for (auto pid : pids)
+	{
+		if (pid > 0)
+		{
+			kill(pid, SIGKILL);
+			waitpid(pid, NULL, 0);
+		}
+	}
+	if (in.fd >= 0)
+		socketUtils::destroy(in.fd);
+	return(ret);
+}
+
+static bool benchShm(size_t pingNums)
+{
+	std::cout << pingNums << " round trips of 8-byte pings to a forked echo process" << std::endl;
+	std::cout << std::setw(10) << "protocol" << std::setw(12) << "pings/s" << std::setw(10) << "p50 us";
+	std::cout << std::setw(10) << "p99 us" << std::setw(10) << "max us" << std::endl;
+	bool ret = true;
+	for (const char* protocol : {"UDP", "SHM"})
+	{
+		std::vector<double> rtt;
+		auto t0 = std::chrono::steady_clock::now();
+		if (!runPing(protocol, pingNums, rtt) || rtt.empty())
+		{
+			ret = false;
+			continue;
+		}
+		double secs = secondsSince(t0);
+		std::sort(rtt.begin(), rtt.end());
+		std::cout << std::fixed << std::setprecision(0) << std::setw(10) << protocol << std::setw(12) << (double)rtt.size() / secs;
+		std::cout << std::setprecision(1) << std::setw(10) << rtt[rtt.size() / 2] << std::setw(10) << rtt[rtt.size() * 99 / 100];
+		std::cout << std::setw(10) << rtt.back() << std::endl;
+	}
+
+	std::cout << std::endl << "SHM ordering, 200-byte messages in bursts of 64 to a receiver sleeping 20 ms every 2000 messages" << std::endl;
+	std::cout << std::setw(36) << "sender" << std::setw(10) << "received" << std::setw(10) << "ring";
+	std::cout << std::setw(10) << "socket" << std::setw(10) << "lost" << std::setw(14) << "out of order" << std::endl;
+	std::vector<orderStats_t> stats;
+	if (!runOrder(stats))
+	{
+		std::cerr << "Failed running the SHM ordering check" << std::endl;
+		return(false);
+	}
+	const char* senderNames[] = {"", "1, receiver restarted at 1.5 s", "2, killed after 1 s", "3, lane of the killed sender"};
+	for (size_t i = 1; i < stats.size(); i++)
+	{
+		const orderStats_t& st = stats[i];
+		std::cout << std::setw(36) << senderNames[i] << std::setw(10) << st.received << std::setw(10) << st.ring;
+		std::cout << std::setw(10) << st.socket << std::setw(10) << st.lastSeq + st.outOfOrder - st.received;
+		std::cout << std::setw(14) << st.outOfOrder << std::endl;
+		if (st.outOfOrder > 0)
+		{
+			std::cerr << "messages of sender " << i << " arrived out of order" << std::endl;
+			ret = false;
+		}
+	}
+	/// the check only counts when the paths it is about were taken
+	if (stats[1].socket == 0)
+	{
+		std::cerr << "no message spilled to the socket" << std::endl;
+		ret = false;
+	}
+	if (stats[1].ringAfterRestart == 0)
+	{
+		std::cerr << "sender 1 did not attach to the ring of the restarted receiver" << std::endl;
+		ret = false;
+	}
+	if ((stats[2].received == 0) || (stats[3].ring == 0))
+	{
+		std::cerr << "no message of sender " << ((stats[2].received == 0) ? 2 : 3) << " arrived through the ring" << std::endl;
+		ret = false;
+	}
+	return(ret);
+}
+
+int main(int argc, char** argv)
+{
+	int option;
+	size_t iterations = 0;
+
+	while ((option = getopt(argc, argv, "n:?")) != EOF)
+	{
+		switch(option)
+		{
+		case 'n':
+			iterations = (size_t)strtoul(optarg, NULL, 10);
+			break;
+		case '?':
+		default:
+			do_usage(argv[0]);
+			break;
+		}
+	}
+	if ((optind < argc - 3) || (optind > argc - 1))
+		do_usage(argv[0]);
+	std::string benchmark = std::string(argv[optind]);
+	std::string dir = (optind + 1 < argc) ? std::string(argv[optind + 1]) : std::string("/tmp");
+	std::string fhex = (optind + 2 < argc) ? std::string(argv[optind + 2]) : std::string("../codecBench/corpus/bsm.hex");
+
+	bool ret = false;
+	if (benchmark == "pace")
+		ret = benchPace((iterations > 0) ? iterations : 200000);
+	else if (benchmark == "logger")
+		ret = benchLogger((iterations > 0) ? iterations : 20000, dir);
+	else if (benchmark == "reactor")
+		ret = benchReactor((iterations > 0) ? iterations : 100);
+	else if (benchmark == "mlog")
+		ret = benchMlog((iterations > 0) ? iterations : 10000000, dir, fhex);
+	else if (benchmark == "shm")
+		ret = benchShm((iterations > 0) ? iterations : 10000);
+	else
+		do_usage(argv[0]);
+	exit(ret ? EXIT_SUCCESS : EXIT_FAILURE);
+}